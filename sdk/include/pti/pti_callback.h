@@ -221,6 +221,8 @@ ptiCallbackSubscribe(pti_callback_subscriber_handle* subscriber,
 /**
  * @brief Unsubscribe Callback subscriber. This unsubscribes from all domains, disables the callback,
  *        cleans up all resources related to the subscriber handle, and invalidates the handle.
+ *        Returns once callbacks of the subscriber running on other threads have returned,
+ *        so user_data may be freed then.
  */
 pti_result PTI_EXPORT
 ptiCallbackUnsubscribe(pti_callback_subscriber_handle subscriber);
@@ -43,6 +43,8 @@ typedef enum _pti_view_kind {
   PTI_VIEW_DEVICE_GPU_MEM_COPY_P2P = 10,     //!< Peer to Peer Memory copies between Devices.
   PTI_VIEW_DEVICE_SYNCHRONIZATION = 11,      //!< Synchronization operations on host and GPU.
   PTI_VIEW_COMMUNICATION = 12,               //!< Communication records via oneCCL. Only for Linux.
+  PTI_VIEW_API_SUMMARY = 13,                 //!< Aggregated API calls, reported in the API summary
+                                             //!< mode, see ptiViewSetApiSummaryPolicy
   PTI_VIEW_KIND_FORCE_UINT32 = 0x7fffffff
 } pti_view_kind;
 
@@ -515,6 +517,27 @@ typedef struct pti_view_record_api {
   uint32_t _return_code;           //!< Applicable only for PTI_VIEW_DRIVER_API, type cast to specific driver code type
 } pti_view_record_api;
 
+/**
+ * @brief API Calls Summary View record type: calls of an API on a thread aggregated over
+ *        an interval, reported instead of pti_view_record_api in the API summary mode
+ */
+typedef struct pti_view_record_api_summary {
+  pti_view_record_base _view_kind; //!< Base record
+  uint64_t _start_timestamp;       //!< Start timestamp of the first call aggregated, ns
+  uint64_t _end_timestamp;         //!< End timestamp of the last call aggregated, ns
+  pti_api_group_id _api_group;     //!< API group of the calls (L0, SYCL, etc)
+  uint32_t _api_id;                //!< Id of the api called
+  uint32_t _process_id;            //!< Process ID of where the API calls observed
+  uint32_t _thread_id;             //!< Thread ID of where the API calls observed
+  uint64_t _count;                 //!< Number of calls
+  uint64_t _total_duration;        //!< Sum of durations of the calls, ns
+  uint64_t _min_duration;          //!< Shortest duration, ns
+  uint64_t _max_duration;          //!< Longest duration, ns
+  uint64_t _p50_duration;          //!< Median duration, ns, within 1/64 of exact
+  uint64_t _p90_duration;          //!< 90th percentile duration, ns, within 1/64 of exact
+  uint64_t _p99_duration;          //!< 99th percentile duration, ns, within 1/64 of exact
+} pti_view_record_api_summary;
+
 /**
  * @brief Communication View record type,
  *        communication provided by oneCCL, supported only for Linux
@@ -613,6 +636,7 @@ ptiViewGetNextRecord(uint8_t* buffer, size_t valid_bytes,
 
 /**
  * @brief Pushes ExternalCorrelationId kind and id for generation of external correlation records
+ *        Returns PTI_ERROR_BAD_ARGUMENT if external_kind is not a pti_view_external_kind value.
  *
  * @param external_kind
  * @param external_id
@@ -725,6 +749,126 @@ ptiViewEnableDriverApiClass(uint32_t enable, pti_api_class api_class, pti_api_gr
 pti_result  PTI_EXPORT
 ptiViewEnableRuntimeApiClass(uint32_t enable, pti_api_class api_class, pti_api_group_id group);
 
+/**
+ * @brief Kernel launch sampling modes
+ */
+typedef enum _pti_view_sampling_mode {
+  PTI_VIEW_SAMPLING_MODE_NONE = 0,       //!< Every kernel launch is traced (default)
+  PTI_VIEW_SAMPLING_MODE_EVERY_NTH = 1,  //!< Launches 1, N + 1, 2N + 1, ... of each kernel
+                                         //!< are traced
+  PTI_VIEW_SAMPLING_MODE_RESERVOIR = 2,  //!< First N launches of each kernel are traced,
+                                         //!< launch n > N is traced with probability N/n
+  PTI_VIEW_SAMPLING_MODE_FORCE_UINT32 = 0x7fffffff
+} pti_view_sampling_mode;
+
+PTI_STATIC_ASSERT(sizeof(pti_view_sampling_mode) == sizeof(uint32_t), "pti_view_sampling_mode enum should be equal to size of uint32_t");
+
+/**
+ * @brief Kernel launch sampling policy
+ */
+typedef struct pti_view_sampling_policy {
+  pti_view_sampling_mode _mode;  //!< Sampling mode
+  uint32_t _rate;                //!< N of the sampling mode, values less than 2 disable sampling
+} pti_view_sampling_policy;
+
+/**
+ * @brief Kernel launch counts under sampling
+ */
+typedef struct pti_view_sampling_counts {
+  uint64_t _launched;  //!< Exact number of kernel launches
+  uint64_t _traced;    //!< Number of launches reported in PTI_VIEW_DEVICE_GPU_KERNEL records
+} pti_view_sampling_counts;
+
+/**
+ * @brief Sets the kernel launch sampling policy. For very high kernel launch rates, only the
+ *        sampled launches are instrumented and reported as PTI_VIEW_DEVICE_GPU_KERNEL records,
+ *        while launches of every kernel are still counted exactly, see ptiViewGetSamplingCounts.
+ *        Kernels are sampled by name. Sampling is not applied while a callback subscriber
+ *        is active. Setting the policy restarts the counting.
+ *
+ * @param policy
+ * @return pti_result
+ */
+pti_result PTI_EXPORT
+ptiViewSetSamplingPolicy(const pti_view_sampling_policy* policy);
+
+/**
+ * @brief Gets kernel launch counts under sampling. Multiplying statistics of the traced launches
+ *        of a kernel by _launched / _traced estimates the statistics of all its launches.
+ *
+ * @param kernel_name name of the kernel as reported in pti_view_record_kernel::_name,
+ *        nullptr to get the counts of all kernels
+ * @param counts
+ * @return pti_result
+ */
+pti_result PTI_EXPORT
+ptiViewGetSamplingCounts(const char* kernel_name, pti_view_sampling_counts* counts);
+
+/**
+ * @brief Aggregated durations of the instances of a kernel on a device queue
+ */
+typedef struct pti_view_kernel_summary {
+  const char* _name;                   //!< Kernel name
+  pti_device_handle_t _device_handle;  //!< Device handle
+  pti_backend_queue_t _queue_handle;   //!< Device back-end queue handle
+  uint64_t _count;                     //!< Number of kernel instances
+  uint64_t _total_duration;            //!< Sum of durations of the instances, ns
+  uint64_t _min_duration;              //!< Shortest duration, ns
+  uint64_t _max_duration;              //!< Longest duration, ns
+  uint64_t _p50_duration;              //!< Median duration, ns, within 1/64 of exact
+  uint64_t _p90_duration;              //!< 90th percentile duration, ns, within 1/64 of exact
+  uint64_t _p99_duration;              //!< 99th percentile duration, ns, within 1/64 of exact
+} pti_view_kernel_summary;
+
+/**
+ * @brief Enables or disables the kernel summary mode. In summary mode kernel instances of
+ *        enabled PTI_VIEW_DEVICE_GPU_KERNEL view are aggregated per kernel name, device and queue
+ *        instead of being reported as records, so no buffer space is used for them.
+ *        Aggregated kernels are kept when the mode is disabled.
+ *
+ * @param enable  non-zero to enable, 0 to disable
+ * @return pti_result
+ */
+pti_result PTI_EXPORT
+ptiViewEnableSummary(uint32_t enable);
+
+/**
+ * @brief Gets the kernel summary. Call with summaries equal to NULL to get the number of
+ *        summaries into *count. Otherwise, up to *count summaries are written and *count is set
+ *        to the number written. Names stay valid until the library is unloaded.
+ *        To get durations of all kernels, call ptiFlushAllViews first.
+ *
+ * @param summaries  array of *count summaries or NULL
+ * @param count
+ * @return pti_result
+ */
+pti_result PTI_EXPORT
+ptiViewGetSummary(pti_view_kernel_summary* summaries, size_t* count);
+
+/**
+ * @brief API summary mode policy
+ */
+typedef struct pti_view_api_summary_policy {
+  uint32_t _enable;          //!< Non-zero to enable the API summary mode, 0 to disable
+  uint32_t _record_rate;     //!< Calls 1, N + 1, 2N + 1, ... of each API on each thread are still
+                             //!< reported as pti_view_record_api, 0 to report none
+  uint64_t _flush_interval;  //!< A thread reports its summaries once this many ns passed since
+                             //!< it last did, 0 to report them only at ptiFlushAllViews
+} pti_view_api_summary_policy;
+
+/**
+ * @brief Sets the API summary policy. In the API summary mode calls of the enabled
+ *        PTI_VIEW_DRIVER_API and PTI_VIEW_RUNTIME_API views are counted per thread and API and
+ *        reported as PTI_VIEW_API_SUMMARY records, at the flush interval and at ptiFlushAllViews,
+ *        instead of one record per call. Summaries aggregated so far are reported at the next
+ *        ptiFlushAllViews when the mode is disabled.
+ *
+ * @param policy
+ * @return pti_result
+ */
+pti_result PTI_EXPORT
+ptiViewSetApiSummaryPolicy(const pti_view_api_summary_policy* policy);
+
 #if defined(__cplusplus)
 }
 #endif
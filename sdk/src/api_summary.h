@@ -0,0 +1,150 @@
+// ==============================================================
+// Copyright (C) Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+// =============================================================
+#ifndef SRC_API_SUMMARY_H_
+#define SRC_API_SUMMARY_H_
+
+/**
+ * \internal
+ * \file api_summary.h
+ * \brief Per-thread, per-API aggregation of API call durations used instead of API view records.
+ *
+ * At high call rates one pti_view_record_api per call costs more buffer space and delivery time
+ * than the calls themselves. In summary mode every thread counts its calls per API in its own
+ * table and reports them as pti_view_record_api_summary records, once per flush interval or
+ * at ptiFlushAllViews. A sampled subset of calls can still be reported as full records.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+
+#include "kernel_summary.h"
+#include "pti/pti_view.h"
+
+namespace pti::view {
+
+/**
+ * \internal
+ * \brief Aggregation of API calls of all threads, one table per thread, see utils::ThreadTables.
+ */
+class ApiSummary {
+ public:
+  /**
+   * \internal
+   * \brief Calls of one API on one thread aggregated since the last take.
+   */
+  struct Interval {
+    pti_api_group_id group;
+    uint32_t api_id;
+    uint32_t thread_id;
+    uint64_t start;  // start of the first call aggregated
+    uint64_t end;    // end of the last call aggregated
+  };
+
+  ApiSummary() = default;
+
+  ApiSummary(const ApiSummary&) = delete;
+  ApiSummary& operator=(const ApiSummary&) = delete;
+
+  /**
+   * \internal
+   * \brief Calls 1, N + 1, 2N + 1, ... of each API on each thread are also to be reported as
+   * records, N = record_rate, none if 0. A thread takes its summaries once flush_interval ns
+   * passed since it last did, only TakeAll takes them if 0.
+   */
+  void SetPolicy(uint32_t record_rate, uint64_t flush_interval) {
+    record_rate_.store(record_rate, std::memory_order_relaxed);
+    flush_interval_.store(flush_interval, std::memory_order_relaxed);
+  }
+
+  /**
+   * \internal
+   * \brief Adds a call made on the calling thread. Returns true if the call is to be reported as
+   * a record as well. If the flush interval of the thread is due, calls take(interval, durations)
+   * for every API the thread called since, with the table of the thread locked.
+   */
+  template <typename F>
+  bool Add(pti_api_group_id group, uint32_t api_id, uint32_t thread_id, uint64_t start,
+           uint64_t end, F take) {
+    uint64_t duration = end > start ? end - start : 0;
+    uint32_t record_rate = record_rate_.load(std::memory_order_relaxed);
+    uint64_t flush_interval = flush_interval_.load(std::memory_order_relaxed);
+
+    ThreadTable* table = tables_.Get();
+    std::lock_guard<std::mutex> lock(table->lock_);
+    table->thread_id_ = thread_id;
+    if (table->taken_at_ == 0) {
+      table->taken_at_ = start;
+    }
+
+    Entry& entry = table->entries_[GetKey(group, api_id)];
+    entry.durations.Add(duration);
+    entry.start = std::min(entry.start, start);
+    entry.end = std::max(entry.end, end);
+    bool record = (record_rate != 0) && (entry.calls % record_rate == 0);
+    entry.calls++;
+
+    if (flush_interval != 0 && end - table->taken_at_ >= flush_interval) {
+      Take(*table, take);
+      table->taken_at_ = end;
+    }
+    return record;
+  }
+
+  /**
+   * \internal
+   * \brief Calls take(interval, durations) for every API called on every thread since the last
+   * take, with the table of the thread locked.
+   */
+  template <typename F>
+  void TakeAll(F take) {
+    tables_.ForEach([&take](ThreadTable& table) { Take(table, take); });
+  }
+
+ private:
+  struct Entry {
+    DurationSummary durations;
+    uint64_t start = UINT64_MAX;
+    uint64_t end = 0;
+    uint64_t calls = 0;  // not reset on take, so sampling spans intervals
+  };
+
+  struct ThreadTable {
+    std::mutex lock_;
+    uint32_t thread_id_ = 0;
+    uint64_t taken_at_ = 0;
+    std::unordered_map<uint64_t, Entry> entries_;
+  };
+
+  static uint64_t GetKey(pti_api_group_id group, uint32_t api_id) {
+    return (static_cast<uint64_t>(group) << 32) | api_id;
+  }
+
+  template <typename F>
+  static void Take(ThreadTable& table, F& take) {
+    for (auto& [key, entry] : table.entries_) {
+      if (entry.durations.count == 0) {
+        continue;
+      }
+      Interval interval{static_cast<pti_api_group_id>(key >> 32), static_cast<uint32_t>(key),
+                        table.thread_id_, entry.start, entry.end};
+      take(interval, entry.durations);
+      entry.durations = DurationSummary{};
+      entry.start = UINT64_MAX;
+      entry.end = 0;
+    }
+  }
+
+  std::atomic<uint32_t> record_rate_ = 0;
+  std::atomic<uint64_t> flush_interval_ = 0;
+  utils::ThreadTables<ThreadTable> tables_;
+};
+
+}  // namespace pti::view
+
+#endif  // SRC_API_SUMMARY_H_
@@ -0,0 +1,238 @@
+// ==============================================================
+// Copyright (C) Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+// =============================================================
+#ifndef SRC_KERNEL_SUMMARY_H_
+#define SRC_KERNEL_SUMMARY_H_
+
+/**
+ * \internal
+ * \file kernel_summary.h
+ * \brief Per-kernel aggregation of GPU kernel durations used instead of kernel view records.
+ *
+ * Every thread delivering kernel records adds them to its own table, so threads never contend
+ * with each other. Tables are merged only when the user asks for the summary.
+ */
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "pti/pti_view.h"
+#include "thread_tables.h"
+
+namespace pti::view {
+
+/**
+ * \internal
+ * \brief High dynamic range histogram of durations in ns.
+ *
+ * Values below 2^kPrecisionBits are counted exactly. Larger values are counted in buckets of
+ * 2^(kPrecisionBits - 1) per power of two, so any recorded value is within 1/64 of its bucket.
+ * Buckets are allocated one power of two at a time, a kernel running in a narrow range of
+ * durations uses a few hundred bytes.
+ */
+class LatencyHistogram {
+ public:
+  static constexpr uint32_t kPrecisionBits = 7;
+
+  void Record(uint64_t value) {
+    auto [block, index] = GetBucket(value);
+    if (!blocks_[block]) {
+      blocks_[block] = std::make_unique<Block>();
+    }
+    (*blocks_[block])[index]++;
+    count_++;
+  }
+
+  void Merge(const LatencyHistogram& other) {
+    for (size_t block = 0; block < kBlockCount; ++block) {
+      if (!other.blocks_[block]) {
+        continue;
+      }
+      if (!blocks_[block]) {
+        blocks_[block] = std::make_unique<Block>(*other.blocks_[block]);
+        continue;
+      }
+      for (size_t index = 0; index < kBlockSize; ++index) {
+        (*blocks_[block])[index] += (*other.blocks_[block])[index];
+      }
+    }
+    count_ += other.count_;
+  }
+
+  uint64_t GetCount() const { return count_; }
+
+  /**
+   * \internal
+   * \brief Value at the percentile (0..100): the middle of the bucket holding the value with
+   * rank percentile * count / 100, rounded and at least 1. 0 if the histogram is empty.
+   */
+  uint64_t GetValueAtPercentile(double percentile) const {
+    if (count_ == 0) {
+      return 0;
+    }
+    percentile = std::clamp(percentile, 0.0, 100.0);
+    auto rank = static_cast<uint64_t>(percentile / 100.0 * static_cast<double>(count_) + 0.5);
+    rank = std::clamp<uint64_t>(rank, 1, count_);
+    uint64_t seen = 0;
+    for (size_t block = 0; block < kBlockCount; ++block) {
+      if (!blocks_[block]) {
+        continue;
+      }
+      for (size_t index = 0; index < kBlockSize; ++index) {
+        seen += (*blocks_[block])[index];
+        if (seen >= rank) {
+          return GetBucketMiddle(block, index);
+        }
+      }
+    }
+    return 0;  // not reached
+  }
+
+ private:
+  static constexpr size_t kBlockSize = size_t{1} << (kPrecisionBits - 1);
+  // block 0 and 1 hold values below 2^kPrecisionBits exactly, block b > 1 holds
+  // [2^(b + kPrecisionBits - 2), 2^(b + kPrecisionBits - 1))
+  static constexpr size_t kBlockCount = 64 - kPrecisionBits + 2;
+
+  using Block = std::array<uint64_t, kBlockSize>;
+
+  static std::pair<size_t, size_t> GetBucket(uint64_t value) {
+    if (value < (uint64_t{1} << kPrecisionBits)) {
+      return {value / kBlockSize, value % kBlockSize};
+    }
+    uint32_t msb = 63;
+    while (!(value >> msb)) {
+      --msb;
+    }
+    uint32_t shift = msb - kPrecisionBits + 1;
+    return {shift + 1, (value >> shift) - kBlockSize};
+  }
+
+  static uint64_t GetBucketMiddle(size_t block, size_t index) {
+    if (block < 2) {
+      return block * kBlockSize + index;
+    }
+    uint32_t shift = static_cast<uint32_t>(block - 1);
+    uint64_t low = static_cast<uint64_t>(index + kBlockSize) << shift;
+    return low + ((uint64_t{1} << shift) >> 1);
+  }
+
+  std::array<std::unique_ptr<Block>, kBlockCount> blocks_;
+  uint64_t count_ = 0;
+};
+
+/**
+ * \internal
+ * \brief Aggregated durations, e.g. of the kernels with the same name, device and queue.
+ */
+struct DurationSummary {
+  uint64_t count = 0;
+  uint64_t total = 0;
+  uint64_t min = UINT64_MAX;
+  uint64_t max = 0;
+  LatencyHistogram histogram;
+
+  void Add(uint64_t duration) {
+    count++;
+    total += duration;
+    min = std::min(min, duration);
+    max = std::max(max, duration);
+    histogram.Record(duration);
+  }
+
+  void Merge(const DurationSummary& other) {
+    count += other.count;
+    total += other.total;
+    min = std::min(min, other.min);
+    max = std::max(max, other.max);
+    histogram.Merge(other.histogram);
+  }
+};
+
+using KernelSummaryEntry = DurationSummary;
+
+/**
+ * \internal
+ * \brief Per-thread kernel aggregation tables merged on demand.
+ *
+ * Every thread delivering kernel records adds them to its own table, see utils::ThreadTables.
+ */
+class KernelSummary {
+ public:
+  using Key = std::tuple<std::string, pti_device_handle_t, pti_backend_queue_t>;
+
+  KernelSummary() = default;
+
+  KernelSummary(const KernelSummary&) = delete;
+  KernelSummary& operator=(const KernelSummary&) = delete;
+
+  void Add(const std::string& name, pti_device_handle_t device, pti_backend_queue_t queue,
+           uint64_t duration) {
+    ThreadTable* table = tables_.Get();
+    std::lock_guard<std::mutex> lock(table->lock_);
+    table->entries_[Key{name, device, queue}].Add(duration);
+  }
+
+  /**
+   * \internal
+   * \brief Merges the tables of all threads. Calls f(name, device, queue, entry) for every
+   * kernel, in the order of keys. Names stay valid as long as the object exists.
+   */
+  template <typename F>
+  void ForEach(F f) {
+    std::map<Key, KernelSummaryEntry> merged;
+    tables_.ForEach([&merged](const ThreadTable& table) {
+      for (const auto& [key, entry] : table.entries_) {
+        merged[key].Merge(entry);
+      }
+    });
+    std::vector<const char*> names;
+    {
+      std::lock_guard<std::mutex> lock(names_lock_);
+      for (const auto& it : merged) {
+        names.push_back(names_.insert(std::get<0>(it.first)).first->c_str());
+      }
+    }
+    size_t i = 0;
+    for (const auto& [key, entry] : merged) {
+      f(names[i++], std::get<1>(key), std::get<2>(key), entry);
+    }
+  }
+
+ private:
+  struct KeyHash {
+    size_t operator()(const Key& key) const {
+      size_t hash = std::hash<std::string>{}(std::get<0>(key));
+      hash ^= std::hash<const void*>{}(std::get<1>(key)) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+      hash ^= std::hash<const void*>{}(std::get<2>(key)) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+      return hash;
+    }
+  };
+
+  struct ThreadTable {
+    std::mutex lock_;
+    std::unordered_map<Key, KernelSummaryEntry, KeyHash> entries_;
+  };
+
+  utils::ThreadTables<ThreadTable> tables_;
+  std::mutex names_lock_;
+  std::set<std::string> names_;  // names handed out by ForEach
+};
+
+}  // namespace pti::view
+
+#endif  // SRC_KERNEL_SUMMARY_H_
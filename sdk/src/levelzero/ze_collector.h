@@ -41,6 +41,7 @@
 #include <vector>
 
 #include "collector_options.h"
+#include "kernel_sampler.h"
 #include "lz_api_tracing_api_loader.h"
 #include "overhead_kinds.h"
 #include "pti/pti_view.h"
@@ -413,6 +414,18 @@ class ZeCollector {
   void SetCollectorOptionSynchronization() { options_.lz_enabled_views.synch_enabled = true; }
   void SetCollectorOptionApiCalls() { options_.lz_enabled_views.api_calls_enabled = true; }
 
+  void SetKernelSamplingPolicy(utils::KernelSamplingMode mode, uint32_t rate) {
+    kernel_sampler_.SetPolicy(mode, rate);
+  }
+
+  // Counts of the kernel launches with the name, of all launches if the name is nullptr
+  utils::KernelLaunchCount GetKernelLaunchCount(const char* kernel_name) const {
+    if (kernel_name == nullptr) {
+      return kernel_sampler_.GetTotalCount();
+    }
+    return kernel_sampler_.GetCount(kernel_name);
+  }
+
   void UnSetCollectorOptionSynchronization() { options_.lz_enabled_views.synch_enabled = false; }
   void UnSetCollectorOptionApiCalls() { options_.lz_enabled_views.api_calls_enabled = false; }
 
@@ -456,17 +469,9 @@ class ZeCollector {
     return cb_subscribers_collection_.DisableAllCallbackDomains(handle);
   }
 
-  // Check if any subscriber has the given domain enabled
+  // Check if any subscriber has the given domain enabled, lock-free
   bool IsCallbackDomainEnabled(pti_callback_domain domain, uint32_t cb_type) {
-    std::shared_lock<std::shared_mutex> lock(subscribers_mutex_);
-    for (auto& subscriber_handle : cb_subscribers_collection_) {
-      auto subscriber = cb_subscribers_collection_.GetSubscriber(subscriber_handle);
-      PTI_ASSERT(subscriber != nullptr);
-      if (subscriber->IsEnabled(domain, cb_type)) {
-        return true;
-      }
-    }
-    return false;
+    return cb_subscribers_collection_.IsDomainEnabled(domain, cb_type);
   }
 
   bool IsAnyCallbackSubscriberActive() {
@@ -556,18 +561,14 @@ class ZeCollector {
   void InvokeCallbacksForSubscribers(pti_callback_domain domain, pti_callback_phase phase,
                                      uint32_t api_id, pti_backend_ctx_t context,
                                      void* callback_data) {
-    std::shared_lock<std::shared_mutex> lock(subscribers_mutex_);
-    for (const auto& subscriber_handle : cb_subscribers_collection_) {
-      auto subscriber = cb_subscribers_collection_.GetSubscriber(subscriber_handle);
-      PTI_ASSERT(subscriber != nullptr);
-      if (subscriber->IsEnabled(domain, phase) && subscriber->GetCallback()) {
-        thread_local_is_within_subscriber_callback = true;
-        subscriber->GetCallback()(domain, PTI_API_GROUP_LEVELZERO, api_id, context, callback_data,
-                                  subscriber->GetUserData(),
-                                  subscriber->GetPtrForInstanceUserData());
-        thread_local_is_within_subscriber_callback = false;
-      }
-    }
+    cb_subscribers_collection_.ForEachEnabledSubscriber(
+        domain, phase, [&](const ZeCollectorCBSubscriber& subscriber) {
+          thread_local_is_within_subscriber_callback = true;
+          subscriber.GetCallback()(domain, PTI_API_GROUP_LEVELZERO, api_id, context,
+                                   callback_data, subscriber.GetUserData(),
+                                   subscriber.GetPtrForInstanceUserData());
+          thread_local_is_within_subscriber_callback = false;
+        });
   }
 
   void DoCallbackOnKernelLifecycle(pti_callback_domain domain, pti_callback_phase phase,
@@ -2080,12 +2081,27 @@ class ZeCollector {
     }
   }
 
+  // Returns false if the kernel launch is not sampled and should not be instrumented
+  bool SampleKernelLaunch(ze_kernel_handle_t kernel) {
+    // callback subscribers expect every GPU operation
+    if (!kernel_sampler_.IsEnabled() || IsAnyCallbackSubscriberActive()) {
+      return true;
+    }
+    return kernel_sampler_.Sample(kernel_name_cache_.GetKernelName(kernel, options_.demangle)) > 0;
+  }
+
   static void PrepareToAppendKernelCommand(ZeCollector* collector,
                                            ze_command_list_handle_t command_list,
                                            KernelCommandType kernel_type,
-                                           ze_event_handle_t& signal_event, void** instance_data) {
+                                           ze_event_handle_t& signal_event, void** instance_data,
+                                           ze_kernel_handle_t kernel = nullptr) {
     PTI_ASSERT(command_list != nullptr);
     PTI_ASSERT(instance_data != nullptr);
+    if (kernel != nullptr && !collector->SampleKernelLaunch(kernel)) {
+      SPDLOG_TRACE("In {} kernel launch is not sampled", __FUNCTION__);
+      *instance_data = nullptr;
+      return;
+    }
     SPDLOG_TRACE("In {} Collection mode: {}, Cmdl: {}, signal_event: {}, kernel_type: {}",
                  __FUNCTION__, static_cast<uint32_t>(collector->collection_mode_),
                  static_cast<const void*>(command_list), static_cast<const void*>(signal_event),
@@ -2500,7 +2516,7 @@ class ZeCollector {
     SPDLOG_TRACE("In {} --->", __FUNCTION__);
     auto* collector = static_cast<ZeCollector*>(global_data);
     PrepareToAppendKernelCommand(collector, *(params->phCommandList), KernelCommandType::kKernel,
-                                 *(params->phSignalEvent), instance_data);
+                                 *(params->phSignalEvent), instance_data, *(params->phKernel));
   }
 
   static void OnExitCommandListAppendLaunchKernel(
@@ -2509,6 +2525,9 @@ class ZeCollector {
     SPDLOG_TRACE("In {}, result: {}", __FUNCTION__, (uint32_t)result);
     auto* collector = static_cast<ZeCollector*>(global_data);
     auto* command = static_cast<ZeKernelCommand*>(*instance_data);
+    if (command == nullptr) {  // launch is not sampled
+      return;
+    }
     command->callback_id_ = zeCommandListAppendLaunchKernel_id;
     collector->PostAppendKernel(collector, *(params->phKernel), *(params->ppLaunchFuncArgs),
                                 *(params->phSignalEvent), *(params->phCommandList), result,
@@ -2524,7 +2543,7 @@ class ZeCollector {
     SPDLOG_TRACE("In {} --->", __FUNCTION__);
     auto* collector = static_cast<ZeCollector*>(global_data);
     PrepareToAppendKernelCommand(collector, *(params->phCommandList), KernelCommandType::kKernel,
-                                 *(params->phSignalEvent), instance_data);
+                                 *(params->phSignalEvent), instance_data, *(params->phKernel));
   }
 
   static void OnExitCommandListAppendLaunchCooperativeKernel(
@@ -2533,6 +2552,9 @@ class ZeCollector {
     SPDLOG_TRACE("In {}, result: {}", __FUNCTION__, (uint32_t)result);
     ZeCollector* collector = static_cast<ZeCollector*>(global_data);
     ZeKernelCommand* command = static_cast<ZeKernelCommand*>(*instance_data);
+    if (command == nullptr) {  // launch is not sampled
+      return;
+    }
     command->callback_id_ = zeCommandListAppendLaunchCooperativeKernel_id;
     collector->PostAppendKernel(collector, *(params->phKernel), *(params->ppLaunchFuncArgs),
                                 *(params->phSignalEvent), *(params->phCommandList), result,
@@ -2548,7 +2570,7 @@ class ZeCollector {
     SPDLOG_TRACE("In {} --->", __FUNCTION__);
     auto* collector = static_cast<ZeCollector*>(global_data);
     PrepareToAppendKernelCommand(collector, *(params->phCommandList), KernelCommandType::kKernel,
-                                 *(params->phSignalEvent), instance_data);
+                                 *(params->phSignalEvent), instance_data, *(params->phKernel));
   }
 
   static void OnExitCommandListAppendLaunchKernelIndirect(
@@ -2557,6 +2579,9 @@ class ZeCollector {
     SPDLOG_TRACE("In {}, result: {}", __FUNCTION__, (uint32_t)result);
     auto* collector = static_cast<ZeCollector*>(global_data);
     auto* command = static_cast<ZeKernelCommand*>(*instance_data);
+    if (command == nullptr) {  // launch is not sampled
+      return;
+    }
     command->callback_id_ = zeCommandListAppendLaunchKernelIndirect_id;
     collector->PostAppendKernel(collector, *(params->phKernel), *(params->ppLaunchArgumentsBuffer),
                                 *(params->phSignalEvent), *(params->phCommandList), result,
@@ -2572,7 +2597,7 @@ class ZeCollector {
     SPDLOG_TRACE("In {} --->", __FUNCTION__);
     auto* collector = static_cast<ZeCollector*>(global_data);
     PrepareToAppendKernelCommand(collector, *(params->phCommandList), KernelCommandType::kKernel,
-                                 *(params->phSignalEvent), instance_data);
+                                 *(params->phSignalEvent), instance_data, *(params->phKernel));
   }
 
   static void OnExitCommandListAppendLaunchKernelWithArguments(
@@ -2581,6 +2606,9 @@ class ZeCollector {
     SPDLOG_TRACE("In {}, result: {}", __FUNCTION__, static_cast<uint32_t>(result));
     auto* collector = static_cast<ZeCollector*>(global_data);
     auto* command = static_cast<ZeKernelCommand*>(*instance_data);
+    if (command == nullptr) {  // launch is not sampled
+      return;
+    }
     command->callback_id_ = zeCommandListAppendLaunchKernelWithArguments_id;
     collector->PostAppendKernel(collector, *(params->phKernel), params->pgroupCounts,
                                 *(params->phSignalEvent), *(params->phCommandList), result,
@@ -2596,7 +2624,7 @@ class ZeCollector {
     SPDLOG_TRACE("In {} --->", __FUNCTION__);
     auto* collector = static_cast<ZeCollector*>(global_data);
     PrepareToAppendKernelCommand(collector, *(params->phCommandList), KernelCommandType::kKernel,
-                                 *(params->phSignalEvent), instance_data);
+                                 *(params->phSignalEvent), instance_data, *(params->phKernel));
   }
 
   static void OnExitCommandListAppendLaunchKernelWithParameters(
@@ -2605,6 +2633,9 @@ class ZeCollector {
     SPDLOG_TRACE("In {}, result: {}", __FUNCTION__, static_cast<uint32_t>(result));
     auto* collector = static_cast<ZeCollector*>(global_data);
     auto* command = static_cast<ZeKernelCommand*>(*instance_data);
+    if (command == nullptr) {  // launch is not sampled
+      return;
+    }
     command->callback_id_ = zeCommandListAppendLaunchKernelWithParameters_id;
     collector->PostAppendKernel(collector, *(params->phKernel), *(params->ppGroupCounts),
                                 *(params->phSignalEvent), *(params->phCommandList), result,
@@ -3425,6 +3456,7 @@ class ZeCollector {
   ZeImageSizeMap image_size_map_;
   ZeKernelGroupSizeMap kernel_group_size_map_;
   ZeKernelNameCache<> kernel_name_cache_;
+  utils::KernelSampler<std::string> kernel_sampler_;
   ZeDeviceMap device_map_;
   std::unordered_map<ze_device_handle_t, ZeDeviceDescriptor> device_descriptors_;
   std::unordered_map<ze_module_handle_t, ze_device_handle_t> module_to_device_map_;
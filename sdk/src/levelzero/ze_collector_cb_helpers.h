@@ -9,11 +9,14 @@
 
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <list>
 #include <memory>
 #include <mutex>
 #include <shared_mutex>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -143,6 +146,32 @@ class ZeCollectorCBSubscriber {
     return DisableAllDomains();
   }
 
+  // Bit of a domain and phase in the masks the callback path checks, zero if the pair has none
+  static uint64_t GetDomainBit(pti_callback_domain domain, uint32_t cb_type) {
+    if (domain >= 32 || (cb_type != PTI_CB_PHASE_API_ENTER && cb_type != PTI_CB_PHASE_API_EXIT)) {
+      return 0;
+    }
+    uint32_t index = 2 * static_cast<uint32_t>(domain) + (cb_type == PTI_CB_PHASE_API_EXIT ? 1 : 0);
+    return uint64_t{1} << index;
+  }
+
+  // Domains and phases the subscriber is called for
+  uint64_t GetEnabledDomains() const {
+    if (subscriber_info_.callback_ == nullptr) {
+      return 0;
+    }
+    uint64_t enabled = 0;
+    for (const auto& [domain, properties] : subscriber_info_.domains_) {
+      if (properties.is_enter_enabled) {
+        enabled |= GetDomainBit(domain, PTI_CB_PHASE_API_ENTER);
+      }
+      if (properties.is_exit_enabled) {
+        enabled |= GetDomainBit(domain, PTI_CB_PHASE_API_EXIT);
+      }
+    }
+    return enabled;
+  }
+
   bool IsEnabled(pti_callback_domain domain, uint32_t cb_type) const {
     auto it = subscriber_info_.domains_.find(domain);
     if (it != subscriber_info_.domains_.end()) {
@@ -202,15 +231,24 @@ class ZeCollectorCBSubscriber {
   _pti_callback_subscriber subscriber_info_;
 };
 
+// Immutable view of the subscribers used on the callback path, in call order
+struct SubscribersSnapshot {
+  struct Entry {
+    const ZeCollectorCBSubscriber* subscriber;
+    uint64_t enabled_domains;
+  };
+  std::vector<Entry> entries;
+};
+
 class SubscribersCollection {
  public:
-  SubscribersCollection() {}
+  SubscribersCollection() : snapshot_(new SubscribersSnapshot()) {}
   SubscribersCollection(const SubscribersCollection&) = delete;
   SubscribersCollection& operator=(const SubscribersCollection&) = delete;
   SubscribersCollection(SubscribersCollection&&) = delete;
   SubscribersCollection& operator=(SubscribersCollection&&) = delete;
 
-  virtual ~SubscribersCollection() {}  // To satisfy Coverity with user-defined destructor
+  virtual ~SubscribersCollection() { delete snapshot_.load(); }
 
   pti_callback_subscriber_handle AddExternalSubscriber(
       std::unique_ptr<ZeCollectorCBSubscriber> subscriber) {
@@ -271,7 +309,9 @@ class SubscribersCollection {
     if (subscribers_map_.find(handle) != subscribers_map_.end()) {
       auto subscriber = subscribers_map_[handle].get();
       PTI_ASSERT(subscriber != nullptr);
-      return subscriber->EnableDomain(domain, enter_cb, exit_cb);
+      pti_result result = subscriber->EnableDomain(domain, enter_cb, exit_cb);
+      PublishSnapshot();
+      return result;
     }
     return pti_result::PTI_ERROR_BAD_ARGUMENT;  // Subscriber not found
   }
@@ -282,7 +322,10 @@ class SubscribersCollection {
     if (subscribers_map_.find(handle) != subscribers_map_.end()) {
       auto subscriber = subscribers_map_[handle].get();
       PTI_ASSERT(subscriber != nullptr);
-      return subscriber->DisableDomain(domain);
+      pti_result result = subscriber->DisableDomain(domain);
+      PublishSnapshot();
+      WaitForReaders();
+      return result;
     }
     return pti_result::PTI_ERROR_BAD_ARGUMENT;  // Subscriber not found
   }
@@ -292,16 +335,57 @@ class SubscribersCollection {
     if (subscribers_map_.find(handle) != subscribers_map_.end()) {
       auto subscriber = subscribers_map_[handle].get();
       PTI_ASSERT(subscriber != nullptr);
-      return subscriber->DisableAllDomains();
+      pti_result result = subscriber->DisableAllDomains();
+      PublishSnapshot();
+      WaitForReaders();
+      return result;
     }
     return pti_result::PTI_ERROR_BAD_ARGUMENT;  // Subscriber not found
   }
 
+  // Lock-free, the callback path checks it before preparing callback data
+  bool IsDomainEnabled(pti_callback_domain domain, uint32_t cb_type) const {
+    return (enabled_domains_.load() & ZeCollectorCBSubscriber::GetDomainBit(domain, cb_type)) != 0;
+  }
+
+  // Calls func for every subscriber with the domain and phase enabled, in call order.
+  // Lock-free and without iteration if no subscriber wants the domain. Subscribers may be
+  // added, changed or removed by other threads meanwhile: func sees the subscribers as they
+  // were when the call started. Removing or disabling waits for such calls to return.
+  template <typename F>
+  void ForEachEnabledSubscriber(pti_callback_domain domain, uint32_t cb_type, F&& func) const {
+    uint64_t bit = ZeCollectorCBSubscriber::GetDomainBit(domain, cb_type);
+    if ((enabled_domains_.load() & bit) == 0) {
+      return;
+    }
+    uint32_t epoch = epoch_.load();
+    readers_[epoch].fetch_add(1);
+    while (epoch_.load() != epoch) {
+      // flipped meanwhile, its writer may have stopped waiting for this counter already
+      readers_[epoch].fetch_sub(1);
+      epoch = epoch_.load();
+      readers_[epoch].fetch_add(1);
+    }
+    const SubscribersSnapshot* snapshot = snapshot_.load();
+    for (const auto& entry : snapshot->entries) {
+      if ((entry.enabled_domains & bit) != 0) {
+        func(*entry.subscriber);
+      }
+    }
+    readers_[epoch].fetch_sub(1);
+  }
+
   size_t GetSubscriberCount() const {
     const std::shared_lock<std::shared_mutex> lock(lock_);
     return subscribers_map_.size();
   }
 
+  // Snapshots replaced while callbacks may still run on them
+  size_t GetRetiredSnapshotCount() const {
+    const std::shared_lock<std::shared_mutex> lock(lock_);
+    return retired_snapshots_.size();
+  }
+
   auto begin() { return subscribers_list_.begin(); }
   auto end() { return subscribers_list_.end(); }
 
@@ -326,6 +410,7 @@ class SubscribersCollection {
       subscribers_list_.push_front(handle);
     }
     subscribers_map_.insert({handle, std::move(subscriber)});
+    PublishSnapshot();
     return handle;
   }
 
@@ -335,13 +420,83 @@ class SubscribersCollection {
     if (it != subscribers_list_.end()) {
       PTI_ASSERT(subscribers_map_.find(handle) != subscribers_map_.end());
       subscribers_list_.erase(it);
-      subscribers_map_.erase(handle);
+      auto map_it = subscribers_map_.find(handle);
+      // callbacks may still run on the snapshot it is part of
+      retired_subscribers_.push_back(std::move(map_it->second));
+      subscribers_map_.erase(map_it);
+      PublishSnapshot();
+      WaitForReaders();
       return true;
     }
     PTI_ASSERT(subscribers_map_.find(handle) == subscribers_map_.end());
     return false;
   }
 
+  void PublishSnapshot() {
+    // lock in a caller
+    auto snapshot = std::make_unique<SubscribersSnapshot>();
+    snapshot->entries.reserve(subscribers_list_.size());
+    uint64_t enabled_domains = 0;
+    for (auto handle : subscribers_list_) {
+      const auto& subscriber = subscribers_map_[handle];
+      PTI_ASSERT(subscriber != nullptr);
+      uint64_t subscriber_domains = subscriber->GetEnabledDomains();
+      snapshot->entries.push_back({subscriber.get(), subscriber_domains});
+      enabled_domains |= subscriber_domains;
+    }
+    retired_snapshots_.push_back({std::unique_ptr<const SubscribersSnapshot>(
+                                      snapshot_.exchange(snapshot.release())),
+                                  flips_});
+    enabled_domains_.store(enabled_domains);
+
+    // Frees what is safe without waiting, so that retired snapshots do not pile up while
+    // callbacks keep running
+    if (readers_[1 - epoch_.load()].load() == 0) {
+      FreeRetired(flips_);
+      FlipEpoch();
+    }
+  }
+
+  // Waits for the callbacks running on retired snapshots, so that once a subscriber is removed or
+  // a domain disabled, the caller may free the user data the callbacks use. Frees all retired
+  // snapshots and subscribers.
+  void WaitForReaders() {
+    // lock in a caller
+    WaitForEpochReaders(1 - epoch_.load());
+    FlipEpoch();
+    WaitForEpochReaders(1 - epoch_.load());
+    FreeRetired(flips_);
+  }
+
+  void WaitForEpochReaders(uint32_t epoch) const {
+    while (readers_[epoch].load() != 0) {
+      std::this_thread::yield();
+    }
+  }
+
+  // Readers register with the counter of the current epoch before they load the snapshot. Once
+  // the epoch is flipped and the counter of the previous one drops to zero, no callback runs on a
+  // snapshot retired before the flip. The counter of the new epoch must have drained before the
+  // flip, so that it counts only readers that load the snapshot after it. A reader still
+  // registering with a stale epoch either sees the flip and retries, or loads the snapshot after it.
+  void FlipEpoch() {
+    // lock in a caller
+    epoch_.store(1 - epoch_.load());
+    ++flips_;
+  }
+
+  // Frees the snapshots retired before the given flip, the counter of the epoch it ended must have
+  // drained. Retired subscribers go with the last retired snapshot
+  void FreeRetired(uint64_t flip) {
+    // lock in a caller
+    auto end = std::find_if(retired_snapshots_.begin(), retired_snapshots_.end(),
+                            [flip](const RetiredSnapshot& retired) { return retired.flip >= flip; });
+    retired_snapshots_.erase(retired_snapshots_.begin(), end);
+    if (retired_snapshots_.empty()) {
+      retired_subscribers_.clear();
+    }
+  }
+
   //  PTI subscribers
   // list ensures subscribers will be called in an order they were added
   std::list<pti_callback_subscriber_handle> subscribers_list_;
@@ -349,6 +504,21 @@ class SubscribersCollection {
   std::unordered_map<pti_callback_subscriber_handle, std::unique_ptr<ZeCollectorCBSubscriber>>
       subscribers_map_;
   mutable std::shared_mutex lock_;
+
+  // Callback path state, published by writers under lock_
+  std::atomic<uint64_t> enabled_domains_ = 0;
+  std::atomic<const SubscribersSnapshot*> snapshot_;
+  std::atomic<uint32_t> epoch_ = 0;
+  mutable std::atomic<uint32_t> readers_[2] = {0, 0};  // callbacks running, per epoch
+
+  // Written and freed by writers only
+  struct RetiredSnapshot {
+    std::unique_ptr<const SubscribersSnapshot> snapshot;
+    uint64_t flip;  // number of epoch flips before it was retired
+  };
+  std::vector<RetiredSnapshot> retired_snapshots_;
+  uint64_t flips_ = 0;
+  std::vector<std::unique_ptr<ZeCollectorCBSubscriber>> retired_subscribers_;
 };
 
 #endif
@@ -93,6 +93,11 @@ class PtiLibHandler {
   decltype(&ptiViewPopExternalCorrelationId) ptiViewPopExternalCorrelationId_ = nullptr;  // NOLINT
   decltype(&ptiViewGetTimestamp) ptiViewGetTimestamp_ = nullptr;                          // NOLINT
   decltype(&ptiViewSetTimestampCallback) ptiViewSetTimestampCallback_ = nullptr;          // NOLINT
+  decltype(&ptiViewSetSamplingPolicy) ptiViewSetSamplingPolicy_ = nullptr;                // NOLINT
+  decltype(&ptiViewGetSamplingCounts) ptiViewGetSamplingCounts_ = nullptr;                // NOLINT
+  decltype(&ptiViewEnableSummary) ptiViewEnableSummary_ = nullptr;                        // NOLINT
+  decltype(&ptiViewGetSummary) ptiViewGetSummary_ = nullptr;                              // NOLINT
+  decltype(&ptiViewSetApiSummaryPolicy) ptiViewSetApiSummaryPolicy_ = nullptr;            // NOLINT
   decltype(&ptiViewGetApiIdName) ptiViewGetApiIdName_ = nullptr;                          // NOLINT
   decltype(&ptiViewEnableDriverApi) ptiViewEnableDriverApi_ = nullptr;                    // NOLINT
   decltype(&ptiViewEnableDriverApiClass) ptiViewEnableDriverApiClass_ = nullptr;          // NOLINT
@@ -218,6 +223,11 @@ class PtiLibHandler {
     PTI_VIEW_GET_SYMBOL(ptiViewPopExternalCorrelationId);
     PTI_VIEW_GET_SYMBOL(ptiViewGetTimestamp);
     PTI_VIEW_GET_SYMBOL(ptiViewSetTimestampCallback);
+    PTI_VIEW_GET_SYMBOL(ptiViewSetSamplingPolicy);
+    PTI_VIEW_GET_SYMBOL(ptiViewGetSamplingCounts);
+    PTI_VIEW_GET_SYMBOL(ptiViewEnableSummary);
+    PTI_VIEW_GET_SYMBOL(ptiViewGetSummary);
+    PTI_VIEW_GET_SYMBOL(ptiViewSetApiSummaryPolicy);
     PTI_VIEW_GET_SYMBOL(ptiViewGetApiIdName);
     PTI_VIEW_GET_SYMBOL(ptiViewEnableDriverApi);
     PTI_VIEW_GET_SYMBOL(ptiViewEnableDriverApiClass);
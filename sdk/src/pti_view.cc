@@ -321,6 +321,66 @@ pti_result ptiViewSetTimestampCallback(pti_fptr_get_timestamp fptr_timestampRequ
   }
 }
 
+// Set kernel launch sampling policy of GPU kernel views.
+pti_result ptiViewSetSamplingPolicy(const pti_view_sampling_policy* policy) {
+  try {
+    return Instance().SetSamplingPolicy(policy);
+  } catch (const std::exception& e) {
+    LogException(e);
+    return pti_result::PTI_ERROR_INTERNAL;
+  } catch (...) {
+    return pti_result::PTI_ERROR_INTERNAL;
+  }
+}
+
+// Get exact and traced kernel launch counts of a kernel (or all kernels) under sampling.
+pti_result ptiViewGetSamplingCounts(const char* kernel_name, pti_view_sampling_counts* counts) {
+  try {
+    return Instance().GetSamplingCounts(kernel_name, counts);
+  } catch (const std::exception& e) {
+    LogException(e);
+    return pti_result::PTI_ERROR_INTERNAL;
+  } catch (...) {
+    return pti_result::PTI_ERROR_INTERNAL;
+  }
+}
+
+// Enable or disable aggregation of GPU kernel instances instead of kernel records.
+pti_result ptiViewEnableSummary(uint32_t enable) {
+  try {
+    return Instance().EnableSummary(enable != 0);
+  } catch (const std::exception& e) {
+    LogException(e);
+    return pti_result::PTI_ERROR_INTERNAL;
+  } catch (...) {
+    return pti_result::PTI_ERROR_INTERNAL;
+  }
+}
+
+// Get aggregated durations of GPU kernels per name, device and queue.
+pti_result ptiViewGetSummary(pti_view_kernel_summary* summaries, size_t* count) {
+  try {
+    return Instance().GetSummary(summaries, count);
+  } catch (const std::exception& e) {
+    LogException(e);
+    return pti_result::PTI_ERROR_INTERNAL;
+  } catch (...) {
+    return pti_result::PTI_ERROR_INTERNAL;
+  }
+}
+
+// Set the policy of aggregating API calls into summary records.
+pti_result ptiViewSetApiSummaryPolicy(const pti_view_api_summary_policy* policy) {
+  try {
+    return Instance().SetApiSummaryPolicy(policy);
+  } catch (const std::exception& e) {
+    LogException(e);
+    return pti_result::PTI_ERROR_INTERNAL;
+  } catch (...) {
+    return pti_result::PTI_ERROR_INTERNAL;
+  }
+}
+
 // Get api function name by api kind (LEVEL_ZERO_CALLS(default), OPENCL_CALLS, etc).
 pti_result ptiViewGetApiIdName(pti_api_group_id type, uint32_t unique_id, const char** name) {
   pti_result result = pti_result::PTI_SUCCESS;
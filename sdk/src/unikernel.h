@@ -9,12 +9,13 @@
 
 #include <level_zero/layers/zel_tracing_api.h>
 
+#include <array>
 #include <atomic>
 #include <cstdint>
 #include <cstring>
 #include <map>
-#include <stack>
 #include <string>
+#include <vector>
 
 #include "pti/pti_view.h"
 #include "pti_memory_route.h"
@@ -124,16 +125,6 @@ struct PidTidInfo {
 inline thread_local ZeKernelCommandExecutionRecord
     overhead_data;  // Placeholder till we refactor the 2nd level callbacks.
 
-struct ExternalCorrIdKey {
-  pti_view_external_kind _external_kind;
-};
-
-struct ExternalKeyCompare {
-  bool operator()(const ExternalCorrIdKey& lhs, const ExternalCorrIdKey& rhs) const {
-    return lhs._external_kind < rhs._external_kind;
-  }
-};
-
 struct OverheadKindKey {
   pti_view_overhead_kind _overhead_kind;
 };
@@ -147,12 +138,59 @@ struct OverheadKeyCompare {
 inline thread_local ZeKernelCommandExecutionRecord sycl_data_mview;
 inline thread_local ZeKernelCommandExecutionRecord sycl_data_kview;
 
-typedef std::map<ExternalCorrIdKey, std::stack<pti_view_record_external_correlation>,
-                 ExternalKeyCompare>
-    ExternalCorrelationIdMapType;
+inline constexpr size_t kExternalKindCount =
+    static_cast<size_t>(pti_view_external_kind::PTI_VIEW_EXTERNAL_KIND_CUSTOM_3) + 1;
+
+// Stack of external ids of one kind. Frameworks push and pop an id around every operation and
+// rarely nest deeply, so the first kInlineDepth ids are stored inline and push/pop do not allocate.
+class ExternalCorrIdStack {
+ public:
+  void Push(uint64_t external_id) {
+    if (size_ < kInlineDepth) {
+      inline_ids_[size_] = external_id;
+    } else {
+      overflow_ids_.push_back(external_id);
+    }
+    size_++;
+  }
+
+  // Stack must not be empty
+  uint64_t Top() const {
+    return size_ <= kInlineDepth ? inline_ids_[size_ - 1] : overflow_ids_.back();
+  }
+
+  // Stack must not be empty
+  void Pop() {
+    if (size_ > kInlineDepth) {
+      overflow_ids_.pop_back();
+    }
+    size_--;
+  }
+
+  bool Empty() const { return size_ == 0; }
+  size_t Size() const { return size_; }
+
+ private:
+  static constexpr size_t kInlineDepth = 8;
+
+  size_t size_ = 0;
+  std::array<uint64_t, kInlineDepth> inline_ids_ = {};
+  std::vector<uint64_t> overflow_ids_;
+};
+
+// External ids pushed on a thread, indexed by pti_view_external_kind.
+// A kind popped empty while in a subscriber callback keeps its last id as deferred, so the
+// records of the API call the callback is in still correlate to it.
+struct ExternalCorrIdStacks {
+  std::array<ExternalCorrIdStack, kExternalKindCount> active;
+  std::array<uint64_t, kExternalKindCount> deferred = {};
+  uint32_t active_mask = 0;    // bit per kind with a non-empty stack
+  uint32_t deferred_mask = 0;  // bit per kind with a deferred id
+
+  static_assert(kExternalKindCount <= 32, "kinds must fit the masks");
+};
 
-inline thread_local ExternalCorrelationIdMapType thread_local_map_ext_corrid_vectors;
-inline thread_local ExternalCorrelationIdMapType thread_local_map_ext_corrid_vectors_deferred_erase;
+inline thread_local ExternalCorrIdStacks thread_local_ext_corrid_stacks;
 
 inline thread_local bool thread_local_is_within_subscriber_callback = false;
 
@@ -13,7 +13,15 @@
 #else
 #define HAVE_CXXABI 0
 #endif
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <mutex>
 #include <string>
+#include <unordered_map>
+#include <utility>
 
 #include "pti_assert.h"
 
@@ -43,6 +51,156 @@ static inline std::string Demangle(const char* name) {
 #endif
 }
 
+// Process-wide cache of demangled names. Names are interned: the references
+// returned stay valid until the process exits. The cache is split into shards
+// selected by the hash of the mangled name, each with its own lock, so threads
+// demangling different names rarely contend
+class DemangleCache {
+ public:
+  static DemangleCache& Instance() {
+    // never destroyed, the names may still be in use by exit handlers
+    static DemangleCache* instance = new DemangleCache;
+    return *instance;
+  }
+
+  const std::string& Get(const char* name) {
+    PTI_ASSERT(name != nullptr);
+    // the mangled name is copied only when it is added to the cache
+    NameRef key{name, std::strlen(name)};
+    Shard& shard = shards_[NameRefHash{}(key) % kShardCount];
+
+    {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      auto it = shard.names.find(key);
+      if (it != shard.names.end()) {
+        return it->second;
+      }
+    }
+
+    // demangle outside of the lock, templated names take long
+    std::string demangled = Demangle(name);
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.names.find(key);
+    if (it != shard.names.end()) {  // added by another thread meanwhile
+      return it->second;
+    }
+    // deque keeps its elements in place, so keys may point into it
+    shard.mangled.emplace_back(name, key.size);
+    key.data = shard.mangled.back().c_str();
+    // rehashing does not move the elements, so the references to them stay valid
+    return shard.names.emplace(key, std::move(demangled)).first->second;
+  }
+
+ private:
+  DemangleCache() = default;
+
+  static constexpr size_t kShardCount = 16;
+
+  // Mangled name, either the one looked up or the copy owned by the shard
+  struct NameRef {
+    const char* data;
+    size_t size;
+
+    bool operator==(const NameRef& other) const {
+      return size == other.size && std::memcmp(data, other.data, size) == 0;
+    }
+  };
+
+  // FNV-1a
+  struct NameRefHash {
+    size_t operator()(const NameRef& name) const {
+      uint64_t hash = 14695981039346656037ULL;
+      for (size_t i = 0; i < name.size; ++i) {
+        hash = (hash ^ static_cast<unsigned char>(name.data[i])) * 1099511628211ULL;
+      }
+      return static_cast<size_t>(hash ^ (hash >> 32));
+    }
+  };
+
+  struct Shard {
+    std::mutex mutex;
+    std::deque<std::string> mangled;
+    std::unordered_map<NameRef, std::string, NameRefHash> names;
+  };
+
+  std::array<Shard, kShardCount> shards_;
+};
+
+static inline const std::string& DemangleCached(const char* name) {
+  return DemangleCache::Instance().Get(name);
+}
+
+// Shortens a demangled name for display to at most max_length characters.
+// Template argument and parameter lists are collapsed to "<...>" and "(...)"
+// starting from the innermost ones. If the name is still too long, the tail is
+// replaced with "..."
+static inline std::string ShortenName(const std::string& name, size_t max_length) {
+  if (name.size() <= max_length) {
+    return name;
+  }
+
+  int max_depth = 0;
+  int depth = 0;
+  for (char c : name) {
+    if (c == '<' || c == '(') {
+      max_depth = (std::max)(max_depth, ++depth);
+    } else if ((c == '>' || c == ')') && depth > 0) {
+      --depth;
+    }
+  }
+
+  std::string result = name;
+  for (int level = max_depth; level > 0 && result.size() > max_length; --level) {
+    std::string collapsed;
+    depth = 0;
+    bool balanced = true;
+    for (char c : name) {
+      if (c == '<' || c == '(') {
+        ++depth;
+        if (depth > level) {
+          continue;
+        }
+        collapsed += c;
+        if (depth == level) {
+          collapsed += "...";
+        }
+        continue;
+      }
+      if (c == '>' || c == ')') {
+        if (depth == 0) {  // e.g. operator>, collapsing would lose the structure
+          balanced = false;
+          break;
+        }
+        --depth;
+        if (depth >= level) {
+          continue;
+        }
+        collapsed += c;
+        continue;
+      }
+      if (depth < level) {
+        collapsed += c;
+      }
+    }
+    if (!balanced) {
+      break;
+    }
+    result = std::move(collapsed);
+  }
+
+  if (result.size() > max_length) {
+    constexpr const char* const ellipsis = "...";
+    constexpr size_t ellipsis_len = 3;
+    if (max_length > ellipsis_len) {
+      result = result.substr(0, max_length - ellipsis_len) + ellipsis;
+    } else {
+      result.resize(max_length);
+    }
+  }
+  return result;
+}
+
 }  // namespace utils
 
 #undef HAVE_CXXABI
@@ -33,12 +33,13 @@ bool IsValid(IntType val, EnumVal V, Next... oth) {
 bool IsPtiViewKindEnum(int v) {
   return IsValid<int, pti_view_kind, pti_view_kind, pti_view_kind, pti_view_kind, pti_view_kind,
                  pti_view_kind, pti_view_kind, pti_view_kind, pti_view_kind, pti_view_kind,
-                 pti_view_kind, pti_view_kind>(
+                 pti_view_kind, pti_view_kind, pti_view_kind>(
       v, pti_view_kind::PTI_VIEW_DEVICE_GPU_KERNEL, pti_view_kind::PTI_VIEW_DEVICE_CPU_KERNEL,
       pti_view_kind::PTI_VIEW_DRIVER_API, pti_view_kind::PTI_VIEW_RESERVED,
       pti_view_kind::PTI_VIEW_COLLECTION_OVERHEAD, pti_view_kind::PTI_VIEW_RUNTIME_API,
       pti_view_kind::PTI_VIEW_EXTERNAL_CORRELATION, pti_view_kind::PTI_VIEW_DEVICE_GPU_MEM_COPY,
       pti_view_kind::PTI_VIEW_DEVICE_GPU_MEM_FILL, pti_view_kind::PTI_VIEW_DEVICE_GPU_MEM_COPY_P2P,
-      pti_view_kind::PTI_VIEW_DEVICE_SYNCHRONIZATION, pti_view_kind::PTI_VIEW_COMMUNICATION);
+      pti_view_kind::PTI_VIEW_DEVICE_SYNCHRONIZATION, pti_view_kind::PTI_VIEW_COMMUNICATION,
+      pti_view_kind::PTI_VIEW_API_SUMMARY);
 }
 #endif  // INTERNAL_HELPER_H_
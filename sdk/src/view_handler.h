@@ -30,6 +30,8 @@
 #endif
 
 #include "itt_collector.h"
+#include "api_summary.h"
+#include "kernel_summary.h"
 #include "overhead_kinds.h"
 #include "unikernel.h"
 #include "utils.h"
@@ -70,6 +72,8 @@ inline void ZeApiCallsCallback(void* data, ZeKernelCommandExecutionRecord& rec);
 inline void CommunicationEvent(void* data, CommunicationRecord& rec);
 
 inline void SyclRuntimeViewCallback(void* data, ZeKernelCommandExecutionRecord& rec);
+inline void InsertApiSummaryRecord(const pti::view::ApiSummary::Interval& interval,
+                                   const pti::view::DurationSummary& durations);
 inline void OverheadCollectionCallback(void* data, ZeKernelCommandExecutionRecord& rec);
 
 inline void GetDeviceId(char* buf, const ze_pci_ext_properties_t& pci_prop_);
@@ -128,7 +132,7 @@ inline static constexpr std::array kPtiClassLzGpuOpsCoreApis{
     pti_api_id_driver_levelzero::zeCommandListImmediateAppendCommandListsExp_id,
 };
 
-inline constexpr size_t kPtiViewKindCount = 13;
+inline constexpr size_t kPtiViewKindCount = 14;
 
 template <typename T, typename M>
 inline void EnableAllIndividualApis(M& mtx, T& map) {
@@ -310,6 +314,7 @@ struct PtiViewRecordHandler {
   virtual ~PtiViewRecordHandler() { CleanUp(); }
 
   inline pti_result FlushBuffers() {
+    api_summary_.TakeAll(InsertApiSummaryRecord);
     auto result = consumer_.Push([this]() mutable {
       view_buffers_.ForEach([this](const auto&, auto&& buffer) {
         if (!buffer.IsNull()) {
@@ -435,6 +440,7 @@ struct PtiViewRecordHandler {
     bool valid = true;
     if ((view_kind == pti_view_kind::PTI_VIEW_INVALID) ||
         (view_kind == pti_view_kind::PTI_VIEW_RESERVED) ||
+        (view_kind == pti_view_kind::PTI_VIEW_API_SUMMARY) ||  // follows the API views
         (static_cast<uint32_t>(view_kind) >= kPtiViewKindCount)) {
       valid = false;
     }
@@ -604,59 +610,50 @@ struct PtiViewRecordHandler {
   }
 
   inline pti_result PushExternalKindId(pti_view_external_kind external_kind, uint64_t external_id) {
-    pti_result result = pti_result::PTI_SUCCESS;
     SPDLOG_TRACE("In {}, ext_id: {}, ext_kind: {}", __FUNCTION__, external_id,
                  static_cast<uint32_t>(external_kind));
+    const auto kind = static_cast<size_t>(external_kind);
+    if (kind >= kExternalKindCount) {
+      return pti_result::PTI_ERROR_BAD_ARGUMENT;
+    }
 
-    pti_view_record_external_correlation record{};
-    record._external_id = external_id;
-    record._external_kind = external_kind;
-    thread_local_map_ext_corrid_vectors[{external_kind}].push(record);
-
-    return result;
+    auto& stacks = thread_local_ext_corrid_stacks;
+    stacks.active[kind].Push(external_id);
+    stacks.active_mask |= (1u << kind);
+    return pti_result::PTI_SUCCESS;
   }
 
   inline pti_result PopExternalKindId(pti_view_external_kind external_kind,
                                       uint64_t* p_external_id) {
-    auto result = pti_result::PTI_SUCCESS;
-    auto it = thread_local_map_ext_corrid_vectors.find({external_kind});
-    if (it != thread_local_map_ext_corrid_vectors.cend()) {
-      // Optimization: Only copy full record if we'll need it for deferred_erase (rare case)
-      // Check before pop if stack will be empty AND we're in subscriber callback
-      const bool will_need_full_record =
-          (it->second.size() == 1) && thread_local_is_within_subscriber_callback;
-
-      if (will_need_full_record) {
-        // RARE case: Make full copy for deferred_erase
-        const auto ext_record = it->second.top();
-        SPDLOG_TRACE("In {}, ext_id: {} ext_kind: {}", __FUNCTION__, ext_record._external_id,
-                     static_cast<uint32_t>(external_kind));
-        if (p_external_id != nullptr) {
-          *p_external_id = ext_record._external_id;
-        }
-        it->second.pop();
+    const auto kind = static_cast<size_t>(external_kind);
+    if (kind >= kExternalKindCount) {
+      return pti_result::PTI_ERROR_BAD_ARGUMENT;
+    }
+
+    auto& stacks = thread_local_ext_corrid_stacks;
+    auto& stack = stacks.active[kind];
+    if (stack.Empty()) {
+      SPDLOG_TRACE("In {}, External ID Queue is empty", __FUNCTION__);
+      return pti_result::PTI_ERROR_EXTERNAL_ID_QUEUE_EMPTY;
+    }
+
+    const uint64_t external_id = stack.Top();
+    SPDLOG_TRACE("In {}, ext_id: {} ext_kind: {}", __FUNCTION__, external_id,
+                 static_cast<uint32_t>(external_kind));
+    if (p_external_id != nullptr) {
+      *p_external_id = external_id;
+    }
+    stack.Pop();
+    if (stack.Empty()) {
+      stacks.active_mask &= ~(1u << kind);
+      if (thread_local_is_within_subscriber_callback) {
         SPDLOG_TRACE("In {}, Deferring erase of External Kind: {}, id: {}", __func__,
-                     static_cast<uint32_t>(external_kind), ext_record._external_id);
-        thread_local_map_ext_corrid_vectors_deferred_erase[{external_kind}].push(ext_record);
-        thread_local_map_ext_corrid_vectors.erase(it);
-      } else {
-        // TYPICAL case: Only extract the ID field we need (avoids copying full record)
-        const uint64_t external_id = it->second.top()._external_id;
-        SPDLOG_TRACE("In {}, ext_id: {} ext_kind: {}", __FUNCTION__, external_id,
-                     static_cast<uint32_t>(external_kind));
-        if (p_external_id != nullptr) {
-          *p_external_id = external_id;
-        }
-        it->second.pop();
-        if (it->second.empty()) {
-          thread_local_map_ext_corrid_vectors.erase(it);
-        }
+                     static_cast<uint32_t>(external_kind), external_id);
+        stacks.deferred[kind] = external_id;
+        stacks.deferred_mask |= (1u << kind);
       }
-    } else {
-      SPDLOG_TRACE("In {}, External ID Queue is empty", __FUNCTION__);
-      result = pti_result::PTI_ERROR_EXTERNAL_ID_QUEUE_EMPTY;
     }
-    return result;
+    return pti_result::PTI_SUCCESS;
   }
 
   inline const char* InsertKernel(const std::string& name) {
@@ -771,6 +768,96 @@ struct PtiViewRecordHandler {
     }
     return pti_result::PTI_ERROR_INTERNAL;
   }
+
+  inline pti_result SetSamplingPolicy(const pti_view_sampling_policy* policy) {
+    if (!policy) return pti_result::PTI_ERROR_BAD_ARGUMENT;
+    utils::KernelSamplingMode mode = utils::KernelSamplingMode::kNone;
+    switch (policy->_mode) {
+      case pti_view_sampling_mode::PTI_VIEW_SAMPLING_MODE_NONE:
+        break;
+      case pti_view_sampling_mode::PTI_VIEW_SAMPLING_MODE_EVERY_NTH:
+        mode = utils::KernelSamplingMode::kEveryNth;
+        break;
+      case pti_view_sampling_mode::PTI_VIEW_SAMPLING_MODE_RESERVOIR:
+        mode = utils::KernelSamplingMode::kReservoir;
+        break;
+      default:
+        return pti_result::PTI_ERROR_BAD_ARGUMENT;
+    }
+    if (!collector_) return pti_result::PTI_ERROR_INTERNAL;
+    collector_->SetKernelSamplingPolicy(mode, policy->_rate);
+    return pti_result::PTI_SUCCESS;
+  }
+
+  inline pti_result GetSamplingCounts(const char* kernel_name, pti_view_sampling_counts* counts) {
+    if (!counts) return pti_result::PTI_ERROR_BAD_ARGUMENT;
+    if (!collector_) return pti_result::PTI_ERROR_INTERNAL;
+    utils::KernelLaunchCount count = collector_->GetKernelLaunchCount(kernel_name);
+    counts->_launched = count.launched;
+    counts->_traced = count.traced;
+    return pti_result::PTI_SUCCESS;
+  }
+
+  inline pti_result EnableSummary(bool enable) {
+    summary_enabled_ = enable;
+    return pti_result::PTI_SUCCESS;
+  }
+
+  inline bool IsSummaryEnabled() const { return summary_enabled_.load(std::memory_order_relaxed); }
+
+  inline void AddKernelSummary(const ZeKernelCommandExecutionRecord& rec) {
+    uint64_t duration = rec.end_time_ > rec.start_time_ ? rec.end_time_ - rec.start_time_ : 0;
+    kernel_summary_.Add(rec.name_, static_cast<pti_device_handle_t>(rec.device_), rec.queue_,
+                        duration);
+  }
+
+  inline pti_result GetSummary(pti_view_kernel_summary* summaries, size_t* count) {
+    if (!count) return pti_result::PTI_ERROR_BAD_ARGUMENT;
+    size_t capacity = *count;
+    size_t written = 0;
+    kernel_summary_.ForEach([&](const char* name, pti_device_handle_t device,
+                                pti_backend_queue_t queue,
+                                const pti::view::KernelSummaryEntry& entry) {
+      if (summaries == nullptr) {
+        written++;
+        return;
+      }
+      if (written == capacity) {
+        return;
+      }
+      pti_view_kernel_summary& summary = summaries[written++];
+      summary._name = name;
+      summary._device_handle = device;
+      summary._queue_handle = queue;
+      summary._count = entry.count;
+      summary._total_duration = entry.total;
+      summary._min_duration = entry.min;
+      summary._max_duration = entry.max;
+      summary._p50_duration = entry.histogram.GetValueAtPercentile(50.0);
+      summary._p90_duration = entry.histogram.GetValueAtPercentile(90.0);
+      summary._p99_duration = entry.histogram.GetValueAtPercentile(99.0);
+    });
+    *count = written;
+    return pti_result::PTI_SUCCESS;
+  }
+
+  inline pti_result SetApiSummaryPolicy(const pti_view_api_summary_policy* policy) {
+    if (!policy) return pti_result::PTI_ERROR_BAD_ARGUMENT;
+    api_summary_.SetPolicy(policy->_record_rate, policy->_flush_interval);
+    api_summary_enabled_ = policy->_enable != 0;
+    return pti_result::PTI_SUCCESS;
+  }
+
+  inline bool IsApiSummaryEnabled() const {
+    return api_summary_enabled_.load(std::memory_order_relaxed);
+  }
+
+  // Returns true if the call is to be reported as a record as well
+  inline bool AddApiSummary(pti_api_group_id group, const ZeKernelCommandExecutionRecord& rec) {
+    return api_summary_.Add(group, rec.callback_id_, rec.tid_, rec.start_time_, rec.end_time_,
+                            InsertApiSummaryRecord);
+  }
+
   inline uint64_t GetUserTimestamp() { return (*user_provided_ts_func_ptr_.load())(); }
 
   inline int64_t GetTimeShift() {
@@ -904,6 +991,10 @@ struct PtiViewRecordHandler {
 
   KernelNameStorageQueue kernel_name_storage_;
   ViewBufferTable view_buffers_;
+  std::atomic<bool> summary_enabled_ = false;  // kernels aggregated instead of reported as records
+  pti::view::KernelSummary kernel_summary_;
+  std::atomic<bool> api_summary_enabled_ = false;  // API calls aggregated instead of reported
+  pti::view::ApiSummary api_summary_;
   pti::view::BufferConsumer consumer_ = {};  // Starts thread
   std::atomic<pti_fptr_get_timestamp> user_provided_ts_func_ptr_ = nullptr;
   int64_t ts_shift_ = 0;  // conversion factor for switching from default clock to user provided
@@ -984,30 +1075,38 @@ inline void GetDeviceId(char* buf, const ze_pci_ext_properties_t& pci_prop_) {
                 pci_prop_.address.bus, pci_prop_.address.device, pci_prop_.address.function);
 }
 
+inline void InsertExternalCorrelationRecord(size_t kind, uint64_t external_id,
+                                            const ZeKernelCommandExecutionRecord& rec) {
+  pti_view_record_external_correlation ext_record{};
+  ext_record._view_kind._view_kind = pti_view_kind::PTI_VIEW_EXTERNAL_CORRELATION;
+  ext_record._correlation_id = rec.cid_;
+  ext_record._external_id = external_id;
+  ext_record._external_kind = static_cast<pti_view_external_kind>(kind);
+  Instance().InsertRecord(ext_record, rec.tid_);
+}
+
 inline void GenerateExternalCorrelationRecords(const ZeKernelCommandExecutionRecord& rec) {
-  // Process active external correlation stacks
-  for (const auto& kv : thread_local_map_ext_corrid_vectors) {
-    const auto& stack = kv.second;
-    auto ext_record = stack.top();  // copy for modification
-    ext_record._correlation_id = rec.cid_;
-    ext_record._view_kind._view_kind = pti_view_kind::PTI_VIEW_EXTERNAL_CORRELATION;
-    Instance().InsertRecord(ext_record, rec.tid_);
+  auto& stacks = thread_local_ext_corrid_stacks;
+  if ((stacks.active_mask | stacks.deferred_mask) == 0) {
+    return;
   }
 
-  // Process deferred-erase external correlation stacks
-  for (const auto& kv : thread_local_map_ext_corrid_vectors_deferred_erase) {
-    const auto& stack = kv.second;
-    if (stack.empty()) {
-      continue;
+  // Process active external correlation stacks, in the order of kinds
+  for (size_t kind = 0; kind < kExternalKindCount; ++kind) {
+    if (stacks.active_mask & (1u << kind)) {
+      InsertExternalCorrelationRecord(kind, stacks.active[kind].Top(), rec);
     }
-    auto ext_record = stack.top();  // copy for modification
-    ext_record._correlation_id = rec.cid_;
-    ext_record._view_kind._view_kind = pti_view_kind::PTI_VIEW_EXTERNAL_CORRELATION;
-    SPDLOG_TRACE("In {}, processing deferred ext records pop - External Kind: {}, id: {}", __func__,
-                 static_cast<uint32_t>(ext_record._external_kind), ext_record._external_id);
-    Instance().InsertRecord(ext_record, rec.tid_);
   }
-  thread_local_map_ext_corrid_vectors_deferred_erase.clear();
+
+  // Process deferred-erase external correlation ids
+  for (size_t kind = 0; kind < kExternalKindCount; ++kind) {
+    if (stacks.deferred_mask & (1u << kind)) {
+      SPDLOG_TRACE("In {}, processing deferred ext records pop - External Kind: {}, id: {}",
+                   __func__, kind, stacks.deferred[kind]);
+      InsertExternalCorrelationRecord(kind, stacks.deferred[kind], rec);
+    }
+  }
+  stacks.deferred_mask = 0;
 }
 
 template <typename T>
@@ -1306,8 +1405,35 @@ inline void ZeDriverEvent(void* /*data*/, const ZeKernelCommandExecutionRecord&
   Instance().InsertRecord(record, record._thread_id);
 }
 
+inline void InsertApiSummaryRecord(const pti::view::ApiSummary::Interval& interval,
+                                   const pti::view::DurationSummary& durations) {
+  pti_view_record_api_summary record{};
+  record._view_kind._view_kind = pti_view_kind::PTI_VIEW_API_SUMMARY;
+
+  int64_t ts_shift = Instance().GetTimeShift();
+
+  record._start_timestamp = ApplyTimeShift(interval.start, ts_shift);
+  record._end_timestamp = ApplyTimeShift(interval.end, ts_shift);
+  record._api_group = interval.group;
+  record._api_id = interval.api_id;
+  record._process_id = utils::GetPid();
+  record._thread_id = interval.thread_id;
+  record._count = durations.count;
+  record._total_duration = durations.total;
+  record._min_duration = durations.min;
+  record._max_duration = durations.max;
+  record._p50_duration = durations.histogram.GetValueAtPercentile(50.0);
+  record._p90_duration = durations.histogram.GetValueAtPercentile(90.0);
+  record._p99_duration = durations.histogram.GetValueAtPercentile(99.0);
+  Instance().InsertRecord(record, record._thread_id);
+}
+
 inline void SyclRuntimeViewCallback(void* data, ZeKernelCommandExecutionRecord& rec) {
   if (GetApiViewState(pti_view_kind::PTI_VIEW_RUNTIME_API)) {
+    if (Instance().IsApiSummaryEnabled() &&
+        !Instance().AddApiSummary(pti_api_group_id::PTI_API_GROUP_SYCL, rec)) {
+      return;
+    }
     SyclRuntimeEvent(data, rec);
   }
 }
@@ -1321,7 +1447,11 @@ inline void OverheadCollectionCallback(void* data, ZeKernelCommandExecutionRecor
 inline void ZeKernelRecordHandler(void* /*data*/, const ZeKernelCommandExecutionRecord& rec) {
   SPDLOG_TRACE("In {}, callback_id: {}, name: {}", __func__, rec.callback_id_, rec.name_);
   if (GetApiViewState(pti_view_kind::PTI_VIEW_DEVICE_GPU_KERNEL)) {
-    KernelEvent(rec);
+    if (Instance().IsSummaryEnabled()) {
+      Instance().AddKernelSummary(rec);
+    } else {
+      KernelEvent(rec);
+    }
   }
 }
 
@@ -1400,6 +1530,10 @@ inline void ZeKernelStagesCallback(void* data,
 inline void ZeApiCallsCallback([[maybe_unused]] void* data,
                                [[maybe_unused]] ZeKernelCommandExecutionRecord& rec) {
   if (GetApiViewState(pti_view_kind::PTI_VIEW_DRIVER_API)) {
+    if (Instance().IsApiSummaryEnabled() &&
+        !Instance().AddApiSummary(pti_api_group_id::PTI_API_GROUP_LEVELZERO, rec)) {
+      return;
+    }
     ZeDriverEvent(data, rec);
   }
 }
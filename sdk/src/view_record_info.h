@@ -12,7 +12,7 @@
 #include "pti/pti_view.h"
 
 inline constexpr auto kReserved = 0;
-inline constexpr auto kSizeOfViewRecordTable = 13;
+inline constexpr auto kSizeOfViewRecordTable = 14;
 
 // kViewSizeLookUpTable
 //
@@ -35,6 +35,7 @@ inline constexpr std::array<std::size_t, kSizeOfViewRecordTable> kViewSizeLookup
     sizeof(pti_view_record_memory_copy_p2p_v2),       // PTI_VIEW_DEVICE_GPU_MEM_COPY_P2P
     sizeof(pti_view_record_synchronization),          // PTI_VIEW_DEVICE_SYNCHRONIZATION
     sizeof(pti_view_record_comms),                    // PTI_VIEW_COMMUNICATION
+    sizeof(pti_view_record_api_summary),              // PTI_VIEW_API_SUMMARY
 };
 
 // clang-format on
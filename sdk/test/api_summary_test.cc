@@ -0,0 +1,195 @@
+//==============================================================
+// Copyright (C) Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+// =============================================================
+
+#include "api_summary.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+struct SummaryRow {
+  pti_api_group_id group;
+  uint32_t api_id;
+  uint32_t thread_id;
+  uint64_t start;
+  uint64_t end;
+  uint64_t count;
+  uint64_t total;
+  uint64_t min;
+  uint64_t max;
+
+  bool operator<(const SummaryRow& other) const {
+    return std::tie(thread_id, group, api_id, start) <
+           std::tie(other.thread_id, other.group, other.api_id, other.start);
+  }
+};
+
+struct RowCollector {
+  std::mutex lock;
+  std::vector<SummaryRow> rows;
+
+  void operator()(const pti::view::ApiSummary::Interval& interval,
+                  const pti::view::DurationSummary& durations) {
+    std::lock_guard<std::mutex> guard(lock);
+    rows.push_back({interval.group, interval.api_id, interval.thread_id, interval.start,
+                    interval.end, durations.count, durations.total, durations.min,
+                    durations.max});
+  }
+
+  std::vector<SummaryRow> Take() {
+    std::lock_guard<std::mutex> guard(lock);
+    std::vector<SummaryRow> taken;
+    taken.swap(rows);
+    std::sort(taken.begin(), taken.end());
+    return taken;
+  }
+};
+
+constexpr auto kLevelZero = pti_api_group_id::PTI_API_GROUP_LEVELZERO;
+constexpr auto kSycl = pti_api_group_id::PTI_API_GROUP_SYCL;
+
+}  // namespace
+
+TEST(ApiSummaryTest, AggregatesPerApi) {
+  pti::view::ApiSummary summary;
+  RowCollector collector;
+  auto take = [&collector](const auto& interval, const auto& durations) {
+    collector(interval, durations);
+  };
+
+  summary.Add(kLevelZero, 1, 7, 100, 110, take);
+  summary.Add(kLevelZero, 1, 7, 200, 230, take);
+  summary.Add(kLevelZero, 2, 7, 300, 305, take);
+  summary.Add(kSycl, 1, 7, 400, 420, take);
+  EXPECT_TRUE(collector.Take().empty());  // no flush interval
+
+  summary.TakeAll(take);
+  auto rows = collector.Take();
+  ASSERT_EQ(rows.size(), 3u);
+
+  EXPECT_EQ(rows[0].group, kLevelZero);
+  EXPECT_EQ(rows[0].api_id, 1u);
+  EXPECT_EQ(rows[0].thread_id, 7u);
+  EXPECT_EQ(rows[0].start, 100u);
+  EXPECT_EQ(rows[0].end, 230u);
+  EXPECT_EQ(rows[0].count, 2u);
+  EXPECT_EQ(rows[0].total, 40u);
+  EXPECT_EQ(rows[0].min, 10u);
+  EXPECT_EQ(rows[0].max, 30u);
+
+  EXPECT_EQ(rows[1].group, kLevelZero);
+  EXPECT_EQ(rows[1].api_id, 2u);
+  EXPECT_EQ(rows[1].count, 1u);
+
+  EXPECT_EQ(rows[2].group, kSycl);
+  EXPECT_EQ(rows[2].api_id, 1u);
+  EXPECT_EQ(rows[2].total, 20u);
+
+  // Taken summaries are not reported again
+  summary.TakeAll(take);
+  EXPECT_TRUE(collector.Take().empty());
+}
+
+TEST(ApiSummaryTest, SamplesEveryNthCallPerApi) {
+  pti::view::ApiSummary summary;
+  summary.SetPolicy(3, 0);
+  auto take = [](const auto&, const auto&) {};
+
+  std::vector<uint32_t> recorded;
+  for (uint32_t i = 0; i < 7; ++i) {
+    if (summary.Add(kLevelZero, 1, 7, i * 10, i * 10 + 1, take)) {
+      recorded.push_back(i);
+    }
+    // Another API does not advance the sampling of the first one
+    summary.Add(kLevelZero, 2, 7, i * 10 + 2, i * 10 + 3, take);
+  }
+  EXPECT_EQ(recorded, (std::vector<uint32_t>{0, 3, 6}));
+
+  // Sampling spans takes
+  summary.TakeAll(take);
+  EXPECT_FALSE(summary.Add(kLevelZero, 1, 7, 100, 101, take));
+  EXPECT_FALSE(summary.Add(kLevelZero, 1, 7, 110, 111, take));
+  EXPECT_TRUE(summary.Add(kLevelZero, 1, 7, 120, 121, take));
+
+  summary.SetPolicy(0, 0);
+  for (uint32_t i = 0; i < 10; ++i) {
+    EXPECT_FALSE(summary.Add(kLevelZero, 3, 7, 200 + i, 201 + i, take));
+  }
+}
+
+TEST(ApiSummaryTest, TakesAtFlushInterval) {
+  pti::view::ApiSummary summary;
+  summary.SetPolicy(0, 1000);
+  RowCollector collector;
+  auto take = [&collector](const auto& interval, const auto& durations) {
+    collector(interval, durations);
+  };
+
+  summary.Add(kLevelZero, 1, 7, 1000, 1010, take);
+  summary.Add(kLevelZero, 1, 7, 1500, 1510, take);
+  EXPECT_TRUE(collector.Take().empty());
+
+  // Interval due, the call is included
+  summary.Add(kLevelZero, 1, 7, 1995, 2005, take);
+  auto rows = collector.Take();
+  ASSERT_EQ(rows.size(), 1u);
+  EXPECT_EQ(rows[0].count, 3u);
+  EXPECT_EQ(rows[0].start, 1000u);
+  EXPECT_EQ(rows[0].end, 2005u);
+
+  // Next interval starts at the end of the call that took the last one
+  summary.Add(kLevelZero, 1, 7, 2500, 2600, take);
+  EXPECT_TRUE(collector.Take().empty());
+  summary.Add(kLevelZero, 1, 7, 3000, 3010, take);
+  rows = collector.Take();
+  ASSERT_EQ(rows.size(), 1u);
+  EXPECT_EQ(rows[0].count, 2u);
+  EXPECT_EQ(rows[0].start, 2500u);
+  EXPECT_EQ(rows[0].max, 100u);
+}
+
+TEST(ApiSummaryTest, KeepsThreadsApart) {
+  constexpr uint32_t kThreads = 4;
+  constexpr uint64_t kCalls = 10000;
+  pti::view::ApiSummary summary;
+  summary.SetPolicy(0, 50000);
+  RowCollector collector;
+  auto take = [&collector](const auto& interval, const auto& durations) {
+    collector(interval, durations);
+  };
+
+  std::vector<std::thread> threads;
+  for (uint32_t t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&summary, &take, t]() {
+      for (uint64_t i = 0; i < kCalls; ++i) {
+        summary.Add(kLevelZero, 1, t + 1, i * 10, i * 10 + t + 1, take);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  summary.TakeAll(take);
+
+  std::vector<uint64_t> counts(kThreads, 0);
+  for (const auto& row : collector.Take()) {
+    ASSERT_GE(row.thread_id, 1u);
+    ASSERT_LE(row.thread_id, kThreads);
+    EXPECT_EQ(row.min, row.thread_id);
+    EXPECT_EQ(row.max, row.thread_id);
+    counts[row.thread_id - 1] += row.count;
+  }
+  for (uint32_t t = 0; t < kThreads; ++t) {
+    EXPECT_EQ(counts[t], kCalls);
+  }
+}
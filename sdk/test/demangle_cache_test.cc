@@ -0,0 +1,63 @@
+//==============================================================
+// Copyright (C) Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+// =============================================================
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "demangle.h"
+
+TEST(DemangleCacheTest, ReturnsSameInternedName) {
+  std::string_view first = utils::DemangleCached("_Z3fooIiEvT_");
+  std::string_view second = utils::DemangleCached("_Z3fooIiEvT_");
+  EXPECT_EQ(first, utils::Demangle("_Z3fooIiEvT_"));
+  EXPECT_EQ(first.data(), second.data());
+}
+
+TEST(DemangleCacheTest, KeepsNamesThatAreNotMangled) {
+  EXPECT_EQ(utils::DemangleCached("GEMM"), "GEMM");
+}
+
+TEST(DemangleCacheTest, ConcurrentLookupsAgree) {
+  constexpr int kThreads = 8;
+  constexpr int kNames = 256;
+  std::vector<std::vector<std::string_view>> results(kThreads);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([t, &results]() {
+      for (int i = 0; i < kNames; ++i) {
+        std::string mangled = "_Z3barILi" + std::to_string(i) + "EEvv";
+        results[t].push_back(utils::DemangleCached(mangled.c_str()));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (int t = 1; t < kThreads; ++t) {
+    for (int i = 0; i < kNames; ++i) {
+      EXPECT_EQ(results[t][i].data(), results[0][i].data());
+    }
+  }
+}
+
+TEST(DemangleCacheTest, ShortenNameCollapsesInnermostLists) {
+  const std::string name =
+      "void ns::kernel<std::tuple<int, float>, sycl::accessor<int, 1>>(sycl::nd_item<1>, int)";
+  EXPECT_EQ(utils::ShortenName(name, name.size()), name);
+  EXPECT_EQ(utils::ShortenName(name, 80),
+            "void ns::kernel<std::tuple<...>, sycl::accessor<...>>(sycl::nd_item<...>, int)");
+  EXPECT_EQ(utils::ShortenName(name, 40), "void ns::kernel<...>(...)");
+}
+
+TEST(DemangleCacheTest, ShortenNameTruncatesWhenCollapsingIsNotEnough) {
+  const std::string name = "very_long_kernel_name_without_any_template_arguments";
+  std::string shortened = utils::ShortenName(name, 20);
+  EXPECT_EQ(shortened.size(), 20u);
+  EXPECT_EQ(shortened, name.substr(0, 17) + "...");
+}
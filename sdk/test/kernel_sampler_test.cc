@@ -0,0 +1,170 @@
+//==============================================================
+// Copyright (C) Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+// =============================================================
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "kernel_sampler.h"
+
+namespace {
+
+// Stands in for a collector: launches kernels, times only the sampled launches and keeps the
+// estimate of the total time of every kernel.
+class MockCollector {
+ public:
+  MockCollector(utils::KernelSamplingMode mode, uint32_t rate) : sampler_(mode, rate) {}
+
+  void Launch(const std::string& name, uint64_t time) {
+    exact_time_[name] += time;
+    double weight = sampler_.Sample(name);
+    if (weight > 0.0) {
+      estimates_[name].Add(static_cast<double>(time), weight);
+    }
+  }
+
+  const utils::KernelSampler<std::string>& GetSampler() const { return sampler_; }
+  uint64_t GetExactTime(const std::string& name) { return exact_time_[name]; }
+  const utils::SampledTotal& GetEstimate(const std::string& name) { return estimates_[name]; }
+
+ private:
+  utils::KernelSampler<std::string> sampler_;
+  std::map<std::string, uint64_t> exact_time_;
+  std::map<std::string, utils::SampledTotal> estimates_;
+};
+
+// Kernel time varying with the launch, deterministic
+uint64_t GetKernelTime(uint64_t launch) { return 1000 + (launch * 7919) % 500; }
+
+}  // namespace
+
+TEST(KernelSamplerTest, TracesEveryLaunchWhenDisabled) {
+  MockCollector collector(utils::KernelSamplingMode::kNone, 0);
+  for (uint64_t i = 0; i < 100; ++i) {
+    collector.Launch("GEMM", GetKernelTime(i));
+  }
+  EXPECT_FALSE(collector.GetSampler().IsEnabled());
+  EXPECT_DOUBLE_EQ(collector.GetEstimate("GEMM").total,
+                   static_cast<double>(collector.GetExactTime("GEMM")));
+  EXPECT_DOUBLE_EQ(collector.GetEstimate("GEMM").variance, 0.0);
+}
+
+TEST(KernelSamplerTest, RateBelowTwoDisablesSampling) {
+  utils::KernelSampler<std::string> sampler(utils::KernelSamplingMode::kEveryNth, 1);
+  EXPECT_FALSE(sampler.IsEnabled());
+  EXPECT_EQ(sampler.GetMode(), utils::KernelSamplingMode::kNone);
+}
+
+TEST(KernelSamplerTest, EveryNthTracesFirstLaunchOfEachGroup) {
+  utils::KernelSampler<std::string> sampler(utils::KernelSamplingMode::kEveryNth, 4);
+  std::vector<uint64_t> traced;
+  for (uint64_t i = 0; i < 10; ++i) {
+    double weight = sampler.Sample("GEMM");
+    if (weight > 0.0) {
+      EXPECT_DOUBLE_EQ(weight, 4.0);
+      traced.push_back(i);
+    }
+  }
+  EXPECT_EQ(traced, (std::vector<uint64_t>{0, 4, 8}));
+  utils::KernelLaunchCount count = sampler.GetCount("GEMM");
+  EXPECT_EQ(count.launched, 10u);
+  EXPECT_EQ(count.traced, 3u);
+}
+
+TEST(KernelSamplerTest, CountsKernelsSeparately) {
+  utils::KernelSampler<std::string> sampler(utils::KernelSamplingMode::kEveryNth, 3);
+  for (int i = 0; i < 9; ++i) {
+    EXPECT_EQ(sampler.Sample("A") > 0.0, i % 3 == 0);
+    EXPECT_EQ(sampler.Sample("B") > 0.0, i % 3 == 0);
+  }
+  EXPECT_EQ(sampler.Sample("C"), 3.0);
+
+  EXPECT_EQ(sampler.GetCount("A").launched, 9u);
+  EXPECT_EQ(sampler.GetCount("B").traced, 3u);
+  EXPECT_EQ(sampler.GetCount("D").launched, 0u);
+  EXPECT_EQ(sampler.GetCounts().size(), 3u);
+  utils::KernelLaunchCount total = sampler.GetTotalCount();
+  EXPECT_EQ(total.launched, 19u);
+  EXPECT_EQ(total.traced, 7u);
+}
+
+TEST(KernelSamplerTest, ReservoirTracesFirstLaunchesThenFewer) {
+  constexpr uint64_t kLaunches = 100000;
+  constexpr uint32_t kRate = 100;
+  MockCollector collector(utils::KernelSamplingMode::kReservoir, kRate);
+  for (uint64_t i = 0; i < kLaunches; ++i) {
+    collector.Launch("GEMM", GetKernelTime(i));
+  }
+
+  utils::KernelLaunchCount count = collector.GetSampler().GetCount("GEMM");
+  EXPECT_EQ(count.launched, kLaunches);
+  // expected number of traced launches is rate * (1 + ln(launches / rate))
+  double expected = kRate * (1.0 + std::log(static_cast<double>(kLaunches) / kRate));
+  EXPECT_GT(count.traced, expected * 0.7);
+  EXPECT_LT(count.traced, expected * 1.3);
+
+  const utils::SampledTotal& estimate = collector.GetEstimate("GEMM");
+  double exact = static_cast<double>(collector.GetExactTime("GEMM"));
+  EXPECT_NEAR(estimate.weight, static_cast<double>(kLaunches), kLaunches * 0.2);
+  EXPECT_GT(estimate.GetErrorBound(), 0.0);
+  EXPECT_LT(std::abs(estimate.total - exact), 2.0 * estimate.GetErrorBound());
+}
+
+TEST(KernelSamplerTest, EveryNthEstimateIsWithinErrorBound) {
+  constexpr uint64_t kLaunches = 10000;
+  MockCollector collector(utils::KernelSamplingMode::kEveryNth, 10);
+  for (uint64_t i = 0; i < kLaunches; ++i) {
+    collector.Launch("GEMM", GetKernelTime(i));
+  }
+
+  const utils::SampledTotal& estimate = collector.GetEstimate("GEMM");
+  double exact = static_cast<double>(collector.GetExactTime("GEMM"));
+  EXPECT_DOUBLE_EQ(estimate.weight, static_cast<double>(kLaunches));
+  EXPECT_LT(std::abs(estimate.total - exact), estimate.GetErrorBound());
+}
+
+TEST(KernelSamplerTest, ReservoirDecisionsAreDeterministic) {
+  utils::KernelSampler<std::string> first(utils::KernelSamplingMode::kReservoir, 8);
+  utils::KernelSampler<std::string> second(utils::KernelSamplingMode::kReservoir, 8);
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_EQ(first.Sample("GEMM"), second.Sample("GEMM"));
+  }
+}
+
+TEST(KernelSamplerTest, SetPolicyRestartsCounting) {
+  utils::KernelSampler<std::string> sampler(utils::KernelSamplingMode::kEveryNth, 2);
+  sampler.Sample("GEMM");
+  sampler.Sample("GEMM");
+  sampler.SetPolicy(utils::KernelSamplingMode::kEveryNth, 5);
+  EXPECT_EQ(sampler.GetCount("GEMM").launched, 0u);
+  EXPECT_DOUBLE_EQ(sampler.Sample("GEMM"), 5.0);
+  EXPECT_EQ(sampler.GetRate(), 5u);
+}
+
+TEST(KernelSamplerTest, ConcurrentLaunchesAreCountedExactly) {
+  constexpr int kThreads = 8;
+  constexpr int kLaunches = 10000;
+  utils::KernelSampler<uint64_t> sampler(utils::KernelSamplingMode::kEveryNth, 16);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&sampler]() {
+      for (int i = 0; i < kLaunches; ++i) {
+        sampler.Sample(static_cast<uint64_t>(i % 5));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  utils::KernelLaunchCount total = sampler.GetTotalCount();
+  EXPECT_EQ(total.launched, static_cast<uint64_t>(kThreads) * kLaunches);
+  EXPECT_EQ(total.traced, 5u * ((kThreads * kLaunches / 5 + 15) / 16));
+}
@@ -0,0 +1,180 @@
+//==============================================================
+// Copyright (C) Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+// =============================================================
+
+#include "kernel_summary.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct SummaryRow {
+  std::string name;
+  pti_device_handle_t device;
+  pti_backend_queue_t queue;
+  uint64_t count;
+  uint64_t total;
+  uint64_t min;
+  uint64_t max;
+  uint64_t p50;
+  uint64_t p99;
+};
+
+std::vector<SummaryRow> GetRows(pti::view::KernelSummary& summary) {
+  std::vector<SummaryRow> rows;
+  summary.ForEach([&rows](const char* name, pti_device_handle_t device, pti_backend_queue_t queue,
+                          const pti::view::KernelSummaryEntry& entry) {
+    rows.push_back({name, device, queue, entry.count, entry.total, entry.min, entry.max,
+                    entry.histogram.GetValueAtPercentile(50.0),
+                    entry.histogram.GetValueAtPercentile(99.0)});
+  });
+  return rows;
+}
+
+// Device and queue handles are opaque, only compared
+pti_device_handle_t kDevice0 = reinterpret_cast<pti_device_handle_t>(0x1000);
+pti_device_handle_t kDevice1 = reinterpret_cast<pti_device_handle_t>(0x2000);
+pti_backend_queue_t kQueue0 = reinterpret_cast<pti_backend_queue_t>(0x3000);
+
+}  // namespace
+
+TEST(LatencyHistogramTest, EmptyHistogramReturnsZero) {
+  pti::view::LatencyHistogram histogram;
+  EXPECT_EQ(histogram.GetCount(), 0u);
+  EXPECT_EQ(histogram.GetValueAtPercentile(50.0), 0u);
+}
+
+TEST(LatencyHistogramTest, SmallValuesAreExact) {
+  pti::view::LatencyHistogram histogram;
+  for (uint64_t value = 1; value <= 100; ++value) {
+    histogram.Record(value);
+  }
+  EXPECT_EQ(histogram.GetValueAtPercentile(50.0), 50u);
+  EXPECT_EQ(histogram.GetValueAtPercentile(99.0), 99u);
+  EXPECT_EQ(histogram.GetValueAtPercentile(100.0), 100u);
+  EXPECT_EQ(histogram.GetValueAtPercentile(0.0), 1u);
+}
+
+TEST(LatencyHistogramTest, LargeValuesAreWithinRelativeError) {
+  pti::view::LatencyHistogram histogram;
+  std::vector<uint64_t> values;
+  for (uint64_t i = 0; i < 10000; ++i) {
+    values.push_back(1000 + (i * 7919) % 10000000);
+  }
+  for (uint64_t value : values) {
+    histogram.Record(value);
+  }
+  std::sort(values.begin(), values.end());
+  for (double percentile : {10.0, 50.0, 90.0, 99.0, 99.9}) {
+    auto exact = values[static_cast<size_t>(percentile / 100.0 * values.size() + 0.5) - 1];
+    auto value = histogram.GetValueAtPercentile(percentile);
+    EXPECT_NEAR(static_cast<double>(value), static_cast<double>(exact), exact / 64.0)
+        << "percentile " << percentile;
+  }
+}
+
+TEST(LatencyHistogramTest, HandlesFullRange) {
+  pti::view::LatencyHistogram histogram;
+  histogram.Record(0);
+  histogram.Record(UINT64_MAX);
+  EXPECT_EQ(histogram.GetValueAtPercentile(50.0), 0u);
+  EXPECT_GT(histogram.GetValueAtPercentile(100.0), UINT64_MAX - UINT64_MAX / 64);
+}
+
+TEST(LatencyHistogramTest, MergeEqualsRecordingEverything) {
+  pti::view::LatencyHistogram first;
+  pti::view::LatencyHistogram second;
+  pti::view::LatencyHistogram all;
+  for (uint64_t i = 0; i < 1000; ++i) {
+    uint64_t value = 10 + i * i;
+    (i % 2 ? first : second).Record(value);
+    all.Record(value);
+  }
+  first.Merge(second);
+  EXPECT_EQ(first.GetCount(), all.GetCount());
+  for (double percentile : {1.0, 50.0, 75.0, 99.0}) {
+    EXPECT_EQ(first.GetValueAtPercentile(percentile), all.GetValueAtPercentile(percentile));
+  }
+}
+
+TEST(KernelSummaryTest, SeparatesKernelsByNameDeviceAndQueue) {
+  pti::view::KernelSummary summary;
+  summary.Add("GEMM", kDevice0, kQueue0, 100);
+  summary.Add("GEMM", kDevice0, kQueue0, 300);
+  summary.Add("GEMM", kDevice1, kQueue0, 50);
+  summary.Add("GEMM", kDevice0, nullptr, 70);
+  summary.Add("AXPY", kDevice0, kQueue0, 20);
+
+  auto rows = GetRows(summary);
+  ASSERT_EQ(rows.size(), 4u);
+  EXPECT_EQ(rows[0].name, "AXPY");
+  auto gemm = std::find_if(rows.begin(), rows.end(), [](const SummaryRow& row) {
+    return row.name == "GEMM" && row.device == kDevice0 && row.queue == kQueue0;
+  });
+  ASSERT_NE(gemm, rows.end());
+  EXPECT_EQ(gemm->count, 2u);
+  EXPECT_EQ(gemm->total, 400u);
+  EXPECT_EQ(gemm->min, 100u);
+  EXPECT_EQ(gemm->max, 300u);
+}
+
+TEST(KernelSummaryTest, MergesTablesOfAllThreads) {
+  constexpr int kThreads = 8;
+  constexpr uint64_t kKernels = 10000;
+  pti::view::KernelSummary summary;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&summary]() {
+      for (uint64_t i = 0; i < kKernels; ++i) {
+        summary.Add(i % 2 ? "A" : "B", kDevice0, kQueue0, 1 + i % 100);
+      }
+    });
+  }
+  // Merging while threads are adding must be safe
+  GetRows(summary);
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  auto rows = GetRows(summary);
+  ASSERT_EQ(rows.size(), 2u);
+  for (const auto& row : rows) {
+    EXPECT_EQ(row.count, kThreads * kKernels / 2);
+    EXPECT_EQ(row.max - row.min, 98u);
+  }
+  // "A" took even durations 2..100, "B" odd durations 1..99
+  EXPECT_EQ(rows[0].p50, 50u);
+  EXPECT_EQ(rows[1].p50, 49u);
+}
+
+TEST(KernelSummaryTest, NamesOutliveMerge) {
+  pti::view::KernelSummary summary;
+  summary.Add("GEMM", kDevice0, kQueue0, 1);
+  const char* name = nullptr;
+  summary.ForEach([&name](const char* kernel_name, auto, auto, const auto&) {
+    name = kernel_name;
+  });
+  summary.Add("AXPY", kDevice0, kQueue0, 1);
+  GetRows(summary);
+  EXPECT_STREQ(name, "GEMM");
+}
+
+TEST(KernelSummaryTest, SummariesAreIndependent) {
+  pti::view::KernelSummary first;
+  pti::view::KernelSummary second;
+  first.Add("GEMM", kDevice0, kQueue0, 1);
+  second.Add("AXPY", kDevice0, kQueue0, 2);
+  first.Add("GEMM", kDevice0, kQueue0, 3);
+  auto rows = GetRows(first);
+  ASSERT_EQ(rows.size(), 1u);
+  EXPECT_EQ(rows[0].count, 2u);
+  EXPECT_EQ(GetRows(second).size(), 1u);
+}
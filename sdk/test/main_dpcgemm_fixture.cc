@@ -1135,6 +1135,39 @@ INSTANTIATE_TEST_SUITE_P(OverflowGroup, ExternalCorrelationOverFlowSuite,
                          testing::Combine(testing::ValuesIn(kExternalKinds),
                                           testing::ValuesIn(kExternalIds)));
 
+TEST(ExternalCorrelationStackTest, ValidateDeeplyNestedIdsPopInReverseOrder) {
+  constexpr uint64_t kDepth = 100;
+  for (uint64_t id = 1; id <= kDepth; ++id) {
+    ASSERT_EQ(ptiViewPushExternalCorrelationId(PTI_VIEW_EXTERNAL_KIND_CUSTOM_0, id), PTI_SUCCESS);
+    ASSERT_EQ(ptiViewPushExternalCorrelationId(PTI_VIEW_EXTERNAL_KIND_CUSTOM_1, id * 10),
+              PTI_SUCCESS);
+  }
+  for (uint64_t id = kDepth; id >= 1; --id) {
+    uint64_t result_id = 0;
+    ASSERT_EQ(ptiViewPopExternalCorrelationId(PTI_VIEW_EXTERNAL_KIND_CUSTOM_0, &result_id),
+              PTI_SUCCESS);
+    ASSERT_EQ(result_id, id);
+  }
+  uint64_t result_id = 0;
+  EXPECT_EQ(ptiViewPopExternalCorrelationId(PTI_VIEW_EXTERNAL_KIND_CUSTOM_0, &result_id),
+            PTI_ERROR_EXTERNAL_ID_QUEUE_EMPTY);
+  // Kinds are kept apart
+  EXPECT_EQ(ptiViewPopExternalCorrelationId(PTI_VIEW_EXTERNAL_KIND_CUSTOM_1, &result_id),
+            PTI_SUCCESS);
+  EXPECT_EQ(result_id, kDepth * 10);
+  for (uint64_t id = 1; id < kDepth; ++id) {
+    ASSERT_EQ(ptiViewPopExternalCorrelationId(PTI_VIEW_EXTERNAL_KIND_CUSTOM_1, nullptr),
+              PTI_SUCCESS);
+  }
+}
+
+TEST(ExternalCorrelationStackTest, ValidateUnknownKindIsRejected) {
+  const auto unknown_kind = static_cast<pti_view_external_kind>(0x100);
+  uint64_t result_id = 0;
+  EXPECT_EQ(ptiViewPushExternalCorrelationId(unknown_kind, 1), PTI_ERROR_BAD_ARGUMENT);
+  EXPECT_EQ(ptiViewPopExternalCorrelationId(unknown_kind, &result_id), PTI_ERROR_BAD_ARGUMENT);
+}
+
 // Can be a tad easier to read than boolean.
 enum class QueueType { kImmediate, kNonImmediate };
 
@@ -1,6 +1,9 @@
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <iostream>
 #include <list>
 #include <thread>
 #include <vector>
@@ -68,3 +71,220 @@ TEST(SubscribersCollectionTest, ThreadSafetyAndIteration) {
   }
   ASSERT_EQ(count, 2 + num_threads * subs_per_thread / 2);
 }
+
+namespace {
+void CountingCallback(pti_callback_domain /*domain*/, pti_api_group_id /*driver_api_group_id*/,
+                      uint32_t /*driver_api_id*/, pti_backend_ctx_t /*backend_context*/,
+                      void* /*cb_data*/, void* global_user_data, void** /*instance_user_data*/) {
+  static_cast<std::atomic<uint64_t>*>(global_user_data)->fetch_add(1, std::memory_order_relaxed);
+}
+
+std::unique_ptr<DummySubscriber> MakeCountingSubscriber(std::atomic<uint64_t>* counter) {
+  auto subscriber = std::make_unique<DummySubscriber>();
+  subscriber->SetCallback(CountingCallback);
+  subscriber->SetUserData(counter);
+  return subscriber;
+}
+
+void CallSubscribers(const SubscribersCollection& collection, pti_callback_domain domain,
+                     pti_callback_phase phase) {
+  collection.ForEachEnabledSubscriber(domain, phase, [&](const ZeCollectorCBSubscriber& sub) {
+    sub.GetCallback()(domain, PTI_API_GROUP_LEVELZERO, 0, nullptr, nullptr, sub.GetUserData(),
+                      sub.GetPtrForInstanceUserData());
+  });
+}
+}  // namespace
+
+TEST(SubscribersCollectionTest, DomainMaskFollowsSubscribers) {
+  SubscribersCollection collection;
+  std::atomic<uint64_t> calls = 0;
+
+  auto handle = collection.AddExternalSubscriber(MakeCountingSubscriber(&calls));
+  EXPECT_FALSE(collection.IsDomainEnabled(PTI_CB_DOMAIN_DRIVER_GPU_OPERATION_APPENDED,
+                                          PTI_CB_PHASE_API_EXIT));
+
+  ASSERT_EQ(collection.EnableCallbackDomain(handle, PTI_CB_DOMAIN_DRIVER_GPU_OPERATION_APPENDED, 0,
+                                            1),
+            PTI_SUCCESS);
+  EXPECT_FALSE(collection.IsDomainEnabled(PTI_CB_DOMAIN_DRIVER_GPU_OPERATION_APPENDED,
+                                          PTI_CB_PHASE_API_ENTER));
+  EXPECT_TRUE(collection.IsDomainEnabled(PTI_CB_DOMAIN_DRIVER_GPU_OPERATION_APPENDED,
+                                         PTI_CB_PHASE_API_EXIT));
+  EXPECT_FALSE(
+      collection.IsDomainEnabled(PTI_CB_DOMAIN_DRIVER_KERNEL_CREATED, PTI_CB_PHASE_API_EXIT));
+
+  CallSubscribers(collection, PTI_CB_DOMAIN_DRIVER_GPU_OPERATION_APPENDED, PTI_CB_PHASE_API_ENTER);
+  CallSubscribers(collection, PTI_CB_DOMAIN_DRIVER_GPU_OPERATION_APPENDED, PTI_CB_PHASE_API_EXIT);
+  EXPECT_EQ(calls.load(), 1ULL);
+
+  ASSERT_EQ(collection.DisableCallbackDomain(handle, PTI_CB_DOMAIN_DRIVER_GPU_OPERATION_APPENDED),
+            PTI_SUCCESS);
+  EXPECT_FALSE(collection.IsDomainEnabled(PTI_CB_DOMAIN_DRIVER_GPU_OPERATION_APPENDED,
+                                          PTI_CB_PHASE_API_EXIT));
+
+  ASSERT_EQ(collection.EnableCallbackDomain(handle, PTI_CB_DOMAIN_DRIVER_KERNEL_CREATED, 1, 1),
+            PTI_SUCCESS);
+  ASSERT_TRUE(collection.RemoveExternalSubscriber(handle));
+  EXPECT_FALSE(
+      collection.IsDomainEnabled(PTI_CB_DOMAIN_DRIVER_KERNEL_CREATED, PTI_CB_PHASE_API_ENTER));
+  CallSubscribers(collection, PTI_CB_DOMAIN_DRIVER_KERNEL_CREATED, PTI_CB_PHASE_API_ENTER);
+  EXPECT_EQ(calls.load(), 1ULL);
+}
+
+// Callback path cost while subscribers are changed on another thread. Reports ns per call for a
+// domain no subscriber wants and for one a subscriber wants.
+TEST(SubscribersCollectionTest, CallbackPathUnderContention) {
+  constexpr int kNumThreads = 8;
+  constexpr uint64_t kCallsPerThread = 200000;
+
+  SubscribersCollection collection;
+  std::atomic<uint64_t> calls = 0;
+  std::atomic<uint64_t> toggled_calls = 0;
+
+  auto handle = collection.AddExternalSubscriber(MakeCountingSubscriber(&calls));
+  ASSERT_EQ(collection.EnableCallbackDomain(handle, PTI_CB_DOMAIN_DRIVER_GPU_OPERATION_APPENDED, 1,
+                                            1),
+            PTI_SUCCESS);
+
+  for (auto domain : {PTI_CB_DOMAIN_DRIVER_KERNEL_DESTROYED,
+                      PTI_CB_DOMAIN_DRIVER_GPU_OPERATION_APPENDED}) {
+    std::atomic<bool> stop = false;
+    std::atomic<int> ready = 0;
+
+    // Writer subscribes, enables and unsubscribes all the time
+    std::thread writer([&]() {
+      while (ready.load() < kNumThreads) {
+      }
+      while (!stop.load()) {
+        auto toggled = collection.AddInternalSubscriber(MakeCountingSubscriber(&toggled_calls));
+        collection.EnableCallbackDomain(toggled, PTI_CB_DOMAIN_DRIVER_KERNEL_CREATED, 1, 1);
+        collection.RemoveInternalSubscriber(toggled);
+      }
+    });
+
+    std::vector<std::thread> readers;
+    std::vector<double> ns_per_call(kNumThreads);
+    for (int t = 0; t < kNumThreads; ++t) {
+      readers.emplace_back([&, t]() {
+        ready++;
+        while (ready.load() < kNumThreads) {
+        }
+        auto start = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < kCallsPerThread; ++i) {
+          CallSubscribers(collection, domain, PTI_CB_PHASE_API_EXIT);
+        }
+        auto end = std::chrono::steady_clock::now();
+        ns_per_call[t] =
+            std::chrono::duration<double, std::nano>(end - start).count() / kCallsPerThread;
+      });
+    }
+    for (auto& th : readers) th.join();
+    stop = true;
+    writer.join();
+
+    double total = 0;
+    for (auto ns : ns_per_call) total += ns;
+    std::cout << "[          ] " << ptiCallbackDomainTypeToString(domain) << ": "
+              << total / kNumThreads << " ns/call on " << kNumThreads << " threads" << std::endl;
+  }
+
+  EXPECT_EQ(calls.load(), kNumThreads * kCallsPerThread);
+  EXPECT_EQ(toggled_calls.load(), 0ULL);
+  EXPECT_EQ(collection.GetSubscriberCount(), 1ULL);
+}
+
+namespace {
+struct BlockingCallbackState {
+  std::atomic<bool> entered = false;
+  std::atomic<bool> release = false;
+  std::atomic<bool> returned = false;
+};
+
+void BlockingCallback(pti_callback_domain /*domain*/, pti_api_group_id /*driver_api_group_id*/,
+                      uint32_t /*driver_api_id*/, pti_backend_ctx_t /*backend_context*/,
+                      void* /*cb_data*/, void* global_user_data, void** /*instance_user_data*/) {
+  auto* state = static_cast<BlockingCallbackState*>(global_user_data);
+  state->entered = true;
+  while (!state->release.load()) {
+    std::this_thread::yield();
+  }
+  state->returned = true;
+}
+}  // namespace
+
+// The user data of a subscriber may be freed as soon as unsubscribing or disabling returns
+TEST(SubscribersCollectionTest, RemoveAndDisableWaitForRunningCallbacks) {
+  for (bool remove : {false, true}) {
+    SubscribersCollection collection;
+    BlockingCallbackState state;
+    auto subscriber = std::make_unique<DummySubscriber>();
+    subscriber->SetCallback(BlockingCallback);
+    subscriber->SetUserData(&state);
+    auto handle = collection.AddExternalSubscriber(std::move(subscriber));
+    ASSERT_EQ(collection.EnableCallbackDomain(handle, PTI_CB_DOMAIN_DRIVER_GPU_OPERATION_APPENDED,
+                                              1, 1),
+              PTI_SUCCESS);
+
+    std::thread caller([&]() {
+      CallSubscribers(collection, PTI_CB_DOMAIN_DRIVER_GPU_OPERATION_APPENDED,
+                      PTI_CB_PHASE_API_EXIT);
+    });
+    while (!state.entered.load()) {
+      std::this_thread::yield();
+    }
+
+    std::atomic<bool> callback_returned_first = false;
+    std::thread writer([&]() {
+      if (remove) {
+        collection.RemoveExternalSubscriber(handle);
+      } else {
+        collection.DisableAllCallbackDomains(handle);
+      }
+      callback_returned_first = state.returned.load();
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    state.release = true;
+    writer.join();
+    caller.join();
+    EXPECT_TRUE(callback_returned_first.load()) << (remove ? "remove" : "disable");
+  }
+}
+
+// Retired snapshots are freed while callbacks keep running, not only when none is running
+TEST(SubscribersCollectionTest, RetiredSnapshotsAreFreedUnderLoad) {
+  SubscribersCollection collection;
+  std::atomic<uint64_t> calls = 0;
+  collection.AddInternalSubscriber(MakeCountingSubscriber(&calls));
+  auto handle = collection.AddExternalSubscriber(MakeCountingSubscriber(&calls));
+  ASSERT_EQ(collection.EnableCallbackDomain(handle, PTI_CB_DOMAIN_DRIVER_GPU_OPERATION_APPENDED, 1,
+                                            1),
+            PTI_SUCCESS);
+
+  std::atomic<bool> stop = false;
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 4; ++t) {
+    readers.emplace_back([&]() {
+      while (!stop.load()) {
+        CallSubscribers(collection, PTI_CB_DOMAIN_DRIVER_GPU_OPERATION_APPENDED,
+                        PTI_CB_PHASE_API_EXIT);
+      }
+    });
+  }
+  while (calls.load() == 0) {
+    std::this_thread::yield();
+  }
+
+  size_t max_retired = 0;
+  for (int i = 0; i < 1000; ++i) {
+    collection.EnableCallbackDomain(handle, PTI_CB_DOMAIN_DRIVER_KERNEL_CREATED, 1, 1);
+    max_retired = std::max(max_retired, collection.GetRetiredSnapshotCount());
+    collection.DisableCallbackDomain(handle, PTI_CB_DOMAIN_DRIVER_KERNEL_CREATED);
+    EXPECT_EQ(collection.GetRetiredSnapshotCount(), 0ULL);
+  }
+  auto toggled = collection.AddInternalSubscriber(MakeCountingSubscriber(&calls));
+  collection.RemoveInternalSubscriber(toggled);
+  EXPECT_EQ(collection.GetRetiredSnapshotCount(), 0ULL);
+  stop = true;
+  for (auto& th : readers) th.join();
+  EXPECT_LE(max_retired, 1ULL);
+}
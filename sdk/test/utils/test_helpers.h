@@ -128,6 +128,7 @@ constexpr auto SizeOfLargestViewRecord() {
       sizeof(pti_view_record_memory_copy_p2p_v2),    // PTI_VIEW_DEVICE_GPU_MEM_COPY_P2P
       sizeof(pti_view_record_synchronization),       // PTI_VIEW_DEVICE_SYNCHRONIZATION
       sizeof(pti_view_record_comms),                 // PTI_VIEW_COMMUNICATION
+      sizeof(pti_view_record_api_summary),           // PTI_VIEW_API_SUMMARY
   };
   return *std::max_element(kViewSizeLookupTable.begin(), kViewSizeLookupTable.end());
 }
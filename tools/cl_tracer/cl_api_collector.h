@@ -17,6 +17,7 @@
 #include "cl_api_tracer.h"
 #include "cl_utils.h"
 #include "correlator.h"
+#include "function_stats_table.h"
 #include "trace_guard.h"
 
 struct ClFunction {
@@ -71,7 +72,8 @@ class ClApiCollector {
         device, correlator, options, callback, callback_data);
     PTI_ASSERT(collector != nullptr);
 
-    ClApiTracer* tracer = new ClApiTracer(device, Callback, collector);
+    ClApiTracer* tracer = new ClApiTracer(
+        device, SelectCallback(options, callback), collector);
     if (tracer == nullptr || !tracer->IsValid()) {
       std::cerr << "[WARNING] Unable to create OpenCL tracer " <<
         "for target device" << std::endl;
@@ -98,8 +100,14 @@ class ClApiCollector {
     PTI_ASSERT(disabled);
   }
 
-  const ClFunctionInfoMap& GetFunctionInfoMap() const {
-    return function_info_map_;
+  ClFunctionInfoMap GetFunctionInfoMap() const {
+    ClFunctionInfoMap function_info_map;
+    {
+      const std::lock_guard<std::mutex> lock(lock_);
+      function_info_map = ext_function_info_map_;
+    }
+    function_stats_.Merge(function_info_map);
+    return function_info_map;
   }
 
   uint64_t GetKernelId() const {
@@ -128,9 +136,10 @@ class ClApiCollector {
   ClApiCollector& operator=(const ClApiCollector& copy) = delete;
 
   void PrintFunctionsTable() const {
+    ClFunctionInfoMap function_info_map = GetFunctionInfoMap();
     std::set< std::pair<std::string, ClFunction>,
               utils::Comparator > sorted_list(
-        function_info_map_.begin(), function_info_map_.end());
+        function_info_map.begin(), function_info_map.end());
 
     uint64_t total_duration = 0;
     size_t max_name_length = kFunctionLength;
@@ -217,24 +226,46 @@ class ClApiCollector {
     return correlator_->GetTimestamp();
   }
 
+  void AddFunctionTime(ClFunctionId function, const char* name, uint64_t time) {
+    function_stats_.AddFunctionTime(function, name, time);
+  }
+
+  // Extension functions have no ClFunctionId, they are rare enough to be
+  // counted by name
   void AddFunctionTime(const std::string& name, uint64_t time) {
     const std::lock_guard<std::mutex> lock(lock_);
-    if (function_info_map_.count(name) == 0) {
-      function_info_map_[name] = {time, time, time, 1};
+    auto it = ext_function_info_map_.find(name);
+    if (it == ext_function_info_map_.end()) {
+      ext_function_info_map_[name] = {time, time, time, 1};
     } else {
-      ClFunction& function = function_info_map_[name];
-      function.total_time += time;
-      if (time < function.min_time) {
-        function.min_time = time;
-      }
-      if (time > function.max_time) {
-        function.max_time = time;
-      }
-      ++function.call_count;
+      FunctionStatsTable<ClFunction, CL_FUNCTION_COUNT>::Add(it->second, time);
     }
   }
 
  private: // Callbacks
+  // Options checked on every traced call, Callback is instantiated for each
+  // combination so the disabled ones are compiled out of it
+  enum CallbackFlags : uint32_t {
+    CALLBACK_CALL_TRACING = 1 << 0,
+    CALLBACK_FUNCTION_FINISH = 1 << 1
+  };
+
+  static cl_tracing_callback SelectCallback(
+      const ApiCollectorOptions& options,
+      OnClFunctionFinishCallback callback) {
+    if (options.call_tracing) {
+      if (callback != nullptr) {
+        return Callback<CALLBACK_CALL_TRACING | CALLBACK_FUNCTION_FINISH>;
+      }
+      return Callback<CALLBACK_CALL_TRACING>;
+    }
+    if (callback != nullptr) {
+      return Callback<CALLBACK_FUNCTION_FINISH>;
+    }
+    return Callback<0>;
+  }
+
+  template <uint32_t Flags>
   static void Callback(
       ClFunctionId function,
       cl_callback_data* callback_data,
@@ -253,7 +284,7 @@ class ClApiCollector {
         return;
       }
 
-      if (collector->options_.call_tracing) {
+      if (Flags & CALLBACK_CALL_TRACING) {
         OnEnterFunction(function, callback_data, collector->GetTimestamp(), collector);
       }
 
@@ -270,14 +301,14 @@ class ClApiCollector {
       }
 
       collector->AddFunctionTime(
-        callback_data->functionName, end_time - start_time);
+        function, callback_data->functionName, end_time - start_time);
 
-      if (collector->options_.call_tracing) {
+      if (Flags & CALLBACK_CALL_TRACING) {
         OnExitFunction(
             function, callback_data, start_time, end_time, collector);
       }
 
-      if (collector->callback_ != nullptr) {
+      if (Flags & CALLBACK_FUNCTION_FINISH) {
         uint64_t kernel_id = 0;
         if (function == CL_FUNCTION_clEnqueueNDRangeKernel ||
             function == CL_FUNCTION_clEnqueueReadBuffer ||
@@ -347,8 +378,9 @@ class ClApiCollector {
   OnClFunctionFinishCallback callback_ = nullptr;
   void* callback_data_ = nullptr;
 
-  std::mutex lock_;
-  ClFunctionInfoMap function_info_map_;
+  mutable std::mutex lock_;
+  ClFunctionInfoMap ext_function_info_map_;
+  FunctionStatsTable<ClFunction, CL_FUNCTION_COUNT> function_stats_;
 
   static const uint32_t kFunctionLength = 10;
   static const uint32_t kCallsLength = 12;
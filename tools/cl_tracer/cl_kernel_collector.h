@@ -8,18 +8,24 @@
 #define PTI_TOOLS_CL_TRACER_CL_KERNEL_COLLECTOR_H_
 
 #include <atomic>
+#include <chrono>
 #include <iomanip>
 #include <iostream>
-#include <list>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <set>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "cl_api_tracer.h"
 #include "cl_utils.h"
+#include "completion_queue.h"
 #include "correlator.h"
+#include "kernel_stats_key.h"
 #include "trace_guard.h"
 
 #ifdef PTI_KERNEL_INTERVALS
@@ -49,11 +55,15 @@ struct ClKernelProps {
 
 struct ClKernelInstance {
   cl_event event = nullptr;
+  cl_command_queue queue = nullptr;
   ClKernelProps props;
   uint64_t kernel_id = 0;
   cl_ulong host_sync = 0;
   cl_ulong device_sync = 0;
   bool need_to_process = true;
+  cl_int event_status = CL_COMPLETE;
+  std::shared_ptr<utils::CompletionQueue<ClKernelInstance>> completion_queue;
+  ClKernelInstance* next_completed = nullptr;
 };
 
 struct ClKernelInfo {
@@ -80,7 +90,6 @@ struct ClKernelInfo {
 };
 
 using ClKernelInfoMap = std::map<std::string, ClKernelInfo>;
-using ClKernelInstanceList = std::list<ClKernelInstance*>;
 
 #ifdef PTI_KERNEL_INTERVALS
 
@@ -144,6 +153,7 @@ class ClKernelCollector {
   }
 
   ~ClKernelCollector() {
+    drainer_.Stop();
 #ifdef PTI_KERNEL_INTERVALS
     ReleaseDeviceMap();
 #endif // PTI_KERNEL_INTERVALS
@@ -156,10 +166,30 @@ class ClKernelCollector {
     PTI_ASSERT(tracer_ != nullptr);
     bool disabled = tracer_->Disable();
     PTI_ASSERT(disabled);
+
+    // Kernels still running will not be reported, their instances are left
+    // to the completion queue
+    if (!completion_queue_->WaitForInFlight(kInFlightTimeout)) {
+      std::cerr << "[WARNING] " << completion_queue_->GetInFlightCount() <<
+        " OpenCL commands did not complete, they are not reported" <<
+        std::endl;
+    }
+    drainer_.Stop();
   }
 
-  const ClKernelInfoMap& GetKernelInfoMap() const {
-    return kernel_info_map_;
+  // Kernel names are formatted here, once per launch configuration
+  ClKernelInfoMap GetKernelInfoMap() const {
+    ClKernelInfoMap kernel_info_map;
+    for (const auto& value : kernel_stats_) {
+      std::string name = kernel_names_.Format(value.first, options_.verbose);
+      auto it = kernel_info_map.find(name);
+      if (it == kernel_info_map.end()) {
+        kernel_info_map.emplace(std::move(name), value.second);
+      } else {
+        MergeKernelInfo(it->second, value.second);
+      }
+    }
+    return kernel_info_map;
   }
 
 #ifdef PTI_KERNEL_INTERVALS
@@ -172,9 +202,10 @@ class ClKernelCollector {
   ClKernelCollector& operator=(const ClKernelCollector& copy) = delete;
 
   void PrintKernelsTable() const {
+    ClKernelInfoMap kernel_info_map = GetKernelInfoMap();
     std::set< std::pair<std::string, ClKernelInfo>,
               utils::Comparator > sorted_list(
-        kernel_info_map_.begin(), kernel_info_map_.end());
+        kernel_info_map.begin(), kernel_info_map.end());
 
     uint64_t total_duration = 0;
     size_t max_name_length = kKernelLength;
@@ -221,9 +252,10 @@ class ClKernelCollector {
   }
 
   void PrintSubmissionTable() const {
+    ClKernelInfoMap kernel_info_map = GetKernelInfoMap();
     std::set< std::pair<std::string, ClKernelInfo>,
               utils::Comparator > sorted_list(
-        kernel_info_map_.begin(), kernel_info_map_.end());
+        kernel_info_map.begin(), kernel_info_map.end());
 
     uint64_t total_queued_duration = 0;
     uint64_t total_submit_duration = 0;
@@ -377,8 +409,6 @@ class ClKernelCollector {
         CL_FUNCTION_clFinish);
     set = set && tracer->SetTracingFunction(
         CL_FUNCTION_clReleaseCommandQueue);
-    set = set && tracer->SetTracingFunction(
-        CL_FUNCTION_clReleaseEvent);
     set = set && tracer->SetTracingFunction(
         CL_FUNCTION_clWaitForEvents);
     PTI_ASSERT(set);
@@ -387,10 +417,51 @@ class ClKernelCollector {
     PTI_ASSERT(enabled);
   }
 
+  // The instance is handed to the drainer thread once its event completes,
+  // so in-flight commands are never polled
   void AddKernelInstance(ClKernelInstance* instance) {
     PTI_ASSERT(instance != nullptr);
+    PTI_ASSERT(instance->event != nullptr);
+    instance->queue = utils::cl::GetCommandQueue(instance->event);
+    PTI_ASSERT(instance->queue != nullptr);
+    {
+      const std::lock_guard<std::mutex> lock(lock_);
+      queue_in_flight_[instance->queue]++;
+      events_in_flight_.insert(instance->event);
+    }
+    instance->completion_queue = completion_queue_;
+    completion_queue_->AddInFlight();
+    cl_int status = clSetEventCallback(
+        instance->event, CL_COMPLETE, OnEventComplete, instance);
+    PTI_ASSERT(status == CL_SUCCESS);
+  }
+
+  static void CL_CALLBACK OnEventComplete(
+      cl_event event, cl_int event_status, void* user_data) {
+    ClKernelInstance* instance =
+      reinterpret_cast<ClKernelInstance*>(user_data);
+    PTI_ASSERT(instance != nullptr);
+    PTI_ASSERT(instance->event == event);
+    instance->event_status = event_status;
+    // Keeps the queue alive even if the collector is already destroyed
+    std::shared_ptr<utils::CompletionQueue<ClKernelInstance>> queue =
+      instance->completion_queue;
+    queue->Push(instance);
+  }
+
+  void OnKernelInstanceComplete(ClKernelInstance* instance) {
+    TraceGuard guard;
     const std::lock_guard<std::mutex> lock(lock_);
-    kernel_instance_list_.push_back(instance);
+    cl_command_queue queue = instance->queue;
+    cl_event event = instance->event;
+    ProcessKernelInstance(instance);  // frees the instance
+
+    auto it = queue_in_flight_.find(queue);
+    PTI_ASSERT(it != queue_in_flight_.end() && it->second > 0);
+    if (--it->second == 0) {
+      queue_in_flight_.erase(it);  // the handle may be reused once released
+    }
+    events_in_flight_.erase(event);
   }
 
   static void ComputeHostTimestamps(
@@ -432,10 +503,8 @@ class ClKernelCollector {
     PTI_ASSERT(instance->event != nullptr);
     cl_event event = instance->event;
 
-    cl_int event_status = utils::cl::GetEventStatus(event);
-    PTI_ASSERT(event_status == CL_COMPLETE);
-
-    if (instance->need_to_process) {
+    // Commands terminated with an error have no profiling data
+    if (instance->need_to_process && instance->event_status == CL_COMPLETE) {
       cl_command_queue queue = utils::cl::GetCommandQueue(event);
       PTI_ASSERT(queue != nullptr);
 
@@ -451,12 +520,7 @@ class ClKernelCollector {
       PTI_ASSERT(device != nullptr);
       AddKernelInterval(instance, device, started, ended);
 #else // PTI_KERNEL_INTERVALS
-      std::string name = instance->props.name;
-      PTI_ASSERT(!name.empty());
-
-      if (options_.verbose) {
-        name = GetVerboseName(&(instance->props));
-      }
+      KernelStatsKey key = GetStatsKey(&(instance->props));
 
       uint64_t host_queued = 0, host_submitted = 0;
       uint64_t host_started = 0, host_ended = 0;
@@ -467,7 +531,7 @@ class ClKernelCollector {
           host_started, host_ended);
 
       AddKernelInfo(
-        name,
+        key,
         host_submitted - host_queued,
         host_started - host_submitted,
         host_ended - host_started);
@@ -478,7 +542,8 @@ class ClKernelCollector {
 
         callback_(
             callback_data_, stream.str(),
-            std::to_string(instance->kernel_id), name,
+            std::to_string(instance->kernel_id),
+            kernel_names_.Get(key, options_.verbose),
             host_queued, host_submitted,
             host_started, host_ended);
       }
@@ -491,80 +556,86 @@ class ClKernelCollector {
     delete instance;
   }
 
-  void ProcessKernelInstance(cl_event event) {
-    PTI_ASSERT(event != nullptr);
-    cl_int event_status = utils::cl::GetEventStatus(event);
-    if (event_status != CL_COMPLETE) {
-      return;
-    }
-
-    const std::lock_guard<std::mutex> lock(lock_);
-    for (auto it = kernel_instance_list_.begin();
-         it != kernel_instance_list_.end(); ++it) {
-      ClKernelInstance* instance = *it;
-      PTI_ASSERT(instance != nullptr);
-      PTI_ASSERT(instance->event != nullptr);
-      if (instance->event == event) {
-        ProcessKernelInstance(instance);
-        it = kernel_instance_list_.erase(it);
-        break;
-      }
-    }
+  // Processes the commands completed so far without waiting for the drainer
+  void ProcessKernelInstances() {
+    drainer_.Drain();
   }
 
-  void ProcessKernelInstances() {
-    const std::lock_guard<std::mutex> lock(lock_);
+  // Event callbacks may still be running when a synchronization call
+  // returns, so the commands it waited for are processed once they fired
+  void ProcessKernelInstances(cl_command_queue queue) {
+    WaitForKernelInstances([this, queue]() {
+      return queue_in_flight_.find(queue) == queue_in_flight_.end();
+    });
+  }
 
-    auto it = kernel_instance_list_.begin();
-    while (it != kernel_instance_list_.end()) {
-      ClKernelInstance* instance = *it;
-      PTI_ASSERT(instance != nullptr);
+  void ProcessKernelInstances(cl_uint num_events, const cl_event* events) {
+    WaitForKernelInstances([this, num_events, events]() {
+      for (cl_uint i = 0; i < num_events; ++i) {
+        if (events_in_flight_.count(events[i]) > 0) {
+          return false;
+        }
+      }
+      return true;
+    });
+  }
 
-      PTI_ASSERT(instance->event != nullptr);
-      cl_int event_status = utils::cl::GetEventStatus(instance->event);
-      if (event_status == CL_COMPLETE) {
-        ProcessKernelInstance(instance);
-        it = kernel_instance_list_.erase(it);
-      } else {
-        ++it;
+  // Drains until done() holds with the data lock taken, at most for
+  // kInFlightTimeout
+  template <typename F>
+  void WaitForKernelInstances(F done) {
+    auto deadline = std::chrono::steady_clock::now() + kInFlightTimeout;
+    while (true) {
+      drainer_.Drain();
+      {
+        const std::lock_guard<std::mutex> lock(lock_);
+        if (done()) {
+          return;
+        }
+      }
+      if (std::chrono::steady_clock::now() >= deadline) {
+        return;  // not complete commands are reported at flush
       }
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
     }
   }
 
-  std::string GetVerboseName(const ClKernelProps* props) {
+  // Sizes are keyed only if they are shown in kernel names
+  KernelStatsKey GetStatsKey(const ClKernelProps* props) {
     PTI_ASSERT(props != nullptr);
     PTI_ASSERT(!props->name.empty());
 
-    std::stringstream sstream;
-    sstream << props->name;
-    if (props->simd_width > 0) {
-      sstream << "[SIMD";
-      if (props->simd_width == 1) {
-        sstream << "_ANY";
-      } else {
-        sstream << props->simd_width;
+    KernelStatsKey key;
+    key.name_id = kernel_names_.GetId(props->name);
+    if (options_.verbose) {
+      key.simd_width = static_cast<uint32_t>(props->simd_width);
+      key.bytes_transferred = props->bytes_transferred;
+      for (int i = 0; i < 3; ++i) {
+        key.global_size[i] = props->global_size[i];
+        key.local_size[i] = props->local_size[i];
       }
-      sstream << " {" <<
-        props->global_size[0] << "; " <<
-        props->global_size[1] << "; " <<
-        props->global_size[2] << "} {" <<
-        props->local_size[0] << "; " <<
-        props->local_size[1] << "; " <<
-        props->local_size[2] << "}]";
-    } else if (props->bytes_transferred > 0) {
-      sstream << props->name << "[" <<
-        std::to_string(props->bytes_transferred) << " bytes]";
     }
+    return key;
+  }
 
-    return sstream.str();
+  static void MergeKernelInfo(ClKernelInfo& kernel, const ClKernelInfo& r) {
+    kernel.queued_time += r.queued_time;
+    kernel.submit_time += r.submit_time;
+    kernel.execute_time += r.execute_time;
+    if (r.max_time > kernel.max_time) {
+      kernel.max_time = r.max_time;
+    }
+    if (r.min_time < kernel.min_time) {
+      kernel.min_time = r.min_time;
+    }
+    kernel.call_count += r.call_count;
   }
 
   void AddKernelInfo(
-      std::string name, uint64_t queued_time,
+      const KernelStatsKey& key, uint64_t queued_time,
       uint64_t submit_time, uint64_t execute_time) {
-    PTI_ASSERT(!name.empty());
-
-    if (kernel_info_map_.count(name) == 0) {
+    auto it = kernel_stats_.find(key);
+    if (it == kernel_stats_.end()) {
       ClKernelInfo info;
       info.queued_time = queued_time;
       info.submit_time = submit_time;
@@ -572,9 +643,9 @@ class ClKernelCollector {
       info.min_time = execute_time;
       info.max_time = execute_time;
       info.call_count = 1;
-      kernel_info_map_[name] = info;
+      kernel_stats_.emplace(key, info);
     } else {
-      ClKernelInfo& kernel = kernel_info_map_[name];
+      ClKernelInfo& kernel = it->second;
       kernel.queued_time += queued_time;
       kernel.submit_time += submit_time;
       kernel.execute_time += execute_time;
@@ -653,12 +724,8 @@ class ClKernelCollector {
         host_started, host_ended);
 #endif /* 0 */
 
-    std::string name = instance->props.name;
-    PTI_ASSERT(!name.empty());
-
-    if (options_.verbose) {
-      name = GetVerboseName(&instance->props);
-    }
+    const std::string& name = kernel_names_.Get(
+        GetStatsKey(&instance->props), options_.verbose);
 
     if (device_map_.count(device) == 1 &&
         !device_map_[device].empty()) { // Implicit Scaling
@@ -882,7 +949,9 @@ class ClKernelCollector {
     }
   }
 
-  static void OnExitEnqueueTransfer(
+  // Returns the event of the command, the event pointer may no longer be
+  // valid on return
+  static cl_event OnExitEnqueueTransfer(
       std::string name, size_t bytes_transferred, cl_event* event,
       cl_callback_data* data, ClKernelCollector* collector) {
     PTI_ASSERT(event != nullptr);
@@ -896,7 +965,8 @@ class ClKernelCollector {
 
     ClKernelInstance* instance = new ClKernelInstance;
     PTI_ASSERT(instance != nullptr);
-    instance->event = *event;
+    cl_event command_event = *event;
+    instance->event = command_event;
     instance->props.name = name;
 
     instance->props.simd_width = 0;
@@ -919,6 +989,7 @@ class ClKernelCollector {
     collector->AddKernelInstance(instance);
 
     delete enqueue_data;
+    return command_event;
   }
 
   static void OnExitEnqueueReadBuffer(
@@ -934,12 +1005,12 @@ class ClKernelCollector {
             data->functionParams);
       PTI_ASSERT(params != nullptr);
 
-      OnExitEnqueueTransfer(
+      cl_event event = OnExitEnqueueTransfer(
           "clEnqueueReadBuffer", *(params->cb),
           *(params->event), data, collector);
 
       if (*params->blockingRead) {
-        collector->ProcessKernelInstances();
+        collector->ProcessKernelInstances(1, &event);
       }
     }
   }
@@ -957,12 +1028,12 @@ class ClKernelCollector {
             data->functionParams);
       PTI_ASSERT(params != nullptr);
 
-      OnExitEnqueueTransfer(
+      cl_event event = OnExitEnqueueTransfer(
           "clEnqueueWriteBuffer", *(params->cb),
           *(params->event), data, collector);
 
       if (*params->blockingWrite) {
-        collector->ProcessKernelInstances();
+        collector->ProcessKernelInstances(1, &event);
       }
     }
   }
@@ -1253,9 +1324,20 @@ class ClKernelCollector {
     }
   }
 
-  static void OnExitFinish(ClKernelCollector* collector) {
+  static void OnExitFinish(
+      cl_callback_data* data, ClKernelCollector* collector) {
+    PTI_ASSERT(data != nullptr);
     PTI_ASSERT(collector != nullptr);
-    collector->ProcessKernelInstances();
+
+    const cl_params_clFinish* params =
+      reinterpret_cast<const cl_params_clFinish*>(data->functionParams);
+    PTI_ASSERT(params != nullptr);
+
+    cl_int* return_value = reinterpret_cast<cl_int*>(
+        data->functionReturnValue);
+    if (*return_value == CL_SUCCESS) {
+      collector->ProcessKernelInstances(*(params->commandQueue));
+    }
   }
 
   static void OnExitReleaseCommandQueue(ClKernelCollector* collector) {
@@ -1263,40 +1345,21 @@ class ClKernelCollector {
     collector->ProcessKernelInstances();
   }
 
-  static void OnEnterReleaseEvent(
+  static void OnExitWaitForEvents(
       cl_callback_data* data, ClKernelCollector* collector) {
     PTI_ASSERT(data != nullptr);
     PTI_ASSERT(collector != nullptr);
 
-    const cl_params_clReleaseEvent* params =
-      reinterpret_cast<const cl_params_clReleaseEvent*>(
+    const cl_params_clWaitForEvents* params =
+      reinterpret_cast<const cl_params_clWaitForEvents*>(
           data->functionParams);
     PTI_ASSERT(params != nullptr);
 
-    if (*(params->event) != nullptr) {
-      collector->ProcessKernelInstance(*(params->event));
-    }
-  }
-
-  static void OnExitWaitForEvents(
-      cl_callback_data* data, ClKernelCollector* collector) {
-    PTI_ASSERT(data != nullptr);
-    PTI_ASSERT(collector != nullptr);
-
     cl_int* return_value = reinterpret_cast<cl_int*>(
         data->functionReturnValue);
     if (*return_value == CL_SUCCESS) {
-      const cl_params_clWaitForEvents* params =
-        reinterpret_cast<const cl_params_clWaitForEvents*>(
-            data->functionParams);
-      PTI_ASSERT(params != nullptr);
-
-      const cl_event* event_list = *(params->eventList);
-      if (event_list != nullptr) {
-        for (cl_uint i = 0; i < *(params->numEvents); ++i) {
-          collector->ProcessKernelInstance(event_list[i]);
-        }
-      }
+      collector->ProcessKernelInstances(
+          *(params->numEvents), *(params->eventList));
     }
   }
 
@@ -1422,16 +1485,12 @@ class ClKernelCollector {
       }
     } else if (function == CL_FUNCTION_clFinish) {
       if (callback_data->site == CL_CALLBACK_SITE_EXIT) {
-        OnExitFinish(collector);
+        OnExitFinish(callback_data, collector);
       }
     } else if (function == CL_FUNCTION_clReleaseCommandQueue) {
       if (callback_data->site == CL_CALLBACK_SITE_EXIT) {
         OnExitReleaseCommandQueue(collector);
       }
-    } else if (function == CL_FUNCTION_clReleaseEvent) {
-      if (callback_data->site == CL_CALLBACK_SITE_ENTER) {
-        OnEnterReleaseEvent(callback_data, collector);
-      }
     } else if (function == CL_FUNCTION_clWaitForEvents) {
       if (callback_data->site == CL_CALLBACK_SITE_EXIT) {
         OnExitWaitForEvents(callback_data, collector);
@@ -1452,8 +1511,12 @@ class ClKernelCollector {
   void* callback_data_ = nullptr;
 
   std::mutex lock_;
-  ClKernelInfoMap kernel_info_map_;
-  ClKernelInstanceList kernel_instance_list_;
+  // Commands not processed yet, waited for at synchronization points
+  std::unordered_map<cl_command_queue, uint64_t> queue_in_flight_;
+  std::unordered_set<cl_event> events_in_flight_;
+  KernelStatsNames kernel_names_;
+  std::unordered_map<
+      KernelStatsKey, ClKernelInfo, KernelStatsKeyHash> kernel_stats_;
 
 #ifdef PTI_KERNEL_INTERVALS
   ze_device_handle_t ze_device_;
@@ -1467,6 +1530,17 @@ class ClKernelCollector {
   static const uint32_t kCallsLength = 12;
   static const uint32_t kTimeLength = 20;
   static const uint32_t kPercentLength = 12;
+
+  static constexpr std::chrono::milliseconds kInFlightTimeout{1000};
+
+  std::shared_ptr<utils::CompletionQueue<ClKernelInstance>> completion_queue_ =
+    std::make_shared<utils::CompletionQueue<ClKernelInstance>>();
+  // Declared last to stop before the data it processes into is destroyed
+  utils::CompletionDrainer<ClKernelInstance> drainer_{
+      completion_queue_,
+      [this](ClKernelInstance* instance) {
+        OnKernelInstanceComplete(instance);
+      }};
 };
 
 #endif // PTI_TOOLS_CL_TRACER_CL_KERNEL_COLLECTOR_H_
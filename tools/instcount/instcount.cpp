@@ -6,6 +6,7 @@
 
 #include "instcount.hpp"
 
+#include <cstddef>
 #include <map>
 
 #include "api/gtpin_api.h"
@@ -172,6 +173,33 @@ PROF_STATUS InstCountGTPinTool::Accumulate(KernelDataSPtr kernelData,
   return PROF_STATUS::SUCCESS;
 }
 
+/**
+ * @brief This function accumulates the counters of one site of instrument in all thread buckets.
+ * @param kernelData A shared pointer to the KernelData object.
+ * @param profilingResult A shared pointer to the ResultData object.
+ * @param siteOfInstrument A shared pointer to the SiteOfInstrument object.
+ * @param records The batch of records, one per thread bucket.
+ * @return PROF_STATUS The status of the operation.
+ */
+PROF_STATUS InstCountGTPinTool::AccumulateBatch(KernelDataSPtr kernelData,
+                                                ResultDataSPtr profilingResult,
+                                                SiteOfInstrumentSPtr siteOfInstrument,
+                                                const RawRecordBatch& records) {
+  auto instCountResultData = std::dynamic_pointer_cast<InstCountResultData>(profilingResult);
+  PTI_ASSERT(instCountResultData != nullptr);
+  auto site = std::dynamic_pointer_cast<InstCountSiteOfInstrument>(siteOfInstrument);
+  PTI_ASSERT(site != nullptr);
+
+  uint64_t count = records.Sum(offsetof(InstCountRawRecord, count));
+  if (site->type == InstCountSiteOfInstrument::Type::Count) {
+    instCountResultData->instructionCounter += count;
+  } else if (site->type == InstCountSiteOfInstrument::Type::Simd) {
+    instCountResultData->simdActiveLaneCounter += count;
+  }
+
+  return PROF_STATUS::SUCCESS;
+}
+
 /// Next functions casts data structures to InstCount types and calls InstCount specific functions
 /// for writing the data
 bool InstCountWriterBase::WriteApplicationData(const ApplicationDataSPtr res) {
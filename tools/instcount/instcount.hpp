@@ -102,6 +102,18 @@ class InstCountGTPinTool : public GTPinTool {
    */
   PROF_STATUS Accumulate(KernelDataSPtr kernelData, ResultDataSPtr profilingResult,
                          SiteOfInstrumentSPtr siteOfInstrument, RawRecord* record) final;
+
+  /**
+   * @brief Accumulates the instruction counts of all thread buckets at once.
+   * @param kernelData The shared pointer to the kernel data.
+   * @param profilingResult The shared pointer to the profiling result data.
+   * @param siteOfInstrument The shared pointer to the site of instrument.
+   * @param records The raw records of the site in all thread buckets.
+   * @return The status of the accumulation.
+   */
+  PROF_STATUS AccumulateBatch(KernelDataSPtr kernelData, ResultDataSPtr profilingResult,
+                              SiteOfInstrumentSPtr siteOfInstrument,
+                              const RawRecordBatch& records) final;
 };
 
 /**
@@ -164,6 +164,8 @@ extern "C" PTI_EXPORT void Usage() {
             << "Disable SIMD active lanes collection" << std::endl;
   std::cout << "--json-output                  "
             << "Print results in JSON format" << std::endl;
+  std::cout << "--post-proc-threads <count>    "
+            << "Accumulate profile data on <count> threads asynchronously" << std::endl;
 }
 
 extern "C" PTI_EXPORT int ParseArgs(int argc, char* argv[]) {
@@ -175,6 +177,13 @@ extern "C" PTI_EXPORT int ParseArgs(int argc, char* argv[]) {
     } else if (strcmp(argv[i], "--json-output") == 0) {
       utils::SetEnv("GIC_JsonOutput", "1");
       app_index++;
+    } else if (strcmp(argv[i], "--post-proc-threads") == 0) {
+      if (i + 1 >= argc) {
+        std::cerr << "Error: --post-proc-threads requires an argument" << std::endl;
+        return -1;
+      }
+      utils::SetEnv("GIC_PostProcThreads", argv[++i]);
+      app_index += 2;
     } else if (strcmp(argv[i], "--version") == 0) {
 #ifdef PTI_VERSION
       std::cout << TOSTRING(PTI_VERSION) << std::endl;
@@ -212,6 +221,12 @@ void EnableProfiling() {
   if (!value.empty() && value == "1") {
     args.push_back("--json-output");
   }
+  /// Own storage, args must stay valid until ConfigureGTPin
+  std::string postProcThreads = utils::GetEnv("GIC_PostProcThreads");
+  if (!postProcThreads.empty()) {
+    args.push_back("--post-proc-threads");
+    args.push_back(postProcThreads.c_str());
+  }
   ConfigureGTPin(args.size(), args.data());
 
   if (knobJsonOutput) {
@@ -6,6 +6,9 @@
 
 #include "memaccess.hpp"
 
+#include <cstddef>
+#include <vector>
+
 #include "api/gtpin_api.h"
 #include "capsule.hpp"
 
@@ -135,6 +138,7 @@ PROF_STATUS MemAccessGTPinTool::Accumulate(std::shared_ptr<KernelData> kernelDat
   auto memAccessResultData = std::dynamic_pointer_cast<MemAccessResultData>(profilingResult);
   auto site = std::dynamic_pointer_cast<MemAccessSiteOfInstrument>(siteOfInstrument);
 
+  std::lock_guard<std::mutex> lock(memAccessResultData->accumulateLock);
   memAccessResultData->accessInstructionCounter += memAccessRawRec->memAccessCounter;
   memAccessResultData->simdLanesActiveCounter += memAccessRawRec->simdLanesActiveCounter;
   memAccessResultData->cacheLinesCounter += memAccessRawRec->cacheLinesCounter;
@@ -148,10 +152,7 @@ PROF_STATUS MemAccessGTPinTool::Accumulate(std::shared_ptr<KernelData> kernelDat
   PTI_ASSERT(site->strideMin == rdc->strideMin);
   PTI_ASSERT(site->strideNum == rdc->strideNum);
   PTI_ASSERT(site->strideStep == rdc->strideStep);
-  for (size_t idx = 0; idx < rdc->strideNum; idx++) {
-    int64_t stride = rdc->strideMin + idx * rdc->strideStep;
-    memAccessResultData->strideDistributionCounter[stride] += memAccessRawRec->strideDistr[idx];
-  }
+  memAccessResultData->strideDistribution.AddDense(memAccessRawRec->strideDistr, rdc->strideNum);
 
   PTI_ASSERT(memAccessResultData->addresses.size() <=
              sizeof(memAccessRawRec->addresses) / sizeof(memAccessRawRec->addresses[0]));
@@ -165,9 +166,70 @@ PROF_STATUS MemAccessGTPinTool::Accumulate(std::shared_ptr<KernelData> kernelDat
   return PROF_STATUS::SUCCESS;
 }
 
+/**
+ * @brief This function accumulates the data of one site of instrument in all thread buckets.
+ * The records are reduced first, the result data is locked only to add the sums, as it may be
+ * shared by invocations processed concurrently.
+ * @param kernelData A shared pointer to the KernelData object.
+ * @param profilingResult A shared pointer to the ResultData object.
+ * @param siteOfInstrument A shared pointer to the SiteOfInstrument object.
+ * @param records The batch of records, one per thread bucket.
+ * @return PROF_STATUS The status of the operation.
+ */
+PROF_STATUS MemAccessGTPinTool::AccumulateBatch(std::shared_ptr<KernelData> kernelData,
+                                                std::shared_ptr<ResultData> profilingResult,
+                                                std::shared_ptr<SiteOfInstrument> siteOfInstrument,
+                                                const RawRecordBatch& records) {
+  auto memAccessResultData = std::dynamic_pointer_cast<MemAccessResultData>(profilingResult);
+  PTI_ASSERT(memAccessResultData != nullptr);
+  auto site = std::dynamic_pointer_cast<MemAccessSiteOfInstrument>(siteOfInstrument);
+  PTI_ASSERT(site != nullptr);
+
+  auto rdc = std::dynamic_pointer_cast<MemAccessResultDataCommon>(memAccessResultData->GetCommon());
+  PTI_ASSERT(rdc != nullptr);
+
+  PTI_ASSERT(site->strideMin == rdc->strideMin);
+  PTI_ASSERT(site->strideNum == rdc->strideNum);
+  PTI_ASSERT(site->strideStep == rdc->strideStep);
+  std::vector<uint64_t> strideDistr(rdc->strideNum, 0);
+  records.SumArray(offsetof(MemAccessRawRecord, strideDistr), rdc->strideNum, strideDistr.data());
+
+  PTI_ASSERT(memAccessResultData->addresses.size() <= GTPIN_UTILS_MAX_SIMD_WIDTH);
+
+  uint64_t memAccessCounter = records.Sum(offsetof(MemAccessRawRecord, memAccessCounter));
+  uint64_t simdLanesActiveCounter =
+      records.Sum(offsetof(MemAccessRawRecord, simdLanesActiveCounter));
+  uint64_t cacheLinesCounter = records.Sum(offsetof(MemAccessRawRecord, cacheLinesCounter));
+  uint64_t clNotAlignedCounter = records.Sum(offsetof(MemAccessRawRecord, clNotAlignedCounter));
+  uint64_t strideOverflowLowerCounter =
+      records.Sum(offsetof(MemAccessRawRecord, strideOverflowLowerCounter));
+  uint64_t strideOverflowHigherCounter =
+      records.Sum(offsetof(MemAccessRawRecord, strideOverflowHigherCounter));
+
+  std::lock_guard<std::mutex> lock(memAccessResultData->accumulateLock);
+  memAccessResultData->accessInstructionCounter += memAccessCounter;
+  memAccessResultData->simdLanesActiveCounter += simdLanesActiveCounter;
+  memAccessResultData->cacheLinesCounter += cacheLinesCounter;
+  memAccessResultData->clNotAlignedCounter += clNotAlignedCounter;
+  memAccessResultData->strideOverflowLowerCounter += strideOverflowLowerCounter;
+  memAccessResultData->strideOverflowHigherCounter += strideOverflowHigherCounter;
+  memAccessResultData->strideDistribution.AddDense(strideDistr.data(), strideDistr.size());
+
+  /// The first non-zero address in thread bucket order is kept, as with per-record accumulation
+  for (size_t idx = 0; idx < records.Size(); idx++) {
+    auto memAccessRawRec = reinterpret_cast<MemAccessRawRecord*>(records[idx]);
+    for (size_t addrIdx = 0; addrIdx < memAccessResultData->addresses.size(); addrIdx++) {
+      if (memAccessRawRec->addresses[addrIdx] && memAccessResultData->addresses[addrIdx] == 0)
+        memAccessResultData->addresses[addrIdx] = memAccessRawRec->addresses[addrIdx];
+    }
+  }
+  return PROF_STATUS::SUCCESS;
+}
+
 std::shared_ptr<GTPinTool> MemAccessFactory::MakeGTPinTool() const {
   auto memAccessControl = std::dynamic_pointer_cast<MemAccessControlDefault>(m_control);
   strideNum = memAccessControl->GetStrideNum();
+  aggregateInvocations = memAccessControl->ShouldAggregateInvocations();
   return std::make_shared<MemAccessGTPinTool>(std::make_shared<MemAccessFactory>(*this));
 }
 
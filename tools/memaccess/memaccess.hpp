@@ -13,9 +13,12 @@
 
 #include <map>
 #include <memory>
+#include <mutex>
+#include <utility>
 
 #include "gen_send_decoder.h"
 #include "profiler.hpp"
+#include "stride_histogram.hpp"
 
 namespace gtpin_prof {
 
@@ -195,6 +198,19 @@ class MemAccessGTPinTool : public GTPinTool {
                          std::shared_ptr<ResultData> profilingResult,
                          std::shared_ptr<SiteOfInstrument> siteOfInstrument,
                          RawRecord* record) final;
+
+  /**
+   * Accumulates the profiling result of all thread buckets at once
+   * @param kernelData The shared pointer to the kernel data.
+   * @param profilingResult The shared pointer to the profiling result data.
+   * @param siteOfInstrument The shared pointer to the site of instrument.
+   * @param records The raw records of the site in all thread buckets.
+   * @return The status of the accumulation.
+   */
+  PROF_STATUS AccumulateBatch(std::shared_ptr<KernelData> kernelData,
+                              std::shared_ptr<ResultData> profilingResult,
+                              std::shared_ptr<SiteOfInstrument> siteOfInstrument,
+                              const RawRecordBatch& records) final;
 };
 
 /**
@@ -232,21 +248,31 @@ class MemAccessInvocationData : public InvocationData {
  * It extends the ResultData class.
  * Provides additional data specific to the MemAccessGTPinTool.
  * Includes counters for the number of active SIMD lanes and the total number of instructions.
+ * An aggregated result data is shared by all invocations of the kernel and accumulates all of them.
  */
 class MemAccessResultData : public ResultData {
  public:
-  MemAccessResultData(std::shared_ptr<ResultDataCommon> resultDataCommon, size_t tileId)
-      : ResultData(resultDataCommon, tileId) {
+  MemAccessResultData(std::shared_ptr<ResultDataCommon> resultDataCommon, size_t tileId,
+                      bool isAggregated = false)
+      : ResultData(resultDataCommon, tileId), isAggregated(isAggregated) {
     auto rdc = std::dynamic_pointer_cast<MemAccessResultDataCommon>(resultDataCommon);
     PTI_ASSERT(rdc != nullptr);
-    for (size_t idx = 0; idx < rdc->strideNum; idx++) {
-      int64_t stride = rdc->strideMin + idx * rdc->strideStep;
-      strideDistributionCounter[stride] = 0;
-    }
     addresses.resize(rdc->simdWidth);
     for (auto addr : addresses) addr = 0;
   }
 
+  /**
+   * Returns the stride of the distribution bucket.
+   * @param rdc The common result data with the bucket layout.
+   * @param bucket The bucket index.
+   * @return The stride in bytes.
+   */
+  static int64_t GetStride(const MemAccessResultDataCommon& rdc, uint32_t bucket) {
+    return rdc.strideMin + static_cast<int64_t>(bucket) * rdc.strideStep;
+  }
+
+  const bool isAggregated;
+
   size_t accessInstructionCounter = 0;
   size_t simdLanesActiveCounter = 0;
   size_t cacheLinesCounter = 0;
@@ -254,7 +280,10 @@ class MemAccessResultData : public ResultData {
   size_t strideOverflowHigherCounter = 0;
   size_t strideOverflowLowerCounter = 0;
   std::vector<uint64_t> addresses;
-  std::map<int64_t, size_t> strideDistributionCounter;
+  StrideHistogram strideDistribution;  ///< bucket i counts strides GetStride(rdc, i)
+
+  /// Invocations of an aggregated result data may be accumulated concurrently
+  std::mutex accumulateLock;
 };
 
 using MemAccessApplicationDataSPtr = std::shared_ptr<MemAccessApplicationData>;
@@ -272,6 +301,14 @@ using MemAccessResultDataCommonSPtr = std::shared_ptr<MemAccessResultDataCommon>
  */
 class MemAccessFactory final : public ToolFactory {
   mutable int32_t strideNum = -1;
+  mutable bool aggregateInvocations = false;
+  /// Result data shared by all invocations, by common result data and tile. The key owns the
+  /// common result data, so its address is not reused by another one while the entry exists
+  mutable std::map<std::pair<std::shared_ptr<ResultDataCommon>, size_t>,
+                   std::shared_ptr<ResultData>>
+      aggregatedResults;
+  /// Kernels may be dispatched from several threads at once
+  mutable std::mutex aggregatedResultsLock;
 
  public:
   using ToolFactory::ToolFactory;
@@ -324,13 +361,22 @@ class MemAccessFactory final : public ToolFactory {
   }
 
   /**
-   * Creates an instance of the MemAccessResultData.
+   * Creates an instance of the MemAccessResultData. If invocations are aggregated, the result data
+   * is created once and shared by all invocations.
    * @param resultDataCommon The shared pointer to the common result data.
    * @return The shared pointer to the MemAccessResultData.
    */
   std::shared_ptr<ResultData> MakeResultData(
       std::shared_ptr<ResultDataCommon> resultDataCommon, size_t tileId) const final {
-    return std::make_shared<MemAccessResultData>(resultDataCommon, tileId);
+    if (!aggregateInvocations) {
+      return std::make_shared<MemAccessResultData>(resultDataCommon, tileId);
+    }
+    std::lock_guard<std::mutex> lock(aggregatedResultsLock);
+    auto& resultData = aggregatedResults[{resultDataCommon, tileId}];
+    if (resultData == nullptr) {
+      resultData = std::make_shared<MemAccessResultData>(resultDataCommon, tileId, true);
+    }
+    return resultData;
   }
 };
 
@@ -439,6 +485,13 @@ class MemAccessControl : public ControlBase {
    * @return The stride step value in bytes.
    */
   virtual int32_t GetStrideStep() const = 0;
+
+  /**
+   * @brief Determines whether all invocations of a kernel are accumulated into the same results
+   * instead of keeping results for each invocation.
+   * @return True if invocations should be aggregated, false otherwise.
+   */
+  virtual bool ShouldAggregateInvocations() const = 0;
 };
 
 /**
@@ -480,6 +533,8 @@ class MemAccessControlDefault : public MemAccessControl {
   int32_t GetStrideNum() const override { return STRIDE_NUM_DEFAULT; }
 
   int32_t GetStrideStep() const override { return STRIDE_STEP_DEFAULT; }
+
+  bool ShouldAggregateInvocations() const override { return false; }
 };
 
 /**
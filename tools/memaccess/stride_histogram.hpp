@@ -0,0 +1,126 @@
+//==============================================================
+// Copyright (C) Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+// =============================================================
+
+#ifndef PTI_TOOLS_MEMACCESS_STRIDE_HISTOGRAM
+#define PTI_TOOLS_MEMACCESS_STRIDE_HISTOGRAM
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace gtpin_prof {
+
+/**
+ * Class representing the accumulated stride distribution of a memory access instruction.
+ * Only the non-zero buckets are stored, as bucket indices and counters sorted by index. Most
+ * instructions hit a few strides out of the whole range, so the storage and the time to write
+ * the distribution depend on the number of strides detected rather than on the number of buckets.
+ */
+class StrideHistogram {
+ public:
+  /**
+   * Adds dense bucket counters, e.g. the stride distribution of raw records.
+   * @param counters The counters of buckets [0, num).
+   * @param num The number of buckets.
+   */
+  void AddDense(const uint64_t* counters, size_t num) {
+    size_t present = m_buckets.size();
+    size_t pos = 0;         // position in the present buckets, both are ordered by index
+    StrideHistogram added;  // buckets not present yet
+    for (size_t base = 0; base < num; base += DENSE_BLOCK_SIZE) {
+      size_t end = (base + DENSE_BLOCK_SIZE < num) ? base + DENSE_BLOCK_SIZE : num;
+      // zero blocks are skipped with one test, the reduction is vectorized by the compiler
+      uint64_t any = 0;
+      for (size_t idx = base; idx < end; idx++) any |= counters[idx];
+      if (any == 0) continue;
+
+      for (size_t idx = base; idx < end; idx++) {
+        if (counters[idx] == 0) continue;
+        while (pos < present && m_buckets[pos] < idx) pos++;
+        if (pos < present && m_buckets[pos] == idx) {
+          m_counts[pos] += counters[idx];
+        } else {
+          added.m_buckets.push_back(static_cast<uint32_t>(idx));
+          added.m_counts.push_back(counters[idx]);
+        }
+      }
+    }
+    Merge(added);
+  }
+
+  /**
+   * Adds the counters of another histogram with the same bucket layout.
+   * An instruction usually hits the same strides in every invocation, so histograms with the same
+   * non-zero buckets are added counter by counter, which the compiler vectorizes. Otherwise the
+   * sorted bucket lists are merged one bucket at a time: the output position depends on the
+   * comparison of every pair of indices, and the lists are short, so the merge is kept scalar.
+   * @param other The histogram to add.
+   */
+  void Merge(const StrideHistogram& other) {
+    if (other.m_buckets.empty()) return;
+    if (m_buckets.empty()) {
+      m_buckets = other.m_buckets;
+      m_counts = other.m_counts;
+      return;
+    }
+    if (m_buckets == other.m_buckets) {
+      uint64_t* counts = m_counts.data();
+      const uint64_t* otherCounts = other.m_counts.data();
+      for (size_t pos = 0; pos < m_counts.size(); pos++) counts[pos] += otherCounts[pos];
+      return;
+    }
+
+    std::vector<uint32_t> buckets;
+    std::vector<uint64_t> counts;
+    buckets.reserve(m_buckets.size() + other.m_buckets.size());
+    counts.reserve(m_buckets.size() + other.m_buckets.size());
+    size_t lhs = 0, rhs = 0;
+    while (lhs < m_buckets.size() || rhs < other.m_buckets.size()) {
+      if (rhs == other.m_buckets.size() ||
+          (lhs < m_buckets.size() && m_buckets[lhs] < other.m_buckets[rhs])) {
+        buckets.push_back(m_buckets[lhs]);
+        counts.push_back(m_counts[lhs++]);
+      } else if (lhs == m_buckets.size() || other.m_buckets[rhs] < m_buckets[lhs]) {
+        buckets.push_back(other.m_buckets[rhs]);
+        counts.push_back(other.m_counts[rhs++]);
+      } else {
+        buckets.push_back(m_buckets[lhs]);
+        counts.push_back(m_counts[lhs++] + other.m_counts[rhs++]);
+      }
+    }
+    m_buckets.swap(buckets);
+    m_counts.swap(counts);
+  }
+
+  /**
+   * Calls f(bucket index, counter) for every non-zero bucket in the ascending order of indices.
+   */
+  template <typename F>
+  void ForEach(F f) const {
+    for (size_t pos = 0; pos < m_buckets.size(); pos++) f(m_buckets[pos], m_counts[pos]);
+  }
+
+  /// Number of non-zero buckets
+  size_t Size() const { return m_buckets.size(); }
+
+  /// Sum of all counters
+  uint64_t GetTotal() const {
+    uint64_t total = 0;
+    for (auto count : m_counts) total += count;
+    return total;
+  }
+
+ private:
+  /// Buckets checked for zero at once by AddDense
+  static constexpr size_t DENSE_BLOCK_SIZE = 16;
+
+  std::vector<uint32_t> m_buckets;
+  std::vector<uint64_t> m_counts;
+};
+
+}  // namespace gtpin_prof
+
+#endif  // PTI_TOOLS_MEMACCESS_STRIDE_HISTOGRAM
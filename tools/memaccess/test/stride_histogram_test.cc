@@ -0,0 +1,145 @@
+//==============================================================
+// Copyright (C) Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+// =============================================================
+
+// Tests of StrideHistogram on synthetic counters, no GTPin is required. Every histogram is
+// checked against the dense counters it is expected to hold.
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "stride_histogram.hpp"
+
+using gtpin_prof::StrideHistogram;
+
+static bool Check(bool condition, const char* message) {
+  if (!condition) {
+    std::cerr << "[ERROR] " << message << std::endl;
+  }
+  return condition;
+}
+
+// Dense counters of the histogram, also checks the buckets are ascending and not zero
+static bool ToDense(const StrideHistogram& histogram, size_t num, std::vector<uint64_t>* dense) {
+  dense->assign(num, 0);
+  bool ordered = true;
+  int64_t previous = -1;
+  histogram.ForEach([&](uint32_t bucket, uint64_t count) {
+    if (static_cast<int64_t>(bucket) <= previous || bucket >= num || count == 0) {
+      ordered = false;
+      return;
+    }
+    previous = bucket;
+    (*dense)[bucket] = count;
+  });
+  return ordered;
+}
+
+static bool CheckHistogram(const StrideHistogram& histogram, const std::vector<uint64_t>& expected,
+                           const char* message) {
+  std::vector<uint64_t> dense;
+  if (!ToDense(histogram, expected.size(), &dense)) {
+    std::cerr << "[ERROR] " << message << ": buckets are not ascending or have zero counters"
+              << std::endl;
+    return false;
+  }
+  size_t nonZero = 0;
+  uint64_t total = 0;
+  for (auto count : expected) {
+    nonZero += (count != 0);
+    total += count;
+  }
+  return Check(dense == expected && histogram.Size() == nonZero && histogram.GetTotal() == total,
+               message);
+}
+
+static bool TestEmpty() {
+  StrideHistogram histogram;
+  std::vector<uint64_t> zeros(37, 0);
+  histogram.AddDense(zeros.data(), zeros.size());
+  histogram.AddDense(nullptr, 0);
+  histogram.Merge(StrideHistogram());
+  return CheckHistogram(histogram, zeros, "histogram of zero counters is not empty");
+}
+
+// Non-zero counters at the first and the last bucket of blocks and of a partial last block
+static bool TestAddDenseBlockBoundaries() {
+  const size_t num = 16 * 3 + 5;
+  std::vector<uint64_t> counters(num, 0);
+  for (size_t idx : {size_t(0), size_t(15), size_t(16), size_t(31), size_t(48), num - 1}) {
+    counters[idx] = idx + 1;
+  }
+  StrideHistogram histogram;
+  histogram.AddDense(counters.data(), num);
+  bool passed = CheckHistogram(histogram, counters, "buckets at block boundaries");
+
+  // Adding to present buckets and to new ones in between
+  std::vector<uint64_t> more(num, 0);
+  more[15] = 100;
+  more[17] = 7;
+  more[47] = 3;
+  more[num - 1] = 1;
+  histogram.AddDense(more.data(), num);
+  for (size_t idx = 0; idx < num; idx++) counters[idx] += more[idx];
+  passed = CheckHistogram(histogram, counters, "present and new buckets are added") && passed;
+  return passed;
+}
+
+static bool TestMerge() {
+  const size_t num = 40;
+  std::vector<uint64_t> lhs(num, 0), rhs(num, 0), sum(num, 0);
+  lhs[1] = 10;
+  lhs[5] = 20;
+  lhs[39] = 30;
+  rhs[0] = 1;
+  rhs[5] = 2;
+  rhs[20] = 3;
+  rhs[39] = 4;
+  for (size_t idx = 0; idx < num; idx++) sum[idx] = lhs[idx] + rhs[idx];
+
+  StrideHistogram left, right;
+  left.AddDense(lhs.data(), num);
+  right.AddDense(rhs.data(), num);
+
+  StrideHistogram merged = left;
+  merged.Merge(right);
+  bool passed = CheckHistogram(merged, sum, "overlapping histograms are merged");
+  merged = right;
+  merged.Merge(left);
+  passed = CheckHistogram(merged, sum, "merge depends on the order") && passed;
+
+  StrideHistogram empty;
+  empty.Merge(left);
+  passed = CheckHistogram(empty, lhs, "merge into an empty histogram") && passed;
+  left.Merge(StrideHistogram());
+  passed = CheckHistogram(left, lhs, "merge of an empty histogram") && passed;
+  return passed;
+}
+
+// Histograms with the same buckets are added counter by counter
+static bool TestMergeSameBuckets() {
+  const size_t num = 100;
+  std::vector<uint64_t> counters(num, 0), expected(num, 0);
+  for (size_t idx = 3; idx < num; idx += 7) counters[idx] = idx;
+
+  StrideHistogram histogram, other;
+  histogram.AddDense(counters.data(), num);
+  other.AddDense(counters.data(), num);
+  for (int i = 0; i < 3; i++) histogram.Merge(other);
+  for (size_t idx = 0; idx < num; idx++) expected[idx] = 4 * counters[idx];
+  return CheckHistogram(histogram, expected, "histograms with the same buckets are added");
+}
+
+int main() {
+  bool passed = true;
+  passed = TestEmpty() && passed;
+  passed = TestAddDenseBlockBoundaries() && passed;
+  passed = TestMerge() && passed;
+  passed = TestMergeSameBuckets() && passed;
+  std::cout << (passed ? "[PASSED]" : "[FAILED]") << " stride_histogram_test" << std::endl;
+  return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
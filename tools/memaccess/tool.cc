@@ -41,7 +41,7 @@ class MemAccessTxtWriter : public MemAccessWriterBase, public TxtWriterBase {
     std::vector<size_t> strideSum(resultsNum);
     std::vector<size_t> strideOvfLower(resultsNum);
     std::vector<size_t> strideOvfHigher(resultsNum);
-    std::vector<std::map<int64_t, size_t>> strides(resultsNum);
+    std::vector<StrideHistogram> strides(resultsNum);
     std::vector<std::vector<size_t>> addresses(resultsNum);
 
     auto resultDataCommon = kernelData->GetResultDataCommon();
@@ -70,13 +70,9 @@ class MemAccessTxtWriter : public MemAccessWriterBase, public TxtWriterBase {
         strideOvfHigher[idx] += resultData->strideOverflowHigherCounter;
         strideSum[idx] +=
             resultData->strideOverflowLowerCounter + resultData->strideOverflowHigherCounter;
-        for (auto stride : resultData->strideDistributionCounter) {
-          strideSum[idx] += stride.second;
-          if (strides[idx].find(stride.first) == strides[idx].end()) {
-            strides[idx][stride.first] = 0;
-          }
-          strides[idx][stride.first] += stride.second;
-        }
+        strideSum[idx] += resultData->strideDistribution.GetTotal();
+        strides[idx].Merge(resultData->strideDistribution);
+        if (resultData->isAggregated) break;  // shared by all invocations
       }
     }
 
@@ -130,12 +126,12 @@ class MemAccessTxtWriter : public MemAccessWriterBase, public TxtWriterBase {
       std::cerr << "  * Stride distribution:\n";
       if (strideSum[idx] > 0) {
         std::map<size_t, int64_t> sortedStrides;  // map is a sorted container
-        for (auto stride : strides[idx]) {
-          if (sortedStrides.size() == 0 || sortedStrides.begin()->first < stride.second) {
-            sortedStrides[stride.second] = stride.first;
+        strides[idx].ForEach([&sortedStrides, &rdc](uint32_t bucket, uint64_t count) {
+          if (sortedStrides.size() == 0 || sortedStrides.begin()->first < count) {
+            sortedStrides[count] = MemAccessResultData::GetStride(*rdc, bucket);
             if (sortedStrides.size() > 5) sortedStrides.erase(sortedStrides.begin());
           }
-        }
+        });
         size_t meaningfulStridesSum = strideOvfHigher[idx] + strideOvfLower[idx];
         for (auto it = sortedStrides.rbegin(); it != sortedStrides.rend(); ++it) {
           if (it->first == 0) continue;
@@ -182,12 +178,54 @@ class MemAccessJsonWriter : public MemAccessWriterBase, public JsonWriterBase {
   using JsonWriterBase::JsonWriterBase;
   virtual ~MemAccessJsonWriter() = default;
 
+  /// Aggregated results are shared by all invocations, they are written once for the kernel
+  /// instead of once per invocation
+  bool WriteMemAccessKernelData(const MemAccessApplicationDataSPtr res,
+                                const MemAccessKernelDataSPtr kernelData) final {
+    auto invocations = kernelData->GetInvocations();
+    if (invocations.empty() || kernelData->GetResultsNum() == 0) return false;
+    auto invocationData = invocations.begin()->second;
+    auto first =
+        std::dynamic_pointer_cast<MemAccessResultData>(invocationData->GetResultData(0, 0));
+    PTI_ASSERT(first != nullptr);
+    if (!first->isAggregated) return false;
+
+    GetStream() << ",\"aggregated_invocations\":true";
+    GetStream() << ",\"tiles\":[\n";
+    for (size_t tileId = 0; tileId < kernelData->GetCollectedTilesNum(); tileId++) {
+      if (tileId > 0) GetStream() << ",";
+      GetStream() << "{\"results\":[";
+      for (size_t idx = 0; idx < kernelData->GetResultsNum(); idx++) {
+        if (idx > 0) GetStream() << ",";
+        auto resultData = std::dynamic_pointer_cast<MemAccessResultData>(
+            invocationData->GetResultData(tileId, idx));
+        auto resultDataCommon = std::dynamic_pointer_cast<MemAccessResultDataCommon>(
+            kernelData->GetResultDataCommon(idx));
+        PTI_ASSERT(resultData != nullptr && resultDataCommon != nullptr);
+        GetStream() << "{";
+        WriteResult(resultData, resultDataCommon);
+        GetStream() << "}";
+      }
+      GetStream() << "]}\n";
+    }
+    GetStream() << "]";  // tiles
+    GetStream() << "}\n";  // kernel, not closed by the caller when the kernel data is written here
+    return true;
+  }
+
   bool WriteMemAccessResultData(const MemAccessApplicationDataSPtr res,
                                 const MemAccessKernelDataSPtr kernelData,
                                 const MemAccessInvocationDataSPtr invocationData,
                                 const MemAccessResultDataSPtr resultData,
                                 const MemAccessResultDataCommonSPtr resultDataCommon,
                                 size_t tileId) final {
+    WriteResult(resultData, resultDataCommon);
+    return false;
+  }
+
+ private:
+  void WriteResult(const MemAccessResultDataSPtr resultData,
+                   const MemAccessResultDataCommonSPtr resultDataCommon) {
     // MemAccessResultDataSPtr
     GetStream() << "\"access_instruction_counter\":" << resultData->accessInstructionCounter;
     GetStream() << ",\"simd_lanes_active_counter\":" << resultData->simdLanesActiveCounter;
@@ -203,12 +241,12 @@ class MemAccessJsonWriter : public MemAccessWriterBase, public JsonWriterBase {
     }
     GetStream() << "],\"stride_distribution\":{";
     bool first = true;
-    for (auto stride : resultData->strideDistributionCounter) {
-      if (stride.second == 0) continue;
+    resultData->strideDistribution.ForEach([&](uint32_t bucket, uint64_t count) {
       if (!first) GetStream() << ",";
       first = false;
-      GetStream() << "\"" << stride.first << "\":" << stride.second;
-    }
+      GetStream() << "\"" << MemAccessResultData::GetStride(*resultDataCommon, bucket)
+                  << "\":" << count;
+    });
     GetStream() << "}";
 
     ///// MemAccessResultDataCommon
@@ -232,8 +270,6 @@ class MemAccessJsonWriter : public MemAccessWriterBase, public JsonWriterBase {
     GetStream() << ",\"is_media\":" << resultDataCommon->isMedia;
     GetStream() << ",\"exec_size\":" << resultDataCommon->execSize;
     GetStream() << ",\"channel_offset\":" << resultDataCommon->channelOffset;
-
-    return false;
   }
 };
 
@@ -245,6 +281,8 @@ static gtpin::Knob<int> knobStrideMin("stride-min", STRIDE_MIN_DEFAULT,
 static gtpin::Knob<int> knobStrideNum("stride-num", STRIDE_NUM_DEFAULT,
                                       "Number of collected strides (buckets)");
 static gtpin::Knob<int> knobStrideStep("stride-step", STRIDE_STEP_DEFAULT, "Stride step (bytes)");
+static gtpin::Knob<bool> knobAggregateInvocations(
+    "aggregate-invocations", false, "Accumulate all invocations of a kernel into the same results");
 
 class MemAccessGTPinControl : public MemAccessControlDefault {
  public:
@@ -265,6 +303,7 @@ class MemAccessGTPinControl : public MemAccessControlDefault {
   int32_t GetStrideMin() const { return knobStrideMin; }
   int32_t GetStrideNum() const { return knobStrideNum; }
   int32_t GetStrideStep() const { return knobStrideStep; }
+  bool ShouldAggregateInvocations() const { return knobAggregateInvocations; }
 };
 
 // External Tool Interface ////////////////////////////////////////////////////
@@ -286,6 +325,10 @@ extern "C" PTI_EXPORT void Usage() {
             << "Stride step (bytes)" << std::endl;
   std::cout << "--json-output                  "
             << "Print results in JSON format" << std::endl;
+  std::cout << "--aggregate-invocations        "
+            << "Keep one result for all invocations of a kernel" << std::endl;
+  std::cout << "--post-proc-threads <count>    "
+            << "Accumulate profile data on <count> threads asynchronously" << std::endl;
 }
 
 extern "C" PTI_EXPORT int ParseArgs(int argc, char* argv[]) {
@@ -322,6 +365,16 @@ extern "C" PTI_EXPORT int ParseArgs(int argc, char* argv[]) {
     } else if (strcmp(argv[i], "--json-output") == 0) {
       utils::SetEnv("GMA_JsonOutput", "1");
       app_index++;
+    } else if (strcmp(argv[i], "--aggregate-invocations") == 0) {
+      utils::SetEnv("GMA_AggregateInvocations", "1");
+      app_index++;
+    } else if (strcmp(argv[i], "--post-proc-threads") == 0) {
+      if (i + 1 >= argc) {
+        std::cerr << "Error: --post-proc-threads requires an argument" << std::endl;
+        return -1;
+      }
+      utils::SetEnv("GMA_PostProcThreads", argv[++i]);
+      app_index += 2;
     } else if (strcmp(argv[i], "--version") == 0) {
 #ifdef PTI_VERSION
       std::cout << TOSTRING(PTI_VERSION) << std::endl;
@@ -375,6 +428,15 @@ void EnableProfiling() {
   if (!value.empty() && value == "1") {
     args.push_back("--json-output");
   }
+  if (utils::GetEnv("GMA_AggregateInvocations") == "1") {
+    args.push_back("--aggregate-invocations");
+  }
+  /// Own storage, args must stay valid until ConfigureGTPin
+  std::string postProcThreads = utils::GetEnv("GMA_PostProcThreads");
+  if (!postProcThreads.empty()) {
+    args.push_back("--post-proc-threads");
+    args.push_back(postProcThreads.c_str());
+  }
   ConfigureGTPin(args.size(), args.data());
 
   if (knobJsonOutput) {
@@ -7,13 +7,22 @@
 #ifndef PTI_TOOLS_ONEPROF_FINALIZER_H_
 #define PTI_TOOLS_ONEPROF_FINALIZER_H_
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <thread>
+
 #include "logger.h"
+#include "metric_columns.h"
 #include "metric_storage.h"
 #include "prof_options.h"
 #include "prof_utils.h"
 #include "result_storage.h"
 #include "utils.h"
 
+constexpr size_t kKernelIntervalBatchSize = 65536;
+
 class Finalizer {
  public:
   static Finalizer* Create(const ProfOptions& options) {
@@ -182,12 +191,12 @@ class Finalizer {
   static std::vector<zet_typed_value_t> GetMetricInterval(
       const std::vector<uint64_t>& cache,
       MetricReader* reader,
-      zet_metric_group_handle_t group,
+      uint32_t report_size,
       uint64_t start,
       uint64_t end,
       uint32_t sub_device_id) {
     PTI_ASSERT(reader != nullptr);
-    PTI_ASSERT(group != nullptr);
+    PTI_ASSERT(report_size > 0);
     PTI_ASSERT(start < end);
 
     size_t start_index = utils::LowerBound(cache, start);
@@ -200,9 +209,6 @@ class Finalizer {
       return std::vector<zet_typed_value_t>();
     }
 
-    uint32_t report_size = GetMetricCount(group);
-    PTI_ASSERT(report_size > 0);
-
     size_t report_size_in_bytes = report_size * sizeof(zet_typed_value_t);
     size_t start_byte = start_index * report_size_in_bytes;
     size_t size = (end_index - start_index) * report_size_in_bytes;
@@ -215,261 +221,29 @@ class Finalizer {
     return target_list;
   }
 
-  static zet_typed_value_t ComputeTotalValue(
-      uint32_t metric_id,
-      const std::vector<zet_typed_value_t>& report_list,
-      uint32_t report_size) {
-    PTI_ASSERT(report_list.size() > 0);
-    PTI_ASSERT(report_size > 0);
-    PTI_ASSERT(metric_id < report_size);
-
-    uint32_t report_count = report_list.size() / report_size;
-    PTI_ASSERT(report_count * report_size == report_list.size());
-
-    const zet_typed_value_t* report = report_list.data();
-    switch (report[metric_id].type) {
-      case ZET_VALUE_TYPE_UINT32: {
-        zet_typed_value_t total;
-        total.type = ZET_VALUE_TYPE_UINT64;
-        total.value.ui64 = 0;
-
-        for (int j = 0; j < report_count; ++j) {
-          report = report_list.data() + j * report_size;
-          zet_typed_value_t value = report[metric_id];
-          PTI_ASSERT(value.type == ZET_VALUE_TYPE_UINT32);
-          total.value.ui64 += value.value.ui32;
-        }
-        return total;
-      }
-      case ZET_VALUE_TYPE_UINT64: {
-        zet_typed_value_t total;
-        total.type = ZET_VALUE_TYPE_UINT64;
-        total.value.ui64 = 0;
-
-        for (int j = 0; j < report_count; ++j) {
-          report = report_list.data() + j * report_size;
-          zet_typed_value_t value = report[metric_id];
-          PTI_ASSERT(value.type == ZET_VALUE_TYPE_UINT64);
-          total.value.ui64 += value.value.ui64;
-        }
-        return total;
-      }
-      case ZET_VALUE_TYPE_FLOAT32: {
-        zet_typed_value_t total;
-        total.type = ZET_VALUE_TYPE_FLOAT64;
-        total.value.fp64 = 0.0;
-
-        for (int j = 0; j < report_count; ++j) {
-          report = report_list.data() + j * report_size;
-          zet_typed_value_t value = report[metric_id];
-          PTI_ASSERT(value.type == ZET_VALUE_TYPE_FLOAT32);
-          total.value.fp64 += value.value.fp32;
-        }
-        return total;
-      }
-      case ZET_VALUE_TYPE_FLOAT64: {
-        zet_typed_value_t total;
-        total.type = ZET_VALUE_TYPE_FLOAT64;
-        total.value.fp64 = 0.0;
-
-        for (int j = 0; j < report_count; ++j) {
-          report = report_list.data() + j * report_size;
-          zet_typed_value_t value = report[metric_id];
-          PTI_ASSERT(value.type == ZET_VALUE_TYPE_FLOAT64);
-          total.value.fp64 += value.value.fp64;
-        }
-        return total;
-      }
-      case ZET_VALUE_TYPE_BOOL8: {
-        // how to aggregate bool values?
-        zet_typed_value_t total;
-        total.type = ZET_VALUE_TYPE_BOOL8;
-        total.value.b8 = 0;
-
-        for (int j = 0; j < report_count; ++j) {
-          report = report_list.data() + j * report_size;
-          zet_typed_value_t value = report[metric_id];
-          PTI_ASSERT(value.type == ZET_VALUE_TYPE_BOOL8);
-          total.value.b8 |= value.value.b8;
-        }
-        return total;
-      }
-      default: {
-        PTI_ASSERT(0);
-        break;
-      }
+  // Calls func(i) for every i in [0, count) on all available cores
+  static void ParallelFor(size_t count, const std::function<void(size_t)>& func) {
+    uint32_t thread_count = std::thread::hardware_concurrency();
+    if (thread_count == 0) {
+      thread_count = 1;
     }
+    thread_count = std::min<size_t>(thread_count, count);
 
-    return zet_typed_value_t();
-  }
-
-  static zet_typed_value_t ComputeAverageValue(
-      uint32_t metric_id,
-      const std::vector<zet_typed_value_t>& report_list,
-      uint32_t report_size,
-      uint64_t total_clocks,
-      uint32_t gpu_clocks_id) {
-    PTI_ASSERT(report_list.size() > 0);
-    PTI_ASSERT(report_size > 0);
-    PTI_ASSERT(metric_id < report_size);
-    PTI_ASSERT(gpu_clocks_id < report_size);
-    PTI_ASSERT(total_clocks > 0);
-
-    uint32_t report_count = report_list.size() / report_size;
-    PTI_ASSERT(report_count * report_size == report_list.size());
-
-    const zet_typed_value_t* report = report_list.data();
-    switch (report[metric_id].type) {
-      case ZET_VALUE_TYPE_UINT32: {
-        zet_typed_value_t total;
-        total.type = ZET_VALUE_TYPE_UINT64;
-        total.value.ui64 = 0;
-
-        for (int j = 0; j < report_count; ++j) {
-          report = report_list.data() + j * report_size;
-          zet_typed_value_t value = report[metric_id];
-          PTI_ASSERT(value.type == ZET_VALUE_TYPE_UINT32);
-          zet_typed_value_t clocks = report[gpu_clocks_id];
-          PTI_ASSERT(clocks.type == ZET_VALUE_TYPE_UINT64);
-          total.value.ui64 += value.value.ui32 * clocks.value.ui64;
-        }
-        total.value.ui64 /= total_clocks;
-        return total;
-      }
-      case ZET_VALUE_TYPE_UINT64: {
-        zet_typed_value_t total;
-        total.type = ZET_VALUE_TYPE_UINT64;
-        total.value.ui64 = 0;
-
-        for (int j = 0; j < report_count; ++j) {
-          report = report_list.data() + j * report_size;
-          zet_typed_value_t value = report[metric_id];
-          PTI_ASSERT(value.type == ZET_VALUE_TYPE_UINT64);
-          zet_typed_value_t clocks = report[gpu_clocks_id];
-          PTI_ASSERT(clocks.type == ZET_VALUE_TYPE_UINT64);
-          total.value.ui64 += value.value.ui64 * clocks.value.ui64;
-        }
-        total.value.ui64 /= total_clocks;
-        return total;
+    std::atomic<size_t> next(0);
+    auto worker = [&next, count, &func]() {
+      for (size_t i = next++; i < count; i = next++) {
+        func(i);
       }
-      case ZET_VALUE_TYPE_FLOAT32: {
-        zet_typed_value_t total;
-        total.type = ZET_VALUE_TYPE_FLOAT64;
-        total.value.fp64 = 0.0;
-
-        for (int j = 0; j < report_count; ++j) {
-          report = report_list.data() + j * report_size;
-          zet_typed_value_t value = report[metric_id];
-          PTI_ASSERT(value.type == ZET_VALUE_TYPE_FLOAT32);
-          zet_typed_value_t clocks = report[gpu_clocks_id];
-          PTI_ASSERT(clocks.type == ZET_VALUE_TYPE_UINT64);
-          total.value.fp64 += value.value.fp32 * clocks.value.ui64;
-        }
-        total.value.fp64 /= total_clocks;
-        return total;
-      }
-      case ZET_VALUE_TYPE_FLOAT64: {
-        zet_typed_value_t total;
-        total.type = ZET_VALUE_TYPE_FLOAT64;
-        total.value.fp64 = 0.0;
-
-        for (int j = 0; j < report_count; ++j) {
-          report = report_list.data() + j * report_size;
-          zet_typed_value_t value = report[metric_id];
-          PTI_ASSERT(value.type == ZET_VALUE_TYPE_FLOAT64);
-          zet_typed_value_t clocks = report[gpu_clocks_id];
-          PTI_ASSERT(clocks.type == ZET_VALUE_TYPE_UINT64);
-          total.value.fp64 += value.value.fp64 * clocks.value.ui64;
-        }
-        total.value.fp64 /= total_clocks;
-        return total;
-      }
-      default: {
-        PTI_ASSERT(0);
-        break;
-      }
-    }
-
-    return zet_typed_value_t();
-  }
-
-  static std::vector<zet_typed_value_t> GetAggregatedMetrics(
-      const std::vector<uint64_t>& cache,
-      MetricReader* reader,
-      zet_metric_group_handle_t group,
-      uint64_t start,
-      uint64_t end,
-      uint32_t sub_device_id,
-      uint32_t gpu_clocks_id) {
-    PTI_ASSERT(reader != nullptr);
-    PTI_ASSERT(group != nullptr);
-    PTI_ASSERT(start < end);
-
-    uint32_t report_size = GetMetricCount(group);
-    PTI_ASSERT(report_size > 0);
+    };
 
-    std::vector<std::string> metric_list = GetMetricList(group);
-    PTI_ASSERT(metric_list.size() == report_size);
-
-    std::vector<zet_metric_type_t> metric_type_list = GetMetricTypeList(group);
-    PTI_ASSERT(metric_type_list.size() == report_size);
-
-    std::vector<zet_typed_value_t> report_list = GetMetricInterval(
-        cache, reader, group, start, end, sub_device_id);
-    uint32_t report_count = report_list.size() / report_size;
-    PTI_ASSERT(report_count * report_size == report_list.size());
-    if (report_count == 0) {
-      return std::vector<zet_typed_value_t>();
+    std::vector<std::thread> thread_list;
+    for (uint32_t i = 1; i < thread_count; ++i) {
+      thread_list.emplace_back(worker);
     }
-
-    uint64_t total_clocks = 0;
-    for (uint32_t i = 0; i < report_count; ++i) {
-      const zet_typed_value_t* report = report_list.data() + i * report_size;
-      PTI_ASSERT(report[gpu_clocks_id].type == ZET_VALUE_TYPE_UINT64);
-      total_clocks += report[gpu_clocks_id].value.ui64;
-    }
-
-    std::vector<zet_typed_value_t> aggregated_report(report_size);
-
-    for (uint32_t i = 0; i < metric_list.size(); ++i) {
-      if (metric_list[i].find("GpuTime") != std::string::npos) {
-        aggregated_report[i] = ComputeTotalValue(i, report_list, report_size);
-        continue;
-      }
-      if (metric_list[i].find("AvgGpuCoreFrequencyMHz") != std::string::npos) {
-        aggregated_report[i] = ComputeAverageValue(
-            i, report_list, report_size, total_clocks, gpu_clocks_id);
-        continue;
-      }
-      if (metric_list[i].find("ReportReason") != std::string::npos) {
-        aggregated_report[i] = report_list.data()[i];
-        continue;
-      }
-      switch (metric_type_list[i]) {
-        case ZET_METRIC_TYPE_DURATION:
-        case ZET_METRIC_TYPE_RATIO:
-          aggregated_report[i] = ComputeAverageValue(
-              i, report_list, report_size, total_clocks, gpu_clocks_id);
-          break;
-        case ZET_METRIC_TYPE_THROUGHPUT:
-        case ZET_METRIC_TYPE_EVENT:
-          aggregated_report[i] = ComputeTotalValue(
-              i, report_list, report_size);
-          break;
-        case ZET_METRIC_TYPE_TIMESTAMP:
-        case ZET_METRIC_TYPE_RAW:
-          aggregated_report[i] = report_list.data()[i];
-          break;
-        case ZET_METRIC_TYPE_EVENT_WITH_RANGE:
-        case ZET_METRIC_TYPE_FLAG:
-          break;
-        default:
-          PTI_ASSERT(0);
-          break;
-      }
+    worker();
+    for (auto& thread : thread_list) {
+      thread.join();
     }
-
-    return aggregated_report;
   }
 
   static void PrintTypedValue(
@@ -606,7 +380,7 @@ class Finalizer {
         PTI_ASSERT(!metric_group_list.empty());
 
         uint32_t metric_data_size = MAX_BUFFER_SIZE;
-        uint8_t* metric_data = reader->ReadChunk(metric_data_size, i);
+        const uint8_t* metric_data = reader->ReadChunk(metric_data_size, i);
         if (metric_data == nullptr) {
           break;
         }
@@ -635,8 +409,6 @@ class Finalizer {
         storage->Dump(
             reinterpret_cast<uint8_t*>(report_chunk.data()),
             report_chunk.size() * sizeof(zet_typed_value_t), i);
-
-        delete[] metric_data;
       }
     }
 
@@ -689,7 +461,8 @@ class Finalizer {
       while (true) {
         uint32_t report_size_in_bytes = report_size * sizeof(zet_typed_value_t);
         uint32_t report_chunk_size = report_size_in_bytes * MAX_REPORT_COUNT;
-        zet_typed_value_t* report_chunk = reinterpret_cast<zet_typed_value_t*>(
+        const zet_typed_value_t* report_chunk =
+          reinterpret_cast<const zet_typed_value_t*>(
             reader->ReadChunk(report_chunk_size, i));
         if (report_chunk == nullptr) {
           break;
@@ -708,8 +481,6 @@ class Finalizer {
           PTI_ASSERT(sub_device_cache.back() <= report[time_id].value.ui64);
           sub_device_cache.push_back(report[time_id].value.ui64);
         }
-
-        delete[] report_chunk;
       }
     }
 
@@ -718,6 +489,70 @@ class Finalizer {
     return cache;
   }
 
+  // Makes empty per-metric columns for every sub-device, the reports are
+  // loaded with LoadColumns(). Metric names of every sub-device are returned
+  // in metric_list_list
+  std::vector<MetricColumns> MakeColumns(
+      const std::vector<ze_device_handle_t>& sub_device_list,
+      std::vector< std::vector<std::string> >& metric_list_list) {
+    PTI_ASSERT(data_ != nullptr);
+    PTI_ASSERT(!sub_device_list.empty());
+
+    std::vector<MetricColumns> column_list;
+    metric_list_list.clear();
+    for (size_t i = 0; i < sub_device_list.size(); ++i) {
+      zet_metric_group_handle_t group = utils::ze::FindMetricGroup(
+          sub_device_list[i], data_->metric_group,
+          ZET_METRIC_GROUP_SAMPLING_TYPE_FLAG_TIME_BASED);
+      PTI_ASSERT(group != nullptr);
+
+      std::vector<std::string> metric_list = GetMetricList(group);
+      PTI_ASSERT(!metric_list.empty());
+      uint32_t report_size = metric_list.size();
+
+      std::vector<zet_metric_type_t> metric_type_list = GetMetricTypeList(group);
+      PTI_ASSERT(metric_type_list.size() == report_size);
+
+      size_t time_id = GetMetricId(metric_list, "QueryBeginTime");
+      PTI_ASSERT(time_id < metric_list.size());
+
+      size_t gpu_clocks_id = GetMetricId(metric_list, "GpuCoreClocks");
+      PTI_ASSERT(gpu_clocks_id < metric_list.size());
+
+      column_list.emplace_back(
+          metric_list, metric_type_list, time_id, gpu_clocks_id);
+      metric_list_list.push_back(std::move(metric_list));
+    }
+
+    return column_list;
+  }
+
+  // Replaces the reports in the columns of a sub-device with the reports
+  // [start_index, end_index) of its metric file
+  static void LoadColumns(
+      MetricReader* reader,
+      uint32_t sub_device_id,
+      uint32_t report_size,
+      size_t start_index,
+      size_t end_index,
+      MetricColumns& columns) {
+    PTI_ASSERT(reader != nullptr);
+    PTI_ASSERT(report_size > 0);
+    PTI_ASSERT(start_index <= end_index);
+
+    columns.Clear();
+    if (start_index == end_index) {
+      return;
+    }
+
+    size_t report_size_in_bytes = report_size * sizeof(zet_typed_value_t);
+    const zet_typed_value_t* report_list =
+      reinterpret_cast<const zet_typed_value_t*>(reader->ReadInPlace(
+          sub_device_id, start_index * report_size_in_bytes,
+          (end_index - start_index) * report_size_in_bytes));
+    columns.Append(report_list, end_index - start_index);
+  }
+
   void ReportKernelIntervals() {
     PTI_ASSERT(data_ != nullptr);
 
@@ -808,7 +643,8 @@ class Finalizer {
       while (true) {
         uint32_t report_size_in_bytes = report_size * sizeof(zet_typed_value_t);
         uint32_t report_chunk_size = report_size_in_bytes * MAX_REPORT_COUNT;
-        zet_typed_value_t* report_chunk = reinterpret_cast<zet_typed_value_t*>(
+        const zet_typed_value_t* report_chunk =
+          reinterpret_cast<const zet_typed_value_t*>(
             reader->ReadChunk(report_chunk_size, i));
         if (report_chunk == nullptr) {
           break;
@@ -830,8 +666,6 @@ class Finalizer {
           line << std::endl;
           logger_.Log(line.str());
         }
-
-        delete[] report_chunk;
       }
 
       logger_.Log("\n");
@@ -865,6 +699,13 @@ class Finalizer {
       metric_group_list.push_back(group);
     }
 
+    // metric names are the same for all the intervals of a sub-device
+    std::vector< std::vector<std::string> > metric_list_list;
+    for (auto group : metric_group_list) {
+      metric_list_list.push_back(GetMetricList(group));
+      PTI_ASSERT(!metric_list_list.back().empty());
+    }
+
     std::string filename = options_.GetResultFile();
     PTI_ASSERT(!filename.empty());
 
@@ -885,17 +726,12 @@ class Finalizer {
         const std::string& kernel_name =
           data_->kernel_name_list[kernel_interval.kernel_id];
 
-        uint32_t report_size = GetMetricCount(
-            metric_group_list[sub_device_id]);
-        PTI_ASSERT(report_size > 0);
-
-        std::vector<std::string> metric_list = GetMetricList(
-            metric_group_list[sub_device_id]);
-        PTI_ASSERT(!metric_list.empty());
-        PTI_ASSERT(metric_list.size() == report_size);
+        const std::vector<std::string>& metric_list =
+          metric_list_list[sub_device_id];
+        uint32_t report_size = metric_list.size();
 
         std::vector<zet_typed_value_t> report_list = GetMetricInterval(
-          cache[sub_device_id], reader, metric_group_list[sub_device_id],
+          cache[sub_device_id], reader, report_size,
           device_interval.start, device_interval.end, sub_device_id);
         uint32_t report_count = report_list.size() / report_size;
         PTI_ASSERT(report_count * report_size == report_list.size());
@@ -935,7 +771,8 @@ class Finalizer {
     delete reader;
   }
 
-  void ReportAggregatedMetrics(const std::vector< std::vector<uint64_t> >& cache) {
+  void ReportAggregatedMetrics(
+      const std::vector< std::vector<uint64_t> >& cache) {
     PTI_ASSERT(data_ != nullptr);
 
     logger_.Log("\n");
@@ -951,14 +788,10 @@ class Finalizer {
       sub_device_list.push_back(device);
     }
 
-    std::vector<zet_metric_group_handle_t> metric_group_list;
-    for (auto sub_device : sub_device_list) {
-      zet_metric_group_handle_t group = utils::ze::FindMetricGroup(
-          sub_device, data_->metric_group,
-          ZET_METRIC_GROUP_SAMPLING_TYPE_FLAG_TIME_BASED);
-      PTI_ASSERT(group != nullptr);
-      metric_group_list.push_back(group);
-    }
+    std::vector< std::vector<std::string> > metric_list_list;
+    std::vector<MetricColumns> column_list =
+      MakeColumns(sub_device_list, metric_list_list);
+    PTI_ASSERT(cache.size() == column_list.size());
 
     std::string filename = options_.GetResultFile();
     PTI_ASSERT(!filename.empty());
@@ -969,40 +802,72 @@ class Finalizer {
         sub_device_list.size(), data_->pid, "bin", path);
     PTI_ASSERT(reader != nullptr);
 
-    for (const auto& kernel_interval : data_->kernel_interval_list) {
-      bool reported = false;
-      const auto& device_interval_list = kernel_interval.device_interval_list;
-      for (const auto& device_interval : device_interval_list) {
-        uint32_t sub_device_id = device_interval.sub_device_id;
-        PTI_ASSERT(sub_device_id < sub_device_list.size());
+    // Kernel intervals are aggregated in parallel batch by batch and
+    // reported in order. The columns hold only the reports of the current
+    // batch: intervals come in time order, so a batch covers a short range
+    // of reports rather than all of them
+    const auto& kernel_interval_list = data_->kernel_interval_list;
+    for (size_t batch_start = 0; batch_start < kernel_interval_list.size();
+         batch_start += kKernelIntervalBatchSize) {
+      size_t batch_size = std::min<size_t>(
+          kKernelIntervalBatchSize, kernel_interval_list.size() - batch_start);
+
+      std::vector<size_t> start_index_list(column_list.size(), SIZE_MAX);
+      std::vector<size_t> end_index_list(column_list.size(), 0);
+      for (size_t i = 0; i < batch_size; ++i) {
+        const auto& device_interval_list =
+          kernel_interval_list[batch_start + i].device_interval_list;
+        for (const auto& device_interval : device_interval_list) {
+          uint32_t sub_device_id = device_interval.sub_device_id;
+          PTI_ASSERT(sub_device_id < column_list.size());
+          const std::vector<uint64_t>& time_list = cache[sub_device_id];
+          start_index_list[sub_device_id] = std::min(
+              start_index_list[sub_device_id],
+              utils::LowerBound(time_list, device_interval.start));
+          end_index_list[sub_device_id] = std::max(
+              end_index_list[sub_device_id],
+              utils::UpperBound(time_list, device_interval.end));
+        }
+      }
+      for (size_t i = 0; i < column_list.size(); ++i) {
+        LoadColumns(
+            reader, i, metric_list_list[i].size(),
+            std::min(start_index_list[i], end_index_list[i]),
+            end_index_list[i], column_list[i]);
+      }
+
+      std::vector< std::vector< std::vector<zet_typed_value_t> > >
+        report_list_list(batch_size);
+      ParallelFor(batch_size, [&](size_t i) {
+        const auto& device_interval_list =
+          kernel_interval_list[batch_start + i].device_interval_list;
+        for (const auto& device_interval : device_interval_list) {
+          uint32_t sub_device_id = device_interval.sub_device_id;
+          PTI_ASSERT(sub_device_id < column_list.size());
+          report_list_list[i].push_back(column_list[sub_device_id].Aggregate(
+              device_interval.start, device_interval.end));
+        }
+      });
 
+      for (size_t i = 0; i < batch_size; ++i) {
+        const auto& kernel_interval = kernel_interval_list[batch_start + i];
         PTI_ASSERT(kernel_interval.kernel_id < data_->kernel_name_list.size());
         const std::string& kernel_name =
           data_->kernel_name_list[kernel_interval.kernel_id];
 
-        uint32_t report_size = GetMetricCount(
-            metric_group_list[sub_device_id]);
-        PTI_ASSERT(report_size > 0);
-
-        std::vector<std::string> metric_list = GetMetricList(
-            metric_group_list[sub_device_id]);
-        PTI_ASSERT(!metric_list.empty());
-        PTI_ASSERT(metric_list.size() == report_size);
-
-        size_t report_time_id = GetMetricId(metric_list, "QueryBeginTime");
-        PTI_ASSERT(report_time_id < metric_list.size());
+        bool reported = false;
+        const auto& device_interval_list = kernel_interval.device_interval_list;
+        for (size_t j = 0; j < device_interval_list.size(); ++j) {
+          const auto& device_interval = device_interval_list[j];
+          const std::vector<zet_typed_value_t>& report = report_list_list[i][j];
+          if (report.empty()) {
+            continue;
+          }
 
-        size_t gpu_clocks_id = GetMetricId(metric_list, "GpuCoreClocks");
-        PTI_ASSERT(gpu_clocks_id < metric_list.size());
+          const std::vector<std::string>& metric_list =
+            metric_list_list[device_interval.sub_device_id];
+          PTI_ASSERT(report.size() == metric_list.size());
 
-        std::vector<zet_typed_value_t> report_list = GetAggregatedMetrics(
-          cache[sub_device_id], reader, metric_group_list[sub_device_id],
-          device_interval.start, device_interval.end,
-          sub_device_id, gpu_clocks_id);
-        uint32_t report_count = report_list.size() / report_size;
-        PTI_ASSERT(report_count * report_size == report_list.size());
-
-        if (report_count > 0) {
           reported = true;
           std::stringstream header;
           header << "Kernel,";
@@ -1013,9 +878,7 @@ class Finalizer {
           }
           header << std::endl;
           logger_.Log(header.str());
-        }
 
-        for (int i = 0; i < report_count; ++i) {
           PTI_ASSERT(device_interval.start <= device_interval.end);
           uint64_t kernel_time = device_interval.end - device_interval.start;
 
@@ -1023,19 +886,17 @@ class Finalizer {
           line << kernel_name << ",";
           line << device_interval.sub_device_id << ",";
           line << kernel_time << ",";
-          const zet_typed_value_t* report =
-            report_list.data() + i * report_size;
-          for (int j = 0; j < report_size; ++j) {
-            PrintTypedValue(line, report[j]);
+          for (const auto& value : report) {
+            PrintTypedValue(line, value);
             line << ",";
           }
           line << std::endl;
           logger_.Log(line.str());
         }
-      }
 
-      if (reported) {
-        logger_.Log("\n");
+        if (reported) {
+          logger_.Log("\n");
+        }
       }
     }
 
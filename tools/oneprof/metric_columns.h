@@ -0,0 +1,270 @@
+//==============================================================
+// Copyright (C) Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+// =============================================================
+
+#ifndef PTI_TOOLS_ONEPROF_METRIC_COLUMNS_H_
+#define PTI_TOOLS_ONEPROF_METRIC_COLUMNS_H_
+
+#include <string>
+#include <vector>
+
+#include <level_zero/zet_api.h>
+
+#include "pti_assert.h"
+#include "utils.h"
+
+// Reports of one sub-device stored column by column with prefix sums, so that
+// the aggregated value of a metric over any range of reports is computed in
+// constant time instead of a pass over the reports of the range. The columns
+// may hold a part of the reports only, see Clear()
+class MetricColumns {
+ public:
+  MetricColumns(
+      const std::vector<std::string>& metric_list,
+      const std::vector<zet_metric_type_t>& metric_type_list,
+      size_t time_id,
+      size_t gpu_clocks_id)
+      : time_id_(time_id), gpu_clocks_id_(gpu_clocks_id),
+        column_list_(metric_list.size()) {
+    PTI_ASSERT(!metric_list.empty());
+    PTI_ASSERT(metric_list.size() == metric_type_list.size());
+    PTI_ASSERT(time_id < metric_list.size());
+    PTI_ASSERT(gpu_clocks_id < metric_list.size());
+
+    for (size_t i = 0; i < metric_list.size(); ++i) {
+      column_list_[i].aggregation =
+        GetAggregation(metric_list[i], metric_type_list[i]);
+    }
+    clocks_prefix_.push_back(0);
+  }
+
+  // Reports are expected in time order
+  void Append(const zet_typed_value_t* report_chunk, uint32_t report_count) {
+    PTI_ASSERT(report_chunk != nullptr);
+
+    uint32_t report_size = column_list_.size();
+    for (uint32_t i = 0; i < report_count; ++i) {
+      const zet_typed_value_t* report = report_chunk + i * report_size;
+
+      PTI_ASSERT(report[time_id_].type == ZET_VALUE_TYPE_UINT64);
+      PTI_ASSERT(time_list_.empty() ||
+                 time_list_.back() <= report[time_id_].value.ui64);
+      time_list_.push_back(report[time_id_].value.ui64);
+
+      PTI_ASSERT(report[gpu_clocks_id_].type == ZET_VALUE_TYPE_UINT64);
+      uint64_t clocks = report[gpu_clocks_id_].value.ui64;
+      clocks_prefix_.push_back(clocks_prefix_.back() + clocks);
+
+      for (uint32_t j = 0; j < report_size; ++j) {
+        AppendValue(column_list_[j], report[j], clocks);
+      }
+    }
+  }
+
+  // Drops the reports, so that the next reports appended are aggregated
+  // without the previous ones
+  void Clear() {
+    time_list_.clear();
+    clocks_prefix_.assign(1, 0);
+    for (auto& column : column_list_) {
+      column.int_prefix.clear();
+      column.fp_prefix.clear();
+      column.value_list.clear();
+    }
+  }
+
+  const std::vector<uint64_t>& GetTimeList() const {
+    return time_list_;
+  }
+
+  // Aggregated report over the reports in [start, end] time range,
+  // empty if there are no reports in the range
+  std::vector<zet_typed_value_t> Aggregate(uint64_t start, uint64_t end) const {
+    PTI_ASSERT(start < end);
+
+    size_t start_index = utils::LowerBound(time_list_, start);
+    size_t end_index = utils::UpperBound(time_list_, end);
+    PTI_ASSERT(start_index <= end_index);
+    if (start_index == end_index) {
+      return std::vector<zet_typed_value_t>();
+    }
+
+    uint64_t total_clocks =
+      clocks_prefix_[end_index] - clocks_prefix_[start_index];
+
+    std::vector<zet_typed_value_t> aggregated_report(column_list_.size());
+    for (size_t i = 0; i < column_list_.size(); ++i) {
+      const Column& column = column_list_[i];
+      switch (column.aggregation) {
+        case AGGREGATION_TOTAL:
+          aggregated_report[i] = ComputeTotalValue(
+              column, start_index, end_index);
+          break;
+        case AGGREGATION_AVERAGE:
+          PTI_ASSERT(total_clocks > 0);
+          aggregated_report[i] = ComputeAverageValue(
+              column, start_index, end_index, total_clocks);
+          break;
+        case AGGREGATION_FIRST:
+          aggregated_report[i] = column.value_list[start_index];
+          break;
+        default:
+          break;
+      }
+    }
+
+    return aggregated_report;
+  }
+
+ private:
+  enum Aggregation {
+    AGGREGATION_NONE,
+    AGGREGATION_TOTAL,    // sum of the values
+    AGGREGATION_AVERAGE,  // average of the values weighted by GPU clocks
+    AGGREGATION_FIRST     // value of the first report in the range
+  };
+
+  struct Column {
+    Aggregation aggregation = AGGREGATION_NONE;
+    zet_value_type_t type = ZET_VALUE_TYPE_UINT32;
+    // prefix sums of the values (total) or the values multiplied by GPU
+    // clocks (average), for integer and floating point metrics respectively
+    std::vector<uint64_t> int_prefix;
+    std::vector<double> fp_prefix;
+    std::vector<zet_typed_value_t> value_list;  // values as is (first)
+  };
+
+  static Aggregation GetAggregation(
+      const std::string& metric, zet_metric_type_t metric_type) {
+    if (metric.find("GpuTime") != std::string::npos) {
+      return AGGREGATION_TOTAL;
+    }
+    if (metric.find("AvgGpuCoreFrequencyMHz") != std::string::npos) {
+      return AGGREGATION_AVERAGE;
+    }
+    if (metric.find("ReportReason") != std::string::npos) {
+      return AGGREGATION_FIRST;
+    }
+    switch (metric_type) {
+      case ZET_METRIC_TYPE_DURATION:
+      case ZET_METRIC_TYPE_RATIO:
+        return AGGREGATION_AVERAGE;
+      case ZET_METRIC_TYPE_THROUGHPUT:
+      case ZET_METRIC_TYPE_EVENT:
+        return AGGREGATION_TOTAL;
+      case ZET_METRIC_TYPE_TIMESTAMP:
+      case ZET_METRIC_TYPE_RAW:
+        return AGGREGATION_FIRST;
+      case ZET_METRIC_TYPE_EVENT_WITH_RANGE:
+      case ZET_METRIC_TYPE_FLAG:
+        return AGGREGATION_NONE;
+      default:
+        PTI_ASSERT(0);
+        break;
+    }
+    return AGGREGATION_NONE;
+  }
+
+  static void AppendValue(
+      Column& column, const zet_typed_value_t& value, uint64_t clocks) {
+    if (column.aggregation == AGGREGATION_NONE) {
+      return;
+    }
+    if (column.aggregation == AGGREGATION_FIRST) {
+      column.value_list.push_back(value);
+      return;
+    }
+
+    if (column.int_prefix.empty() && column.fp_prefix.empty()) {
+      column.type = value.type;
+      if (value.type == ZET_VALUE_TYPE_FLOAT32 ||
+          value.type == ZET_VALUE_TYPE_FLOAT64) {
+        column.fp_prefix.push_back(0.0);
+      } else {
+        column.int_prefix.push_back(0);
+      }
+    }
+    PTI_ASSERT(value.type == column.type);
+
+    bool average = (column.aggregation == AGGREGATION_AVERAGE);
+    switch (value.type) {
+      case ZET_VALUE_TYPE_UINT32:
+        column.int_prefix.push_back(column.int_prefix.back() +
+          (average ? value.value.ui32 * clocks : value.value.ui32));
+        break;
+      case ZET_VALUE_TYPE_UINT64:
+        column.int_prefix.push_back(column.int_prefix.back() +
+          (average ? value.value.ui64 * clocks : value.value.ui64));
+        break;
+      case ZET_VALUE_TYPE_FLOAT32:
+        column.fp_prefix.push_back(column.fp_prefix.back() +
+          (average ? value.value.fp32 * clocks : value.value.fp32));
+        break;
+      case ZET_VALUE_TYPE_FLOAT64:
+        column.fp_prefix.push_back(column.fp_prefix.back() +
+          (average ? value.value.fp64 * clocks : value.value.fp64));
+        break;
+      case ZET_VALUE_TYPE_BOOL8:
+        // how to average bool values?
+        PTI_ASSERT(!average);
+        // count of set values, the total is their logical OR
+        column.int_prefix.push_back(column.int_prefix.back() +
+          (value.value.b8 ? 1 : 0));
+        break;
+      default:
+        PTI_ASSERT(0);
+        break;
+    }
+  }
+
+  static zet_typed_value_t ComputeTotalValue(
+      const Column& column, size_t start_index, size_t end_index) {
+    zet_typed_value_t total;
+    switch (column.type) {
+      case ZET_VALUE_TYPE_UINT32:
+      case ZET_VALUE_TYPE_UINT64:
+        total.type = ZET_VALUE_TYPE_UINT64;
+        total.value.ui64 =
+          column.int_prefix[end_index] - column.int_prefix[start_index];
+        break;
+      case ZET_VALUE_TYPE_FLOAT32:
+      case ZET_VALUE_TYPE_FLOAT64:
+        total.type = ZET_VALUE_TYPE_FLOAT64;
+        total.value.fp64 =
+          column.fp_prefix[end_index] - column.fp_prefix[start_index];
+        break;
+      case ZET_VALUE_TYPE_BOOL8:
+        total.type = ZET_VALUE_TYPE_BOOL8;
+        total.value.b8 =
+          (column.int_prefix[end_index] > column.int_prefix[start_index]);
+        break;
+      default:
+        PTI_ASSERT(0);
+        break;
+    }
+    return total;
+  }
+
+  static zet_typed_value_t ComputeAverageValue(
+      const Column& column, size_t start_index, size_t end_index,
+      uint64_t total_clocks) {
+    zet_typed_value_t total = ComputeTotalValue(column, start_index, end_index);
+    if (total.type == ZET_VALUE_TYPE_UINT64) {
+      total.value.ui64 /= total_clocks;
+    } else {
+      PTI_ASSERT(total.type == ZET_VALUE_TYPE_FLOAT64);
+      total.value.fp64 /= total_clocks;
+    }
+    return total;
+  }
+
+  size_t time_id_;
+  size_t gpu_clocks_id_;
+  std::vector<uint64_t> time_list_;
+  std::vector<uint64_t> clocks_prefix_;
+  std::vector<Column> column_list_;
+};
+
+#endif // PTI_TOOLS_ONEPROF_METRIC_COLUMNS_H_
@@ -7,23 +7,264 @@
 #ifndef PTI_TOOLS_ONEPROF_METRIC_STORAGE_H_
 #define PTI_TOOLS_ONEPROF_METRIC_STORAGE_H_
 
+#include <algorithm>
+#include <cerrno>
 #include <cstring>
 #include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
 #include <vector>
 
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #include "utils.h"
 
 #define MAX_REPORT_SIZE  512
 #define MAX_REPORT_COUNT 32768
 #define MAX_BUFFER_SIZE  (MAX_REPORT_COUNT * MAX_REPORT_SIZE * 2)
 
-#define CACHE_SIZE 134217728
+#define MAPPED_WINDOW_SIZE 67108864
+
+// Append-only file written through a memory-mapped window that slides
+// forward as the file grows, so only one window is resident at a time
+class MappedFileWriter {
+ public:
+  explicit MappedFileWriter(const std::string& filename) {
+#if defined(_WIN32)
+    file_.open(filename, std::ios::out | std::ios::binary);
+#else
+    fd_ = open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+#endif
+  }
+
+  ~MappedFileWriter() {
+#if defined(_WIN32)
+    file_.close();
+#else
+    if (fd_ < 0) {
+      return;
+    }
+    if (window_ != nullptr) {
+      munmap(window_, MAPPED_WINDOW_SIZE);
+    }
+    // drop the unused tail of the last window
+    int status = ftruncate(fd_, size_);
+    PTI_ASSERT(status == 0);
+    close(fd_);
+#endif
+  }
+
+  bool IsOpen() const {
+#if defined(_WIN32)
+    return file_.is_open();
+#else
+    return fd_ >= 0;
+#endif
+  }
+
+  void Write(const uint8_t* data, size_t size) {
+    PTI_ASSERT(data != nullptr);
+#if defined(_WIN32)
+    file_.write(reinterpret_cast<const char*>(data), size);
+    size_ += size;
+#else
+    if (failed_) {
+      return;
+    }
+    while (size > 0) {
+      if (window_ == nullptr || size_ == window_offset_ + MAPPED_WINDOW_SIZE) {
+        if (!MapWindow((window_ == nullptr) ? 0 : size_)) {
+          return;
+        }
+      }
+
+      size_t offset = size_ - window_offset_;
+      size_t part = std::min<size_t>(size, MAPPED_WINDOW_SIZE - offset);
+      memcpy(window_ + offset, data, part);
+      data += part;
+      size -= part;
+      size_ += part;
+    }
+#endif
+  }
+
+  MappedFileWriter(const MappedFileWriter& copy) = delete;
+  MappedFileWriter& operator=(const MappedFileWriter& copy) = delete;
+
+ private:
+#if !defined(_WIN32)
+  bool MapWindow(size_t offset) {
+    if (window_ != nullptr) {
+      munmap(window_, MAPPED_WINDOW_SIZE);
+      window_ = nullptr;
+    }
+
+    // allocate the blocks up front, writing to a mapped hole on a full disk
+    // would raise SIGBUS
+    int status = posix_fallocate(fd_, offset, MAPPED_WINDOW_SIZE);
+    if (status != 0) {
+      Fail("Unable to extend metric data file", status);
+      return false;
+    }
+
+    void* window = mmap(nullptr, MAPPED_WINDOW_SIZE, PROT_READ | PROT_WRITE,
+                        MAP_SHARED, fd_, offset);
+    if (window == MAP_FAILED) {
+      Fail("Unable to map metric data file", errno);
+      return false;
+    }
+    madvise(window, MAPPED_WINDOW_SIZE, MADV_SEQUENTIAL);
+
+    window_ = reinterpret_cast<uint8_t*>(window);
+    window_offset_ = offset;
+    return true;
+  }
+
+  // The data written so far is kept, the file is truncated to it on close
+  void Fail(const char* message, int error) {
+    std::cerr << "[WARNING] " << message << " (" << strerror(error) <<
+      "), the rest of the data is lost" << std::endl;
+    failed_ = true;
+  }
+#endif
 
-struct CacheBuffer {
-  std::vector<uint8_t> buffer = std::vector<uint8_t>(CACHE_SIZE);
-  size_t used_size = 0;
+ private:
+#if defined(_WIN32)
+  std::ofstream file_;
+#else
+  int fd_ = -1;
+  uint8_t* window_ = nullptr;
+  size_t window_offset_ = 0;
+  bool failed_ = false;  // no more data is written once the file can not grow
+#endif
+  size_t size_ = 0;
 };
 
+// Read-only memory-mapped file
+class MappedFileReader {
+ public:
+  explicit MappedFileReader(const std::string& filename) {
+#if defined(_WIN32)
+    file_ = CreateFileA(
+        filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file_ == INVALID_HANDLE_VALUE) {
+      return;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file_, &size) || size.QuadPart == 0) {
+      return;
+    }
+    mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    PTI_ASSERT(mapping_ != nullptr);
+    data_ = reinterpret_cast<const uint8_t*>(
+        MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+    PTI_ASSERT(data_ != nullptr);
+    size_ = size.QuadPart;
+#else
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return;
+    }
+    is_open_ = true;
+
+    struct stat stat_buffer;
+    if (fstat(fd, &stat_buffer) == 0 && stat_buffer.st_size > 0) {
+      void* data = mmap(nullptr, stat_buffer.st_size, PROT_READ, MAP_PRIVATE,
+                        fd, 0);
+      PTI_ASSERT(data != MAP_FAILED);
+      // the finalizer mostly scans the reports from the start to the end
+      madvise(data, stat_buffer.st_size, MADV_SEQUENTIAL);
+      data_ = reinterpret_cast<const uint8_t*>(data);
+      size_ = stat_buffer.st_size;
+    }
+    close(fd);
+#endif
+  }
+
+  ~MappedFileReader() {
+#if defined(_WIN32)
+    if (data_ != nullptr) {
+      UnmapViewOfFile(data_);
+    }
+    if (mapping_ != nullptr) {
+      CloseHandle(mapping_);
+    }
+    if (file_ != INVALID_HANDLE_VALUE) {
+      CloseHandle(file_);
+    }
+#else
+    if (data_ != nullptr) {
+      munmap(const_cast<uint8_t*>(data_), size_);
+    }
+#endif
+  }
+
+  bool IsOpen() const {
+#if defined(_WIN32)
+    return file_ != INVALID_HANDLE_VALUE;
+#else
+    return is_open_;
+#endif
+  }
+
+  const uint8_t* GetData() const {
+    return data_;
+  }
+
+  size_t GetSize() const {
+    return size_;
+  }
+
+  MappedFileReader(const MappedFileReader& copy) = delete;
+  MappedFileReader& operator=(const MappedFileReader& copy) = delete;
+
+ private:
+#if defined(_WIN32)
+  HANDLE file_ = INVALID_HANDLE_VALUE;
+  HANDLE mapping_ = nullptr;
+#else
+  bool is_open_ = false;
+#endif
+  const uint8_t* data_ = nullptr;
+  size_t size_ = 0;
+};
+
+inline std::vector<std::string> GetMetricFileList(
+    uint32_t count,
+    uint32_t pid,
+    const std::string& ext,
+    const std::string& path) {
+  std::vector<std::string> filename_list;
+  if (count == 0) {
+    std::string filename =
+      std::string("data.") + std::to_string(pid) + "." + ext;
+    if (!path.empty()) {
+      filename = path + "/" + filename;
+    }
+    filename_list.push_back(filename);
+  } else {
+    for (uint32_t i = 0; i < count; ++i) {
+      std::string filename =
+        std::string("data.") + std::to_string(pid) + "." +
+        std::to_string(i) + "." + ext;
+      if (!path.empty()) {
+        filename = path + "/" + filename;
+      }
+      filename_list.push_back(filename);
+    }
+  }
+  return filename_list;
+}
+
 class MetricStorage {
  public:
   static MetricStorage* Create(
@@ -38,7 +279,7 @@ class MetricStorage {
 
     bool succeed = true;
     for (const auto& file : storage->storage_) {
-      succeed = succeed && file.is_open();
+      succeed = succeed && file->IsOpen();
     }
 
     if (!succeed) {
@@ -49,44 +290,11 @@ class MetricStorage {
     return storage;
   }
 
-  ~MetricStorage() {
-    PTI_ASSERT(storage_.size() == cache_.size());
-
-    for (size_t i = 0; i < cache_.size(); ++i) {
-      if (cache_[i].used_size > 0) {
-        const char* buffer = reinterpret_cast<const char*>(
-            cache_[i].buffer.data());
-        storage_[i].write(
-            buffer, cache_[i].used_size * sizeof(uint8_t));
-      }
-    }
-
-    for (auto& storage : storage_) {
-      storage.close();
-    }
-  }
-
   void Dump(const uint8_t* data, uint32_t size, uint32_t storage_id) {
     PTI_ASSERT(data != nullptr);
     PTI_ASSERT(size > 0);
     PTI_ASSERT(storage_id < storage_.size());
-    PTI_ASSERT(storage_id < cache_.size());
-
-    if (cache_[storage_id].used_size + size >
-        cache_[storage_id].buffer.size()) {
-      const char* buffer = reinterpret_cast<const char*>(
-          cache_[storage_id].buffer.data());
-      storage_[storage_id].write(
-          buffer, cache_[storage_id].used_size * sizeof(uint8_t));
-      cache_[storage_id].used_size = 0;
-    }
-
-    PTI_ASSERT(cache_[storage_id].used_size + size <=
-               cache_[storage_id].buffer.size());
-    memcpy(
-        cache_[storage_id].buffer.data() + cache_[storage_id].used_size,
-        data, size * sizeof(uint8_t));
-    cache_[storage_id].used_size += size;
+    storage_[storage_id]->Write(data, size);
   }
 
  private:
@@ -95,38 +303,13 @@ class MetricStorage {
       uint32_t pid,
       const std::string& ext,
       const std::string& path) {
-    std::vector<std::string> filename_list;
-    if (count == 0) {
-      std::string filename =
-        std::string("data.") + std::to_string(pid) + "." + ext;
-      if (!path.empty()) {
-        filename = path + "/" + filename;
-      }
-      filename_list.push_back(filename);
-    } else {
-      for (uint32_t i = 0; i < count; ++i) {
-        std::string filename =
-          std::string("data.") + std::to_string(pid) + "." +
-          std::to_string(i) + "." + ext;
-        if (!path.empty()) {
-          filename = path + "/" + filename;
-        }
-        filename_list.push_back(filename);
-      }
-    }
-
-    for (const auto& filename : filename_list) {
-      storage_.emplace(
-          storage_.end(),
-          std::ofstream(filename, std::ios::out | std::ios::binary));
-      cache_.emplace_back(CacheBuffer());
-      PTI_ASSERT(!cache_.back().buffer.empty());
+    for (const auto& filename : GetMetricFileList(count, pid, ext, path)) {
+      storage_.push_back(std::make_unique<MappedFileWriter>(filename));
     }
   }
 
  private:
-  std::vector<std::ofstream> storage_;
-  std::vector<CacheBuffer> cache_;
+  std::vector< std::unique_ptr<MappedFileWriter> > storage_;
 };
 
 class MetricReader {
@@ -143,7 +326,7 @@ class MetricReader {
 
     bool succeed = true;
     for (const auto& file : reader->storage_) {
-      succeed = succeed && file.is_open();
+      succeed = succeed && file->IsOpen();
     }
 
     if (!succeed) {
@@ -155,92 +338,80 @@ class MetricReader {
   }
 
   void Reset() {
-    for (auto& storage : storage_) {
-      storage.clear();
-      storage.seekg(0, storage.beg);
+    for (auto& position : position_) {
+      position = 0;
     }
   }
 
-  uint8_t* ReadChunk(uint32_t& size, uint32_t storage_id) {
+  // Returns the next (at most) size bytes in place, the data stays valid
+  // as long as the reader exists
+  const uint8_t* ReadChunk(uint32_t& size, uint32_t storage_id) {
     PTI_ASSERT(storage_id < storage_.size());
-    if (storage_[storage_id].peek() == std::ifstream::traits_type::eof()) {
+    size_t& position = position_[storage_id];
+    size_t file_size = storage_[storage_id]->GetSize();
+    if (position >= file_size) {
       size = 0;
       return nullptr;
     }
 
-    uint8_t* data = new uint8_t[size];
-    PTI_ASSERT(data != nullptr);
-
-    storage_[storage_id].read(reinterpret_cast<char*>(data), size);
-    if (storage_[storage_id].gcount() < size) {
-      size = storage_[storage_id].gcount();
+    if (file_size - position < size) {
+      size = file_size - position;
     }
 
+    const uint8_t* data = storage_[storage_id]->GetData() + position;
+    position += size;
     return data;
   }
 
+  // Returns size bytes at start in place, the data stays valid as long as
+  // the reader exists
+  const uint8_t* ReadInPlace(uint32_t storage_id, size_t start, size_t size) {
+    PTI_ASSERT(storage_id < storage_.size());
+    PTI_ASSERT(start + size <= storage_[storage_id]->GetSize());
+
+    position_[storage_id] = start + size;
+    return storage_[storage_id]->GetData() + start;
+  }
+
   void Read(uint32_t storage_id, size_t start, size_t size, char* data) {
     PTI_ASSERT(storage_id < storage_.size());
     PTI_ASSERT(data != nullptr);
+    PTI_ASSERT(start + size <= storage_[storage_id]->GetSize());
 
-    storage_[storage_id].seekg(start);
-    storage_[storage_id].read(data, size);
-    PTI_ASSERT(storage_[storage_id].gcount() == size);
+    memcpy(data, storage_[storage_id]->GetData() + start, size);
+    position_[storage_id] = start + size;
   }
 
   bool ReadNext(uint32_t storage_id, size_t size, char* data) {
     PTI_ASSERT(storage_id < storage_.size());
     PTI_ASSERT(data != nullptr);
 
-    storage_[storage_id].read(data, size);
-    if (storage_[storage_id].gcount() < size) {
+    size_t& position = position_[storage_id];
+    if (storage_[storage_id]->GetSize() - position < size) {
+      position = storage_[storage_id]->GetSize();
       return false;
     }
 
+    memcpy(data, storage_[storage_id]->GetData() + position, size);
+    position += size;
     return true;
   }
 
-  ~MetricReader() {
-    for (auto& storage : storage_) {
-      storage.close();
-    }
-  }
-
  private:
   MetricReader(
       uint32_t count,
       uint32_t pid,
       const std::string& ext,
       const std::string& path) {
-    std::vector<std::string> filename_list;
-    if (count == 0) {
-      std::string filename =
-        std::string("data.") + std::to_string(pid) + "." + ext;
-      if (!path.empty()) {
-        filename = path + "/" + filename;
-      }
-      filename_list.push_back(filename);
-    } else {
-      for (uint32_t i = 0; i < count; ++i) {
-        std::string filename =
-          std::string("data.") + std::to_string(pid) + "." +
-          std::to_string(i) + "." + ext;
-        if (!path.empty()) {
-          filename = path + "/" + filename;
-        }
-        filename_list.push_back(filename);
-      }
-    }
-
-    for (const auto& filename : filename_list) {
-      storage_.emplace(
-          storage_.end(),
-          std::ifstream(filename, std::ios::in | std::ios::binary));
+    for (const auto& filename : GetMetricFileList(count, pid, ext, path)) {
+      storage_.push_back(std::make_unique<MappedFileReader>(filename));
+      position_.push_back(0);
     }
   }
 
  private:
-  std::vector<std::ifstream> storage_;
+  std::vector< std::unique_ptr<MappedFileReader> > storage_;
+  std::vector<size_t> position_;
 };
 
 #endif // PTI_TOOLS_ONEPROF_METRIC_STORAGE_H_
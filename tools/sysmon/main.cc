@@ -1,15 +1,21 @@
+#include <signal.h>
+
 #include <bitset>
+#include <chrono>
 #include <iomanip>
 #include <iostream>
 #include <map>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include <level_zero/ze_api.h>
 #include <level_zero/zes_api.h>
 
+#include "telemetry_sampler.h"
 #include "utils.h"
 #include "ze_utils.h"
+#include "zes_telemetry_backend.h"
 
 #define BYTES_IN_KB (1024.0f)
 #define BYTES_IN_MB (1024.0f * 1024)
@@ -25,12 +31,23 @@
 #define MEMORY_LENGTH   24
 #define ENGINES_LENGTH  12
 
+#define WATCH_FLUSH_PERIOD_MS 1000
+
 enum Mode {
   MODE_PROCESSES,
   MODE_DEVICE_LIST,
-  MODE_DETAILS
+  MODE_DETAILS,
+  MODE_WATCH
+};
+
+struct WatchOptions {
+  uint32_t interval = 1000;  // ms
+  uint64_t count = 0;  // 0 means until interrupted
+  TelemetryFormat format = TELEMETRY_FORMAT_LINE;
 };
 
+static volatile sig_atomic_t watch_stopped = 0;
+
 static void Usage() {
   std::cout <<
     "Usage: ./sysmon [options]" <<
@@ -48,6 +65,22 @@ static void Usage() {
     "--details [-d]      " <<
     "Print detailed information for all of the devices and subdevices" <<
     std::endl;
+  std::cout <<
+    "--watch [-w] <ms>   " <<
+    "Sample frequency, power, temperature, memory bandwidth and engine" <<
+    std::endl;
+  std::cout <<
+    "                    " <<
+    "utilization every <ms> milliseconds as line protocol records" <<
+    std::endl;
+  std::cout <<
+    "  --count <n>       " <<
+    "Stop after <n> samples (default: until interrupted)" <<
+    std::endl;
+  std::cout <<
+    "  --binary          " <<
+    "Write binary records instead of line protocol" <<
+    std::endl;
   std::cout <<
     "--help [-h]         " <<
     "Print help message" <<
@@ -1216,8 +1249,90 @@ static void PrintDetails(ze_driver_handle_t driver,
   std::cout << std::endl;
 }
 
+static bool ParseWatchOptions(
+    int argc, char* argv[], WatchOptions* options) {
+  PTI_ASSERT(options != nullptr);
+  if (argc < 3) {
+    return false;
+  }
+
+  try {
+    int interval = std::stoi(argv[2]);
+    if (interval <= 0) {
+      return false;
+    }
+    options->interval = static_cast<uint32_t>(interval);
+
+    for (int i = 3; i < argc; ++i) {
+      if (std::string(argv[i]) == "--count" && i + 1 < argc) {
+        options->count = std::stoull(argv[++i]);
+      } else if (std::string(argv[i]) == "--binary") {
+        options->format = TELEMETRY_FORMAT_BINARY;
+      } else {
+        return false;
+      }
+    }
+  } catch (const std::exception&) {
+    return false;
+  }
+
+  return true;
+}
+
+static void OnWatchSignal(int /* signal */) {
+  watch_stopped = 1;
+}
+
+// Samples all devices with the period until interrupted, records are
+// written in batches of about WATCH_FLUSH_PERIOD_MS
+static void Watch(
+    const std::vector<ze_driver_handle_t>& driver_list,
+    const WatchOptions& options) {
+  std::vector<zes_device_handle_t> device_list;
+  for (auto driver : driver_list) {
+    for (auto device : utils::ze::GetDeviceList(driver)) {
+      device_list.push_back(device);
+    }
+  }
+
+  ZesTelemetryBackend backend(device_list);
+  uint32_t batch = WATCH_FLUSH_PERIOD_MS / options.interval;
+  if (batch == 0) {
+    batch = 1;
+  }
+  TelemetrySampler sampler(&backend, 2 * batch);
+  TelemetryWriter writer(stdout, options.format);
+
+  signal(SIGINT, OnWatchSignal);
+  signal(SIGTERM, OnWatchSignal);
+
+  auto write = [&writer](const TelemetrySample& sample) {
+    writer.Write(sample);
+  };
+
+  auto period = std::chrono::milliseconds(options.interval);
+  auto next = std::chrono::steady_clock::now();
+  for (uint64_t i = 0; options.count == 0 || i < options.count; ++i) {
+    std::this_thread::sleep_until(next);
+    if (watch_stopped) {
+      break;
+    }
+    next += period;
+
+    sampler.Sample(utils::GetTime(CLOCK_REALTIME));
+    if (sampler.GetPendingCount() >= batch * sampler.GetDeviceCount()) {
+      sampler.TakePending(write);
+      writer.Flush();
+    }
+  }
+
+  sampler.TakePending(write);
+  writer.Flush();
+}
+
 int main(int argc, char* argv[]) {
   Mode mode = MODE_PROCESSES;
+  WatchOptions watch_options;
   ze_result_t status = ZE_RESULT_SUCCESS;
 
   if (argc > 1) {
@@ -1234,6 +1349,13 @@ int main(int argc, char* argv[]) {
     } else if (std::string(argv[1]) == "--details" ||
                std::string(argv[1]) == "-d") {
       mode = MODE_DETAILS;
+    } else if (std::string(argv[1]) == "--watch" ||
+               std::string(argv[1]) == "-w") {
+      if (!ParseWatchOptions(argc, argv, &watch_options)) {
+        Usage();
+        return EXIT_FAILURE;
+      }
+      mode = MODE_WATCH;
     } else if (std::string(argv[1]) == "--version") {
 #ifdef PTI_VERSION
       std::cout << TOSTRING(PTI_VERSION) << std::endl;
@@ -1280,8 +1402,12 @@ int main(int argc, char* argv[]) {
   }
 
   PTI_ASSERT(mode == MODE_DEVICE_LIST || mode == MODE_DETAILS ||
-             mode == MODE_PROCESSES);
+             mode == MODE_PROCESSES || mode == MODE_WATCH);
   switch(mode) {
+    case MODE_WATCH: {
+      Watch(driver_list, watch_options);
+      break;
+    }
     case MODE_DEVICE_LIST: {
       PrintDeviceList(driver_list);
       break;
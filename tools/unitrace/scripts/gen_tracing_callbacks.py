@@ -255,27 +255,57 @@ def get_enum_map(include_path):
 
 # Generate Callbacks ##########################################################
 
-def gen_register(f, func_list):
+def gen_register_callback(f, reg_fname, site, callback, condition):
+  indent = "      "
+  if condition != "":
+    f.write("      if (" + condition + ") {\n")
+    indent = "        "
+  f.write(indent + "status = " + reg_fname + "(tracer, " + site + ", " + callback + ");\n")
+  f.write(indent + "PTI_ASSERT(status == ZE_RESULT_SUCCESS);\n")
+  if condition != "":
+    f.write("      }\n")
+
+# Callbacks of functions in always_list are registered unconditionally. In kernel tracing only mode
+# a callback that does not call into the collector is needed only if host API events are logged, so it
+# is registered on the "host_events" condition.
+def gen_register(f, func_list, always_list=None):
   for func in func_list:
     offset = 2
     if func.startswith("zer") or func.startswith("zex"):
       offset = 3
     reg_fname = "ZeLoader::get().zelTracer" + func[offset:] + "RegisterCallback_"
+    enter_condition = ""
+    exit_condition = ""
+    if always_list is not None:
+      if (func, "enter") not in always_list:
+        enter_condition = "host_events"
+      if (func, "exit") not in always_list:
+        exit_condition = "host_events"
     f.write("    if (" + reg_fname + " != nullptr) {\n")
-    f.write("      status = " + reg_fname + "(tracer, ZEL_REGISTER_PROLOGUE, " + func + "OnEnter);\n")
-    f.write("      PTI_ASSERT(status == ZE_RESULT_SUCCESS);\n")
-    f.write("      status = " + reg_fname + "(tracer, ZEL_REGISTER_EPILOGUE, " + func + "OnExit);\n")
-    f.write("      PTI_ASSERT(status == ZE_RESULT_SUCCESS);\n")
+    gen_register_callback(f, reg_fname, "ZEL_REGISTER_PROLOGUE", func + "OnEnter", enter_condition)
+    gen_register_callback(f, reg_fname, "ZEL_REGISTER_EPILOGUE", func + "OnExit", exit_condition)
     f.write("    }\n")
 
-def gen_api(f, func_list, kfunc_list):
+def gen_api(f, func_list, kfunc_list, synchronize_func_list_on_enter):
+  # Callbacks device activity tracing depends on: the ones calling into kernel tracing callbacks of the
+  # collector, the exit callbacks the enter callbacks pass kernel ids to and the extension API interception
+  always_list = set()
+  for func in kfunc_list:
+    if get_kernel_tracing_callback('OnEnter' + func[2:]) != "":
+      always_list.add((func, "enter"))
+    if get_kernel_tracing_callback('OnExit' + func[2:]) != "" or func in synchronize_func_list_on_enter or func == "zeDriverGetExtensionFunctionAddress":
+      always_list.add((func, "exit"))
+
   f.write("void EnableTracing(zel_tracer_handle_t tracer) {\n")
   f.write("  ze_result_t status = ZE_RESULT_SUCCESS;\n")
   f.write("  if (options_.api_tracing) {\n")
   gen_register(f, func_list)
   f.write("  }\n")
   f.write("  else if (options_.kernel_tracing) {\n")
-  gen_register(f, kfunc_list)
+  f.write("    // host API events are logged in the timeline only if there is a function callback,\n")
+  f.write("    // otherwise applications do not pay for the callbacks that only take timestamps\n")
+  f.write("    bool host_events = (fcallback_ != nullptr);\n")
+  gen_register(f, kfunc_list, always_list)
   f.write("  }\n")
   f.write("\n")
   f.write("  status = ZE_FUNC(zelTracerSetEnabled)(tracer, true);\n")
@@ -1176,7 +1206,7 @@ def main():
   gen_result_converter(dst_file, enum_map)
   gen_structure_type_converter(dst_file, enum_map)
   gen_callbacks(dst_file, func_dict, submission_func_list, synchronize_func_list_on_enter, synchronize_func_list_on_exit, param_map)
-  gen_api(dst_file, func_list, kfunc_list)
+  gen_api(dst_file, func_list, kfunc_list, synchronize_func_list_on_enter)
 
   # Parse and generate extension API tracing
   ext_funcs = []
@@ -7,6 +7,7 @@
 #ifndef PTI_TOOLS_UNITRACE_CHROME_LOGGER_H_
 #define PTI_TOOLS_UNITRACE_CHROME_LOGGER_H_
 
+#include <atomic>
 #include <chrono>
 #include <cstdint>
 #include <fstream>
@@ -25,7 +26,11 @@
 #include "unievent.h"
 #include "unimemory.h"
 #include "logger_factory.h"
+#include "telemetry_sampler.h"
 #include "utils_host.h"
+#ifndef _WIN32
+#include "event_stream.h"
+#endif /* _WIN32 */
 
 #include "common_header.gen"
 
@@ -77,6 +82,109 @@ static std::shared_ptr<Logger> logger_ = nullptr;
 
 std::recursive_mutex logger_lock_; //lock to synchronize file write
 
+#ifndef _WIN32
+// live stream of the events to a consumer, nullptr if not enabled (see --stream-events)
+static std::atomic<EventStreamer*> event_streamer_{nullptr};
+static std::atomic<uint32_t> event_streamer_users_{0};  // threads between loading the streamer and done using it
+
+// Keeps the streamer alive while the thread adds events to it, see DestroyEventStreamer()
+class EventStreamerRef {
+  public:
+    EventStreamerRef() {
+      event_streamer_users_.fetch_add(1, std::memory_order_seq_cst);
+      streamer_ = event_streamer_.load(std::memory_order_seq_cst);
+    }
+    ~EventStreamerRef() {
+      event_streamer_users_.fetch_sub(1, std::memory_order_release);
+    }
+    EventStreamerRef(const EventStreamerRef& that) = delete;
+    EventStreamerRef& operator=(const EventStreamerRef& that) = delete;
+
+    EventStreamer* Get() const {
+      return streamer_;
+    }
+
+  private:
+    EventStreamer* streamer_;
+};
+
+// Application threads may still be streaming events, so wait for them to be done with the streamer before freeing it
+static void DestroyEventStreamer() {
+  EventStreamer* streamer = event_streamer_.exchange(nullptr, std::memory_order_seq_cst);
+  while (event_streamer_users_.load(std::memory_order_acquire) != 0) {
+    std::this_thread::yield();
+  }
+  delete streamer;
+}
+
+static std::string UnquoteEventName(const std::string& name) {
+  if ((name.size() >= 2) && (name[0] == '\"') && (name[name.size() - 1] == '\"')) {
+    return name.substr(1, name.size() - 2);
+  }
+  return name;
+}
+
+static void StreamHostEvent(const HostEventRecord& rec, uint32_t tid) {
+  if (event_streamer_.load(std::memory_order_relaxed) == nullptr) {
+    return;
+  }
+  EventStreamerRef streamer;
+  if (streamer.Get() == nullptr) {
+    return;
+  }
+
+  EventStreamRecord srec;
+  if (rec.type_ == EVENT_COMPLETE) {
+    srec.ph_ = 'X';
+  } else if (rec.type_ == EVENT_DURATION_START) {
+    srec.ph_ = 'B';
+  } else if (rec.type_ == EVENT_DURATION_END) {
+    srec.ph_ = 'E';
+  } else {
+    // flows and marks are not streamed
+    return;
+  }
+
+  std::string name;
+  if (rec.name_ != nullptr) {
+    name = UnquoteEventName(rec.name_);
+  } else if ((rec.api_id_ != XptiTracingId) && (rec.api_id_ != IttTracingId)) {
+    name = get_symbol(rec.api_id_);
+  }
+
+  srec.start_ = UniTimer::GetEpochTime(rec.start_time_);
+  srec.dur_ = (rec.type_ == EVENT_COMPLETE) ? (rec.end_time_ - rec.start_time_) : 0;
+  srec.id_ = rec.id_;
+  srec.tid_ = tid;
+  srec.kind_ = EVENT_STREAM_HOST;
+  srec.tile_ = -1;
+  srec.engine_ = 0;
+  streamer.Get()->Add(srec, name);
+}
+
+template <typename T>
+static void StreamDeviceEvent(const T& rec, const std::string& kname, uint32_t engine) {
+  EventStreamerRef streamer;
+  if (streamer.Get() == nullptr) {
+    return;
+  }
+  EventStreamRecord srec;
+  std::string name = UnquoteEventName(kname);
+  if (rec.implicit_scaling_) {
+    name = "Tile #" + std::to_string(rec.tile_) + ": " + name;
+  }
+  srec.start_ = UniTimer::GetEpochTime(rec.start_time_);
+  srec.dur_ = rec.end_time_ - rec.start_time_;
+  srec.id_ = rec.kid_;
+  srec.tid_ = static_cast<uint32_t>(rec.tid_);
+  srec.kind_ = EVENT_STREAM_DEVICE;
+  srec.ph_ = 'X';
+  srec.tile_ = static_cast<int16_t>(rec.tile_);
+  srec.engine_ = engine;
+  streamer.Get()->Add(srec, name);
+}
+#endif /* _WIN32 */
+
 static bool device_logging_no_thread_ = (utils::GetEnv("UNITRACE_ChromeNoThreadOnDevice") == "1") ? true : false;
 static bool device_logging_no_engine_ = (utils::GetEnv("UNITRACE_ChromeNoEngineOnDevice") == "1") ? true : false;
 
@@ -714,6 +822,9 @@ class TraceBuffer {
     }
 
     void BufferHostEvent(void) {
+#ifndef _WIN32
+      StreamHostEvent(host_event_buffer_[current_host_event_buffer_slice_][next_host_event_index_], tid_);
+#endif /* _WIN32 */
       if (flush_immediately_) {
         std::lock_guard<std::recursive_mutex> lock(logger_lock_);
         FlushHostEvent(host_event_buffer_[current_host_event_buffer_slice_][next_host_event_index_]);
@@ -727,6 +838,13 @@ class TraceBuffer {
     }
 
     void BufferDeviceEvent(void) {
+#ifndef _WIN32
+      if (event_streamer_.load(std::memory_order_acquire) != nullptr) {
+        auto& rec = device_event_buffer_[current_device_event_buffer_slice_][next_device_event_index_];
+        StreamDeviceEvent(rec, GetZeKernelCommandName(rec.kernel_command_id_, rec.group_count_, rec.mem_size_),
+                          (rec.engine_ordinal_ << 16) | (rec.engine_index_ & 0xFFFF));
+      }
+#endif /* _WIN32 */
       if (flush_immediately_) {
         std::lock_guard<std::recursive_mutex> lock(logger_lock_);
         FlushDeviceEvent(device_event_buffer_[current_device_event_buffer_slice_][next_device_event_index_]);
@@ -1177,6 +1295,9 @@ class ClTraceBuffer {
     }
 
     void BufferHostEvent(void) {
+#ifndef _WIN32
+      StreamHostEvent(host_event_buffer_[current_host_event_buffer_slice_][next_host_event_index_], tid_);
+#endif /* _WIN32 */
       if (flush_immediately_) {
         std::lock_guard<std::recursive_mutex> lock(logger_lock_);
         FlushHostEvent(host_event_buffer_[current_host_event_buffer_slice_][next_host_event_index_]);
@@ -1190,6 +1311,12 @@ class ClTraceBuffer {
     }
 
     void BufferDeviceEvent(void) {
+#ifndef _WIN32
+      if (event_streamer_.load(std::memory_order_acquire) != nullptr) {
+        auto& rec = device_event_buffer_[current_device_event_buffer_slice_][next_device_event_index_];
+        StreamDeviceEvent(rec, GetClKernelCommandName(rec.kernel_command_id_), 0);
+      }
+#endif /* _WIN32 */
       if (flush_immediately_) {
         std::lock_guard<std::recursive_mutex> lock(logger_lock_);
         FlushDeviceEvent(device_event_buffer_[current_device_event_buffer_slice_][next_device_event_index_]);
@@ -1528,6 +1655,17 @@ class ChromeLogger {
 
       logger_->Log(str);
       logger_->SetEmptyPosition();
+
+#ifndef _WIN32
+      std::string address = utils::GetEnv("UNITRACE_EventStream");
+      if (!address.empty()) {
+        EventStreamDropPolicy policy;
+        if (!ParseEventStreamDropPolicy(utils::GetEnv("UNITRACE_EventStreamDropPolicy"), policy)) {
+          policy = EVENT_STREAM_BLOCK;
+        }
+        event_streamer_.store(EventStreamer::Create(address, policy, process_name_), std::memory_order_release);
+      }
+#endif /* _WIN32 */
     }
 
   public:
@@ -1560,6 +1698,11 @@ class ChromeLogger {
 
         logger_lock_.unlock();
 
+#ifndef _WIN32
+        // the buffers are finalized, send what is left to the consumer
+        DestroyEventStreamer();
+#endif /* _WIN32 */
+
         if (logger_->IsEmpty()) {
           // no data has been logged 
           std::cerr << "[INFO] No event of interest is logged for process " << utils::GetPid() << " (" << process_name_ << ")" << std::endl;
@@ -1710,6 +1853,38 @@ class ChromeLogger {
       }
     }
 
+    // Writes the sample as counter events of the host process, one counter per field, e.g. "GPU 0 Frequency"
+    static void TelemetryLoggingCallback(const TelemetrySample& sample) {
+      static const char* const counter_names[TELEMETRY_FIELD_COUNT] = {
+        "Frequency", "Power", "Temperature", "Memory Read Bandwidth", "Memory Write Bandwidth",
+        "Utilization", "Compute Utilization", "Render Utilization", "Media Utilization", "Copy Utilization"};
+      static const char* const counter_units[TELEMETRY_FIELD_COUNT] = {
+        "MHz", "W", "C", "GB/s", "GB/s", "%", "%", "%", "%", "%"};
+
+      double values[TELEMETRY_FIELD_COUNT] = {
+        sample.frequency, sample.power, sample.temperature, sample.read_bandwidth * 1e-9, sample.write_bandwidth * 1e-9};
+      for (uint32_t i = 0; i < TELEMETRY_ENGINE_COUNT; ++i) {
+        values[TELEMETRY_FIELD_UTILIZATION + i] = sample.utilization[i] * 100.0;
+      }
+
+      std::string prefix = ",\n{\"ph\": \"C\", \"name\": \"GPU " + std::to_string(sample.device) + " ";
+      std::string suffix = "\", \"pid\": " + std::to_string(utils::GetPid()) + ", \"ts\": " +
+                           std::to_string(sample.timestamp / 1000.0) + ", \"args\": {\"";
+      std::string str;
+      for (uint32_t i = 0; i < TELEMETRY_FIELD_COUNT; ++i) {
+        if (sample.IsValid(i)) {
+          str += prefix + counter_names[i] + suffix + counter_units[i] + "\": " + std::to_string(values[i]) + "}}";
+        }
+      }
+
+      if (!str.empty()) {
+        std::lock_guard<std::recursive_mutex> lock(logger_lock_);
+        if (logger_ != nullptr) {
+          logger_->Log(str);
+        }
+      }
+    }
+
     static void ZeChromeKernelLoggingCallback(uint64_t kid, uint64_t tid, uint64_t start, uint64_t end, uint32_t ordinal, uint32_t index, int32_t tile, const ze_device_handle_t device, const uint64_t kernel_command_id, bool implicit_scaling, const ze_group_count_t &group_count, size_t mem_size) {
       if (thread_local_buffer_.IsFinalized()) {
         return;
@@ -7,6 +7,9 @@
 #ifndef PTI_TOOLS_UNITRACE_COLLECTOR_OPTIONS_
 #define PTI_TOOLS_UNITRACE_COLLECTOR_OPTIONS_
 
+#include <cstddef>
+#include <cstdint>
+
 struct CollectorOptions {
   bool device_timing = false;
   bool device_timeline = false;
@@ -23,6 +26,9 @@ struct CollectorOptions {
   bool metric_query = false;
   bool metric_stream = false;
   bool stall_sampling = false;
+  size_t kernel_name_max_length = 0;  // 0: kernel names are not shortened in summary tables
+  uint32_t kernel_sampling_rate = 0;  // 0 or 1: every kernel launch is traced
+  bool kernel_sampling_reservoir = false;  // reservoir instead of every Nth launch sampling
 };
 
 #endif //PTI_TOOLS_UNITRACE_COLLECTOR_OPTIONS_
@@ -17,6 +17,7 @@
 #include <shared_mutex>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <cmath>
 #include <fstream>
@@ -30,6 +31,7 @@
 #include <level_zero/layers/zel_tracing_register_cb.h>
 
 #include "utils.h"
+#include "kernel_sampler.h"
 #include "ze_event_cache.h"
 #include "utils_ze.h"
 #include "collector_options.h"
@@ -229,6 +231,7 @@ struct ZeInstanceData {
   zet_metric_query_handle_t query_; // Appended command query handle
   ze_event_handle_t in_order_counter_event_;  // Appended command event counter based event or null
   bool instrument_;                 // false if command should be skipped
+  double sample_weight_;            // number of launches the instrumented one stands for
 };
 
 thread_local ZeInstanceData ze_instance_data;
@@ -527,6 +530,7 @@ struct ZeKernelCommandTime {
   uint64_t min_time_;
   uint64_t max_time_;
   uint64_t call_count_;
+  utils::SampledTotal sampled_time_;  // estimated total execute time of all launches if sampled
 
   bool operator>(const ZeKernelCommandTime& r) const {
     if (execute_time_ != r.execute_time_) {
@@ -684,6 +688,7 @@ void SweepKernelCommandTimeStats(std::map<ZeKernelCommandNameKey, ZeKernelComman
       stat.min_time_ = it->second.min_time_;
       stat.max_time_ = it->second.max_time_;
       stat.call_count_ = it->second.call_count_;
+      stat.sampled_time_ = it->second.sampled_time_;
       global_device_time_stats_->insert({it->first, std::move(stat)});
     }
     else {
@@ -697,6 +702,7 @@ void SweepKernelCommandTimeStats(std::map<ZeKernelCommandNameKey, ZeKernelComman
         it2->second.min_time_ = it->second.min_time_;
       }
       it2->second.call_count_ += it->second.call_count_;
+      it2->second.sampled_time_.Merge(it->second.sampled_time_);
     }
   }
   global_device_time_stats_mutex_.unlock();
@@ -778,6 +784,7 @@ struct ZeCommand {
   bool implicit_scaling_;
   bool immediate_;
   bool graph_command_;  // true if this command is part of a graph execution (event is owned by graph)
+  double sample_weight_;  // number of launches this one stands for under kernel sampling
 };
 
 
@@ -867,6 +874,7 @@ struct ZeDeviceSubmissions {
     command->command_list_ = nullptr;
     command->queue_ = nullptr;
     command->mem_size_ = 0;
+    command->sample_weight_ = 1.0;
 
     command->timestamp_seq_ = -1;
     command->timestamp_event_ = nullptr;
@@ -1013,6 +1021,7 @@ struct ZeDeviceSubmissions {
       stat.min_time_ = kernel_time;
       stat.max_time_ = kernel_time;
       stat.call_count_ = 1;
+      stat.sampled_time_.Add(kernel_time, command->sample_weight_);
       device_time_stats_.insert({std::move(key), std::move(stat)});
     }
     else {
@@ -1026,6 +1035,7 @@ struct ZeDeviceSubmissions {
         it->second.min_time_ = kernel_time;
       }
       it->second.call_count_ += 1;
+      it->second.sampled_time_.Add(kernel_time, command->sample_weight_);
     }
   }
 
@@ -1157,13 +1167,15 @@ typedef void (*OnZeKernelFinishCallback)(uint64_t kid, uint64_t tid, uint64_t st
 
 ze_result_t (*ZexKernelGetBaseAddress)(ze_kernel_handle_t hKernel, uint64_t *baseAddress) = nullptr;
 
-inline std::string GetZeKernelCommandName(uint64_t id, const ze_group_count_t& group_count, size_t size, bool detailed = true) {
+// The demangled name is shortened to max_name_length characters if it is not 0
+inline std::string FormatZeKernelCommandName(uint64_t id, const ze_group_count_t& group_count, size_t size, bool detailed, size_t max_name_length = 0) {
   std::string str;
   kernel_command_properties_mutex_.lock_shared();
   auto it = kernel_command_properties_->find(id);
   if (it != kernel_command_properties_->end()) {
     str = "\"";
-    str += std::move(utils::Demangle(it->second.name_.c_str()));  // quote kernel name which may contain ","
+    const std::string& name = utils::DemangleCached(it->second.name_.c_str());
+    str += (max_name_length == 0) ? name : utils::ShortenName(name, max_name_length);  // quote kernel name which may contain ","
     if (detailed) {
       if (it->second.type_ == KERNEL_COMMAND_TYPE_COMPUTE) {
         if (it->second.simd_width_ > 0) {
@@ -1194,6 +1206,51 @@ inline std::string GetZeKernelCommandName(uint64_t id, const ze_group_count_t& g
   return str;
 }
 
+struct ZeKernelCommandNameCacheKey {
+  uint64_t id_;
+  uint32_t group_count_[3];
+  size_t size_;
+  bool detailed_;
+
+  bool operator==(const ZeKernelCommandNameCacheKey& other) const {
+    return (id_ == other.id_) && (group_count_[0] == other.group_count_[0]) && (group_count_[1] == other.group_count_[1]) &&
+      (group_count_[2] == other.group_count_[2]) && (size_ == other.size_) && (detailed_ == other.detailed_);
+  }
+};
+
+struct ZeKernelCommandNameCacheKeyHash {
+  size_t operator()(const ZeKernelCommandNameCacheKey& key) const {
+    uint64_t hash = key.id_ * 0x9e3779b97f4a7c15ULL;
+    hash ^= ((uint64_t(key.group_count_[0]) << 32) | key.group_count_[1]) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    hash ^= ((uint64_t(key.group_count_[2]) << 1) | key.detailed_) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    hash ^= uint64_t(key.size_) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    return size_t(hash);
+  }
+};
+
+// Properties of a kernel command never change once recorded, so the name of every (command, group count, size)
+// is formatted once and then served from a per-thread cache, without taking kernel_command_properties_mutex_ again.
+// Device events of the same kernel launch configuration share the name.
+inline std::string GetZeKernelCommandName(uint64_t id, const ze_group_count_t& group_count, size_t size, bool detailed = true) {
+  constexpr size_t kMaxCachedNames = 4096;
+  thread_local std::unordered_map<ZeKernelCommandNameCacheKey, std::string, ZeKernelCommandNameCacheKeyHash> names;
+
+  ZeKernelCommandNameCacheKey key{id, {group_count.groupCountX, group_count.groupCountY, group_count.groupCountZ}, size, detailed};
+  auto it = names.find(key);
+  if (it != names.end()) {
+    return it->second;
+  }
+
+  std::string str = FormatZeKernelCommandName(id, group_count, size, detailed);
+  if (!str.empty()) {  // unknown commands may still be recorded later
+    if (names.size() >= kMaxCachedNames) {
+      names.clear();
+    }
+    names.emplace(key, str);
+  }
+  return str;
+}
+
 inline std::string GetZeKernelCommandName(uint64_t id, ze_group_count_t& group_count, size_t size, bool detailed = true) {
   const ze_group_count_t& gcount = group_count;
   return GetZeKernelCommandName(id, gcount, size, detailed);
@@ -1467,7 +1524,7 @@ class ZeCollector {
     global_device_time_stats_mutex_.lock();
     if (global_device_time_stats_) {
       for (auto it = global_device_time_stats_->begin(); it != global_device_time_stats_->end(); it++) {
-        total_time += it->second.execute_time_;
+        total_time += GetEstimatedStats(it->second).execute_time_;
       }
     }
     global_device_time_stats_mutex_.unlock();
@@ -1483,17 +1540,19 @@ class ZeCollector {
 
     AggregateDeviceTimeStats();
 
-    std::set<std::pair<ZeKernelCommandNameKey, ZeKernelCommandTime>, utils::Comparator> sorted_list(
-        global_device_time_stats_->begin(), global_device_time_stats_->end());
+    std::set<std::pair<ZeKernelCommandNameKey, ZeKernelCommandTime>, utils::Comparator> sorted_list;
+    for (auto& it : *global_device_time_stats_) {
+      sorted_list.emplace(it.first, GetEstimatedStats(it.second));
+    }
 
     for (auto& it : sorted_list) {
       total_time += it.second.execute_time_;
       std::string kname;
       if (it.first.tile_ >= 0) {
-        kname = "Tile #" + std::to_string(it.first.tile_) + ": " + GetZeKernelCommandName(it.first.kernel_command_id_, it.first.group_count_, it.first.mem_size_, options_.verbose);
+        kname = "Tile #" + std::to_string(it.first.tile_) + ": " + GetDisplayCommandName(it.first);
       }
       else {
-        kname = GetZeKernelCommandName(it.first.kernel_command_id_, it.first.group_count_, it.first.mem_size_, options_.verbose);
+        kname = GetDisplayCommandName(it.first);
       }
       if (kname.size() > max_name_size) {
         max_name_size = kname.size();
@@ -1510,7 +1569,11 @@ class ZeCollector {
         "    Time (%), " +
       std::string(std::max(int(kTimeLength - sizeof("Average (ns)") + 1), 0), ' ') + "Average (ns), " +
       std::string(std::max(int(kTimeLength - sizeof("Min (ns)") + 1), 0), ' ') + "Min (ns), " +
-      std::string(std::max(int(kTimeLength - sizeof("Max (ns)") + 1), 0), ' ') + "Max (ns)\n";
+      std::string(std::max(int(kTimeLength - sizeof("Max (ns)") + 1), 0), ' ') + "Max (ns)";
+      if (kernel_sampler_.IsEnabled()) {
+        str += ", " + std::string(std::max(int(kTimeLength - sizeof("Error (ns)") + 1), 0), ' ') + "Error (ns)";
+      }
+      str += "\n";
       logger->Log(str);
       int i = 0;
       for (auto& it : sorted_list) {
@@ -1529,11 +1592,21 @@ class ZeCollector {
         std::to_string(percent_time) + ", " +
         std::string(std::max(int(kTimeLength - std::to_string(avg_time).length()), 0), ' ') + std::to_string(avg_time) + ", " +
         std::string(std::max(int(kTimeLength - std::to_string(min_time).length()), 0), ' ') + std::to_string(min_time) + ", " +
-        std::string(std::max(int(kTimeLength - std::to_string(max_time).length()), 0), ' ') + std::to_string(max_time) + "\n";
+        std::string(std::max(int(kTimeLength - std::to_string(max_time).length()), 0), ' ') + std::to_string(max_time);
+        if (kernel_sampler_.IsEnabled()) {
+          // half-width of the 95% confidence interval of the time
+          uint64_t error = std::llround(it.second.sampled_time_.GetErrorBound());
+          str += ", " + std::string(std::max(int(kTimeLength - std::to_string(error).length()), 0), ' ') + std::to_string(error);
+        }
+        str += "\n";
         logger->Log(str);
         i++;
       }
 
+      if (kernel_sampler_.IsEnabled()) {
+        PrintKernelSamplingTable(logger);
+      }
+
       str = "\n\n=== Kernel Properties ===\n\n";
       str = str + std::string(std::max(int(max_name_size - sizeof("Kernel") + 1), 0), ' ') +
         "Kernel, Compiled, SIMD, Number of Arguments, SLM Per Work Group, Private Memory Per Thread, Spill Memory Per Thread, Register File Size Per Thread\n";
@@ -1595,8 +1668,10 @@ class ZeCollector {
 
     AggregateDeviceTimeStats();
 
-    std::set<std::pair<ZeKernelCommandNameKey, ZeKernelCommandTime>, utils::Comparator> sorted_list(
-        global_device_time_stats_->begin(), global_device_time_stats_->end());
+    std::set<std::pair<ZeKernelCommandNameKey, ZeKernelCommandTime>, utils::Comparator> sorted_list;
+    for (auto& it : *global_device_time_stats_) {
+      sorted_list.emplace(it.first, GetEstimatedStats(it.second));
+    }
 
     for (auto& it : sorted_list) {
       total_device_time += it.second.execute_time_;
@@ -1604,10 +1679,10 @@ class ZeCollector {
       total_submit_time += it.second.submit_time_;
       std::string kname;
       if (it.first.tile_ >= 0) {
-        kname = "Tile #" + std::to_string(it.first.tile_) + ": " + GetZeKernelCommandName(it.first.kernel_command_id_, it.first.group_count_, it.first.mem_size_, options_.verbose);
+        kname = "Tile #" + std::to_string(it.first.tile_) + ": " + GetDisplayCommandName(it.first);
       }
       else {
-        kname = GetZeKernelCommandName(it.first.kernel_command_id_, it.first.group_count_, it.first.mem_size_, options_.verbose);
+        kname = GetDisplayCommandName(it.first);
       }
       if (kname.size() > max_name_size) {
         max_name_size = kname.size();
@@ -1840,6 +1915,62 @@ class ZeCollector {
 
  private: // Implementation
 
+  // Statistics of all launches estimated from the sampled ones. Min and max are the ones of the
+  // traced launches.
+  ZeKernelCommandTime GetEstimatedStats(const ZeKernelCommandTime& stat) const {
+    if (!kernel_sampler_.IsEnabled() || (stat.call_count_ == 0)) {
+      return stat;
+    }
+    double scale = stat.sampled_time_.weight / stat.call_count_;
+    ZeKernelCommandTime estimate = stat;
+    estimate.call_count_ = std::llround(stat.sampled_time_.weight);
+    estimate.execute_time_ = std::llround(stat.sampled_time_.total);
+    estimate.append_time_ = std::llround(stat.append_time_ * scale);
+    estimate.submit_time_ = std::llround(stat.submit_time_ * scale);
+    return estimate;
+  }
+
+  void PrintKernelSamplingTable(std::shared_ptr<Logger> logger) const {
+    auto counts = kernel_sampler_.GetCounts();
+    std::vector<std::string> knames;
+    size_t max_name_size = sizeof("Kernel") - 1;
+    for (auto& it : counts) {
+      knames.push_back(GetDisplayName(std::string(utils::DemangleCached(it.first.c_str()))));
+      max_name_size = std::max(max_name_size, knames.back().size());
+    }
+
+    std::string str = "\n\n=== Kernel Sampling ===\n\n";
+    str += "Statistics above are estimated from the traced launches, Error (ns) is the 95% confidence bound of Time (ns)\n\n";
+    str += std::string(max_name_size - sizeof("Kernel") + 1, ' ') + "Kernel, " +
+      std::string(std::max(int(kCallsLength - sizeof("Launched") + 1), 0), ' ') + "Launched, " +
+      std::string(std::max(int(kCallsLength - sizeof("Traced") + 1), 0), ' ') + "Traced\n";
+    logger->Log(str);
+    for (size_t i = 0; i < counts.size(); i++) {
+      std::string launched = std::to_string(counts[i].second.launched);
+      std::string traced = std::to_string(counts[i].second.traced);
+      str = std::string(max_name_size - knames[i].size(), ' ') + knames[i] + ", " +
+        std::string(std::max(int(kCallsLength - launched.length()), 0), ' ') + launched + ", " +
+        std::string(std::max(int(kCallsLength - traced.length()), 0), ' ') + traced + "\n";
+      logger->Log(str);
+    }
+  }
+
+  // Kernel name as shown in summary tables, shortened if requested
+  std::string GetDisplayName(const std::string& name) const {
+    if (options_.kernel_name_max_length == 0) {
+      return name;
+    }
+    return utils::ShortenName(name, options_.kernel_name_max_length);
+  }
+
+  // Command name as shown in summary tables, only the kernel name itself is shortened
+  std::string GetDisplayCommandName(const ZeKernelCommandNameKey& key) const {
+    if (options_.kernel_name_max_length == 0) {
+      return GetZeKernelCommandName(key.kernel_command_id_, key.group_count_, key.mem_size_, options_.verbose);
+    }
+    return FormatZeKernelCommandName(key.kernel_command_id_, key.group_count_, key.mem_size_, options_.verbose, options_.kernel_name_max_length);
+  }
+
   ZeCollector(
       CollectorOptions options,
       OnZeKernelFinishCallback kcallback,
@@ -1858,6 +1989,9 @@ class ZeCollector {
         include_kernels_(include_kernels),
         exclude_kernels_(exclude_kernels) {
     data_dir_name_ = data_dir_name;
+    kernel_sampler_.SetPolicy(
+      options_.kernel_sampling_reservoir ? utils::KernelSamplingMode::kReservoir : utils::KernelSamplingMode::kEveryNth,
+      options_.kernel_sampling_rate);
     // Create loggers using the factory
     if (options_.call_logging) {
       logger_ = logger_factory_->GetLogger(LOGGER_TYPE_TRACE_CALL_LOGGING);
@@ -2365,7 +2499,7 @@ class ZeCollector {
         uint64_t prev_base = 0;
         for (auto it = props.second.crbegin(); it != props.second.crend(); it++) {
           // quote kernel name which may contain ","
-          kpfs_logger->Log("\"" + utils::Demangle(it->second->name_.c_str()) + "\"\n");
+          kpfs_logger->Log("\"" + std::string(utils::DemangleCached(it->second->name_.c_str())) + "\"\n");
           kpfs_logger->Log(std::to_string(it->second->base_addr_) + "\n");
           if (prev_base == 0) {
             kpfs_logger->Log(std::to_string(it->second->size_) + "\n");
@@ -3511,6 +3645,7 @@ class ZeCollector {
     ze_instance_data.query_ = nullptr;
     ze_instance_data.in_order_counter_event_ = nullptr;
     ze_instance_data.instrument_ = true;
+    ze_instance_data.sample_weight_ = 1.0;
 
     if (iskernel) {
       if (kernel == nullptr) {
@@ -3526,6 +3661,15 @@ class ZeCollector {
             kernel_command_properties_mutex_.unlock_shared();
             return;
           }
+          if (collector->kernel_sampler_.IsEnabled()) {
+            ze_instance_data.sample_weight_ = collector->kernel_sampler_.Sample(kit->second.name_);
+            if (ze_instance_data.sample_weight_ == 0.0) {
+              // launch is counted, but not instrumented
+              ze_instance_data.instrument_ = false;
+              kernel_command_properties_mutex_.unlock_shared();
+              return;
+            }
+          }
       }
       kernel_command_properties_mutex_.unlock_shared();
     }
@@ -3654,6 +3798,7 @@ class ZeCollector {
 
       desc->type_ = KERNEL_COMMAND_TYPE_COMPUTE;
       desc->kernel_command_id_ = kernel_id;
+      desc->sample_weight_ = ze_instance_data.sample_weight_;
       desc->group_size_ = group_size;
       desc->group_count_ = *group_count;
       desc->engine_ordinal_ = it->second->engine_ordinal_;
@@ -5965,7 +6110,7 @@ typedef struct _zex_kernel_register_file_size_exp_t {
       // Then, check exclude_kernels_ to see if the kernel should be excluded (if any match, skip=true).
       desc.skip_ = false;
       if (!collector->include_kernels_.empty() || !collector->exclude_kernels_.empty()) {
-        std::string demangled_name = utils::Demangle(desc.name_.c_str());
+        std::string_view demangled_name = utils::DemangleCached(desc.name_.c_str());
         if (!collector->include_kernels_.empty()) {
           desc.skip_ = true;
           for (const auto& filter : collector->include_kernels_) {
@@ -6171,6 +6316,7 @@ typedef struct _zex_kernel_register_file_size_exp_t {
             it->second.max_time_ = it2->second.max_time_;
           }
           it->second.call_count_ += it2->second.call_count_;
+          it->second.sampled_time_.Merge(it2->second.sampled_time_);
           it2 = global_device_time_stats_->erase(it2);
         }
         else {
@@ -6281,6 +6427,7 @@ typedef struct _zex_kernel_register_file_size_exp_t {
   std::vector<std::string> include_kernels_;
   std::vector<std::string> exclude_kernels_;
 
+  utils::KernelSampler<std::string> kernel_sampler_;  // keyed by kernel name
 };
 
 #endif // PTI_TOOLS_UNITRACE_LEVEL_ZERO_COLLECTOR_H_
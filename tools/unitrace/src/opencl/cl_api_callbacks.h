@@ -5852,7 +5852,7 @@ static void clCreateKernelOnEnter(
   } else {
     log_msg += " kernelName = \"" + std::string(*(params->kernelName)) + "\"";
     if (collector->Demangle()) {
-      log_msg += " (" + utils::Demangle(*(params->kernelName)) + ")";
+      log_msg += " (" + std::string(utils::DemangleCached(*(params->kernelName))) + ")";
     }
   }
   log_msg += " errcodeRet = " + ToHexString(reinterpret_cast<uintptr_t>(*(params->errcodeRet)));
@@ -10,17 +10,23 @@
 #include <atomic>
 #include <iomanip>
 #include <iostream>
-#include <list>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <shared_mutex>
 #include <set>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 #include <chrono>
 
 #include "cl_api_tracer.h"
 #include "cl_utils.h"
+#include "completion_queue.h"
+#include "kernel_stats_key.h"
 #include "trace_guard.h"
 #include "collector_options.h"
 #include "logger.h"
@@ -62,6 +68,7 @@ struct ClKernelProps {
 
 struct ClKernelInstance {
   cl_event event = nullptr;
+  cl_command_queue queue = nullptr;
   ClKernelProps props;
   uint64_t kernel_id = 0;
   cl_ulong host_sync = 0;
@@ -69,6 +76,9 @@ struct ClKernelInstance {
   bool need_to_process = true;
   cl_device_id device;
   std::vector<int32_t> sub_device_list;
+  cl_int event_status = CL_COMPLETE;
+  std::shared_ptr<utils::CompletionQueue<ClKernelInstance>> completion_queue;
+  ClKernelInstance* next_completed = nullptr;
 };
 
 struct ClKernelInfo {
@@ -103,7 +113,6 @@ struct ClKernelMemInfo{
 using ClKernelMemInfoMap = std::map<uint64_t, ClKernelMemInfo>;
 
 using ClKernelInfoMap = std::map<std::string, ClKernelInfo>;
-using ClKernelInstanceList = std::list<ClKernelInstance*>;
 
 struct ClDevice {
   cl_device_id id_;
@@ -328,7 +337,10 @@ class ClCollector {
     collector->SetKernelTracingPoints();
 
     ClApiTracer* tracer;
-    tracer = new ClApiTracer(device, TracingCallBack, collector);
+    tracer = new ClApiTracer(
+        device, SelectTracingCallBack(collector->GetTracingCallBackFlags(),
+                                      std::make_index_sequence<TRACING_CALLBACK_FLAG_COUNT>()),
+        collector);
     collector->EnableTracing(tracer);
 
     if (tracer == nullptr || !tracer->IsValid()) {
@@ -354,6 +366,7 @@ class ClCollector {
   }
 
   ~ClCollector() {
+    drainer_.Stop();
     ReleaseDeviceMap();
     if (tracer_ != nullptr) {
       delete tracer_;
@@ -361,6 +374,10 @@ class ClCollector {
   }
 
   void FlushData() {
+    if (!completion_queue_->WaitForInFlight(kInFlightTimeout)) {
+      std::cerr << "[WARNING] " << completion_queue_->GetInFlightCount()
+                << " OpenCL commands did not complete, they are not reported" << std::endl;
+    }
     ProcessKernelInstances();
     DumpKernelProfiles();
   }
@@ -386,7 +403,7 @@ class ClCollector {
         std::ofstream kpfs = std::ofstream(fpath, std::ios::out | std::ios::trunc);
         uint64_t prev_base = 0;
         for (auto it = props.second.crbegin(); it != props.second.crend(); it++) {
-          kpfs << "\"" << utils::Demangle(it->second->name.c_str()) << "\"" << std::endl;
+          kpfs << "\"" << utils::DemangleCached(it->second->name.c_str()) << "\"" << std::endl;
           kpfs << std::to_string(it->second->base_addr) << std::endl;
           if (prev_base == 0) {
             kpfs << std::to_string(it->second->size) << std::endl;
@@ -439,8 +456,20 @@ class ClCollector {
     }
   }
 
-  const ClKernelInfoMap& GetKernelInfoMap() const {
-    return kernel_info_map_;
+  // Kernel names are formatted here, once per launch configuration. Kernels whose names are the same
+  // once shortened to max_name_length characters share one entry
+  ClKernelInfoMap GetKernelInfoMap(size_t max_name_length = 0) const {
+    ClKernelInfoMap kernel_info_map;
+    for (const auto& value : kernel_stats_) {
+      std::string name = kernel_names_.Format(value.first, options_.verbose, max_name_length);
+      auto it = kernel_info_map.find(name);
+      if (it == kernel_info_map.end()) {
+        kernel_info_map.emplace(std::move(name), value.second);
+      } else {
+        MergeKernelInfo(it->second, value.second);
+      }
+    }
+    return kernel_info_map;
   }
 
   ClCollector(const ClCollector& copy) = delete;
@@ -451,16 +480,18 @@ class ClCollector {
   }
 
   void PrintKernelsTable(std::shared_ptr<Logger> logger) const {
+    ClKernelInfoMap kernel_info_map = GetKernelInfoMap(options_.kernel_name_max_length);
     std::set< std::pair<std::string, ClKernelInfo>,
               utils::Comparator > sorted_list(
-        kernel_info_map_.begin(), kernel_info_map_.end());
+        kernel_info_map.begin(), kernel_info_map.end());
 
     uint64_t total_duration = 0;
     size_t max_name_length = kKernelLength;
     for (auto& value : sorted_list) {
       total_duration += value.second.execute_time;
-      if (value.first.size() > max_name_length) {
-        max_name_length = value.first.size();
+      size_t name_length = value.first.size();
+      if (name_length > max_name_length) {
+        max_name_length = name_length;
       }
     }
 
@@ -498,9 +529,10 @@ class ClCollector {
   }
 
   void PrintSubmissionTable(std::shared_ptr<Logger> logger) const {
+    ClKernelInfoMap kernel_info_map = GetKernelInfoMap(options_.kernel_name_max_length);
     std::set< std::pair<std::string, ClKernelInfo>,
               utils::Comparator > sorted_list(
-        kernel_info_map_.begin(), kernel_info_map_.end());
+        kernel_info_map.begin(), kernel_info_map.end());
 
     uint64_t total_queued_duration = 0;
     uint64_t total_submit_duration = 0;
@@ -510,8 +542,9 @@ class ClCollector {
       total_queued_duration += value.second.queued_time;
       total_submit_duration += value.second.submit_time;
       total_execute_duration += value.second.execute_time;
-      if (value.first.size() > max_name_length) {
-        max_name_length = value.first.size();
+      size_t name_length = value.first.size();
+      if (name_length > max_name_length) {
+        max_name_length = name_length;
       }
     }
 
@@ -882,7 +915,6 @@ class ClCollector {
     kernel_tracing_points_enabled[CL_FUNCTION_clEnqueueCopyBufferToImage] = true;
     kernel_tracing_points_enabled[CL_FUNCTION_clFinish] = true;
     kernel_tracing_points_enabled[CL_FUNCTION_clReleaseCommandQueue] = true;
-    kernel_tracing_points_enabled[CL_FUNCTION_clReleaseEvent] = true;
     kernel_tracing_points_enabled[CL_FUNCTION_clWaitForEvents] = true;
   }
 
@@ -966,8 +998,55 @@ class ClCollector {
         instance->device = device;
       }
     }
-    kernel_instance_list_.push_back(instance);
     AddKernelMemInfo(instance->props.name, instance->props.base_addr, instance->props.size);
+
+    instance->queue = queue;
+    queue_in_flight_[queue]++;
+    events_in_flight_.insert(event);
+
+    // The instance is handed to the drainer thread once its event completes, so in-flight
+    // commands are never polled. It may be processed before clSetEventCallback returns.
+    instance->completion_queue = completion_queue_;
+    completion_queue_->AddInFlight();
+    cl_int status = clSetEventCallback(event, CL_COMPLETE, OnEventComplete, instance);
+    PTI_ASSERT(status == CL_SUCCESS);
+  }
+
+  static void CL_CALLBACK OnEventComplete(cl_event event, cl_int event_status, void* user_data) {
+    ClKernelInstance* instance = reinterpret_cast<ClKernelInstance*>(user_data);
+    PTI_ASSERT(instance != nullptr);
+    PTI_ASSERT(instance->event == event);
+    instance->event_status = event_status;
+    // Keeps the queue alive even if the collector is already destroyed
+    std::shared_ptr<utils::CompletionQueue<ClKernelInstance>> queue = instance->completion_queue;
+    queue->Push(instance);
+  }
+
+  void OnKernelInstanceComplete(ClKernelInstance* instance) {
+    PTI_ASSERT(instance != nullptr);
+    {
+      const std::lock_guard<std::mutex> lock(lock_);
+      // Commands terminated with an error have no profiling data
+      if (instance->event_status == CL_COMPLETE) {
+        if (instance->sub_device_list.size()) {
+          for (size_t i = 0; i < instance->sub_device_list.size(); ++i) {
+            ProcessKernelInstance(instance, instance->sub_device_list[i]);
+          }
+        } else {
+          ProcessKernelInstance(instance, -1);
+        }
+      }
+
+      auto it = queue_in_flight_.find(instance->queue);
+      PTI_ASSERT(it != queue_in_flight_.end() && it->second > 0);
+      if (--it->second == 0) {
+        queue_in_flight_.erase(it);  // the queue may be released and its handle reused
+      }
+      events_in_flight_.erase(instance->event);
+    }
+    cl_int status = clReleaseEvent(instance->event);
+    PTI_ASSERT(status == CL_SUCCESS);
+    delete instance;
   }
 
   static void ComputeHostTimestamps(
@@ -1014,7 +1093,7 @@ class ClCollector {
 #endif /* _WIN32 */
   }
 
-  void PrintOutOffloadedCommand(std::string& name, cl_device_id& device, uint64_t appended, uint64_t submitted, uint64_t kernel_start, uint64_t kernel_end) {
+  void PrintOutOffloadedCommand(const std::string& name, cl_device_id& device, uint64_t appended, uint64_t submitted, uint64_t kernel_start, uint64_t kernel_end) {
     std::string output = "Thread " + std::to_string(utils::GetTid()) +
                          " Device " + std::to_string(reinterpret_cast<uintptr_t>(device)) +
                          " : " + name + " [ns] " +
@@ -1038,9 +1117,6 @@ class ClCollector {
     PTI_ASSERT(instance->event != nullptr);
     cl_event event = instance->event;
 
-    cl_int event_status = utils::cl::GetEventStatus(event);
-    PTI_ASSERT(event_status == CL_COMPLETE);
-
     if (instance->need_to_process) {
       cl_command_queue queue = utils::cl::GetCommandQueue(event);
       PTI_ASSERT(queue != nullptr);
@@ -1054,17 +1130,12 @@ class ClCollector {
       PTI_ASSERT(device != nullptr);
       cl_device_pci_bus_info_khr pciInfo = GetDevicePciInfo(device);
 
-      std::string name = instance->props.name;
-      PTI_ASSERT(!name.empty());
-
-      if (options_.verbose) {
-        name = GetVerboseName(&(instance->props));
-      }
+      KernelStatsKey key = GetStatsKey(&(instance->props));
 
       uint64_t host_queued = 0, host_submitted = 0;
       uint64_t host_started = 0, host_ended = 0;
       ComputeHostTimestamps(instance, started, ended, host_queued, host_submitted, host_started, host_ended);
-      AddKernelInfo(name, host_submitted - host_queued, host_started - host_submitted, host_ended - host_started);
+      AddKernelInfo(key, host_submitted - host_queued, host_started - host_submitted, host_ended - host_started);
 
       bool implicit = false;
 
@@ -1079,7 +1150,7 @@ class ClCollector {
       }
 
       if (options_.device_timeline) {
-        PrintOutOffloadedCommand(name, device, host_queued, host_submitted, host_started, host_ended);
+        PrintOutOffloadedCommand(kernel_names_.Get(key, options_.verbose), device, host_queued, host_submitted, host_started, host_ended);
       }
 
       auto it = cl_kernel_command_properties_.find(instance->kernel_id);
@@ -1109,66 +1180,83 @@ class ClCollector {
     }
   }
 
-  void ProcessKernelInstance(cl_event event) {
-    PTI_ASSERT(event != nullptr);
-    cl_int event_status = utils::cl::GetEventStatus(event);
-    if (event_status != CL_COMPLETE) {
-      return;
-    }
+  // Processes the commands completed so far without waiting for the drainer thread
+  void ProcessKernelInstances() {
+    drainer_.Drain();
+  }
 
-    const std::lock_guard<std::mutex> lock(lock_);
-    for (auto it = kernel_instance_list_.begin();
-         it != kernel_instance_list_.end(); ++it) {
-      ClKernelInstance* instance = *it;
-      PTI_ASSERT(instance != nullptr);
-      PTI_ASSERT(instance->event != nullptr);
-      if (instance->event == event) {
-	if (instance->sub_device_list.size()) {
-          for (size_t i = 0; i < instance->sub_device_list.size(); ++i) {
-            ProcessKernelInstance(instance,instance->sub_device_list[i]);
-	  };
-	} else {
-          ProcessKernelInstance(instance,-1);
-	};
-        cl_int status = clReleaseEvent(event);
-        PTI_ASSERT(status == CL_SUCCESS);
-	delete instance;
+  // Event callbacks may still be running when a synchronization call returns, so the
+  // commands it waited for are processed once their callbacks have fired
+  void ProcessKernelInstances(cl_command_queue queue) {
+    WaitForKernelInstances([this, queue]() {
+      return queue_in_flight_.find(queue) == queue_in_flight_.end();
+    });
+  }
 
-        it = kernel_instance_list_.erase(it);
-        break;
+  void ProcessKernelInstances(cl_uint num_events, const cl_event* events) {
+    WaitForKernelInstances([this, num_events, events]() {
+      for (cl_uint i = 0; i < num_events; ++i) {
+        if (events_in_flight_.count(events[i]) > 0) {
+          return false;
+        }
       }
-    }
+      return true;
+    });
   }
 
-  void ProcessKernelInstances() {
-    const std::lock_guard<std::mutex> lock(lock_);
+  // Drains until done() holds with the data lock taken, at most for kInFlightTimeout
+  template <typename F>
+  void WaitForKernelInstances(F done) {
+    auto deadline = std::chrono::steady_clock::now() + kInFlightTimeout;
+    while (true) {
+      drainer_.Drain();
+      {
+        const std::lock_guard<std::mutex> lock(lock_);
+        if (done()) {
+          return;
+        }
+      }
+      if (std::chrono::steady_clock::now() >= deadline) {
+        return;  // not complete commands are reported at FlushData
+      }
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+  }
 
-    auto it = kernel_instance_list_.begin();
-    while (it != kernel_instance_list_.end()) {
-      ClKernelInstance* instance = *it;
-      PTI_ASSERT(instance != nullptr);
+  // Sizes are keyed only if they are shown in kernel names
+  KernelStatsKey GetStatsKey(const ClKernelProps* props) {
+    PTI_ASSERT(props != nullptr);
+    PTI_ASSERT(!props->name.empty());
 
-      PTI_ASSERT(instance->event != nullptr);
-      cl_int event_status = utils::cl::GetEventStatus(instance->event);
-      if (event_status == CL_COMPLETE) {
-        if (instance->sub_device_list.size()) {
-          for (size_t i = 0; i < instance->sub_device_list.size(); ++i) {
-            ProcessKernelInstance(instance,instance->sub_device_list[i]);
-          }
-        } else {
-          ProcessKernelInstance(instance,-1);
-	}
-        it = kernel_instance_list_.erase(it);
-      } else {
-        ++it;
+    KernelStatsKey key;
+    key.name_id = kernel_names_.GetId(props->name);
+    if (options_.verbose) {
+      key.simd_width = static_cast<uint32_t>(props->simd_width);
+      key.bytes_transferred = props->bytes_transferred;
+      for (int i = 0; i < 3; ++i) {
+        key.global_size[i] = props->global_size[i];
+        key.local_size[i] = props->local_size[i];
       }
     }
+    return key;
   }
 
-  void AddKernelInfo(std::string name, uint64_t queued_time, uint64_t submit_time, uint64_t execute_time) {
-    PTI_ASSERT(!name.empty());
+  static void MergeKernelInfo(ClKernelInfo& kernel, const ClKernelInfo& r) {
+    kernel.queued_time += r.queued_time;
+    kernel.submit_time += r.submit_time;
+    kernel.execute_time += r.execute_time;
+    if (r.max_time > kernel.max_time) {
+      kernel.max_time = r.max_time;
+    }
+    if (r.min_time < kernel.min_time) {
+      kernel.min_time = r.min_time;
+    }
+    kernel.call_count += r.call_count;
+  }
 
-    if (kernel_info_map_.count(name) == 0) {
+  void AddKernelInfo(const KernelStatsKey& key, uint64_t queued_time, uint64_t submit_time, uint64_t execute_time) {
+    auto it = kernel_stats_.find(key);
+    if (it == kernel_stats_.end()) {
       ClKernelInfo info;
       info.queued_time = queued_time;
       info.submit_time = submit_time;
@@ -1176,9 +1264,9 @@ class ClCollector {
       info.min_time = execute_time;
       info.max_time = execute_time;
       info.call_count = 1;
-      kernel_info_map_[name] = info;
+      kernel_stats_.emplace(key, info);
     } else {
-      ClKernelInfo& kernel = kernel_info_map_[name];
+      ClKernelInfo& kernel = it->second;
       kernel.queued_time += queued_time;
       kernel.submit_time += submit_time;
       kernel.execute_time += execute_time;
@@ -1399,7 +1487,8 @@ class ClCollector {
     }
   }
 
-  static void OnExitEnqueueTransfer(std::string name, size_t bytes_transferred, cl_event* event, cl_callback_data* data, ClCollector* collector, uint64_t *kid) {
+  // Returns the event of the command, the event pointer may no longer be valid on return
+  static cl_event OnExitEnqueueTransfer(std::string name, size_t bytes_transferred, cl_event* event, cl_callback_data* data, ClCollector* collector, uint64_t *kid) {
     PTI_ASSERT(event != nullptr);
     PTI_ASSERT(data != nullptr);
     PTI_ASSERT(collector != nullptr);
@@ -1411,7 +1500,8 @@ class ClCollector {
 
     ClKernelInstance* instance = new ClKernelInstance;
     PTI_ASSERT(instance != nullptr);
-    instance->event = *event;
+    cl_event command_event = *event;
+    instance->event = command_event;
     instance->props.name = std::move(name);
 
     instance->props.simd_width = 0;
@@ -1434,6 +1524,7 @@ class ClCollector {
     collector->AddKernelInstance(instance);
 
     delete enqueue_data;
+    return command_event;
   }
 
   static void OnExitEnqueueReadBuffer(cl_callback_data* data, ClCollector* collector, uint64_t *kid) {
@@ -1448,10 +1539,10 @@ class ClCollector {
             data->functionParams);
       PTI_ASSERT(params != nullptr);
 
-      OnExitEnqueueTransfer( "clEnqueueReadBuffer", *(params->cb), *(params->event), data, collector, kid);
+      cl_event event = OnExitEnqueueTransfer( "clEnqueueReadBuffer", *(params->cb), *(params->event), data, collector, kid);
 
       if (*params->blockingRead) {
-        collector->ProcessKernelInstances();
+        collector->ProcessKernelInstances(1, &event);
       }
     }
   }
@@ -1465,10 +1556,10 @@ class ClCollector {
       const cl_params_clEnqueueWriteBuffer* params = reinterpret_cast<const cl_params_clEnqueueWriteBuffer*>( data->functionParams);
       PTI_ASSERT(params != nullptr);
 
-      OnExitEnqueueTransfer( "clEnqueueWriteBuffer", *(params->cb), *(params->event), data, collector, kid);
+      cl_event event = OnExitEnqueueTransfer( "clEnqueueWriteBuffer", *(params->cb), *(params->event), data, collector, kid);
 
       if (*params->blockingWrite) {
-        collector->ProcessKernelInstances();
+        collector->ProcessKernelInstances(1, &event);
       }
     }
   }
@@ -1676,9 +1767,17 @@ class ClCollector {
     }
   }
 
-  static void OnExitFinish(ClCollector* collector) {
+  static void OnExitFinish(cl_callback_data* data, ClCollector* collector) {
+    PTI_ASSERT(data != nullptr);
     PTI_ASSERT(collector != nullptr);
-    collector->ProcessKernelInstances();
+
+    const cl_params_clFinish* params = reinterpret_cast<const cl_params_clFinish*>(data->functionParams);
+    PTI_ASSERT(params != nullptr);
+
+    cl_int* return_value = reinterpret_cast<cl_int*>(data->functionReturnValue);
+    if (*return_value == CL_SUCCESS) {
+      collector->ProcessKernelInstances(*(params->commandQueue));
+    }
   }
 
   static void OnExitReleaseCommandQueue(ClCollector* collector) {
@@ -1686,33 +1785,16 @@ class ClCollector {
     collector->ProcessKernelInstances();
   }
 
-  static void OnEnterReleaseEvent(cl_callback_data* data, ClCollector* collector) {
+  static void OnExitWaitForEvents(cl_callback_data* data, ClCollector* collector) {
     PTI_ASSERT(data != nullptr);
     PTI_ASSERT(collector != nullptr);
 
-    const cl_params_clReleaseEvent* params = reinterpret_cast<const cl_params_clReleaseEvent*>(data->functionParams);
+    const cl_params_clWaitForEvents* params = reinterpret_cast<const cl_params_clWaitForEvents*>(data->functionParams);
     PTI_ASSERT(params != nullptr);
 
-    if (*(params->event) != nullptr) {
-      collector->ProcessKernelInstance(*(params->event));
-    }
-  }
-
-  static void OnExitWaitForEvents(cl_callback_data* data, ClCollector* collector) {
-    PTI_ASSERT(data != nullptr);
-    PTI_ASSERT(collector != nullptr);
-
     cl_int* return_value = reinterpret_cast<cl_int*>(data->functionReturnValue);
     if (*return_value == CL_SUCCESS) {
-      const cl_params_clWaitForEvents* params = reinterpret_cast<const cl_params_clWaitForEvents*>(data->functionParams);
-      PTI_ASSERT(params != nullptr);
-
-      const cl_event* event_list = *(params->eventList);
-      if (event_list != nullptr) {
-        for (cl_uint i = 0; i < *(params->numEvents); ++i) {
-          collector->ProcessKernelInstance(event_list[i]);
-        }
-      }
+      collector->ProcessKernelInstances(*(params->numEvents), *(params->eventList));
     }
   }
 
@@ -1769,9 +1851,6 @@ class ClCollector {
       case CL_FUNCTION_clFinish:
       case CL_FUNCTION_clReleaseCommandQueue:
         break;
-      case CL_FUNCTION_clReleaseEvent:
-        OnEnterReleaseEvent(callback_data, collector);
-        break;
       case CL_FUNCTION_clWaitForEvents:
         break;
       default:
@@ -1829,13 +1908,11 @@ class ClCollector {
         OnExitEnqueueCopyBufferToImage(callback_data, collector, kid);
         break;
       case CL_FUNCTION_clFinish:
-        OnExitFinish(collector);
+        OnExitFinish(callback_data, collector);
         break;
       case CL_FUNCTION_clReleaseCommandQueue:
         OnExitReleaseCommandQueue(collector);
         break;
-      case CL_FUNCTION_clReleaseEvent:
-        break;
       case CL_FUNCTION_clWaitForEvents:
         OnExitWaitForEvents(callback_data, collector);
         break;
@@ -1844,6 +1921,41 @@ class ClCollector {
     }
   }
 
+  // Options checked on every traced call. TracingCallBack is instantiated for each combination and the
+  // one matching the options is registered, so disabled features are compiled out of the callback.
+  enum TracingCallBackFlags : uint32_t {
+    TRACING_CALLBACK_KERNEL_TRACING = 1 << 0,
+    TRACING_CALLBACK_HOST_TIMING = 1 << 1,
+    TRACING_CALLBACK_CALL_LOGGING = 1 << 2,
+    TRACING_CALLBACK_FUNCTION_FINISH = 1 << 3,
+    TRACING_CALLBACK_FLAG_COUNT = 1 << 4
+  };
+
+  uint32_t GetTracingCallBackFlags() const {
+    uint32_t flags = 0;
+    if (options_.kernel_tracing) {
+      flags |= TRACING_CALLBACK_KERNEL_TRACING;
+    }
+    if (options_.host_timing) {
+      flags |= TRACING_CALLBACK_HOST_TIMING;
+    }
+    if (options_.call_logging) {
+      flags |= TRACING_CALLBACK_CALL_LOGGING;
+    }
+    if (fcallback_ != nullptr) {
+      flags |= TRACING_CALLBACK_FUNCTION_FINISH;
+    }
+    return flags;
+  }
+
+  template <size_t... Flags>
+  static cl_tracing_callback SelectTracingCallBack(uint32_t flags, std::index_sequence<Flags...>) {
+    static constexpr cl_tracing_callback callbacks[] = {&TracingCallBack<Flags>...};
+    PTI_ASSERT(flags < sizeof...(Flags));
+    return callbacks[flags];
+  }
+
+  template <size_t Flags>
   static void TracingCallBack(ClFunctionId function, cl_callback_data* callback_data, void* user_data) {
     if (IsTracingNow()) {
       // no recursive tracing
@@ -1855,11 +1967,13 @@ class ClCollector {
       if (UniController::IsCollectionEnabled()) {
         collector->TracingNowOn();
         uint64_t kid = KERNEL_INSTANCE_ID_INVALID;
-        if (collector->options_.kernel_tracing && collector->kernel_tracing_points_enabled[function]) {
-          KernelTracingCallBackOnEnter(function, collector, callback_data, &kid);
+        if constexpr ((Flags & TRACING_CALLBACK_KERNEL_TRACING) != 0) {
+          if (collector->kernel_tracing_points_enabled[function]) {
+            KernelTracingCallBackOnEnter(function, collector, callback_data, &kid);
+          }
         }
 
-        if (collector->options_.call_logging) {
+        if constexpr ((Flags & TRACING_CALLBACK_CALL_LOGGING) != 0) {
           OnEnterFunction(function, callback_data, collector->GetTimestamp(), collector);
         }
 
@@ -1876,19 +1990,21 @@ class ClCollector {
 
       if (UniController::IsCollectionEnabled()) {
         uint64_t kid = KERNEL_INSTANCE_ID_INVALID;
-        if (collector->options_.kernel_tracing && collector->kernel_tracing_points_enabled[function]) {
-          KernelTracingCallBackOnExit(function, collector, callback_data, &kid);
+        if constexpr ((Flags & TRACING_CALLBACK_KERNEL_TRACING) != 0) {
+          if (collector->kernel_tracing_points_enabled[function]) {
+            KernelTracingCallBackOnExit(function, collector, callback_data, &kid);
+          }
         }
 
-        if (collector->options_.host_timing) {
+        if constexpr ((Flags & TRACING_CALLBACK_HOST_TIMING) != 0) {
           collector->AddFunctionTime(callback_data->functionName, end_time - start_time);
         }
 
-        if (collector->options_.call_logging) {
+        if constexpr ((Flags & TRACING_CALLBACK_CALL_LOGGING) != 0) {
           OnExitFunction(function, callback_data, start_time, end_time, collector);
         }
 
-        if (collector->fcallback_ != nullptr) {
+        if constexpr ((Flags & TRACING_CALLBACK_FUNCTION_FINISH) != 0) {
           FLOW_DIR flow_dir = FLOW_NUL;
           std::vector<uint64_t> kids;
           if (function == CL_FUNCTION_clEnqueueNDRangeKernel ||
@@ -1988,8 +2104,11 @@ class ClCollector {
   OnClFunctionFinishCallback fcallback_ = nullptr;
 
   std::mutex lock_;
-  ClKernelInfoMap kernel_info_map_;
-  ClKernelInstanceList kernel_instance_list_;
+  // Commands not processed yet, waited for at synchronization points
+  std::unordered_map<cl_command_queue, uint64_t> queue_in_flight_;
+  std::unordered_set<cl_event> events_in_flight_;
+  KernelStatsNames kernel_names_{""};  // transfer sizes are shown as "[N]"
+  std::unordered_map<KernelStatsKey, ClKernelInfo, KernelStatsKeyHash> kernel_stats_;
 
   bool kernel_tracing_points_enabled[CL_FUNCTION_COUNT];
 
@@ -2019,6 +2138,17 @@ class ClCollector {
 
   inline static ClCollector *cl_gpu_collector_ = nullptr;
   inline static ClCollector *cl_cpu_collector_ = nullptr;
+
+  static constexpr std::chrono::milliseconds kInFlightTimeout{1000};
+
+  std::shared_ptr<utils::CompletionQueue<ClKernelInstance>> completion_queue_ =
+    std::make_shared<utils::CompletionQueue<ClKernelInstance>>();
+  // Declared last to stop before the data it processes into is destroyed. Its own OpenCL
+  // calls are not traced.
+  utils::CompletionDrainer<ClKernelInstance> drainer_{
+    completion_queue_,
+    [this](ClKernelInstance* instance) { OnKernelInstanceComplete(instance); },
+    []() { TracingNowOn(); }};
 };
 
 template <cl_device_type device_type>
@@ -35,6 +35,7 @@
 
 #include "chromelogger.h"
 #include "unimemory.h"
+#include "unitelemetry.h"
 #include "ze_loader.h"
 #include "logger_factory.h"
 
@@ -155,6 +156,15 @@ class UniTracer {
       collector_options.verbose = tracer->CheckOption(TRACE_VERBOSE);
       collector_options.demangle = tracer->CheckOption(TRACE_DEMANGLE);
       collector_options.kernels_per_tile = tracer->CheckOption(TRACE_KERNELS_PER_TILE);
+      std::string max_length = utils::GetEnv("UNITRACE_KernelNameMaxLength");
+      if (!max_length.empty()) {
+        collector_options.kernel_name_max_length = std::stoul(max_length);
+      }
+      std::string sampling_rate = utils::GetEnv("UNITRACE_KernelSamplingRate");
+      if (!sampling_rate.empty()) {
+        collector_options.kernel_sampling_rate = std::stoul(sampling_rate);
+        collector_options.kernel_sampling_reservoir = (utils::GetEnv("UNITRACE_KernelSamplingReservoir") == "1");
+      }
     }
 
     if (tracer->CheckOption(TRACE_CALL_LOGGING) ||
@@ -222,6 +232,20 @@ class UniTracer {
       tracer->ze_collector_ = ze_collector;
     }
 
+    std::string telemetry_interval = utils::GetEnv("UNITRACE_TelemetryInterval");
+    if (!telemetry_interval.empty()) {
+      // telemetry goes to the timeline if there is one, to a side stream otherwise
+      OnTelemetrySampleCallback telemetry_callback = nullptr;
+      if (tracer->chrome_logger_ != nullptr) {
+        telemetry_callback = ChromeLogger::TelemetryLoggingCallback;
+      }
+      tracer->telemetry_ = UniTelemetry::Create(GetDeviceList(), std::stoul(telemetry_interval), telemetry_callback,
+                                                tracer->logger_factory_->GenerateLogFileName(LOGGER_TYPE_TELEMETRY));
+      if (tracer->telemetry_ == nullptr) {
+        std::cerr << "[WARNING] Unable to sample device telemetry" << std::endl;
+      }
+    }
+
     return tracer;
   }
 
@@ -255,6 +279,11 @@ class UniTracer {
     }
 #endif /* BUILD_WITH_ITT */
 
+    if (telemetry_ != nullptr) {
+      // the last samples have to be in the timeline before it is closed
+      telemetry_->Stop();
+    }
+
     if (chrome_logger_ != nullptr) {
       chrome_logger_->Flush();
     }
@@ -303,6 +332,9 @@ class UniTracer {
       delete cl_gpu_collector_;
     }
 #endif /* BUILD_WITH_OPENCL */
+    if (telemetry_ != nullptr) {
+      delete telemetry_;
+    }
     if (chrome_logger_ != nullptr) {
       delete chrome_logger_;
     }
@@ -697,6 +729,7 @@ class UniTracer {
   ClCollector* cl_gpu_collector_ = nullptr;
 #endif /* BUILD_WITH_OPENCL */
   ChromeLogger* chrome_logger_ = nullptr;
+  UniTelemetry* telemetry_ = nullptr;
 };
 
 #endif // PTI_TOOLS_UNITRACE_UNIFIED_TRACER_H_
@@ -0,0 +1,72 @@
+//==============================================================
+// Copyright (C) Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+// =============================================================
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "trace_index.h"
+
+static void Usage(const char* progname) {
+  std::cout <<
+    "Usage: " << progname << " [options] <trace-file>" << std::endl <<
+    "Build a sidecar index of a unitrace Chrome JSON trace for unitrace_query and unitrace_merge" << std::endl <<
+    "Options:" << std::endl <<
+    "--output [-o] <index-file>    Index file name, default is <trace-file>.idx" << std::endl <<
+    "--window [-w] <us>            Time window granularity in microseconds, default is 1000" << std::endl <<
+    "--verbose [-v]                Report progress" << std::endl <<
+    "--help [-h]                   Show this message" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+  std::string trace_file;
+  std::string index_file;
+  int64_t window_ns = kTraceIndexDefaultWindowNs;
+  bool verbose = false;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "-o" || arg == "--output") {
+      if (++i >= argc) {
+        Usage(argv[0]);
+        return -1;
+      }
+      index_file = argv[i];
+    } else if (arg == "-w" || arg == "--window") {
+      if (++i >= argc || !ParseTraceTimeToNs(argv[i], window_ns) || window_ns <= 0) {
+        std::cerr << "[ERROR] Invalid time window" << std::endl;
+        return -1;
+      }
+    } else if (arg == "-v" || arg == "--verbose") {
+      verbose = true;
+    } else if (arg == "-h" || arg == "--help") {
+      Usage(argv[0]);
+      return 0;
+    } else if (trace_file.empty() && arg[0] != '-') {
+      trace_file = arg;
+    } else {
+      std::cerr << "[ERROR] Unknown option " << arg << std::endl;
+      Usage(argv[0]);
+      return -1;
+    }
+  }
+
+  if (trace_file.empty()) {
+    Usage(argv[0]);
+    return -1;
+  }
+  if (index_file.empty()) {
+    index_file = GetDefaultTraceIndexFileName(trace_file);
+  }
+
+  TraceIndexBuilder builder(window_ns);
+  if (!builder.Build(trace_file, index_file, verbose)) {
+    return -1;
+  }
+
+  std::cerr << "[INFO] Indexed " << builder.GetEventCount() << " events of " << trace_file << " into " << index_file << std::endl;
+  return 0;
+}
@@ -0,0 +1,487 @@
+//==============================================================
+// Copyright (C) Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+// =============================================================
+
+#ifndef PTI_TOOLS_UNITRACE_TRACETOOLS_TRACE_INDEX_H_
+#define PTI_TOOLS_UNITRACE_TRACETOOLS_TRACE_INDEX_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "trace_scanner.h"
+
+// Sidecar index of a Chrome JSON trace. The index is built in a single streaming pass over the
+// trace and lets tools locate events by time window, by (pid, tid) and by event name, then read
+// only those events from the trace with a seek.
+//
+// Layout (all integers are little endian, as written by the host):
+//   TraceIndexHeader
+//   uint64_t windows[window_count + 1]     first entry of every time window
+//   TraceIndexEntry entries[event_count]   timed events, sorted by (ts, offset)
+//   TraceIndexEntry meta[meta_count]       metadata and untimed events, in file order
+//   TraceIndexName names[name_count]
+//   TraceIndexThread threads[thread_count]
+//   uint64_t postings[...]                 entry numbers per name and per thread, ascending
+//   char strings[strings_size]             event names, still JSON escaped
+
+constexpr char kTraceIndexMagic[8] = {'U', 'T', 'R', 'A', 'C', 'E', 'I', 'X'};
+constexpr uint32_t kTraceIndexVersion = 1;
+constexpr int64_t kTraceIndexDefaultWindowNs = 1000000;     // 1 ms
+constexpr uint64_t kTraceIndexMaxWindows = 16 * 1024 * 1024;
+constexpr uint32_t kTraceIndexNoName = (std::numeric_limits<uint32_t>::max)();
+
+struct TraceIndexHeader {
+  char magic_[8];
+  uint32_t version_;
+  uint32_t reserved_;
+  uint64_t trace_size_;        // size of the indexed trace, used to detect stale indices
+  uint64_t event_count_;
+  uint64_t meta_count_;
+  uint64_t name_count_;
+  uint64_t thread_count_;
+  uint64_t window_count_;
+  int64_t window_ns_;
+  int64_t min_ts_;
+  int64_t max_ts_;
+  int64_t max_dur_;            // longest event, lets time range queries catch overlapping events
+  uint64_t windows_offset_;
+  uint64_t entries_offset_;
+  uint64_t meta_offset_;
+  uint64_t names_offset_;
+  uint64_t threads_offset_;
+  uint64_t postings_offset_;
+  uint64_t strings_offset_;
+  uint64_t strings_size_;
+};
+
+struct TraceIndexEntry {
+  int64_t ts_;
+  int64_t dur_;
+  uint64_t offset_;
+  uint32_t length_;
+  uint32_t name_id_;
+  uint32_t thread_id_;
+  char ph_;
+  char reserved_[3];
+};
+
+struct TraceIndexName {
+  uint64_t string_offset_;
+  uint64_t string_length_;
+  uint64_t postings_first_;
+  uint64_t postings_count_;
+};
+
+struct TraceIndexThread {
+  int64_t pid_;
+  int64_t tid_;
+  uint64_t postings_first_;
+  uint64_t postings_count_;
+};
+
+static_assert(sizeof(TraceIndexEntry) == 40, "Unexpected TraceIndexEntry layout");
+static_assert(sizeof(TraceIndexName) == 32, "Unexpected TraceIndexName layout");
+static_assert(sizeof(TraceIndexThread) == 32, "Unexpected TraceIndexThread layout");
+
+inline std::string GetDefaultTraceIndexFileName(const std::string& trace_file) {
+  return trace_file + ".idx";
+}
+
+class TraceIndexBuilder {
+ public:
+  explicit TraceIndexBuilder(int64_t window_ns = kTraceIndexDefaultWindowNs) : window_ns_(window_ns) {}
+
+  TraceIndexBuilder(const TraceIndexBuilder& that) = delete;
+  TraceIndexBuilder& operator=(const TraceIndexBuilder& that) = delete;
+
+  // Scans the trace once and writes the index. Returns false on I/O errors.
+  bool Build(const std::string& trace_file, const std::string& index_file, bool verbose = false) {
+    TraceScanner scanner(trace_file);
+    if (!scanner.IsOpen()) {
+      std::cerr << "[ERROR] Failed to open trace file " << trace_file << std::endl;
+      return false;
+    }
+
+    TraceEvent event;
+    uint64_t next_report = kReportInterval;
+    while (scanner.Next(event)) {
+      Add(event);
+      if (verbose && scanner.GetPosition() >= next_report) {
+        std::cerr << "[INFO] Indexed " << (scanner.GetPosition() >> 20) << " of "
+          << (scanner.GetFileSize() >> 20) << " MB" << std::endl;
+        next_report += kReportInterval;
+      }
+    }
+
+    return Write(index_file, scanner.GetFileSize());
+  }
+
+  void Add(const TraceEvent& event) {
+    if (event.text_.size() > (std::numeric_limits<uint32_t>::max)()) {
+      return;
+    }
+    TraceIndexEntry entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.ts_ = event.ts_;
+    entry.dur_ = (event.dur_ > 0) ? event.dur_ : 0;
+    entry.offset_ = event.offset_;
+    entry.length_ = static_cast<uint32_t>(event.text_.size());
+    entry.name_id_ = event.name_.empty() ? kTraceIndexNoName : GetNameId(event.name_);
+    entry.thread_id_ = GetThreadId(event.pid_, event.tid_);
+    entry.ph_ = event.ph_.empty() ? ' ' : event.ph_[0];
+    if (event.IsMetadata()) {
+      meta_.push_back(entry);
+    } else {
+      entries_.push_back(entry);
+    }
+  }
+
+  bool Write(const std::string& index_file, uint64_t trace_size) {
+    std::sort(entries_.begin(), entries_.end(), [](const TraceIndexEntry& lhs, const TraceIndexEntry& rhs) {
+      return (lhs.ts_ < rhs.ts_) || ((lhs.ts_ == rhs.ts_) && (lhs.offset_ < rhs.offset_));
+    });
+
+    TraceIndexHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic_, kTraceIndexMagic, sizeof(header.magic_));
+    header.version_ = kTraceIndexVersion;
+    header.trace_size_ = trace_size;
+    header.event_count_ = entries_.size();
+    header.meta_count_ = meta_.size();
+    header.name_count_ = names_.size();
+    header.thread_count_ = threads_.size();
+    header.min_ts_ = entries_.empty() ? 0 : entries_.front().ts_;
+    header.max_ts_ = entries_.empty() ? 0 : entries_.back().ts_;
+    header.max_dur_ = 0;
+    for (const auto& entry : entries_) {
+      header.max_dur_ = (std::max)(header.max_dur_, entry.dur_);
+    }
+
+    int64_t window_ns = (window_ns_ > 0) ? window_ns_ : kTraceIndexDefaultWindowNs;
+    uint64_t span = static_cast<uint64_t>(header.max_ts_ - header.min_ts_);
+    while (span / static_cast<uint64_t>(window_ns) + 1 > kTraceIndexMaxWindows) {
+      window_ns *= 2;
+    }
+    header.window_ns_ = window_ns;
+    header.window_count_ = entries_.empty() ? 0 : (span / static_cast<uint64_t>(window_ns) + 1);
+
+    std::vector<uint64_t> windows(header.window_count_ + 1);
+    uint64_t e = 0;
+    for (uint64_t w = 0; w < header.window_count_; w++) {
+      int64_t window_start = header.min_ts_ + static_cast<int64_t>(w) * window_ns;
+      while (e < entries_.size() && entries_[e].ts_ < window_start) {
+        e++;
+      }
+      windows[w] = e;
+    }
+    windows[header.window_count_] = entries_.size();
+
+    // Postings are filled in entry order, so every list comes out sorted by time
+    std::vector<TraceIndexName> names(names_.size());
+    std::vector<TraceIndexThread> threads(threads_.size());
+    std::vector<uint64_t> name_counts(names_.size(), 0);
+    std::vector<uint64_t> thread_counts(threads_.size(), 0);
+    for (const auto& entry : entries_) {
+      if (entry.name_id_ != kTraceIndexNoName) {
+        name_counts[entry.name_id_]++;
+      }
+      thread_counts[entry.thread_id_]++;
+    }
+
+    std::string strings;
+    uint64_t first = 0;
+    for (size_t i = 0; i < names_.size(); i++) {
+      names[i].string_offset_ = strings.size();
+      names[i].string_length_ = names_[i].size();
+      names[i].postings_first_ = first;
+      names[i].postings_count_ = 0;
+      strings += names_[i];
+      first += name_counts[i];
+    }
+    for (size_t i = 0; i < threads_.size(); i++) {
+      threads[i].pid_ = threads_[i].first;
+      threads[i].tid_ = threads_[i].second;
+      threads[i].postings_first_ = first;
+      threads[i].postings_count_ = 0;
+      first += thread_counts[i];
+    }
+
+    std::vector<uint64_t> postings(first);
+    for (uint64_t i = 0; i < entries_.size(); i++) {
+      const auto& entry = entries_[i];
+      if (entry.name_id_ != kTraceIndexNoName) {
+        auto& name = names[entry.name_id_];
+        postings[name.postings_first_ + name.postings_count_++] = i;
+      }
+      auto& thread = threads[entry.thread_id_];
+      postings[thread.postings_first_ + thread.postings_count_++] = i;
+    }
+
+    header.windows_offset_ = sizeof(header);
+    header.entries_offset_ = header.windows_offset_ + windows.size() * sizeof(uint64_t);
+    header.meta_offset_ = header.entries_offset_ + entries_.size() * sizeof(TraceIndexEntry);
+    header.names_offset_ = header.meta_offset_ + meta_.size() * sizeof(TraceIndexEntry);
+    header.threads_offset_ = header.names_offset_ + names.size() * sizeof(TraceIndexName);
+    header.postings_offset_ = header.threads_offset_ + threads.size() * sizeof(TraceIndexThread);
+    header.strings_offset_ = header.postings_offset_ + postings.size() * sizeof(uint64_t);
+    header.strings_size_ = strings.size();
+
+    std::ofstream out(index_file, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+      std::cerr << "[ERROR] Failed to open file " << index_file << " for writing. Do you have the right permission?" << std::endl;
+      return false;
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    WriteVector(out, windows);
+    WriteVector(out, entries_);
+    WriteVector(out, meta_);
+    WriteVector(out, names);
+    WriteVector(out, threads);
+    WriteVector(out, postings);
+    out.write(strings.data(), strings.size());
+    out.close();
+    if (!out) {
+      std::cerr << "[ERROR] Failed to write index file " << index_file << std::endl;
+      return false;
+    }
+    return true;
+  }
+
+  uint64_t GetEventCount() const {
+    return entries_.size() + meta_.size();
+  }
+
+ private:
+  static constexpr uint64_t kReportInterval = 1024ull * 1024 * 1024;
+
+  template <typename T>
+  static void WriteVector(std::ofstream& out, const std::vector<T>& data) {
+    if (!data.empty()) {
+      out.write(reinterpret_cast<const char*>(data.data()), data.size() * sizeof(T));
+    }
+  }
+
+  uint32_t GetNameId(std::string_view name) {
+    auto it = name_ids_.find(std::string(name));
+    if (it != name_ids_.end()) {
+      return it->second;
+    }
+    uint32_t id = static_cast<uint32_t>(names_.size());
+    names_.emplace_back(name);
+    name_ids_.emplace(names_.back(), id);
+    return id;
+  }
+
+  uint32_t GetThreadId(int64_t pid, int64_t tid) {
+    auto key = std::make_pair(pid, tid);
+    auto it = thread_ids_.find(key);
+    if (it != thread_ids_.end()) {
+      return it->second;
+    }
+    uint32_t id = static_cast<uint32_t>(threads_.size());
+    threads_.push_back(key);
+    thread_ids_.emplace(key, id);
+    return id;
+  }
+
+  int64_t window_ns_;
+  std::vector<TraceIndexEntry> entries_;
+  std::vector<TraceIndexEntry> meta_;
+  std::vector<std::string> names_;
+  std::unordered_map<std::string, uint32_t> name_ids_;
+  std::vector<std::pair<int64_t, int64_t>> threads_;
+  std::map<std::pair<int64_t, int64_t>, uint32_t> thread_ids_;
+};
+
+// Read side of the index. Only the header and the small directories are loaded, entries and
+// postings are read on demand.
+class TraceIndex {
+ public:
+  TraceIndex() = default;
+  TraceIndex(const TraceIndex& that) = delete;
+  TraceIndex& operator=(const TraceIndex& that) = delete;
+
+  // trace_size is compared with the size recorded in the index unless it is 0
+  bool Open(const std::string& index_file, uint64_t trace_size = 0) {
+    file_.open(index_file, std::ios::in | std::ios::binary);
+    if (!file_.is_open()) {
+      return false;
+    }
+    file_.read(reinterpret_cast<char*>(&header_), sizeof(header_));
+    if (!file_ || memcmp(header_.magic_, kTraceIndexMagic, sizeof(header_.magic_)) != 0) {
+      std::cerr << "[ERROR] " << index_file << " is not a trace index file" << std::endl;
+      return false;
+    }
+    if (header_.version_ != kTraceIndexVersion) {
+      std::cerr << "[ERROR] Unsupported trace index version " << header_.version_ << " in " << index_file << std::endl;
+      return false;
+    }
+    if (trace_size != 0 && trace_size != header_.trace_size_) {
+      std::cerr << "[ERROR] Index file " << index_file << " is stale, please rebuild it" << std::endl;
+      return false;
+    }
+
+    windows_.resize(header_.window_count_ + 1);
+    names_.resize(header_.name_count_);
+    threads_.resize(header_.thread_count_);
+    strings_.resize(header_.strings_size_);
+    if (!ReadAt(header_.windows_offset_, windows_.data(), windows_.size() * sizeof(uint64_t)) ||
+        !ReadAt(header_.names_offset_, names_.data(), names_.size() * sizeof(TraceIndexName)) ||
+        !ReadAt(header_.threads_offset_, threads_.data(), threads_.size() * sizeof(TraceIndexThread)) ||
+        !ReadAt(header_.strings_offset_, strings_.data(), strings_.size())) {
+      std::cerr << "[ERROR] Index file " << index_file << " is truncated" << std::endl;
+      return false;
+    }
+    return true;
+  }
+
+  const TraceIndexHeader& GetHeader() const {
+    return header_;
+  }
+
+  uint64_t GetEventCount() const {
+    return header_.event_count_;
+  }
+
+  size_t GetNameCount() const {
+    return names_.size();
+  }
+
+  std::string_view GetName(uint32_t name_id) const {
+    if (name_id >= names_.size()) {
+      return std::string_view();
+    }
+    return std::string_view(strings_.data() + names_[name_id].string_offset_, names_[name_id].string_length_);
+  }
+
+  uint64_t GetNameInstanceCount(uint32_t name_id) const {
+    return (name_id < names_.size()) ? names_[name_id].postings_count_ : 0;
+  }
+
+  const std::vector<TraceIndexThread>& GetThreads() const {
+    return threads_;
+  }
+
+  // Names equal to name (exact) or containing it (substring)
+  std::vector<uint32_t> FindNames(std::string_view name, bool substring) const {
+    std::vector<uint32_t> ids;
+    for (uint32_t i = 0; i < names_.size(); i++) {
+      std::string_view candidate = GetName(i);
+      if (substring ? (candidate.find(name) != std::string_view::npos) : (candidate == name)) {
+        ids.push_back(i);
+      }
+    }
+    return ids;
+  }
+
+  std::vector<uint32_t> FindThreads(int64_t pid, int64_t tid) const {
+    std::vector<uint32_t> ids;
+    for (uint32_t i = 0; i < threads_.size(); i++) {
+      if ((pid < 0 || threads_[i].pid_ == pid) && (tid < 0 || threads_[i].tid_ == tid)) {
+        ids.push_back(i);
+      }
+    }
+    return ids;
+  }
+
+  bool ReadMeta(std::vector<TraceIndexEntry>& meta) {
+    meta.resize(header_.meta_count_);
+    return ReadAt(header_.meta_offset_, meta.data(), meta.size() * sizeof(TraceIndexEntry));
+  }
+
+  bool ReadEntries(uint64_t first, uint64_t count, std::vector<TraceIndexEntry>& entries) {
+    if (first > header_.event_count_) {
+      first = header_.event_count_;
+    }
+    count = (std::min)(count, header_.event_count_ - first);
+    entries.resize(count);
+    return ReadAt(header_.entries_offset_ + first * sizeof(TraceIndexEntry), entries.data(), count * sizeof(TraceIndexEntry));
+  }
+
+  bool ReadEntry(uint64_t n, TraceIndexEntry& entry) {
+    return ReadAt(header_.entries_offset_ + n * sizeof(TraceIndexEntry), &entry, sizeof(entry));
+  }
+
+  // Range [first, last) of entries that may overlap [from, to]
+  std::pair<uint64_t, uint64_t> GetEntryRange(int64_t from, int64_t to) const {
+    if (header_.window_count_ == 0 || to < from) {
+      return {0, 0};
+    }
+    // saturate, from is INT64_MIN if the range has no lower bound
+    constexpr int64_t kMinTs = (std::numeric_limits<int64_t>::min)();
+    int64_t lower = (from < kMinTs + header_.max_dur_) ? kMinTs : from - header_.max_dur_;
+    return {windows_[GetWindow(lower)], windows_[GetWindow(to) + 1]};
+  }
+
+  // Posting lists are ascending, so the part of a list inside [first, last) is found by bisection
+  bool ReadPostings(uint64_t postings_first, uint64_t postings_count, uint64_t first, uint64_t last,
+                    std::vector<uint64_t>& postings) {
+    postings.resize(postings_count);
+    if (!ReadAt(header_.postings_offset_ + postings_first * sizeof(uint64_t), postings.data(),
+                postings_count * sizeof(uint64_t))) {
+      return false;
+    }
+    auto begin = std::lower_bound(postings.begin(), postings.end(), first);
+    auto end = std::lower_bound(begin, postings.end(), last);
+    postings.erase(end, postings.end());
+    postings.erase(postings.begin(), begin);
+    return true;
+  }
+
+  bool ReadNamePostings(uint32_t name_id, uint64_t first, uint64_t last, std::vector<uint64_t>& postings) {
+    return ReadPostings(names_[name_id].postings_first_, names_[name_id].postings_count_, first, last, postings);
+  }
+
+  bool ReadThreadPostings(uint32_t thread_id, uint64_t first, uint64_t last, std::vector<uint64_t>& postings) {
+    return ReadPostings(threads_[thread_id].postings_first_, threads_[thread_id].postings_count_, first, last, postings);
+  }
+
+ private:
+  uint64_t GetWindow(int64_t ts) const {
+    if (ts <= header_.min_ts_) {
+      return 0;
+    }
+    uint64_t w = static_cast<uint64_t>(ts - header_.min_ts_) / static_cast<uint64_t>(header_.window_ns_);
+    return (std::min)(w, header_.window_count_ - 1);
+  }
+
+  bool ReadAt(uint64_t offset, void* data, size_t size) {
+    if (size == 0) {
+      return true;
+    }
+    file_.clear();
+    file_.seekg(static_cast<std::streamoff>(offset), std::ios::beg);
+    file_.read(reinterpret_cast<char*>(data), size);
+    return static_cast<bool>(file_);
+  }
+
+  std::ifstream file_;
+  TraceIndexHeader header_ = {};
+  std::vector<uint64_t> windows_;
+  std::vector<TraceIndexName> names_;
+  std::vector<TraceIndexThread> threads_;
+  std::vector<char> strings_;
+};
+
+// Reads the raw text of an indexed event back from the trace
+inline bool ReadTraceEventText(std::ifstream& trace, const TraceIndexEntry& entry, std::string& text) {
+  text.resize(entry.length_);
+  trace.clear();
+  trace.seekg(static_cast<std::streamoff>(entry.offset_), std::ios::beg);
+  trace.read(&text[0], entry.length_);
+  return static_cast<bool>(trace);
+}
+
+#endif // PTI_TOOLS_UNITRACE_TRACETOOLS_TRACE_INDEX_H_
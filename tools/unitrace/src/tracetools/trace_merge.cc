@@ -0,0 +1,487 @@
+//==============================================================
+// Copyright (C) Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+// =============================================================
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <queue>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "trace_index.h"
+
+// Streaming k-way merge of unitrace traces (e.g. one per MPI rank). Every input is read in time
+// order through its sidecar index, so only one batch of index entries per input is held in memory
+// regardless of the trace sizes.
+
+static constexpr uint64_t kDefaultBatchSize = 4096;
+static constexpr size_t kOutputBufferSize = 4 * 1024 * 1024;
+
+static void Usage(const char* progname) {
+  std::cout <<
+    "Usage: " << progname << " [options] <trace-file-1> <trace-file-2> ..." << std::endl <<
+    "Merge unitrace Chrome JSON traces, e.g. of multiple MPI ranks, into one trace ordered by time" << std::endl <<
+    "Options:" << std::endl <<
+    "--output [-o] <file>          Output file name, default is unitrace.all.json" << std::endl <<
+    "--slice <us>                  Split output into files of <us> microseconds each, named <output>.<n>.json" << std::endl <<
+    "--offsets <us>,<us>,...       Clock offset in microseconds added to timestamps of each input, in input order" << std::endl <<
+    "--align-start                 Shift every input so that its first event starts with the earliest input" << std::endl <<
+    "--index-dir <dir>             Directory to look for and store input indices, default is next to the inputs" << std::endl <<
+    "--batch <count>               Number of index entries buffered per input, default is 4096" << std::endl <<
+    "--help [-h]                   Show this message" << std::endl;
+}
+
+// Rewrites pid and/or ts of an event in place of the original values
+static void RewriteEvent(const std::string& text, int64_t pid, int64_t ts_offset, std::string& result) {
+  TraceEvent event;
+  event.text_ = text;
+  if (!ParseTraceEventFields(event)) {
+    result = text;
+    return;
+  }
+
+  struct Replacement {
+    size_t pos_;
+    size_t len_;
+    std::string value_;
+  };
+  std::vector<Replacement> replacements;
+  if (pid >= 0 && event.pid_pos_ != std::string_view::npos && pid != event.pid_) {
+    replacements.push_back({event.pid_pos_, event.pid_len_, std::to_string(pid)});
+  }
+  if (ts_offset != 0 && event.has_ts_) {
+    replacements.push_back({event.ts_pos_, event.ts_len_, FormatTraceTime(event.ts_ + ts_offset)});
+  }
+  if (replacements.empty()) {
+    result = text;
+    return;
+  }
+  std::sort(replacements.begin(), replacements.end(), [](const Replacement& lhs, const Replacement& rhs) {
+    return lhs.pos_ < rhs.pos_;
+  });
+
+  result.clear();
+  size_t pos = 0;
+  for (const auto& r : replacements) {
+    result.append(text, pos, r.pos_ - pos);
+    result += r.value_;
+    pos = r.pos_ + r.len_;
+  }
+  result.append(text, pos, std::string::npos);
+}
+
+class MergeInput {
+ public:
+  MergeInput(const std::string& trace_file, uint64_t batch_size) : trace_file_(trace_file), batch_size_(batch_size) {}
+
+  MergeInput(const MergeInput& that) = delete;
+  MergeInput& operator=(const MergeInput& that) = delete;
+
+  bool Open(const std::string& index_file) {
+    trace_.open(trace_file_, std::ios::in | std::ios::binary | std::ios::ate);
+    if (!trace_.is_open()) {
+      std::cerr << "[ERROR] Failed to open trace file " << trace_file_ << std::endl;
+      return false;
+    }
+    uint64_t trace_size = static_cast<uint64_t>(trace_.tellg());
+
+    std::ifstream existing(index_file, std::ios::in | std::ios::binary);
+    bool build = !existing.is_open();
+    if (!build) {
+      TraceIndexHeader header;
+      existing.read(reinterpret_cast<char*>(&header), sizeof(header));
+      build = (!existing || memcmp(header.magic_, kTraceIndexMagic, sizeof(header.magic_)) != 0 ||
+               header.version_ != kTraceIndexVersion || header.trace_size_ != trace_size);
+    }
+    existing.close();
+    if (build) {
+      std::cerr << "[INFO] Building index " << index_file << std::endl;
+      TraceIndexBuilder builder;
+      if (!builder.Build(trace_file_, index_file)) {
+        return false;
+      }
+    }
+    return index_.Open(index_file, trace_size);
+  }
+
+  TraceIndex& GetIndex() {
+    return index_;
+  }
+
+  const std::string& GetTraceFile() const {
+    return trace_file_;
+  }
+
+  void SetClockOffset(int64_t offset) {
+    offset_ = offset;
+  }
+
+  int64_t GetClockOffset() const {
+    return offset_;
+  }
+
+  void SetPidMap(std::map<int64_t, int64_t>&& pid_map) {
+    pid_map_ = std::move(pid_map);
+  }
+
+  bool HasEvent() const {
+    return pos_ < batch_.size();
+  }
+
+  // Timestamp of the current event with the clock offset applied
+  int64_t GetTime() const {
+    return batch_[pos_].ts_ + offset_;
+  }
+
+  bool Start() {
+    next_ = 0;
+    return Load();
+  }
+
+  bool Advance() {
+    pos_++;
+    if (pos_ == batch_.size()) {
+      return Load();
+    }
+    return true;
+  }
+
+  bool ReadEvent(const TraceIndexEntry& entry, std::string& text) {
+    if (!ReadTraceEventText(trace_, entry, raw_)) {
+      std::cerr << "[ERROR] Failed to read event at offset " << entry.offset_ << " of " << trace_file_ << std::endl;
+      return false;
+    }
+    const auto& thread = index_.GetThreads()[entry.thread_id_];
+    auto it = pid_map_.find(thread.pid_);
+    RewriteEvent(raw_, (it == pid_map_.end()) ? -1 : it->second, offset_, text);
+    return true;
+  }
+
+  bool ReadCurrentEvent(std::string& text) {
+    return ReadEvent(batch_[pos_], text);
+  }
+
+ private:
+  bool Load() {
+    batch_.clear();
+    pos_ = 0;
+    uint64_t count = (std::min)(batch_size_, index_.GetEventCount() - next_);
+    if (count == 0) {
+      return true;
+    }
+    if (!index_.ReadEntries(next_, count, batch_)) {
+      std::cerr << "[ERROR] Failed to read index of " << trace_file_ << std::endl;
+      batch_.clear();
+      return false;
+    }
+    next_ += count;
+    return true;
+  }
+
+  std::string trace_file_;
+  uint64_t batch_size_;
+  std::ifstream trace_;
+  TraceIndex index_;
+  int64_t offset_ = 0;
+  std::map<int64_t, int64_t> pid_map_;
+  std::vector<TraceIndexEntry> batch_;
+  size_t pos_ = 0;
+  uint64_t next_ = 0;
+  std::string raw_;
+};
+
+class MergeOutput {
+ public:
+  MergeOutput(const std::string& output_file, int64_t slice_ns, const std::vector<std::string>& meta)
+    : output_file_(output_file), slice_ns_(slice_ns), meta_(meta), buffer_(kOutputBufferSize) {}
+
+  MergeOutput(const MergeOutput& that) = delete;
+  MergeOutput& operator=(const MergeOutput& that) = delete;
+
+  ~MergeOutput() {
+    Close();
+  }
+
+  bool Write(int64_t ts, const std::string& text) {
+    if (!file_.is_open() || (slice_ns_ > 0 && ts >= slice_end_)) {
+      if (!OpenNext(ts)) {
+        return false;
+      }
+    }
+    file_ << (first_ ? "" : ",\n") << text;
+    first_ = false;
+    return true;
+  }
+
+  // Makes sure an output exists even if there is nothing to merge
+  bool Finish() {
+    if (!opened_ && !OpenNext(0)) {
+      return false;
+    }
+    return Close();
+  }
+
+  bool Close() {
+    if (!file_.is_open()) {
+      return true;
+    }
+    file_ << "\n]\n}\n";
+    file_.close();
+    if (!file_) {
+      std::cerr << "[ERROR] Failed to write " << current_file_ << std::endl;
+      return false;
+    }
+    std::cerr << "[INFO] Merged trace is stored in " << current_file_ << std::endl;
+    return true;
+  }
+
+ private:
+  bool OpenNext(int64_t ts) {
+    if (!Close()) {
+      return false;
+    }
+    current_file_ = output_file_;
+    if (slice_ns_ > 0) {
+      if (slice_count_ == 0) {
+        slice_start_ = ts;
+      }
+      int64_t slice = (ts - slice_start_) / slice_ns_;
+      slice_end_ = slice_start_ + (slice + 1) * slice_ns_;
+      size_t pos = output_file_.rfind(".json");
+      std::string base = (pos == std::string::npos) ? output_file_ : output_file_.substr(0, pos);
+      current_file_ = base + "." + std::to_string(slice) + ".json";
+      slice_count_++;
+    }
+
+    file_.clear();
+    file_.rdbuf()->pubsetbuf(buffer_.data(), buffer_.size());
+    file_.open(current_file_, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file_.is_open()) {
+      std::cerr << "[ERROR] Failed to open file " << current_file_ << " for writing. Do you have the right permission?" << std::endl;
+      return false;
+    }
+    file_ << "{ \"traceEvents\":[\n";
+    opened_ = true;
+    first_ = true;
+    // every slice carries the process and thread names so it can be viewed on its own
+    for (const auto& text : meta_) {
+      file_ << (first_ ? "" : ",\n") << text;
+      first_ = false;
+    }
+    return true;
+  }
+
+  std::string output_file_;
+  std::string current_file_;
+  int64_t slice_ns_;
+  int64_t slice_start_ = 0;
+  int64_t slice_end_ = 0;
+  uint64_t slice_count_ = 0;
+  bool opened_ = false;
+  bool first_ = true;
+  const std::vector<std::string>& meta_;
+  std::vector<char> buffer_;
+  std::ofstream file_;
+};
+
+static std::string GetIndexFileName(const std::string& trace_file, const std::string& index_dir) {
+  if (index_dir.empty()) {
+    return GetDefaultTraceIndexFileName(trace_file);
+  }
+  size_t pos = trace_file.find_last_of("/\\");
+  std::string name = (pos == std::string::npos) ? trace_file : trace_file.substr(pos + 1);
+  return GetDefaultTraceIndexFileName(index_dir + "/" + name);
+}
+
+int main(int argc, char* argv[]) {
+  std::vector<std::string> input_files;
+  std::string output_file = "unitrace.all.json";
+  std::string index_dir;
+  std::vector<int64_t> offsets;
+  int64_t slice_ns = 0;
+  bool align_start = false;
+  uint64_t batch_size = kDefaultBatchSize;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    bool has_value = (i + 1 < argc);
+    if (arg == "-h" || arg == "--help") {
+      Usage(argv[0]);
+      return 0;
+    } else if ((arg == "-o" || arg == "--output") && has_value) {
+      output_file = argv[++i];
+    } else if (arg == "--slice" && has_value) {
+      if (!ParseTraceTimeToNs(argv[++i], slice_ns) || slice_ns <= 0) {
+        std::cerr << "[ERROR] Invalid slice duration" << std::endl;
+        return -1;
+      }
+    } else if (arg == "--offsets" && has_value) {
+      std::string list = argv[++i];
+      size_t start = 0;
+      while (start <= list.size()) {
+        size_t end = list.find(',', start);
+        if (end == std::string::npos) {
+          end = list.size();
+        }
+        int64_t offset = 0;
+        if (!ParseTraceTimeToNs(list.substr(start, end - start), offset)) {
+          std::cerr << "[ERROR] Invalid clock offset list " << list << std::endl;
+          return -1;
+        }
+        offsets.push_back(offset);
+        start = end + 1;
+      }
+    } else if (arg == "--align-start") {
+      align_start = true;
+    } else if (arg == "--index-dir" && has_value) {
+      index_dir = argv[++i];
+    } else if (arg == "--batch" && has_value) {
+      batch_size = std::strtoull(argv[++i], nullptr, 0);
+      if (batch_size == 0) {
+        batch_size = kDefaultBatchSize;
+      }
+    } else if (arg[0] != '-') {
+      input_files.push_back(arg);
+    } else {
+      std::cerr << "[ERROR] Unknown or incomplete option " << arg << std::endl;
+      Usage(argv[0]);
+      return -1;
+    }
+  }
+
+  if (input_files.empty()) {
+    Usage(argv[0]);
+    return -1;
+  }
+  if (!offsets.empty() && offsets.size() != input_files.size()) {
+    std::cerr << "[ERROR] " << offsets.size() << " clock offsets are given for " << input_files.size() << " input files" << std::endl;
+    return -1;
+  }
+
+  std::vector<std::unique_ptr<MergeInput>> inputs;
+  for (size_t i = 0; i < input_files.size(); i++) {
+    const std::string& file = input_files[i];
+    auto input = std::make_unique<MergeInput>(file, batch_size);
+    if (!input->Open(GetIndexFileName(file, index_dir))) {
+      std::cerr << "[WARNING] Skipping " << file << std::endl;
+      continue;
+    }
+    // Offsets are given per input file, so they are taken before any file is skipped
+    input->SetClockOffset(offsets.empty() ? 0 : offsets[i]);
+    inputs.push_back(std::move(input));
+  }
+  if (inputs.empty()) {
+    std::cerr << "[ERROR] No valid input trace" << std::endl;
+    return -1;
+  }
+
+  // Clock offset correction
+  int64_t earliest = (std::numeric_limits<int64_t>::max)();
+  for (const auto& input : inputs) {
+    if (input->GetIndex().GetEventCount() > 0) {
+      earliest = (std::min)(earliest, input->GetIndex().GetHeader().min_ts_);
+    }
+  }
+  if (align_start) {
+    for (const auto& input : inputs) {
+      if (input->GetIndex().GetEventCount() > 0) {
+        input->SetClockOffset(input->GetClockOffset() + earliest - input->GetIndex().GetHeader().min_ts_);
+      }
+    }
+  }
+
+  // Rank-aware pid remapping: a pid already taken by a previous input (e.g. the same host pid on
+  // two nodes) is moved to an unused one, so processes of different ranks never share a track
+  std::set<int64_t> used_pids;
+  for (const auto& input : inputs) {
+    for (const auto& thread : input->GetIndex().GetThreads()) {
+      used_pids.insert(thread.pid_);
+    }
+  }
+  std::set<int64_t> assigned_pids;
+  int64_t next_pid = 1;
+  for (const auto& input : inputs) {
+    std::map<int64_t, int64_t> pid_map;
+    for (const auto& thread : input->GetIndex().GetThreads()) {
+      if (thread.pid_ < 0 || pid_map.count(thread.pid_) != 0) {
+        continue;
+      }
+      int64_t pid = thread.pid_;
+      if (assigned_pids.count(pid) != 0) {
+        while (used_pids.count(next_pid) != 0 || assigned_pids.count(next_pid) != 0) {
+          next_pid++;
+        }
+        pid = next_pid;
+        std::cerr << "[INFO] Process " << thread.pid_ << " of " << input->GetTraceFile() << " is remapped to " << pid << std::endl;
+      }
+      pid_map[thread.pid_] = pid;
+    }
+    for (const auto& [from, to] : pid_map) {
+      assigned_pids.insert(to);
+    }
+    input->SetPidMap(std::move(pid_map));
+  }
+
+  // Metadata of all inputs goes to the head of (every slice of) the output
+  std::vector<std::string> meta;
+  std::string text;
+  for (auto& input : inputs) {
+    std::vector<TraceIndexEntry> entries;
+    if (!input->GetIndex().ReadMeta(entries)) {
+      std::cerr << "[ERROR] Failed to read index of " << input->GetTraceFile() << std::endl;
+      return -1;
+    }
+    for (const auto& entry : entries) {
+      if (entry.ph_ == 'M' && input->ReadEvent(entry, text)) {
+        meta.push_back(text);
+      }
+    }
+  }
+
+  auto later = [&inputs](size_t lhs, size_t rhs) {
+    int64_t lhs_ts = inputs[lhs]->GetTime();
+    int64_t rhs_ts = inputs[rhs]->GetTime();
+    return (lhs_ts > rhs_ts) || ((lhs_ts == rhs_ts) && (lhs > rhs));
+  };
+  std::priority_queue<size_t, std::vector<size_t>, decltype(later)> heap(later);
+  for (size_t i = 0; i < inputs.size(); i++) {
+    if (!inputs[i]->Start()) {
+      return -1;
+    }
+    if (inputs[i]->HasEvent()) {
+      heap.push(i);
+    }
+  }
+
+  MergeOutput output(output_file, slice_ns, meta);
+  uint64_t count = 0;
+  while (!heap.empty()) {
+    size_t i = heap.top();
+    heap.pop();
+    auto& input = inputs[i];
+    if (!input->ReadCurrentEvent(text) || !output.Write(input->GetTime(), text)) {
+      return -1;
+    }
+    count++;
+    if (!input->Advance()) {
+      return -1;
+    }
+    if (input->HasEvent()) {
+      heap.push(i);
+    }
+  }
+  if (!output.Finish()) {
+    return -1;
+  }
+
+  std::cerr << "[INFO] " << count << " events from " << inputs.size() << " traces merged" << std::endl;
+  return 0;
+}
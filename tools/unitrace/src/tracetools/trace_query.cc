@@ -0,0 +1,332 @@
+//==============================================================
+// Copyright (C) Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+// =============================================================
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "trace_index.h"
+
+static constexpr uint64_t kEntryBatchSize = 64 * 1024;
+
+static void Usage(const char* progname) {
+  std::cout <<
+    "Usage: " << progname << " [options] <trace-file>" << std::endl <<
+    "Extract events from a unitrace Chrome JSON trace using its sidecar index (see unitrace_index)" << std::endl <<
+    "Options:" << std::endl <<
+    "--index [-i] <index-file>     Index file name, default is <trace-file>.idx. The index is built if it does not exist" << std::endl <<
+    "--from <us>                   Extract events that end at or after this time (in microseconds)" << std::endl <<
+    "--to <us>                     Extract events that start at or before this time (in microseconds)" << std::endl <<
+    "--relative                    --from and --to are relative to the first event in the trace" << std::endl <<
+    "--name <name>                 Extract events (e.g. kernel instances) with this exact name" << std::endl <<
+    "--name-contains <string>      Extract events whose name contains the string" << std::endl <<
+    "--pid <pid>                   Extract events of this process" << std::endl <<
+    "--tid <tid>                   Extract events of this thread" << std::endl <<
+    "--limit <count>               Extract no more than <count> events" << std::endl <<
+    "--csv                         Output ts,dur,pid,tid,name records instead of a Chrome JSON trace" << std::endl <<
+    "--list-names                  List event names with their instance counts" << std::endl <<
+    "--stats                       Show summary of the index" << std::endl <<
+    "--output [-o] <file>          Output file name, default is stdout" << std::endl <<
+    "--help [-h]                   Show this message" << std::endl;
+}
+
+struct QueryOptions {
+  std::string trace_file;
+  std::string index_file;
+  std::string output_file;
+  int64_t from = (std::numeric_limits<int64_t>::min)();
+  int64_t to = (std::numeric_limits<int64_t>::max)();
+  bool from_set = false;
+  bool to_set = false;
+  bool relative = false;
+  std::string name;
+  bool name_set = false;
+  bool name_substring = false;
+  int64_t pid = -1;
+  int64_t tid = -1;
+  uint64_t limit = (std::numeric_limits<uint64_t>::max)();
+  bool csv = false;
+  bool list_names = false;
+  bool stats = false;
+};
+
+static bool ParseOptions(int argc, char* argv[], QueryOptions& options) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    bool has_value = (i + 1 < argc);
+    if (arg == "-i" || arg == "--index") {
+      if (!has_value) return false;
+      options.index_file = argv[++i];
+    } else if (arg == "-o" || arg == "--output") {
+      if (!has_value) return false;
+      options.output_file = argv[++i];
+    } else if (arg == "--from") {
+      if (!has_value || !ParseTraceTimeToNs(argv[++i], options.from)) return false;
+      options.from_set = true;
+    } else if (arg == "--to") {
+      if (!has_value || !ParseTraceTimeToNs(argv[++i], options.to)) return false;
+      options.to_set = true;
+    } else if (arg == "--relative") {
+      options.relative = true;
+    } else if (arg == "--name" || arg == "--name-contains") {
+      if (!has_value) return false;
+      options.name = argv[++i];
+      options.name_set = true;
+      options.name_substring = (arg == "--name-contains");
+    } else if (arg == "--pid") {
+      if (!has_value || !ParseTraceInteger(argv[++i], options.pid)) return false;
+    } else if (arg == "--tid") {
+      if (!has_value || !ParseTraceInteger(argv[++i], options.tid)) return false;
+    } else if (arg == "--limit") {
+      if (!has_value) return false;
+      options.limit = std::strtoull(argv[++i], nullptr, 0);
+    } else if (arg == "--csv") {
+      options.csv = true;
+    } else if (arg == "--list-names") {
+      options.list_names = true;
+    } else if (arg == "--stats") {
+      options.stats = true;
+    } else if (options.trace_file.empty() && arg[0] != '-') {
+      options.trace_file = arg;
+    } else {
+      std::cerr << "[ERROR] Unknown or incomplete option " << arg << std::endl;
+      return false;
+    }
+  }
+  return !options.trace_file.empty();
+}
+
+static uint64_t GetFileSize(const std::string& path) {
+  std::ifstream file(path, std::ios::in | std::ios::binary | std::ios::ate);
+  return file.is_open() ? static_cast<uint64_t>(file.tellg()) : 0;
+}
+
+// Entry numbers selected by the name or thread filter, or empty if the filter is absent
+static bool CollectPostings(TraceIndex& index, const QueryOptions& options, uint64_t first, uint64_t last,
+                            std::vector<uint64_t>& selected) {
+  std::vector<uint64_t> postings;
+  if (options.name_set) {
+    for (auto name_id : index.FindNames(options.name, options.name_substring)) {
+      if (!index.ReadNamePostings(name_id, first, last, postings)) {
+        return false;
+      }
+      selected.insert(selected.end(), postings.begin(), postings.end());
+    }
+  } else {
+    for (auto thread_id : index.FindThreads(options.pid, options.tid)) {
+      if (!index.ReadThreadPostings(thread_id, first, last, postings)) {
+        return false;
+      }
+      selected.insert(selected.end(), postings.begin(), postings.end());
+    }
+  }
+  std::sort(selected.begin(), selected.end());
+  return true;
+}
+
+class QueryOutput {
+ public:
+  QueryOutput(std::ostream& out, bool csv, TraceIndex& index) : out_(out), csv_(csv), index_(index) {
+    if (csv_) {
+      out_ << "ts,dur,pid,tid,name" << std::endl;
+    } else {
+      out_ << "{ \"traceEvents\":[\n";
+    }
+  }
+
+  ~QueryOutput() {
+    if (!csv_) {
+      out_ << "\n]\n}\n";
+    }
+  }
+
+  void Emit(const TraceIndexEntry& entry, const std::string& text) {
+    if (csv_) {
+      const auto& thread = index_.GetThreads()[entry.thread_id_];
+      std::string name(index_.GetName(entry.name_id_));
+      out_ << FormatTraceTime(entry.ts_) << "," << FormatTraceTime(entry.dur_) << "," << thread.pid_ << ","
+        << thread.tid_ << ",\"" << name << "\"" << std::endl;
+    } else {
+      if (count_ > 0) {
+        out_ << ",\n";
+      }
+      out_ << text;
+    }
+    count_++;
+  }
+
+  uint64_t GetCount() const {
+    return count_;
+  }
+
+ private:
+  std::ostream& out_;
+  bool csv_;
+  TraceIndex& index_;
+  uint64_t count_ = 0;
+};
+
+int main(int argc, char* argv[]) {
+  QueryOptions options;
+  if (argc > 1 && (std::string(argv[1]) == "-h" || std::string(argv[1]) == "--help")) {
+    Usage(argv[0]);
+    return 0;
+  }
+  if (!ParseOptions(argc, argv, options)) {
+    Usage(argv[0]);
+    return -1;
+  }
+
+  uint64_t trace_size = GetFileSize(options.trace_file);
+  if (trace_size == 0) {
+    std::cerr << "[ERROR] Trace file " << options.trace_file << " is empty or does not exist" << std::endl;
+    return -1;
+  }
+  if (options.index_file.empty()) {
+    options.index_file = GetDefaultTraceIndexFileName(options.trace_file);
+  }
+  if (GetFileSize(options.index_file) == 0) {
+    std::cerr << "[INFO] Building index " << options.index_file << std::endl;
+    TraceIndexBuilder builder;
+    if (!builder.Build(options.trace_file, options.index_file)) {
+      return -1;
+    }
+  }
+
+  TraceIndex index;
+  if (!index.Open(options.index_file, trace_size)) {
+    return -1;
+  }
+
+  std::ofstream output_file;
+  if (!options.output_file.empty()) {
+    output_file.open(options.output_file, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!output_file.is_open()) {
+      std::cerr << "[ERROR] Failed to open file " << options.output_file << " for writing" << std::endl;
+      return -1;
+    }
+  }
+  std::ostream& out = output_file.is_open() ? output_file : std::cout;
+
+  const TraceIndexHeader& header = index.GetHeader();
+  if (options.stats) {
+    out << "Events:        " << header.event_count_ << std::endl;
+    out << "Metadata:      " << header.meta_count_ << std::endl;
+    out << "Names:         " << header.name_count_ << std::endl;
+    out << "Threads:       " << header.thread_count_ << std::endl;
+    out << "First (us):    " << FormatTraceTime(header.min_ts_) << std::endl;
+    out << "Last (us):     " << FormatTraceTime(header.max_ts_) << std::endl;
+    out << "Window (us):   " << FormatTraceTime(header.window_ns_) << std::endl;
+    return 0;
+  }
+
+  if (options.list_names) {
+    for (uint32_t i = 0; i < index.GetNameCount(); i++) {
+      out << index.GetNameInstanceCount(i) << "\t" << index.GetName(i) << std::endl;
+    }
+    return 0;
+  }
+
+  if (options.relative) {
+    if (options.from_set) options.from += header.min_ts_;
+    if (options.to_set) options.to += header.min_ts_;
+  }
+
+  std::ifstream trace(options.trace_file, std::ios::in | std::ios::binary);
+  if (!trace.is_open()) {
+    std::cerr << "[ERROR] Failed to open trace file " << options.trace_file << std::endl;
+    return -1;
+  }
+
+  std::set<uint32_t> name_ids;
+  if (options.name_set) {
+    for (auto id : index.FindNames(options.name, options.name_substring)) {
+      name_ids.insert(id);
+    }
+  }
+  std::set<uint32_t> thread_ids;
+  bool thread_filter = (options.pid >= 0 || options.tid >= 0);
+  if (thread_filter) {
+    for (auto id : index.FindThreads(options.pid, options.tid)) {
+      thread_ids.insert(id);
+    }
+  }
+
+  auto match = [&](const TraceIndexEntry& entry) {
+    if (entry.ts_ > options.to || entry.ts_ + entry.dur_ < options.from) {
+      return false;
+    }
+    if (options.name_set && name_ids.count(entry.name_id_) == 0) {
+      return false;
+    }
+    if (thread_filter && thread_ids.count(entry.thread_id_) == 0) {
+      return false;
+    }
+    return true;
+  };
+
+  std::string text;
+  QueryOutput result(out, options.csv, index);
+
+  if (!options.csv) {
+    // process and thread names so that viewers label the extracted events properly
+    std::vector<TraceIndexEntry> meta;
+    if (!index.ReadMeta(meta)) {
+      std::cerr << "[ERROR] Failed to read index file " << options.index_file << std::endl;
+      return -1;
+    }
+    for (const auto& entry : meta) {
+      if (entry.ph_ == 'M' && ReadTraceEventText(trace, entry, text)) {
+        result.Emit(entry, text);
+      }
+    }
+  }
+  uint64_t meta_count = result.GetCount();
+
+  auto [first, last] = (options.from_set || options.to_set) ?
+    index.GetEntryRange(options.from, options.to) : std::make_pair(uint64_t(0), index.GetEventCount());
+
+  std::vector<TraceIndexEntry> entries;
+  if (options.name_set || thread_filter) {
+    std::vector<uint64_t> selected;
+    if (!CollectPostings(index, options, first, last, selected)) {
+      std::cerr << "[ERROR] Failed to read index file " << options.index_file << std::endl;
+      return -1;
+    }
+    TraceIndexEntry entry;
+    for (auto n : selected) {
+      if (result.GetCount() - meta_count >= options.limit) {
+        break;
+      }
+      if (index.ReadEntry(n, entry) && match(entry) && ReadTraceEventText(trace, entry, text)) {
+        result.Emit(entry, text);
+      }
+    }
+  } else {
+    for (uint64_t n = first; n < last && result.GetCount() - meta_count < options.limit; n += kEntryBatchSize) {
+      if (!index.ReadEntries(n, (std::min)(kEntryBatchSize, last - n), entries)) {
+        std::cerr << "[ERROR] Failed to read index file " << options.index_file << std::endl;
+        return -1;
+      }
+      for (const auto& entry : entries) {
+        if (result.GetCount() - meta_count >= options.limit) {
+          break;
+        }
+        if (match(entry) && ReadTraceEventText(trace, entry, text)) {
+          result.Emit(entry, text);
+        }
+      }
+    }
+  }
+
+  std::cerr << "[INFO] " << (result.GetCount() - meta_count) << " events extracted" << std::endl;
+  return 0;
+}
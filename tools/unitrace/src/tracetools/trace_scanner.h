@@ -0,0 +1,413 @@
+//==============================================================
+// Copyright (C) Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+// =============================================================
+
+#ifndef PTI_TOOLS_UNITRACE_TRACETOOLS_TRACE_SCANNER_H_
+#define PTI_TOOLS_UNITRACE_TRACETOOLS_TRACE_SCANNER_H_
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Streaming reader of Chrome JSON traces produced by unitrace. The file is consumed in fixed-size
+// chunks and each object of the "traceEvents" array (or of a bare top-level array) is handed to
+// the caller together with its byte offset, so traces far larger than memory can be processed.
+
+constexpr size_t kTraceScannerChunkSize = 4 * 1024 * 1024;
+
+struct TraceEvent {
+  uint64_t offset_ = 0;         // offset of the opening '{' in the trace file
+  std::string_view text_;       // complete event object, from '{' to '}'
+  std::string_view ph_;         // values below point into text_, strings are still JSON escaped
+  std::string_view name_;
+  std::string_view cat_;
+  int64_t pid_ = -1;
+  int64_t tid_ = -1;
+  int64_t ts_ = 0;              // in nanoseconds
+  int64_t dur_ = 0;             // in nanoseconds, 0 if not present
+  bool has_ts_ = false;
+  // position and length of the raw "pid" and "ts" values inside text_, used to rewrite them
+  size_t pid_pos_ = std::string_view::npos;
+  size_t pid_len_ = 0;
+  size_t ts_pos_ = std::string_view::npos;
+  size_t ts_len_ = 0;
+
+  bool IsMetadata() const {
+    return (ph_ == "M") || !has_ts_;
+  }
+};
+
+// Converts a JSON number in microseconds, e.g. "1729012345678901.250000", to nanoseconds
+// without going through double, which cannot hold epoch microseconds with sub-microsecond precision
+inline bool ParseTraceTimeToNs(std::string_view value, int64_t& ns) {
+  if (value.empty()) {
+    return false;
+  }
+  if (value.find_first_of("eE") != std::string_view::npos) {
+    std::string str(value);
+    char* end = nullptr;
+    double us = std::strtod(str.c_str(), &end);
+    if (end == str.c_str()) {
+      return false;
+    }
+    ns = static_cast<int64_t>(us * 1000.0 + ((us < 0) ? -0.5 : 0.5));
+    return true;
+  }
+
+  size_t i = 0;
+  bool negative = false;
+  if (value[i] == '-' || value[i] == '+') {
+    negative = (value[i] == '-');
+    i++;
+  }
+  int64_t integer = 0;
+  bool digits = false;
+  for (; i < value.size() && value[i] >= '0' && value[i] <= '9'; i++) {
+    integer = integer * 10 + (value[i] - '0');
+    digits = true;
+  }
+  int64_t fraction = 0;
+  int scale = 100;
+  bool round_up = false;
+  if (i < value.size() && value[i] == '.') {
+    i++;
+    for (int k = 0; i < value.size() && value[i] >= '0' && value[i] <= '9'; i++, k++) {
+      if (k < 3) {
+        fraction += (value[i] - '0') * scale;
+        scale /= 10;
+      } else if (k == 3) {
+        round_up = (value[i] >= '5');
+      }
+      digits = true;
+    }
+  }
+  if (!digits) {
+    return false;
+  }
+  ns = integer * 1000 + fraction + (round_up ? 1 : 0);
+  if (negative) {
+    ns = -ns;
+  }
+  return true;
+}
+
+// Inverse of ParseTraceTimeToNs(), formats like std::to_string(double) does in unitrace
+inline std::string FormatTraceTime(int64_t ns) {
+  std::string str;
+  if (ns < 0) {
+    str = "-";
+    ns = -ns;
+  }
+  std::string fraction = std::to_string(ns % 1000);
+  str += std::to_string(ns / 1000) + "." + std::string(3 - fraction.size(), '0') + fraction + "000";
+  return str;
+}
+
+inline bool ParseTraceInteger(std::string_view value, int64_t& result) {
+  if (!value.empty() && value.front() == '\"' && value.size() >= 2) {
+    value = value.substr(1, value.size() - 2);
+  }
+  if (value.empty()) {
+    return false;
+  }
+  size_t i = 0;
+  bool negative = false;
+  if (value[0] == '-') {
+    negative = true;
+    i++;
+  }
+  int64_t number = 0;
+  size_t start = i;
+  for (; i < value.size() && value[i] >= '0' && value[i] <= '9'; i++) {
+    number = number * 10 + (value[i] - '0');
+  }
+  if (i == start) {
+    return false;
+  }
+  result = negative ? -number : number;
+  return true;
+}
+
+// Returns the end (one past) of the JSON value starting at pos, or npos if malformed
+inline size_t SkipTraceJsonValue(std::string_view text, size_t pos) {
+  if (pos >= text.size()) {
+    return std::string_view::npos;
+  }
+  char c = text[pos];
+  if (c == '\"') {
+    for (size_t i = pos + 1; i < text.size(); i++) {
+      if (text[i] == '\\') {
+        i++;
+      } else if (text[i] == '\"') {
+        return i + 1;
+      }
+    }
+    return std::string_view::npos;
+  }
+  if (c == '{' || c == '[') {
+    int depth = 0;
+    bool in_string = false;
+    for (size_t i = pos; i < text.size(); i++) {
+      char d = text[i];
+      if (in_string) {
+        if (d == '\\') {
+          i++;
+        } else if (d == '\"') {
+          in_string = false;
+        }
+      } else if (d == '\"') {
+        in_string = true;
+      } else if (d == '{' || d == '[') {
+        depth++;
+      } else if (d == '}' || d == ']') {
+        depth--;
+        if (depth == 0) {
+          return i + 1;
+        }
+      }
+    }
+    return std::string_view::npos;
+  }
+  size_t i = pos;
+  while (i < text.size() && text[i] != ',' && text[i] != '}' && text[i] != ']' &&
+         text[i] != ' ' && text[i] != '\t' && text[i] != '\r' && text[i] != '\n') {
+    i++;
+  }
+  return i;
+}
+
+// Extracts the top-level fields of interest from an event object. Nested objects such as "args"
+// are skipped, so a "name" inside "args" never shadows the event name.
+inline bool ParseTraceEventFields(TraceEvent& event) {
+  std::string_view text = event.text_;
+  auto skip_ws = [&text](size_t i) {
+    while (i < text.size() && (text[i] == ' ' || text[i] == '\t' || text[i] == '\r' || text[i] == '\n')) {
+      i++;
+    }
+    return i;
+  };
+
+  size_t i = skip_ws(0);
+  if (i >= text.size() || text[i] != '{') {
+    return false;
+  }
+  i = skip_ws(i + 1);
+  while (i < text.size() && text[i] != '}') {
+    if (text[i] != '\"') {
+      return false;
+    }
+    size_t key_end = SkipTraceJsonValue(text, i);
+    if (key_end == std::string_view::npos) {
+      return false;
+    }
+    std::string_view key = text.substr(i + 1, key_end - i - 2);
+    i = skip_ws(key_end);
+    if (i >= text.size() || text[i] != ':') {
+      return false;
+    }
+    i = skip_ws(i + 1);
+    size_t value_end = SkipTraceJsonValue(text, i);
+    if (value_end == std::string_view::npos) {
+      return false;
+    }
+    std::string_view value = text.substr(i, value_end - i);
+    std::string_view unquoted = value;
+    if (value.size() >= 2 && value.front() == '\"') {
+      unquoted = value.substr(1, value.size() - 2);
+    }
+
+    if (key == "ph") {
+      event.ph_ = unquoted;
+    } else if (key == "name") {
+      event.name_ = unquoted;
+    } else if (key == "cat") {
+      event.cat_ = unquoted;
+    } else if (key == "pid") {
+      ParseTraceInteger(value, event.pid_);
+      event.pid_pos_ = i;
+      event.pid_len_ = value.size();
+    } else if (key == "tid") {
+      ParseTraceInteger(value, event.tid_);
+    } else if (key == "ts") {
+      event.has_ts_ = ParseTraceTimeToNs(unquoted, event.ts_);
+      event.ts_pos_ = i;
+      event.ts_len_ = value.size();
+    } else if (key == "dur") {
+      ParseTraceTimeToNs(unquoted, event.dur_);
+    }
+
+    i = skip_ws(value_end);
+    if (i < text.size() && text[i] == ',') {
+      i = skip_ws(i + 1);
+    }
+  }
+  return true;
+}
+
+class TraceScanner {
+ public:
+  explicit TraceScanner(const std::string& path, size_t chunk_size = kTraceScannerChunkSize)
+    : chunk_(chunk_size) {
+    file_.open(path, std::ios::in | std::ios::binary);
+    if (file_.is_open()) {
+      file_.seekg(0, std::ios::end);
+      file_size_ = static_cast<uint64_t>(file_.tellg());
+      file_.seekg(0, std::ios::beg);
+    }
+  }
+
+  TraceScanner(const TraceScanner& that) = delete;
+  TraceScanner& operator=(const TraceScanner& that) = delete;
+
+  bool IsOpen() const {
+    return file_.is_open();
+  }
+
+  uint64_t GetFileSize() const {
+    return file_size_;
+  }
+
+  // Bytes consumed so far, for progress reporting
+  uint64_t GetPosition() const {
+    return chunk_offset_ + pos_;
+  }
+
+  // Returns false at the end of input. Event views stay valid until the next call.
+  // A trailing event truncated by an abnormal termination of the traced process is dropped.
+  bool Next(TraceEvent& event) {
+    while (true) {
+      if (pos_ == len_) {
+        if (!Fill()) {
+          return false;
+        }
+      }
+
+      if (in_event_) {
+        // fast path: copy the event body up to the next structural character
+        size_t start = pos_;
+        while (pos_ < len_) {
+          char c = chunk_[pos_];
+          if (in_string_) {
+            if (escape_) {
+              escape_ = false;
+            } else if (c == '\\') {
+              escape_ = true;
+            } else if (c == '\"') {
+              in_string_ = false;
+            }
+          } else if (c == '\"') {
+            in_string_ = true;
+          } else if (c == '{' || c == '[') {
+            event_depth_++;
+          } else if (c == '}' || c == ']') {
+            event_depth_--;
+            if (event_depth_ == 0) {
+              pos_++;
+              object_.append(&chunk_[start], pos_ - start);
+              in_event_ = false;
+              event = TraceEvent();
+              event.offset_ = object_offset_;
+              event.text_ = std::string_view(object_.data(), object_.size());
+              if (ParseTraceEventFields(event)) {
+                return true;
+              }
+              break;
+            }
+          }
+          pos_++;
+        }
+        if (in_event_) {
+          object_.append(&chunk_[start], pos_ - start);
+        }
+        continue;
+      }
+
+      char c = chunk_[pos_];
+      if (in_string_) {
+        if (escape_) {
+          escape_ = false;
+        } else if (c == '\\') {
+          escape_ = true;
+        } else if (c == '\"') {
+          in_string_ = false;
+          if (containers_.size() == 1 && containers_[0] == '{') {
+            last_root_key_ = key_;
+          }
+        } else if (containers_.size() == 1 && key_.size() < 64) {
+          key_.push_back(c);
+        }
+        pos_++;
+        continue;
+      }
+
+      if (c == '\"') {
+        in_string_ = true;
+        key_.clear();
+      } else if (c == '{' || c == '[') {
+        if (c == '{' && IsEventArray()) {
+          in_event_ = true;
+          event_depth_ = 1;
+          object_.clear();
+          object_.push_back(c);
+          object_offset_ = chunk_offset_ + pos_;
+        } else {
+          containers_.push_back(c);
+        }
+      } else if (c == '}' || c == ']') {
+        if (!containers_.empty()) {
+          containers_.pop_back();
+        }
+      }
+      pos_++;
+    }
+  }
+
+ private:
+  bool IsEventArray() const {
+    if (containers_.size() == 1) {
+      return containers_[0] == '[';
+    }
+    if (containers_.size() == 2) {
+      return (containers_[0] == '{' && containers_[1] == '[' && last_root_key_ == "traceEvents");
+    }
+    return false;
+  }
+
+  bool Fill() {
+    chunk_offset_ += len_;
+    pos_ = 0;
+    len_ = 0;
+    if (!file_.is_open() || file_.eof()) {
+      return false;
+    }
+    file_.read(chunk_.data(), chunk_.size());
+    len_ = static_cast<size_t>(file_.gcount());
+    return (len_ > 0);
+  }
+
+  std::ifstream file_;
+  uint64_t file_size_ = 0;
+  std::vector<char> chunk_;
+  uint64_t chunk_offset_ = 0;
+  size_t pos_ = 0;
+  size_t len_ = 0;
+
+  std::vector<char> containers_;  // open containers outside of events
+  std::string key_;               // current string at root level
+  std::string last_root_key_;
+  bool in_string_ = false;
+  bool escape_ = false;
+
+  bool in_event_ = false;
+  int event_depth_ = 0;
+  std::string object_;
+  uint64_t object_offset_ = 0;
+};
+
+#endif // PTI_TOOLS_UNITRACE_TRACETOOLS_TRACE_SCANNER_H_
@@ -0,0 +1,267 @@
+//==============================================================
+// Copyright (C) Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+// =============================================================
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "event_stream.h"
+
+// Reference consumer of the live event stream of unitrace (--stream-events). It accepts any number
+// of traced processes and periodically prints the top host and device events by total time.
+
+static constexpr double kDefaultInterval = 1.0;   // seconds
+static constexpr uint32_t kDefaultTop = 20;
+static constexpr size_t kReceiveBufferSize = 256 * 1024;
+
+static volatile sig_atomic_t stop_ = 0;
+
+static void Usage(const char* progname) {
+  std::cout <<
+    "Usage: " << progname << " [options] <address>" << std::endl <<
+    "Receive events streamed live by unitrace --stream-events <address> and show the top events by total time" << std::endl <<
+    "<address> is unix:<path> for a Unix domain socket or tcp:<port> for a local TCP port" << std::endl <<
+    "Options:" << std::endl <<
+    "--interval <seconds>          Time between two reports, default is 1 second, 0 to report only at the end" << std::endl <<
+    "--top <count>                 Number of host and device events in each report, default is 20" << std::endl <<
+    "--exit-when-done              Exit once all connected processes are done instead of waiting for Ctrl-C" << std::endl <<
+    "--help [-h]                   Show this message" << std::endl;
+}
+
+struct EventStats {
+  uint64_t count_ = 0;
+  uint64_t total_ = 0;
+  uint64_t min_ = UINT64_MAX;
+  uint64_t max_ = 0;
+};
+
+struct Producer {
+  int fd_;
+  EventStreamDecoder decoder_;
+  uint64_t received_ = 0;
+  bool done_ = false;
+};
+
+class StreamAggregator {
+ public:
+  void Add(const EventStreamRecord& rec, const std::string& name) {
+    if (rec.ph_ != 'X') {
+      // only complete events have durations
+      return;
+    }
+    auto& stats = (rec.kind_ == EVENT_STREAM_DEVICE) ? device_stats_[name] : host_stats_[name];
+    stats.count_++;
+    stats.total_ += rec.dur_;
+    stats.min_ = std::min(stats.min_, rec.dur_);
+    stats.max_ = std::max(stats.max_, rec.dur_);
+  }
+
+  void Report(const std::vector<std::unique_ptr<Producer>>& producers, uint32_t top, bool final) const {
+    std::cout << std::endl << (final ? "=== Final summary ===" : "=== Live summary ===") << std::endl;
+    for (const auto& p : producers) {
+      std::cout << "Process " << p->decoder_.GetPid() << " (" << p->decoder_.GetProcessName() << "): " <<
+        p->received_ << " events received, " << p->decoder_.GetDroppedCount() << " events dropped" <<
+        (p->done_ ? ", done" : "") << std::endl;
+    }
+    PrintTable("Host", host_stats_, top);
+    PrintTable("Device", device_stats_, top);
+    std::cout.flush();
+  }
+
+ private:
+  static void PrintTable(const char* title, const std::map<std::string, EventStats>& stats, uint32_t top) {
+    if (stats.empty()) {
+      return;
+    }
+    std::vector<std::pair<const std::string*, const EventStats*>> sorted;
+    sorted.reserve(stats.size());
+    for (const auto& s : stats) {
+      sorted.emplace_back(&s.first, &s.second);
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const auto& lhs, const auto& rhs) {
+      return lhs.second->total_ > rhs.second->total_;
+    });
+    if (sorted.size() > top) {
+      sorted.resize(top);
+    }
+    std::cout << std::endl << std::setw(40) << std::right << title << ", " <<
+      std::setw(12) << "Calls" << ", " << std::setw(20) << "Time (ns)" << ", " <<
+      std::setw(20) << "Average (ns)" << ", " << std::setw(20) << "Min (ns)" << ", " <<
+      std::setw(20) << "Max (ns)" << std::endl;
+    for (const auto& s : sorted) {
+      std::string name = *s.first;
+      if (name.size() > 40) {
+        name = "..." + name.substr(name.size() - 37);
+      }
+      std::cout << std::setw(40) << std::right << name << ", " <<
+        std::setw(12) << s.second->count_ << ", " << std::setw(20) << s.second->total_ << ", " <<
+        std::setw(20) << s.second->total_ / s.second->count_ << ", " << std::setw(20) << s.second->min_ << ", " <<
+        std::setw(20) << s.second->max_ << std::endl;
+    }
+  }
+
+  std::map<std::string, EventStats> host_stats_;
+  std::map<std::string, EventStats> device_stats_;
+};
+
+static int Listen(const std::string& address) {
+  sockaddr_storage addr;
+  socklen_t len;
+  if (!ParseEventStreamAddress(address, addr, len)) {
+    std::cerr << "[ERROR] Invalid address " << address << std::endl;
+    return -1;
+  }
+  int fd = socket(addr.ss_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    std::cerr << "[ERROR] Failed to create socket (" << strerror(errno) << ")" << std::endl;
+    return -1;
+  }
+  if (addr.ss_family == AF_UNIX) {
+    unlink(reinterpret_cast<sockaddr_un*>(&addr)->sun_path);  // stale socket of a previous run
+  } else {
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  }
+  if (bind(fd, reinterpret_cast<sockaddr*>(&addr), len) != 0 || listen(fd, SOMAXCONN) != 0) {
+    std::cerr << "[ERROR] Failed to listen on " << address << " (" << strerror(errno) << ")" << std::endl;
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+int main(int argc, char* argv[]) {
+  std::string address;
+  double interval = kDefaultInterval;
+  uint32_t top = kDefaultTop;
+  bool exit_when_done = false;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    bool has_value = (i + 1 < argc);
+    if (arg == "-h" || arg == "--help") {
+      Usage(argv[0]);
+      return 0;
+    } else if (arg == "--interval" && has_value) {
+      interval = std::strtod(argv[++i], nullptr);
+      if (interval < 0) {
+        std::cerr << "[ERROR] Invalid report interval" << std::endl;
+        return -1;
+      }
+    } else if (arg == "--top" && has_value) {
+      top = std::strtoul(argv[++i], nullptr, 0);
+      if (top == 0) {
+        top = kDefaultTop;
+      }
+    } else if (arg == "--exit-when-done") {
+      exit_when_done = true;
+    } else if (arg[0] != '-' && address.empty()) {
+      address = arg;
+    } else {
+      std::cerr << "[ERROR] Unknown or incomplete option " << arg << std::endl;
+      Usage(argv[0]);
+      return -1;
+    }
+  }
+
+  if (address.empty()) {
+    Usage(argv[0]);
+    return -1;
+  }
+
+  int listen_fd = Listen(address);
+  if (listen_fd < 0) {
+    return -1;
+  }
+  std::cerr << "[INFO] Listening on " << address << std::endl;
+
+  struct sigaction action = {};
+  action.sa_handler = [](int) { stop_ = 1; };
+  sigaction(SIGINT, &action, nullptr);
+  sigaction(SIGTERM, &action, nullptr);
+
+  StreamAggregator aggregator;
+  std::vector<std::unique_ptr<Producer>> producers;
+  std::vector<pollfd> fds;
+  std::vector<char> buffer(kReceiveBufferSize);
+  auto next_report = std::chrono::steady_clock::now() + std::chrono::duration<double>(interval);
+
+  while (!stop_) {
+    fds.clear();
+    fds.push_back({listen_fd, POLLIN, 0});
+    for (const auto& p : producers) {
+      fds.push_back({p->done_ ? -1 : p->fd_, POLLIN, 0});
+    }
+    if (poll(fds.data(), fds.size(), 100) < 0 && errno != EINTR) {
+      std::cerr << "[ERROR] Failed to poll connections (" << strerror(errno) << ")" << std::endl;
+      break;
+    }
+
+    for (size_t i = 1; i < fds.size(); i++) {
+      if (fds[i].fd < 0 || fds[i].revents == 0) {
+        continue;
+      }
+      auto& p = producers[i - 1];
+      ssize_t size = recv(p->fd_, buffer.data(), buffer.size(), 0);
+      if (size < 0 && (errno == EINTR || errno == EAGAIN)) {
+        continue;
+      }
+      bool valid = (size > 0) && p->decoder_.Feed(buffer.data(), size,
+        [&aggregator, &p](uint32_t /* pid */, const EventStreamRecord& rec, const std::string& name) {
+          p->received_++;
+          aggregator.Add(rec, name);
+        });
+      if (!valid) {
+        if (size > 0) {
+          std::cerr << "[WARNING] Corrupted stream from process " << p->decoder_.GetPid() << std::endl;
+        }
+        close(p->fd_);
+        p->done_ = true;
+      }
+    }
+
+    if (fds[0].revents & POLLIN) {
+      int fd = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+      if (fd >= 0) {
+        auto p = std::make_unique<Producer>();
+        p->fd_ = fd;
+        producers.push_back(std::move(p));
+      }
+    }
+
+    if (interval > 0 && std::chrono::steady_clock::now() >= next_report) {
+      aggregator.Report(producers, top, false);
+      next_report = std::chrono::steady_clock::now() + std::chrono::duration<double>(interval);
+    }
+
+    if (exit_when_done && !producers.empty() &&
+        std::all_of(producers.begin(), producers.end(), [](const auto& p) { return p->done_; })) {
+      break;
+    }
+  }
+
+  aggregator.Report(producers, top, true);
+
+  for (const auto& p : producers) {
+    if (!p->done_) {
+      close(p->fd_);
+    }
+  }
+  close(listen_fd);
+  if (address.compare(0, 4, "tcp:") != 0) {
+    unlink((address.compare(0, 5, "unix:") == 0) ? address.c_str() + 5 : address.c_str());
+  }
+  return 0;
+}
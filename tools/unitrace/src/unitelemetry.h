@@ -0,0 +1,155 @@
+//==============================================================
+// Copyright (C) Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+// =============================================================
+
+#ifndef PTI_TOOLS_UNITRACE_UNITELEMETRY_H
+#define PTI_TOOLS_UNITRACE_UNITELEMETRY_H
+
+#include <stdio.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <level_zero/ze_api.h>
+#include <level_zero/zes_api.h>
+
+#include "ze_loader.h"
+
+// Sysman is called through the loader like the rest of Level Zero
+#define ZES_FUNC(X) ZE_FUNC(X)
+#include "zes_telemetry_backend.h"
+
+#include "telemetry_sampler.h"
+#include "unimemory.h"
+#include "unitimer.h"
+
+typedef void (*OnTelemetrySampleCallback)(const TelemetrySample& sample);
+
+// Samples GPU frequency, power, temperature, memory bandwidth and engine utilization on its own thread
+// while the application runs. Samples are kept in per-device rings and handed over about once a second,
+// either to the callback, e.g. to become Chrome counter events, or to a binary side stream in the sysmon
+// --watch --binary format. Sample timestamps are taken with UniTimer, so they line up with the host and
+// device events of the timeline.
+class UniTelemetry {
+  public:
+    // filename is used only if callback is nullptr
+    static UniTelemetry* Create(const std::vector<ze_device_handle_t>& device_list, uint32_t interval_ms,
+                                OnTelemetrySampleCallback callback, const std::string& filename) {
+      if (device_list.empty() || interval_ms == 0) {
+        return nullptr;
+      }
+
+      FILE* file = nullptr;
+      if (callback == nullptr) {
+        file = fopen(filename.c_str(), "wb");
+        if (file == nullptr) {
+          std::cerr << "[ERROR] Unable to create telemetry file " << filename << std::endl;
+          return nullptr;
+        }
+      }
+
+      std::vector<zes_device_handle_t> sysman_device_list;
+      for (auto device : device_list) {
+        // device handles are Sysman handles as ZES_ENABLE_SYSMAN is set
+        sysman_device_list.push_back(reinterpret_cast<zes_device_handle_t>(device));
+      }
+
+      UniTelemetry* telemetry = new UniTelemetry(sysman_device_list, interval_ms, callback, file, filename);
+      UniMemory::ExitIfOutOfMemory((void *)telemetry);
+      return telemetry;
+    }
+
+    UniTelemetry(const UniTelemetry& that) = delete;
+    UniTelemetry& operator=(const UniTelemetry& that) = delete;
+
+    ~UniTelemetry() {
+      Stop();
+      if (file_ != nullptr) {
+        writer_.reset();
+        fclose(file_);
+        std::cerr << "[INFO] Telemetry is stored in " << filename_ << std::endl;
+      }
+    }
+
+    // Stops sampling and hands over the samples taken so far, must be called before the timeline is closed
+    void Stop() {
+      if (!thread_.joinable()) {
+        return;
+      }
+      {
+        std::lock_guard<std::mutex> lock(lock_);
+        stop_ = true;
+      }
+      cv_.notify_one();
+      thread_.join();
+      Drain();
+    }
+
+  private:
+    UniTelemetry(const std::vector<zes_device_handle_t>& device_list, uint32_t interval_ms,
+                 OnTelemetrySampleCallback callback, FILE* file, const std::string& filename)
+        : backend_(device_list), interval_(interval_ms), callback_(callback), file_(file), filename_(filename) {
+      // hand over about once a second, rings hold two batches in case the drain is late
+      batch_ = (interval_ms < 1000) ? (1000 / interval_ms) : 1;
+      sampler_ = std::make_unique<TelemetrySampler>(&backend_, 2 * batch_);
+      if (file_ != nullptr) {
+        writer_ = std::make_unique<TelemetryWriter>(file_, TELEMETRY_FORMAT_BINARY);
+      }
+      thread_ = std::thread([this]() { Run(); });
+    }
+
+    void Run() {
+      uint32_t count = 0;
+      auto next = std::chrono::steady_clock::now();
+      std::unique_lock<std::mutex> lock(lock_);
+      while (!stop_) {
+        lock.unlock();
+        sampler_->Sample(UniTimer::GetEpochTime(UniTimer::GetHostTimestamp()));
+        if (++count == batch_) {
+          Drain();
+          count = 0;
+        }
+        lock.lock();
+
+        next += interval_;
+        auto now = std::chrono::steady_clock::now();
+        if (next < now) {
+          next = now;  // do not try to catch up if Sysman queries took longer than the interval
+        }
+        cv_.wait_until(lock, next, [this]() { return stop_; });
+      }
+    }
+
+    // Called on the sampling thread, or after it is joined
+    void Drain() {
+      if (callback_ != nullptr) {
+        sampler_->TakePending(callback_);
+      } else {
+        sampler_->TakePending([this](const TelemetrySample& sample) { writer_->Write(sample); });
+        writer_->Flush();
+      }
+    }
+
+    ZesTelemetryBackend backend_;
+    std::unique_ptr<TelemetrySampler> sampler_;
+    uint32_t batch_;
+    std::chrono::milliseconds interval_;
+    OnTelemetrySampleCallback callback_;
+    FILE* file_;
+    std::string filename_;
+    std::unique_ptr<TelemetryWriter> writer_;
+    std::mutex lock_;
+    std::condition_variable cv_;
+    bool stop_ = false;
+    std::thread thread_;
+};
+
+#endif // PTI_TOOLS_UNITRACE_UNITELEMETRY_H
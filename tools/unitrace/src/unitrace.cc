@@ -44,6 +44,11 @@
 #include "logger_factory.h"
 #include "unitimer.h"
 #include "utils_host.h"
+#include "compressed_sink.h"
+#ifndef _WIN32
+#include "event_stream.h"
+#include "shm_transport.h"
+#endif /* _WIN32 */
 
 #if !defined(UNITRACE_INSTALL_LIBDIR)
 #define UNITRACE_INSTALL_LIBDIR "lib"
@@ -58,7 +63,9 @@ void Usage(char * progname) {
   std::cout << "BUILD_WITH_OPENCL=" << BUILD_WITH_OPENCL << ", ";
   std::cout << "BUILD_WITH_ITT=" << BUILD_WITH_ITT << ", ";
   std::cout << "BUILD_WITH_XPTI=" << BUILD_WITH_XPTI << ", ";
-  std::cout << "BUILD_WITH_MPI=" << BUILD_WITH_MPI;
+  std::cout << "BUILD_WITH_MPI=" << BUILD_WITH_MPI << ", ";
+  std::cout << "BUILD_WITH_ZLIB=" << BUILD_WITH_ZLIB << ", ";
+  std::cout << "BUILD_WITH_ZSTD=" << BUILD_WITH_ZSTD;
   std::cout << ")" << std::endl;
   std::cout <<
     "Usage: " << progname << " [options] <application> <args>" <<
@@ -157,6 +164,21 @@ void Usage(char * progname) {
     "--demangle                       " <<
     "Demangle kernel names. For OpenCL backend only. Kernel names are always demangled for Level Zero backend" <<
     std::endl;
+  std::cout <<
+    "--kernel-name-max-length <length> " <<
+    "Shorten kernel names longer than <length> characters in summary tables" << std::endl <<
+    "                                 Template arguments and parameter lists are collapsed first, then names are truncated" <<
+    std::endl;
+  std::cout <<
+    "--kernel-sampling-rate <rate>    " <<
+    "Trace only every <rate>th launch of each kernel. For Level Zero backend only" << std::endl <<
+    "                                 Launches are still counted exactly, summary tables show estimated statistics and their error bounds" <<
+    std::endl;
+  std::cout <<
+    "--kernel-sampling-reservoir      " <<
+    "Trace the first <rate> launches of each kernel, then launch n with probability <rate>/n" << std::endl <<
+    "                                 Use with --kernel-sampling-rate" <<
+    std::endl;
   std::cout <<
     "--separate-tiles                 " <<
     "Trace each tile separately in case of implicit scaling" <<
@@ -190,6 +212,14 @@ void Usage(char * progname) {
     "--result-dir <path>              " <<
     "Output result to a hierarchical directory" <<
     std::endl;
+  std::cout <<
+    "--compress-output                " <<
+    "Compress trace output files (.gz if built with BUILD_WITH_ZLIB=1 or .zst if built with BUILD_WITH_ZSTD=1)" <<
+    std::endl;
+  std::cout <<
+    "--rotate-output-size <MB>        " <<
+    "Continue trace output in a new file once the current file reaches <MB> megabytes" <<
+    std::endl;
   std::cout <<
     "--metric-query [-q]              " <<
     "Query hardware metrics for each kernel instance (Level Zero)" <<
@@ -206,6 +236,11 @@ void Usage(char * progname) {
     "--sampling-interval [-i] <interval> " <<
     "Hardware performance metric sampling interval in us (default is 50 us) in time-based mode" <<
     std::endl;
+  std::cout <<
+    "--telemetry-interval <interval>  " <<
+    "Sample GPU frequency, power, temperature, memory bandwidth and engine utilization every <interval> ms" << std::endl <<
+    "                                 Samples are added to the timeline as counters if Chrome logging is enabled, or stored in telemetry.<pid>.bin otherwise" <<
+    std::endl;
   std::cout <<
     "--device-list                    " <<
     "Print available devices" <<
@@ -258,6 +293,21 @@ void Usage(char * progname) {
     "--chrome-kmd-logging <script>    " <<
     "Trace OS/KMD activities. The argument <script> file defines the OS kernel or device driver activities to trace" <<
     std::endl;
+  std::cout <<
+    "--shm-transport                  " <<
+    "Send trace output of the application processes to unitrace through shared memory" << std::endl <<
+    "                                 Output files are written by unitrace instead of the application processes" <<
+    std::endl;
+  std::cout <<
+    "--stream-events <address>        " <<
+    "Stream host and device events live to a consumer such as unitrace_stream listening on <address>" << std::endl <<
+    "                                 <address> is unix:<path> for a Unix domain socket or tcp:<port> for a local TCP port" << std::endl <<
+    "                                 Kernel logging (--chrome-kernel-logging) is enabled if no Chrome logging option is present" <<
+    std::endl;
+  std::cout <<
+    "--stream-drop-policy <policy>    " <<
+    "What to do if the consumer falls behind: block (default), drop-newest or drop-oldest" <<
+    std::endl;
 #endif /* _WIN32 */
   std::cout <<
     "--include-kernels <kernel-names> " <<
@@ -400,6 +450,25 @@ int ParseArgs(int argc, char* argv[]) {
     } else if (strcmp(argv[i], "--demangle") == 0) {
       utils::SetEnv("UNITRACE_Demangle", "1");
       ++app_index;
+    } else if (strcmp(argv[i], "--kernel-name-max-length") == 0) {
+      ++i;
+      if ((i >= argc) || (atoi(argv[i]) <= 0)) {
+        std::cout << "[ERROR] Kernel name length is not specified or invalid" << std::endl;
+        return -1;
+      }
+      utils::SetEnv("UNITRACE_KernelNameMaxLength", argv[i]);
+      app_index += 2;
+    } else if (strcmp(argv[i], "--kernel-sampling-rate") == 0) {
+      ++i;
+      if ((i >= argc) || (atoi(argv[i]) <= 0)) {
+        std::cout << "[ERROR] Kernel sampling rate is not specified or invalid" << std::endl;
+        return -1;
+      }
+      utils::SetEnv("UNITRACE_KernelSamplingRate", argv[i]);
+      app_index += 2;
+    } else if (strcmp(argv[i], "--kernel-sampling-reservoir") == 0) {
+      utils::SetEnv("UNITRACE_KernelSamplingReservoir", "1");
+      ++app_index;
     } else if (strcmp(argv[i], "--separate-tiles") == 0) {
       utils::SetEnv("UNITRACE_KernelOnSeparateTiles", "1");
       ++app_index;
@@ -434,6 +503,22 @@ int ParseArgs(int argc, char* argv[]) {
       utils::SetEnv("UNITRACE_UseResultDirectory", "1");
       utils::SetEnv("UNITRACE_ResultDirectory", argv[i]);
       app_index += 2;
+    } else if (strcmp(argv[i], "--compress-output") == 0) {
+#if UNITRACE_COMPRESSION_ENABLED
+      utils::SetEnv("UNITRACE_CompressOutput", "1");
+      ++app_index;
+#else /* UNITRACE_COMPRESSION_ENABLED */
+      std::cout << "[ERROR] Option --compress-output requires unitrace built with BUILD_WITH_ZLIB=1 or BUILD_WITH_ZSTD=1" << std::endl;
+      return -1;
+#endif /* UNITRACE_COMPRESSION_ENABLED */
+    } else if (strcmp(argv[i], "--rotate-output-size") == 0) {
+      ++i;
+      if ((i >= argc) || !IsNumericString(argv[i]) || (std::stoull(argv[i]) == 0)) {
+        std::cout << "[ERROR] Option --rotate-output-size takes a positive number of megabytes" << std::endl;
+        return -1;
+      }
+      utils::SetEnv("UNITRACE_RotateOutputSize", std::to_string(std::stoull(argv[i]) * 1024 * 1024).c_str());
+      app_index += 2;
     } else if (strcmp(argv[i], "--metric-query") == 0 || strcmp(argv[i], "-q") == 0) {
       utils::SetEnv("UNITRACE_MetricQuery", "1");
       ++app_index;
@@ -542,6 +627,14 @@ int ParseArgs(int argc, char* argv[]) {
       }
       utils::SetEnv("UNITRACE_SamplingInterval", argv[i]);
       app_index += 2;
+    } else if (strcmp(argv[i], "--telemetry-interval") == 0) {
+      ++i;
+      if ((i >= argc) || !IsNumericString(argv[i]) || (atoi(argv[i]) <= 0)) {
+        std::cout << "[ERROR] Option --telemetry-interval takes a positive number of milliseconds" << std::endl;
+        return -1;
+      }
+      utils::SetEnv("UNITRACE_TelemetryInterval", argv[i]);
+      app_index += 2;
     } else if (strcmp(argv[i], "--device-list") == 0) {
       SetSysmanEnvironment();    // enable ZES_ENABLE_SYSMAN
       PrintDeviceList();
@@ -620,6 +713,28 @@ int ParseArgs(int argc, char* argv[]) {
       }
       utils::SetEnv("UNITRACE_ChromeKmdLogging", argv[i]);
       app_index += 2;
+    } else if (strcmp(argv[i], "--shm-transport") == 0) {
+      utils::SetEnv("UNITRACE_ShmTransport", "1");
+      app_index++;
+    } else if (strcmp(argv[i], "--stream-events") == 0) {
+      ++i;
+      sockaddr_storage addr;
+      socklen_t len;
+      if ((i >= argc) || !ParseEventStreamAddress(argv[i], addr, len)) {
+        std::cout << "[ERROR] Option --stream-events takes unix:<path> or tcp:<port>" << std::endl;
+        return -1;
+      }
+      utils::SetEnv("UNITRACE_EventStream", argv[i]);
+      app_index += 2;
+    } else if (strcmp(argv[i], "--stream-drop-policy") == 0) {
+      ++i;
+      EventStreamDropPolicy policy;
+      if ((i >= argc) || !ParseEventStreamDropPolicy(argv[i], policy)) {
+        std::cout << "[ERROR] Option --stream-drop-policy takes block, drop-newest or drop-oldest" << std::endl;
+        return -1;
+      }
+      utils::SetEnv("UNITRACE_EventStreamDropPolicy", argv[i]);
+      app_index += 2;
   #endif /* _WIN32 */
     } else if (strcmp(argv[i], "--version") == 0) {
       std::cout << UNITRACE_VERSION << " (" << COMMIT_HASH << ")" << std::endl;
@@ -769,6 +884,20 @@ int ParseArgs(int argc, char* argv[]) {
     }
   }
 
+  if (!utils::GetEnv("UNITRACE_EventStreamDropPolicy").empty() && utils::GetEnv("UNITRACE_EventStream").empty()) {
+    std::cerr << "[ERROR] Option --stream-drop-policy requires --stream-events" << std::endl;
+    return 1;
+  }
+
+  if (!utils::GetEnv("UNITRACE_EventStream").empty() &&
+      utils::GetEnv("UNITRACE_ChromeCallLogging").empty() && utils::GetEnv("UNITRACE_ChromeKernelLogging").empty() &&
+      utils::GetEnv("UNITRACE_ChromeDeviceLogging").empty() && utils::GetEnv("UNITRACE_ChromeSyclLogging").empty() &&
+      utils::GetEnv("UNITRACE_ChromeIttLogging").empty()) {
+    // events are streamed from the Chrome logging buffers
+    std::cerr << "[INFO] Option --stream-events enables --chrome-kernel-logging" << std::endl;
+    utils::SetEnv("UNITRACE_ChromeKernelLogging", "1");
+  }
+
   std::string include_kernels_file = utils::GetEnv("UNITRACE_IncludeKernelsFile");
   if (!include_kernels_file.empty()) {
       if (!CXX_STD_FILESYSTEM_NAMESPACE::exists(CXX_STD_FILESYSTEM_NAMESPACE::path(include_kernels_file))) {
@@ -851,8 +980,18 @@ static void TerminateProcess(pid_t pid) {
 #endif /* _WIN32 */
 
 static char *data_dir = nullptr;
+#ifndef _WIN32
+static ShmTransportDrainer *shm_drainer = nullptr;
+#endif /* _WIN32 */
 
 void TearDown() {
+#ifndef _WIN32
+  if (shm_drainer != nullptr) {
+    // write out whatever the application processes left in the rings
+    delete shm_drainer;
+    shm_drainer = nullptr;
+  }
+#endif /* _WIN32 */
   if (data_dir == nullptr) {
     return;
   }
@@ -1204,7 +1343,8 @@ int main(int argc, char *argv[]) {
   utils::SetEnv("LD_PRELOAD", preload.c_str());
 
 
-  if (utils::GetEnv("UNITRACE_KernelMetrics") == "1" || !utils::GetEnv("UNITRACE_ChromeKmdLogging").empty()) {
+  if (utils::GetEnv("UNITRACE_KernelMetrics") == "1" || !utils::GetEnv("UNITRACE_ChromeKmdLogging").empty() ||
+      utils::GetEnv("UNITRACE_ShmTransport") == "1") {
 
     char pattern[] = "/tmp/tmpdir.XXXXXX";
 
@@ -1226,6 +1366,15 @@ int main(int argc, char *argv[]) {
 
     utils::SetEnv("UNITRACE_DataDir", data_dir);
 
+    if (utils::GetEnv("UNITRACE_ShmTransport") == "1") {
+      shm_drainer = ShmTransportDrainer::Create(utils::GetPid());
+      if (shm_drainer == nullptr) {
+        std::cerr << "[WARNING] Failed to create shared memory transport, application processes write their own output files" << std::endl;
+      } else {
+        shm_drainer->SetRotateSize(std::strtoull(utils::GetEnv("UNITRACE_RotateOutputSize").c_str(), nullptr, 10));
+      }
+    }
+
     int child;
 
     child = fork();
@@ -1250,6 +1399,10 @@ int main(int argc, char *argv[]) {
 
       // ready to go
       utils::SetEnv("UNITRACE_DataDir", data_dir);
+      if (shm_drainer != nullptr) {
+        // only the application processes send output through the transport
+        utils::SetEnv("UNITRACE_ShmTransportRegistry", shm_drainer->GetRegistryName().c_str());
+      }
 
       int ret = 0;
 
@@ -1279,6 +1432,9 @@ int main(int argc, char *argv[]) {
       if (!utils::GetEnv("UNITRACE_ChromeKmdLogging").empty()) {
         bpftrace_pid = child;
       }
+      if (shm_drainer != nullptr) {
+        shm_drainer->Start();
+      }
       if (utils::GetEnv("UNITRACE_KernelMetrics") == "1") {
         
         metric_profiler = EnableProfiling(child, data_dir, logfile, idle_sampling);
@@ -0,0 +1,466 @@
+//==============================================================
+// Copyright (C) Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+// =============================================================
+
+#ifndef PTI_TOOLS_UNITRACE_UTILS_COMPRESSED_SINK_H_
+#define PTI_TOOLS_UNITRACE_UTILS_COMPRESSED_SINK_H_
+
+// Compressed and size-rotated log output.
+//
+// Output is cut into blocks that are compressed independently on a background thread:
+//   - zlib: every block is a complete gzip member, so the file is a valid multi-member gzip file.
+//     The member header carries an extra field "UT" with the member size and the uncompressed
+//     block size (like BGZF), so readers can hop from block to block without inflating.
+//   - zstd: every block is a complete zstd frame, preceded by a skippable frame with the
+//     same two sizes. Standard zstd tools skip the skippable frames.
+// Both formats can be concatenated, so rotated files concatenated in order form the whole output.
+// Uncompressed output is rotated between Log calls, so every rotated file holds whole records.
+
+#if !defined(BUILD_WITH_ZSTD)
+#define BUILD_WITH_ZSTD 0
+#endif /* BUILD_WITH_ZSTD */
+
+#if !defined(BUILD_WITH_ZLIB)
+#define BUILD_WITH_ZLIB 0
+#endif /* BUILD_WITH_ZLIB */
+
+#define UNITRACE_COMPRESSION_ENABLED (BUILD_WITH_ZSTD || BUILD_WITH_ZLIB)
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "logger.h"
+
+// Name of the <index>-th file of a rotated output: <name>.<ext> for the first file and
+// <name>.<index>.<ext> for the others, where <ext> is the last extension before the
+// compression extension comp_ext, if the name has it (e.g. app.1234.json.gz,
+// app.1234.1.json.gz, app.1234.2.json.gz, ... or app.1234.json, app.1234.1.json, ...)
+inline std::string GetRotatedFileName(const std::string& filename, uint32_t index, const std::string& comp_ext = "") {
+  if (index == 0) {
+    return filename;
+  }
+  std::string ext = comp_ext;
+  std::string base = filename;
+  if (!ext.empty() && base.size() > ext.size() && base.compare(base.size() - ext.size(), ext.size(), ext) == 0) {
+    base.resize(base.size() - ext.size());
+  } else {
+    ext.clear();
+  }
+  size_t dot = base.find_last_of('.');
+  size_t slash = base.find_last_of('/');
+  if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+    return base + "." + std::to_string(index) + ext;
+  }
+  return base.substr(0, dot) + "." + std::to_string(index) + base.substr(dot) + ext;
+}
+
+// Logger destination that writes uncompressed output and continues in a new file once the
+// current file would exceed rotate_size bytes. Files are switched between writes, so a record
+// logged with one Log call is never split.
+class RotatingFileSink : public LogSink {
+ public:
+  RotatingFileSink(const std::string& filename, uint64_t rotate_size)
+    : filename_(filename), rotate_size_(rotate_size) {
+    Open(filename_);
+  }
+
+  RotatingFileSink(const RotatingFileSink& that) = delete;
+  RotatingFileSink& operator=(const RotatingFileSink& that) = delete;
+
+  bool IsOpen() const {
+    return file_.is_open();
+  }
+
+  void Write(const std::string& text) override {
+    if (!file_.is_open()) {
+      return;
+    }
+    if (rotate_size_ > 0 && file_size_ > 0 && file_size_ + text.size() > rotate_size_) {
+      file_.close();
+      file_index_++;
+      file_size_ = 0;
+      if (!Open(GetRotatedFileName(filename_, file_index_))) {
+        return;
+      }
+    }
+    file_ << text;
+    file_size_ += text.size();
+  }
+
+  void Flush() override {
+    if (file_.is_open()) {
+      file_.flush();
+    }
+  }
+
+  void Close(bool empty) override {
+    if (file_.is_open()) {
+      file_.close();
+    }
+    if (empty) {
+      for (uint32_t i = 0; i <= file_index_; i++) {
+        std::remove(GetRotatedFileName(filename_, i).c_str());
+      }
+    }
+  }
+
+ private:
+  bool Open(const std::string& name) {
+    file_.open(name, std::ios::out | std::ios::trunc);
+    if (!file_.is_open()) {
+      std::cerr << "[ERROR] Failed to open file " << name << " for writing. Do you have the right permission?" << std::endl;
+      return false;
+    }
+    return true;
+  }
+
+  std::string filename_;
+  uint64_t rotate_size_;
+  std::ofstream file_;
+  uint64_t file_size_ = 0;
+  uint32_t file_index_ = 0;
+};
+
+#if UNITRACE_COMPRESSION_ENABLED
+
+#if BUILD_WITH_ZSTD
+#include <zstd.h>
+#else /* BUILD_WITH_ZSTD */
+#include <zlib.h>
+#endif /* BUILD_WITH_ZSTD */
+
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+constexpr size_t kCompressedBlockSize = 1024 * 1024;
+// blocks waiting for compression before writers are throttled
+constexpr size_t kCompressedBlockQueueDepth = 8;
+
+struct CompressedBlockInfo {
+  uint64_t offset_;             // offset of the block in the file
+  uint32_t size_;               // compressed size including framing
+  uint32_t raw_size_;           // uncompressed size
+};
+
+inline void PutLE32(std::string& out, uint32_t value) {
+  for (int i = 0; i < 4; i++) {
+    out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+  }
+}
+
+inline uint32_t GetLE32(const unsigned char* in) {
+  return uint32_t(in[0]) | (uint32_t(in[1]) << 8) | (uint32_t(in[2]) << 16) | (uint32_t(in[3]) << 24);
+}
+
+#if BUILD_WITH_ZSTD
+
+constexpr uint32_t kZstdBlockInfoMagic = 0x184D2A5B;   // one of the zstd skippable frame magics
+constexpr uint32_t kZstdBlockInfoSize = 16;
+
+inline const char* GetCompressedFileExtension() {
+  return ".zst";
+}
+
+// Compresses data into one self-contained block
+inline bool CompressBlock(const std::string& data, std::string& out) {
+  size_t bound = ZSTD_compressBound(data.size());
+  out.clear();
+  PutLE32(out, kZstdBlockInfoMagic);
+  PutLE32(out, 8);
+  PutLE32(out, 0);    // block size, filled in below
+  PutLE32(out, static_cast<uint32_t>(data.size()));
+  out.resize(kZstdBlockInfoSize + bound);
+  size_t size = ZSTD_compress(&out[kZstdBlockInfoSize], bound, data.data(), data.size(), 3);
+  if (ZSTD_isError(size)) {
+    std::cerr << "[ERROR] Failed to compress output (" << ZSTD_getErrorName(size) << ")" << std::endl;
+    return false;
+  }
+  out.resize(kZstdBlockInfoSize + size);
+  uint32_t total = static_cast<uint32_t>(out.size());
+  for (int i = 0; i < 4; i++) {
+    out[8 + i] = static_cast<char>((total >> (8 * i)) & 0xFF);
+  }
+  return true;
+}
+
+// Reads the framing of the block at the current position of the file
+inline bool ReadCompressedBlockInfo(std::ifstream& in, CompressedBlockInfo& info) {
+  unsigned char header[kZstdBlockInfoSize];
+  info.offset_ = static_cast<uint64_t>(in.tellg());
+  if (!in.read(reinterpret_cast<char*>(header), sizeof(header)) || GetLE32(header) != kZstdBlockInfoMagic) {
+    return false;
+  }
+  info.size_ = GetLE32(header + 8);
+  info.raw_size_ = GetLE32(header + 12);
+  return true;
+}
+
+inline bool DecompressBlock(const std::string& block, std::string& out) {
+  if (block.size() < kZstdBlockInfoSize) {
+    return false;
+  }
+  out.resize(GetLE32(reinterpret_cast<const unsigned char*>(block.data()) + 12));
+  size_t size = ZSTD_decompress(&out[0], out.size(), block.data() + kZstdBlockInfoSize, block.size() - kZstdBlockInfoSize);
+  return !ZSTD_isError(size) && (size == out.size());
+}
+
+#else /* BUILD_WITH_ZSTD */
+
+// gzip member header: ID1 ID2 CM FLG(FEXTRA) MTIME(4) XFL OS XLEN(2), then subfield "UT" of 8 bytes
+constexpr uint32_t kGzipBlockHeaderSize = 12 + 4 + 8;
+constexpr uint32_t kGzipBlockTrailerSize = 8;
+
+inline const char* GetCompressedFileExtension() {
+  return ".gz";
+}
+
+inline bool CompressBlock(const std::string& data, std::string& out) {
+  z_stream zs;
+  memset(&zs, 0, sizeof(zs));
+  // raw deflate, the gzip framing is written here to carry the block sizes
+  if (deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+    std::cerr << "[ERROR] Failed to initialize output compression" << std::endl;
+    return false;
+  }
+  uLong bound = deflateBound(&zs, static_cast<uLong>(data.size()));
+  out.clear();
+  const unsigned char header[] = {0x1f, 0x8b, 8, 4, 0, 0, 0, 0, 0, 0xff, 12, 0, 'U', 'T', 8, 0};
+  out.append(reinterpret_cast<const char*>(header), sizeof(header));
+  PutLE32(out, 0);    // block size, filled in below
+  PutLE32(out, static_cast<uint32_t>(data.size()));
+  out.resize(kGzipBlockHeaderSize + bound);
+
+  zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+  zs.avail_in = static_cast<uInt>(data.size());
+  zs.next_out = reinterpret_cast<Bytef*>(&out[kGzipBlockHeaderSize]);
+  zs.avail_out = static_cast<uInt>(bound);
+  int status = deflate(&zs, Z_FINISH);
+  size_t size = zs.total_out;
+  deflateEnd(&zs);
+  if (status != Z_STREAM_END) {
+    std::cerr << "[ERROR] Failed to compress output" << std::endl;
+    return false;
+  }
+  out.resize(kGzipBlockHeaderSize + size);
+  PutLE32(out, static_cast<uint32_t>(crc32(0, reinterpret_cast<const Bytef*>(data.data()), static_cast<uInt>(data.size()))));
+  PutLE32(out, static_cast<uint32_t>(data.size()));
+
+  uint32_t total = static_cast<uint32_t>(out.size());
+  for (int i = 0; i < 4; i++) {
+    out[16 + i] = static_cast<char>((total >> (8 * i)) & 0xFF);
+  }
+  return true;
+}
+
+inline bool ReadCompressedBlockInfo(std::ifstream& in, CompressedBlockInfo& info) {
+  unsigned char header[kGzipBlockHeaderSize];
+  info.offset_ = static_cast<uint64_t>(in.tellg());
+  if (!in.read(reinterpret_cast<char*>(header), sizeof(header)) ||
+      header[0] != 0x1f || header[1] != 0x8b || header[12] != 'U' || header[13] != 'T') {
+    return false;
+  }
+  info.size_ = GetLE32(header + 16);
+  info.raw_size_ = GetLE32(header + 20);
+  return true;
+}
+
+inline bool DecompressBlock(const std::string& block, std::string& out) {
+  if (block.size() < kGzipBlockHeaderSize + kGzipBlockTrailerSize) {
+    return false;
+  }
+  out.resize(GetLE32(reinterpret_cast<const unsigned char*>(block.data()) + 20));
+  z_stream zs;
+  memset(&zs, 0, sizeof(zs));
+  if (inflateInit2(&zs, -15) != Z_OK) {
+    return false;
+  }
+  zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(block.data()) + kGzipBlockHeaderSize);
+  zs.avail_in = static_cast<uInt>(block.size() - kGzipBlockHeaderSize - kGzipBlockTrailerSize);
+  zs.next_out = reinterpret_cast<Bytef*>(&out[0]);
+  zs.avail_out = static_cast<uInt>(out.size());
+  int status = inflate(&zs, Z_FINISH);
+  bool ok = (status == Z_STREAM_END) && (zs.total_out == out.size());
+  inflateEnd(&zs);
+  return ok;
+}
+
+#endif /* BUILD_WITH_ZSTD */
+
+// Lists the blocks of a compressed file, the blocks can then be read and decompressed individually
+inline bool ReadCompressedBlockIndex(const std::string& filename, std::vector<CompressedBlockInfo>& blocks) {
+  std::ifstream in(filename, std::ios::in | std::ios::binary);
+  if (!in.is_open()) {
+    return false;
+  }
+  in.seekg(0, std::ios::end);
+  uint64_t size = static_cast<uint64_t>(in.tellg());
+  in.seekg(0, std::ios::beg);
+  blocks.clear();
+  CompressedBlockInfo info;
+  while (static_cast<uint64_t>(in.tellg()) < size) {
+    if (!ReadCompressedBlockInfo(in, info) || info.offset_ + info.size_ > size) {
+      return false;
+    }
+    blocks.push_back(info);
+    in.seekg(info.offset_ + info.size_, std::ios::beg);
+  }
+  return true;
+}
+
+// Logger destination that compresses on a background thread and optionally rotates the output
+// file once it reaches rotate_size bytes (compressed) at a block boundary. Every write may start
+// a new block, so the sink is meant for lazily flushed Loggers: a block is submitted once it is
+// full, once its oldest data is kFlushInterval old or on Flush.
+class CompressedFileSink : public LogSink {
+ public:
+  CompressedFileSink(const std::string& filename, uint64_t rotate_size = 0, size_t block_size = kCompressedBlockSize)
+    : filename_(filename), rotate_size_(rotate_size), block_size_(block_size) {
+    file_.open(filename_, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file_.is_open()) {
+      std::cerr << "[ERROR] Failed to open file " << filename_ << " for writing. Do you have the right permission?" << std::endl;
+    }
+    current_.reserve(block_size_);
+    thread_ = std::thread([this]() { Run(); });
+  }
+
+  CompressedFileSink(const CompressedFileSink& that) = delete;
+  CompressedFileSink& operator=(const CompressedFileSink& that) = delete;
+
+  ~CompressedFileSink() {
+    Stop();
+  }
+
+  bool IsOpen() const {
+    return file_.is_open();
+  }
+
+  void Write(const std::string& text) override {
+    std::unique_lock<std::mutex> lock(lock_);
+    auto now = std::chrono::steady_clock::now();
+    if (current_.empty()) {
+      pending_since_ = now;
+    }
+    current_.append(text);
+    if (current_.size() >= block_size_ || now - pending_since_ >= kFlushInterval) {
+      Submit(lock);
+    }
+  }
+
+  // Hands whatever is pending over for compression
+  void Flush() override {
+    std::unique_lock<std::mutex> lock(lock_);
+    if (!current_.empty()) {
+      Submit(lock);
+    }
+  }
+
+  void Close(bool empty) override {
+    Stop();
+    if (empty) {
+      for (uint32_t i = 0; i <= file_index_; i++) {
+        std::remove(GetRotatedFileName(filename_, i, GetCompressedFileExtension()).c_str());
+      }
+    }
+  }
+
+ private:
+  static constexpr std::chrono::seconds kFlushInterval{1};
+
+  // Called with lock_ held
+  void Submit(std::unique_lock<std::mutex>& lock) {
+    space_.wait(lock, [this]() { return queue_.size() < kCompressedBlockQueueDepth; });
+    queue_.emplace_back(std::move(current_));
+    current_ = std::string();
+    current_.reserve(block_size_);
+    ready_.notify_one();
+  }
+
+  void Stop() {
+    {
+      std::unique_lock<std::mutex> lock(lock_);
+      if (stopped_) {
+        return;
+      }
+      if (!current_.empty()) {
+        Submit(lock);
+      }
+      stopped_ = true;
+      ready_.notify_one();
+    }
+    thread_.join();
+    if (file_.is_open()) {
+      file_.close();
+    }
+  }
+
+  void Run() {
+    std::string compressed;
+    while (true) {
+      std::string block;
+      {
+        std::unique_lock<std::mutex> lock(lock_);
+        ready_.wait(lock, [this]() { return stopped_ || !queue_.empty(); });
+        if (queue_.empty()) {
+          break;
+        }
+        block = std::move(queue_.front());
+        queue_.pop_front();
+        space_.notify_all();
+      }
+      if (!file_.is_open() || !CompressBlock(block, compressed)) {
+        continue;
+      }
+      if (rotate_size_ > 0 && file_size_ > 0 && file_size_ + compressed.size() > rotate_size_) {
+        Rotate();
+      }
+      file_.write(compressed.data(), compressed.size());
+      file_.flush();
+      file_size_ += compressed.size();
+    }
+  }
+
+  void Rotate() {
+    file_.close();
+    file_index_++;
+    file_size_ = 0;
+    std::string name = GetRotatedFileName(filename_, file_index_, GetCompressedFileExtension());
+    file_.open(name, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file_.is_open()) {
+      std::cerr << "[ERROR] Failed to open file " << name << " for writing. Do you have the right permission?" << std::endl;
+    }
+  }
+
+  std::string filename_;
+  uint64_t rotate_size_;
+  size_t block_size_;
+
+  std::mutex lock_;
+  std::condition_variable ready_;     // a block is queued or the sink is stopped
+  std::condition_variable space_;     // the queue has room
+  std::deque<std::string> queue_;
+  std::string current_;
+  std::chrono::steady_clock::time_point pending_since_;  // when the oldest data of current_ was written
+  bool stopped_ = false;
+
+  // owned by the background thread until it is joined
+  std::ofstream file_;
+  uint64_t file_size_ = 0;
+  uint32_t file_index_ = 0;
+
+  std::thread thread_;
+};
+
+#endif /* UNITRACE_COMPRESSION_ENABLED */
+
+#endif // PTI_TOOLS_UNITRACE_UTILS_COMPRESSED_SINK_H_
@@ -0,0 +1,465 @@
+//==============================================================
+// Copyright (C) Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+// =============================================================
+
+#ifndef PTI_TOOLS_UNITRACE_UTILS_EVENT_STREAM_H_
+#define PTI_TOOLS_UNITRACE_UTILS_EVENT_STREAM_H_
+
+// Live streaming of trace events to a local consumer (see unitrace_stream).
+//
+// A producer connects to the consumer over a Unix domain socket ("unix:<path>" or just <path>)
+// or a local TCP port ("tcp:<port>") and sends messages, each an EventStreamHeader followed by
+// a payload:
+//   - HELLO: the process name
+//   - BATCH: names first defined in this batch (id, length, characters), then fixed-size
+//            EventStreamRecords referring to the names by id
+// Events are batched on the application threads and sent by a background thread. If the
+// consumer falls behind, the socket blocks the sender and batches queue up. Once the queue is
+// full, the drop policy decides whether the application waits or batches are dropped. Names
+// defined in dropped batches are carried over to the next batch, so every record the consumer
+// receives can be resolved.
+
+#ifndef _WIN32
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+constexpr uint32_t kEventStreamMagic = 0x53455455;    // "UTES"
+constexpr uint16_t kEventStreamVersion = 1;
+constexpr uint32_t kEventStreamBatchSize = 4096;      // events per batch
+constexpr uint32_t kEventStreamQueueDepth = 64;       // batches waiting to be sent
+constexpr uint32_t kEventStreamMaxNameSize = 64 * 1024;
+// partial batches are sent at least this often so that consumers see a live view
+constexpr std::chrono::milliseconds kEventStreamFlushInterval(100);
+// how long a terminating process waits for the consumer to take the remaining batches
+constexpr std::chrono::seconds kEventStreamLingerTimeout(5);
+
+enum EventStreamMessageType : uint16_t {
+  EVENT_STREAM_HELLO = 1,
+  EVENT_STREAM_BATCH = 2,
+};
+
+enum EventStreamEventKind : uint8_t {
+  EVENT_STREAM_HOST = 0,      // host API call or annotation
+  EVENT_STREAM_DEVICE = 1,    // kernel or command on device
+};
+
+enum EventStreamDropPolicy {
+  EVENT_STREAM_BLOCK = 0,       // application threads wait for the consumer
+  EVENT_STREAM_DROP_NEWEST,     // the batch that does not fit is dropped
+  EVENT_STREAM_DROP_OLDEST,     // the oldest queued batch is dropped
+};
+
+struct EventStreamHeader {
+  uint32_t magic_;
+  uint16_t version_;
+  uint16_t type_;
+  uint32_t pid_;
+  uint32_t size_;             // payload size in bytes
+  uint32_t name_count_;       // BATCH: names defined in the batch
+  uint32_t event_count_;      // BATCH: records following the names
+  uint64_t dropped_;          // events dropped by the producer so far
+};
+
+static_assert(sizeof(EventStreamHeader) == 32, "Unexpected EventStreamHeader layout");
+
+struct EventStreamRecord {
+  uint64_t start_;            // epoch time in ns
+  uint64_t dur_;              // ns
+  uint64_t id_;               // kernel instance id for device events
+  uint32_t name_id_;
+  uint32_t tid_;
+  uint8_t kind_;              // EventStreamEventKind
+  char ph_;                   // Chrome trace phase: 'X', 'B' or 'E'
+  int16_t tile_;              // -1 if not applicable
+  uint32_t engine_;           // (engine ordinal << 16) | engine index for device events
+};
+
+static_assert(sizeof(EventStreamRecord) == 40, "Unexpected EventStreamRecord layout");
+
+inline bool ParseEventStreamDropPolicy(const std::string& str, EventStreamDropPolicy& policy) {
+  if (str.empty() || str == "block") {
+    policy = EVENT_STREAM_BLOCK;
+  } else if (str == "drop-newest") {
+    policy = EVENT_STREAM_DROP_NEWEST;
+  } else if (str == "drop-oldest") {
+    policy = EVENT_STREAM_DROP_OLDEST;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// Returns a socket address for "unix:<path>", "<path>" or "tcp:<port>" (TCP is on the loopback interface)
+inline bool ParseEventStreamAddress(const std::string& address, sockaddr_storage& addr, socklen_t& len) {
+  memset(&addr, 0, sizeof(addr));
+  if (address.compare(0, 4, "tcp:") == 0) {
+    char* end = nullptr;
+    unsigned long port = std::strtoul(address.c_str() + 4, &end, 10);
+    if (end == address.c_str() + 4 || *end != '\0' || port == 0 || port > 65535) {
+      return false;
+    }
+    auto* in = reinterpret_cast<sockaddr_in*>(&addr);
+    in->sin_family = AF_INET;
+    in->sin_port = htons(static_cast<uint16_t>(port));
+    in->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    len = sizeof(sockaddr_in);
+    return true;
+  }
+  std::string path = (address.compare(0, 5, "unix:") == 0) ? address.substr(5) : address;
+  auto* un = reinterpret_cast<sockaddr_un*>(&addr);
+  if (path.empty() || path.size() >= sizeof(un->sun_path)) {
+    return false;
+  }
+  un->sun_family = AF_UNIX;
+  memcpy(un->sun_path, path.c_str(), path.size() + 1);
+  len = sizeof(sockaddr_un);
+  return true;
+}
+
+inline bool SendEventStreamData(int fd, const char* data, size_t size) {
+  while (size > 0) {
+    ssize_t sent = send(fd, data, size, MSG_NOSIGNAL);
+    if (sent < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    data += sent;
+    size -= sent;
+  }
+  return true;
+}
+
+// Producer side, one per process
+class EventStreamer {
+ public:
+  EventStreamer(const EventStreamer& that) = delete;
+  EventStreamer& operator=(const EventStreamer& that) = delete;
+
+  // Connects to the consumer, returns nullptr if the consumer is not reachable
+  static EventStreamer* Create(const std::string& address, EventStreamDropPolicy policy, const std::string& process_name,
+                               uint32_t batch_size = kEventStreamBatchSize, uint32_t queue_depth = kEventStreamQueueDepth) {
+    sockaddr_storage addr;
+    socklen_t len;
+    if (!ParseEventStreamAddress(address, addr, len)) {
+      std::cerr << "[ERROR] Invalid event stream address " << address << std::endl;
+      return nullptr;
+    }
+    int fd = socket(addr.ss_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&addr), len) != 0) {
+      std::cerr << "[WARNING] Failed to connect to event stream consumer at " << address << " (" << strerror(errno) << ")" << std::endl;
+      if (fd >= 0) {
+        close(fd);
+      }
+      return nullptr;
+    }
+    if (addr.ss_family == AF_INET) {
+      int one = 1;
+      setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+    return new EventStreamer(fd, policy, process_name, batch_size, queue_depth);
+  }
+
+  ~EventStreamer() {
+    {
+      std::unique_lock<std::mutex> lock(lock_);
+      Submit(lock);
+      stopped_ = true;
+      ready_.notify_all();
+      space_.notify_all();
+    }
+    sender_.join();
+    close(fd_);
+    uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+    if (dropped > 0) {
+      std::cerr << "[WARNING] " << dropped << " events are not streamed because the consumer is slow or gone" << std::endl;
+    }
+  }
+
+  // Called from application threads
+  void Add(EventStreamRecord& rec, const std::string& name) {
+    std::unique_lock<std::mutex> lock(lock_);
+    if (disconnected_) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    rec.name_id_ = Intern(name);
+    current_.events_.push_back(rec);
+    if (current_.events_.size() >= batch_size_) {
+      Submit(lock);
+    }
+  }
+
+  uint64_t GetDroppedCount() const {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  struct Batch {
+    std::string names_;                     // serialized name definitions
+    uint32_t name_count_ = 0;
+    std::vector<EventStreamRecord> events_;
+  };
+
+  EventStreamer(int fd, EventStreamDropPolicy policy, const std::string& process_name, uint32_t batch_size, uint32_t queue_depth)
+    : fd_(fd), policy_(policy), batch_size_(batch_size), queue_depth_(queue_depth), pid_(getpid()) {
+    current_.events_.reserve(batch_size_);
+    std::string hello = process_name.substr(0, kEventStreamMaxNameSize);
+    EventStreamHeader header = MakeHeader(EVENT_STREAM_HELLO, hello.size(), 0, 0);
+    std::string message(reinterpret_cast<const char*>(&header), sizeof(header));
+    message += hello;
+    if (!SendEventStreamData(fd_, message.data(), message.size())) {
+      disconnected_ = true;
+    }
+    sender_ = std::thread([this]() { Run(); });
+  }
+
+  EventStreamHeader MakeHeader(uint16_t type, size_t size, uint32_t name_count, uint32_t event_count) const {
+    EventStreamHeader header;
+    header.magic_ = kEventStreamMagic;
+    header.version_ = kEventStreamVersion;
+    header.type_ = type;
+    header.pid_ = pid_;
+    header.size_ = static_cast<uint32_t>(size);
+    header.name_count_ = name_count;
+    header.event_count_ = event_count;
+    header.dropped_ = dropped_.load(std::memory_order_relaxed);
+    return header;
+  }
+
+  // Called with lock_ held
+  uint32_t Intern(const std::string& name) {
+    auto it = names_.find(name);
+    if (it != names_.end()) {
+      return it->second;
+    }
+    uint32_t id = static_cast<uint32_t>(names_.size());
+    names_.emplace(name, id);
+    uint32_t size = static_cast<uint32_t>((name.size() < kEventStreamMaxNameSize) ? name.size() : kEventStreamMaxNameSize);
+    current_.names_.append(reinterpret_cast<const char*>(&id), sizeof(id));
+    current_.names_.append(reinterpret_cast<const char*>(&size), sizeof(size));
+    current_.names_.append(name.data(), size);
+    current_.name_count_++;
+    return id;
+  }
+
+  // Called with lock_ held, the names defined in the dropped batch are moved to the batch sent next
+  void Drop(Batch& batch, Batch& next) {
+    dropped_.fetch_add(batch.events_.size(), std::memory_order_relaxed);
+    next.names_.insert(0, batch.names_);
+    next.name_count_ += batch.name_count_;
+  }
+
+  // Called with lock_ held
+  void Submit(std::unique_lock<std::mutex>& lock) {
+    if (current_.events_.empty() && current_.name_count_ == 0) {
+      return;
+    }
+    if (queue_.size() >= queue_depth_ && !disconnected_) {
+      if (policy_ == EVENT_STREAM_BLOCK) {
+        space_.wait(lock, [this]() { return queue_.size() < queue_depth_ || disconnected_; });
+      } else if (policy_ == EVENT_STREAM_DROP_OLDEST) {
+        Batch oldest = std::move(queue_.front());
+        queue_.pop_front();
+        Drop(oldest, queue_.empty() ? current_ : queue_.front());
+      } else {
+        Batch newest = std::move(current_);
+        current_ = Batch();
+        current_.events_.reserve(batch_size_);
+        Drop(newest, current_);
+        return;
+      }
+    }
+    if (disconnected_) {
+      dropped_.fetch_add(current_.events_.size(), std::memory_order_relaxed);
+    } else {
+      queue_.emplace_back(std::move(current_));
+      ready_.notify_one();
+    }
+    current_ = Batch();
+    current_.events_.reserve(batch_size_);
+  }
+
+  void Run() {
+    std::string message;
+    auto deadline = std::chrono::steady_clock::time_point::max();
+    while (true) {
+      Batch batch;
+      {
+        std::unique_lock<std::mutex> lock(lock_);
+        if (!ready_.wait_for(lock, kEventStreamFlushInterval, [this]() { return stopped_ || !queue_.empty(); })) {
+          // nothing sent for a while, send the partial batch for a live view
+          Submit(lock);
+        }
+        if (queue_.empty()) {
+          if (stopped_) {
+            break;
+          }
+          continue;
+        }
+        if (stopped_ && deadline == std::chrono::steady_clock::time_point::max()) {
+          deadline = std::chrono::steady_clock::now() + kEventStreamLingerTimeout;
+          // the consumer is not to hold up the exit of the application forever
+          timeval tv = {1, 0};
+          setsockopt(fd_, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+        }
+        batch = std::move(queue_.front());
+        queue_.pop_front();
+        space_.notify_all();
+      }
+
+      EventStreamHeader header = MakeHeader(EVENT_STREAM_BATCH,
+        batch.names_.size() + batch.events_.size() * sizeof(EventStreamRecord), batch.name_count_, batch.events_.size());
+      message.assign(reinterpret_cast<const char*>(&header), sizeof(header));
+      message += batch.names_;
+      message.append(reinterpret_cast<const char*>(batch.events_.data()), batch.events_.size() * sizeof(EventStreamRecord));
+      if (std::chrono::steady_clock::now() > deadline || !SendEventStreamData(fd_, message.data(), message.size())) {
+        std::unique_lock<std::mutex> lock(lock_);
+        if (!disconnected_) {
+          std::cerr << "[WARNING] Event stream consumer is gone, stop streaming events" << std::endl;
+        }
+        disconnected_ = true;
+        dropped_.fetch_add(batch.events_.size(), std::memory_order_relaxed);
+        for (auto& b : queue_) {
+          dropped_.fetch_add(b.events_.size(), std::memory_order_relaxed);
+        }
+        queue_.clear();
+        space_.notify_all();
+      }
+    }
+  }
+
+  int fd_;
+  EventStreamDropPolicy policy_;
+  uint32_t batch_size_;
+  uint32_t queue_depth_;
+  uint32_t pid_;
+
+  std::mutex lock_;
+  std::condition_variable ready_;     // a batch is queued or the streamer is stopped
+  std::condition_variable space_;     // the queue has room
+  std::deque<Batch> queue_;
+  Batch current_;
+  std::unordered_map<std::string, uint32_t> names_;
+  bool stopped_ = false;
+  bool disconnected_ = false;
+  std::atomic<uint64_t> dropped_{0};
+
+  std::thread sender_;
+};
+
+// Consumer side: reassembles messages of one connection from the bytes received
+class EventStreamDecoder {
+ public:
+  using EventHandler = std::function<void(uint32_t pid, const EventStreamRecord& rec, const std::string& name)>;
+
+  // Returns false if the stream is corrupted
+  bool Feed(const char* data, size_t size, const EventHandler& handler) {
+    buffer_.append(data, size);
+    size_t pos = 0;
+    while (buffer_.size() - pos >= sizeof(EventStreamHeader)) {
+      EventStreamHeader header;
+      memcpy(&header, buffer_.data() + pos, sizeof(header));
+      if (header.magic_ != kEventStreamMagic || header.version_ != kEventStreamVersion) {
+        return false;
+      }
+      if (buffer_.size() - pos - sizeof(header) < header.size_) {
+        break;
+      }
+      const char* payload = buffer_.data() + pos + sizeof(header);
+      pid_ = header.pid_;
+      dropped_ = header.dropped_;
+      if (header.type_ == EVENT_STREAM_HELLO) {
+        process_name_.assign(payload, header.size_);
+      } else if (header.type_ == EVENT_STREAM_BATCH) {
+        if (!DecodeBatch(header, payload, handler)) {
+          return false;
+        }
+      }
+      pos += sizeof(header) + header.size_;
+    }
+    buffer_.erase(0, pos);
+    return true;
+  }
+
+  uint32_t GetPid() const {
+    return pid_;
+  }
+
+  const std::string& GetProcessName() const {
+    return process_name_;
+  }
+
+  // Events dropped by the producer as of the last message
+  uint64_t GetDroppedCount() const {
+    return dropped_;
+  }
+
+ private:
+  bool DecodeBatch(const EventStreamHeader& header, const char* payload, const EventHandler& handler) {
+    const char* end = payload + header.size_;
+    for (uint32_t i = 0; i < header.name_count_; i++) {
+      uint32_t id;
+      uint32_t size;
+      if (end - payload < static_cast<ptrdiff_t>(sizeof(id) + sizeof(size))) {
+        return false;
+      }
+      memcpy(&id, payload, sizeof(id));
+      memcpy(&size, payload + sizeof(id), sizeof(size));
+      payload += sizeof(id) + sizeof(size);
+      if (end - payload < static_cast<ptrdiff_t>(size)) {
+        return false;
+      }
+      if (id >= names_.size()) {
+        names_.resize(id + 1);
+      }
+      names_[id].assign(payload, size);
+      payload += size;
+    }
+    if (end - payload != static_cast<ptrdiff_t>(header.event_count_ * sizeof(EventStreamRecord))) {
+      return false;
+    }
+    EventStreamRecord rec;
+    for (uint32_t i = 0; i < header.event_count_; i++) {
+      memcpy(&rec, payload + i * sizeof(EventStreamRecord), sizeof(rec));
+      if (rec.name_id_ >= names_.size()) {
+        return false;
+      }
+      handler(header.pid_, rec, names_[rec.name_id_]);
+    }
+    return true;
+  }
+
+  std::string buffer_;
+  std::vector<std::string> names_;
+  std::string process_name_;
+  uint32_t pid_ = 0;
+  uint64_t dropped_ = 0;
+};
+
+#endif /* _WIN32 */
+
+#endif // PTI_TOOLS_UNITRACE_UTILS_EVENT_STREAM_H_
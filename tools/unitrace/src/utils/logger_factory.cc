@@ -16,13 +16,20 @@
 
 #include <thread>
 
+#include "compressed_sink.h"
+#ifndef _WIN32
+#include "shm_transport.h"
+#endif /* _WIN32 */
+
 // LoggerFactory base constructor
 LoggerFactory::LoggerFactory(uint32_t app_id)
     : app_id_(app_id),
       dir_path_(""),
       app_name_(GetAppName()),
       rank_((utils::GetEnv("PMI_RANK").empty()) ? utils::GetEnv("PMIX_RANK") : utils::GetEnv("PMI_RANK")),
-      data_dir_path_(utils::GetEnv("UNITRACE_DataDir"))
+      data_dir_path_(utils::GetEnv("UNITRACE_DataDir")),
+      compress_output_(utils::GetEnv("UNITRACE_CompressOutput") == "1"),
+      rotate_size_(std::strtoull(utils::GetEnv("UNITRACE_RotateOutputSize").c_str(), nullptr, 10))
 {}
 
 // LoggerFactory directory creation helper
@@ -76,11 +83,85 @@ std::shared_ptr<Logger> LoggerFactory::GetLoggerImpl(LoggerType type, int32_t de
         return it->second;
     }
     std::string filename = GenerateLogFileName(type, device_id);
-    auto logger = std::make_shared<Logger>(filename, lazy_flush, lock_free);
+    std::shared_ptr<Logger> logger;
+#if UNITRACE_COMPRESSION_ENABLED
+    bool compressed = (compress_output_ && !filename.empty() && IsTraceOutputType(type));
+    if (compressed) {
+        filename += GetCompressedFileExtension();
+        // the sink cuts blocks on its own, a flush after every record would make a block of it
+        lazy_flush = true;
+    }
+#endif /* UNITRACE_COMPRESSION_ENABLED */
+#ifndef _WIN32
+    if (!filename.empty() && IsTransportedType(type)) {
+        auto producer = GetShmRingProducer();
+        if (producer != nullptr) {
+            // the launcher may run in a different working directory
+            std::string path = CXX_STD_FILESYSTEM_NAMESPACE::absolute(filename).string();
+            ShmRingOutputKind kind = SHM_RING_OUTPUT_PLAIN;
+#if UNITRACE_COMPRESSION_ENABLED
+            if (compressed) {
+                // compressed by the launcher
+                kind = SHM_RING_OUTPUT_COMPRESSED;
+            }
+#endif /* UNITRACE_COMPRESSION_ENABLED */
+            logger = std::make_shared<Logger>(filename, std::make_unique<ShmRingSink>(producer, path, kind), lazy_flush, lock_free);
+        }
+    }
+#endif /* _WIN32 */
+#if UNITRACE_COMPRESSION_ENABLED
+    if (logger == nullptr && compressed) {
+        logger = std::make_shared<Logger>(filename, std::make_unique<CompressedFileSink>(filename, rotate_size_), lazy_flush, lock_free);
+    }
+#endif /* UNITRACE_COMPRESSION_ENABLED */
+    if (logger == nullptr && rotate_size_ > 0 && !filename.empty() && IsTraceOutputType(type)) {
+        logger = std::make_shared<Logger>(filename, std::make_unique<RotatingFileSink>(filename, rotate_size_), lazy_flush, lock_free);
+    }
+    if (logger == nullptr) {
+        logger = std::make_shared<Logger>(filename, lazy_flush, lock_free);
+    }
     loggers_[key] = logger;
     return logger;
 }
 
+// Trace outputs are written by the launcher if the shared memory transport is enabled. Temporary
+// files and outputs the launcher reads back are always written by the process itself.
+bool LoggerFactory::IsTransportedType(LoggerType type) {
+    switch (type) {
+        case LOGGER_TYPE_LEGACY_SHARED_TRACE:
+        case LOGGER_TYPE_TRACE_HOST_TIMING:
+        case LOGGER_TYPE_TRACE_DEVICE_TIMING:
+        case LOGGER_TYPE_TRACE_DEVICE_SUBMISSION:
+        case LOGGER_TYPE_TRACE_CALL_LOGGING:
+        case LOGGER_TYPE_TRACE_CCL_SUMMARY_REPORT:
+        case LOGGER_TYPE_TRACE_DEVICE_TIMELINE:
+        case LOGGER_TYPE_CHROME_TRACE_UNITRACE:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Trace outputs are compressed and rotated if enabled. Outputs that are read back by unitrace,
+// e.g. metric data, are never compressed or rotated.
+bool LoggerFactory::IsTraceOutputType(LoggerType type) {
+    return IsTransportedType(type) || (type == LOGGER_TYPE_KMD_TRACE);
+}
+
+#ifndef _WIN32
+// Called with mutex_ held
+std::shared_ptr<ShmRingProducer> LoggerFactory::GetShmRingProducer() const {
+    if (!shm_producer_initialized_) {
+        shm_producer_initialized_ = true;
+        std::string registry = utils::GetEnv("UNITRACE_ShmTransportRegistry");
+        if (!registry.empty()) {
+            shm_producer_ = ShmRingProducer::Create(registry);
+        }
+    }
+    return shm_producer_;
+}
+#endif /* _WIN32 */
+
 void LegacyLoggerFactory::AdjustLoggerTypeAndDeviceId(LoggerType& type, int32_t& device_id) const {
     
     if (type == LOGGER_TYPE_TRACE_HOST_TIMING ||
@@ -238,6 +319,8 @@ std::string LegacyLoggerFactory::GenerateLogFileName(LoggerType type, int32_t de
             }
         case LOGGER_TYPE_KMD_TRACE:
             return GetLogFileName("oskmd.json", app_id_);
+        case LOGGER_TYPE_TELEMETRY:
+            return (dir_path_.empty() ? std::string() : dir_path_ + '/') + GetLogFileName("telemetry.bin", app_id_);
         default:
             PTI_ASSERT(false);
             return "";
@@ -335,6 +418,9 @@ std::string ResultDirLoggerFactory::GetTraceLogFileName(LoggerType type) const{
         case LOGGER_TYPE_KMD_TRACE:
             filename = "oskmd.json";
             break;
+        case LOGGER_TYPE_TELEMETRY:
+            filename = "telemetry.bin";
+            break;
         default:
             std::cerr << "[ERROR] ResultDirLoggerFactory::GetTraceLogFileName Unknown logger type: " << type << std::endl;
             break;
@@ -355,6 +441,7 @@ std::string ResultDirLoggerFactory::GenerateLogFileName(LoggerType type, int32_t
         case LOGGER_TYPE_TRACE_CCL_SUMMARY_REPORT:
         case LOGGER_TYPE_TRACE_DEVICE_TIMELINE:
         case LOGGER_TYPE_KMD_TRACE:
+        case LOGGER_TYPE_TELEMETRY:
             return GetTraceLogFileName(type);
         case LOGGER_TYPE_CHROME_TRACE_UNITRACE:
             return dir_path_ + "/chrome_trace.json";
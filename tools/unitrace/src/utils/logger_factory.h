@@ -30,11 +30,13 @@ enum LoggerType {
   LOGGER_TYPE_TRACE_CALL_LOGGING,
   LOGGER_TYPE_TRACE_CCL_SUMMARY_REPORT,
   LOGGER_TYPE_TRACE_DEVICE_TIMELINE,
-  LOGGER_TYPE_KMD_TRACE
+  LOGGER_TYPE_KMD_TRACE,
+  LOGGER_TYPE_TELEMETRY
 };
 
 class LegacyLoggerFactory;
 class ResultDirLoggerFactory;
+class ShmRingProducer;
 
 class LoggerFactory {
 public:
@@ -67,14 +69,25 @@ protected:
     void CreateDirectory(const std::string& dir) const;
     std::shared_ptr<Logger> GetLoggerImpl(LoggerType type, int32_t device_id, bool lazy_flush, bool lock_free) const;
     void SetAppId(uint32_t app_id) {app_id_ = app_id;}
+    static bool IsTransportedType(LoggerType type);
+    static bool IsTraceOutputType(LoggerType type);
+#ifndef _WIN32
+    std::shared_ptr<ShmRingProducer> GetShmRingProducer() const;
+#endif // _WIN32
 
     uint32_t app_id_;
     const std::string app_name_;
     const std::string rank_;
     std::string dir_path_; // Directory path for output, empty by default
     std::string data_dir_path_; // path for temporary files
+    const bool compress_output_; // compress trace outputs, see compressed_sink.h
+    const uint64_t rotate_size_; // rotation size in bytes of trace outputs, 0 if not rotated
     mutable std::mutex mutex_;
     mutable std::map<std::pair<LoggerType, int32_t>, std::shared_ptr<Logger>> loggers_;
+#ifndef _WIN32
+    mutable std::shared_ptr<ShmRingProducer> shm_producer_; // shared memory transport to the launcher, if enabled
+    mutable bool shm_producer_initialized_ = false;
+#endif // _WIN32
 };
 
 class LegacyLoggerFactory : public LoggerFactory {
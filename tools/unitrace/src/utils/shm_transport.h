@@ -0,0 +1,571 @@
+//==============================================================
+// Copyright (C) Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+// =============================================================
+
+#ifndef PTI_TOOLS_UNITRACE_UTILS_SHM_TRANSPORT_H_
+#define PTI_TOOLS_UNITRACE_UTILS_SHM_TRANSPORT_H_
+
+// Shared-memory transport of log output from instrumented processes to the unitrace launcher.
+//
+// The launcher creates a registry of process slots. Every instrumented process claims a slot and
+// creates its own single-producer/single-consumer ring, then its loggers append records to the
+// ring (a memcpy under a process-local lock). The launcher drains all rings on a background
+// thread and owns every output file: it opens, writes, flushes, closes and removes empty files
+// on behalf of the instrumented processes.
+//
+// Records are 8-byte aligned and never wrap: a record that does not fit before the end of the
+// ring is preceded by a padding record that sends the consumer back to the start.
+
+#ifndef _WIN32
+
+#include <errno.h>
+#include <signal.h>
+#include <sched.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "compressed_sink.h"
+#include "logger.h"
+#include "shared_memory.h"
+
+#define UNITRACE_SHM_TRANSPORT_REGISTRY "unitrace_shm_transport"
+#define UNITRACE_SHM_TRANSPORT_RING "unitrace_shm_ring"
+
+constexpr uint32_t kShmTransportMaxProcesses = 256;
+constexpr uint64_t kShmRingDefaultSize = 16 * 1024 * 1024;
+constexpr uint64_t kShmRingMinSize = 64 * 1024;
+constexpr uint32_t kShmRingAlignment = 8;
+// how long a producer waits for space in a full ring before it drops the record
+constexpr std::chrono::milliseconds kShmRingFullTimeout(5000);
+// a producer sends at most one flush record per stream within this interval, the launcher flushes
+// the rest of the output of flushed streams once it has drained all rings
+constexpr std::chrono::milliseconds kShmRingFlushInterval(100);
+
+enum ShmRingRecordType : uint16_t {
+  SHM_RING_RECORD_PADDING = 0,
+  SHM_RING_RECORD_OPEN,       // payload is the output kind (ShmRingOutputKind) followed by the file name
+  SHM_RING_RECORD_DATA,       // payload is appended to the file
+  SHM_RING_RECORD_FLUSH,
+  SHM_RING_RECORD_CLOSE,      // payload is one byte, non-zero if the file is to be removed
+};
+
+enum ShmRingOutputKind : char {
+  SHM_RING_OUTPUT_PLAIN = 0,
+  SHM_RING_OUTPUT_COMPRESSED,
+};
+
+struct ShmRingRecordHeader {
+  uint32_t size_;             // payload size in bytes
+  uint16_t type_;
+  uint16_t stream_;
+};
+
+static_assert(sizeof(ShmRingRecordHeader) == kShmRingAlignment, "Unexpected ShmRingRecordHeader layout");
+
+struct ShmRingHeader {
+  alignas(64) std::atomic<uint64_t> head_;      // written by the producer only
+  alignas(64) std::atomic<uint64_t> tail_;      // written by the consumer only
+  alignas(64) uint64_t capacity_;               // size of the data area, power of 2
+  std::atomic<uint64_t> dropped_;               // records dropped because the ring stayed full
+};
+
+enum ShmTransportSlotState : uint32_t {
+  SHM_TRANSPORT_SLOT_FREE = 0,
+  SHM_TRANSPORT_SLOT_CLAIMED,   // ring is being created
+  SHM_TRANSPORT_SLOT_ACTIVE,
+  SHM_TRANSPORT_SLOT_CLOSED,    // producer exited normally, ring is to be drained and released
+};
+
+struct ShmTransportSlot {
+  std::atomic<uint32_t> state_;
+  uint32_t pid_;
+  uint64_t ring_size_;
+};
+
+struct ShmTransportRegistry {
+  uint64_t ring_size_;
+  ShmTransportSlot slots_[kShmTransportMaxProcesses];
+};
+
+inline std::string GetShmTransportRegistryName(uint32_t launcher_pid) {
+  return std::string(UNITRACE_SHM_TRANSPORT_REGISTRY) + "." + std::to_string(launcher_pid);
+}
+
+inline std::string GetShmRingName(const std::string& registry, uint32_t pid) {
+  return std::string(UNITRACE_SHM_TRANSPORT_RING) + "." + registry.substr(registry.find_last_of('.') + 1) + "." + std::to_string(pid);
+}
+
+inline uint64_t AlignShmRingRecord(uint64_t size) {
+  return (size + kShmRingAlignment - 1) & ~static_cast<uint64_t>(kShmRingAlignment - 1);
+}
+
+// Producer side, one per instrumented process
+class ShmRingProducer {
+ public:
+  ShmRingProducer(const ShmRingProducer& that) = delete;
+  ShmRingProducer& operator=(const ShmRingProducer& that) = delete;
+
+  // Claims a slot in the launcher's registry and creates the ring. Returns nullptr if the
+  // registry is not available or full, in which case the caller writes files directly.
+  static std::shared_ptr<ShmRingProducer> Create(const std::string& registry) {
+    std::shared_ptr<ShmRingProducer> producer(new ShmRingProducer());
+    if (!producer->Init(registry)) {
+      return nullptr;
+    }
+    return producer;
+  }
+
+  ~ShmRingProducer() {
+    if (slot_ == nullptr || getpid() != pid_) {
+      // forked without exec: the ring belongs to the parent process
+      return;
+    }
+    uint64_t dropped = ring_->dropped_.load(std::memory_order_relaxed);
+    if (dropped > 0) {
+      std::cerr << "[WARNING] " << dropped << " log records are dropped because the shared memory transport is full" << std::endl;
+    }
+    slot_->state_.store(SHM_TRANSPORT_SLOT_CLOSED, std::memory_order_release);
+    ring_shm_.SoftRelease();
+    registry_shm_.SoftRelease();
+  }
+
+  uint16_t OpenStream(const std::string& filename, ShmRingOutputKind kind) {
+    const std::lock_guard<std::mutex> lock(lock_);
+    uint16_t stream = next_stream_++;
+    std::string payload = static_cast<char>(kind) + filename;
+    Put(SHM_RING_RECORD_OPEN, stream, payload.data(), payload.size());
+    return stream;
+  }
+
+  void Write(uint16_t stream, const char* data, size_t size) {
+    const std::lock_guard<std::mutex> lock(lock_);
+    // large texts are split so that a record never exceeds a quarter of the ring
+    while (size > 0) {
+      size_t chunk = (size < max_payload_) ? size : max_payload_;
+      Put(SHM_RING_RECORD_DATA, stream, data, chunk);
+      data += chunk;
+      size -= chunk;
+    }
+  }
+
+  // Loggers flush after every record unless lazy flush is on, so flush records are rate limited
+  void Flush(uint16_t stream) {
+    const std::lock_guard<std::mutex> lock(lock_);
+    auto now = std::chrono::steady_clock::now();
+    if (stream >= last_flush_.size()) {
+      last_flush_.resize(stream + 1);
+    }
+    if (now - last_flush_[stream] < kShmRingFlushInterval) {
+      return;
+    }
+    last_flush_[stream] = now;
+    Put(SHM_RING_RECORD_FLUSH, stream, nullptr, 0);
+  }
+
+  void CloseStream(uint16_t stream, bool remove) {
+    const std::lock_guard<std::mutex> lock(lock_);
+    char flag = remove ? 1 : 0;
+    Put(SHM_RING_RECORD_CLOSE, stream, &flag, sizeof(flag));
+  }
+
+ private:
+  ShmRingProducer() = default;
+
+  bool Init(const std::string& registry) {
+    pid_ = getpid();
+    if (registry_shm_.AttachWrite(registry.c_str(), sizeof(ShmTransportRegistry)) != SHM_SUCCESS) {
+      return false;
+    }
+    auto* reg = reinterpret_cast<ShmTransportRegistry*>(registry_shm_.GetPtr());
+    for (uint32_t i = 0; i < kShmTransportMaxProcesses; i++) {
+      uint32_t expected = SHM_TRANSPORT_SLOT_FREE;
+      if (reg->slots_[i].state_.compare_exchange_strong(expected, SHM_TRANSPORT_SLOT_CLAIMED, std::memory_order_acq_rel)) {
+        slot_ = &reg->slots_[i];
+        break;
+      }
+    }
+    if (slot_ == nullptr) {
+      std::cerr << "[WARNING] Too many processes for shared memory transport, process " << pid_ << " writes its own files" << std::endl;
+      registry_shm_.SoftRelease();
+      return false;
+    }
+
+    uint64_t capacity = reg->ring_size_;
+    std::string name = GetShmRingName(registry, pid_);
+    if (ring_shm_.Create(name.c_str(), sizeof(ShmRingHeader) + capacity, true) != SHM_SUCCESS) {
+      slot_->state_.store(SHM_TRANSPORT_SLOT_FREE, std::memory_order_release);
+      slot_ = nullptr;
+      registry_shm_.SoftRelease();
+      return false;
+    }
+    ring_ = reinterpret_cast<ShmRingHeader*>(ring_shm_.GetPtr());
+    ring_->head_.store(0, std::memory_order_relaxed);
+    ring_->tail_.store(0, std::memory_order_relaxed);
+    ring_->capacity_ = capacity;
+    ring_->dropped_.store(0, std::memory_order_relaxed);
+    data_ = reinterpret_cast<char*>(ring_) + sizeof(ShmRingHeader);
+    max_payload_ = capacity / 4 - sizeof(ShmRingRecordHeader);
+
+    slot_->pid_ = pid_;
+    slot_->ring_size_ = capacity;
+    slot_->state_.store(SHM_TRANSPORT_SLOT_ACTIVE, std::memory_order_release);
+    return true;
+  }
+
+  // Waits until the consumer frees enough space, gives up after kShmRingFullTimeout
+  bool Reserve(uint64_t head, uint64_t needed) {
+    uint64_t capacity = ring_->capacity_;
+    if (capacity - (head - ring_->tail_.load(std::memory_order_acquire)) >= needed) {
+      return true;
+    }
+    auto start = std::chrono::steady_clock::now();
+    while (capacity - (head - ring_->tail_.load(std::memory_order_acquire)) < needed) {
+      if (std::chrono::steady_clock::now() - start > kShmRingFullTimeout) {
+        return false;
+      }
+      sched_yield();
+    }
+    return true;
+  }
+
+  void Put(uint16_t type, uint16_t stream, const void* payload, size_t size) {
+    if (getpid() != pid_) {
+      // forked without exec, the ring and the streams belong to the parent process
+      if (!fork_warned_) {
+        fork_warned_ = true;
+        std::cerr << "[WARNING] Process " << getpid() << " is forked from " << pid_ << " without exec, its log output is dropped" << std::endl;
+      }
+      return;
+    }
+    uint64_t capacity = ring_->capacity_;
+    uint64_t total = AlignShmRingRecord(sizeof(ShmRingRecordHeader) + size);
+    uint64_t head = ring_->head_.load(std::memory_order_relaxed);
+    uint64_t offset = head & (capacity - 1);
+    uint64_t contiguous = capacity - offset;
+    uint64_t needed = (contiguous < total) ? (contiguous + total) : total;
+
+    if (!Reserve(head, needed)) {
+      ring_->dropped_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+
+    if (contiguous < total) {
+      ShmRingRecordHeader padding = {static_cast<uint32_t>(contiguous - sizeof(ShmRingRecordHeader)), SHM_RING_RECORD_PADDING, 0};
+      memcpy(data_ + offset, &padding, sizeof(padding));
+      head += contiguous;
+      offset = 0;
+    }
+
+    ShmRingRecordHeader header = {static_cast<uint32_t>(size), type, stream};
+    memcpy(data_ + offset, &header, sizeof(header));
+    if (size > 0) {
+      memcpy(data_ + offset + sizeof(header), payload, size);
+    }
+    ring_->head_.store(head + total, std::memory_order_release);
+  }
+
+  std::mutex lock_;
+  pid_t pid_ = 0;
+  SharedMemory registry_shm_;
+  SharedMemory ring_shm_;
+  ShmTransportSlot* slot_ = nullptr;
+  ShmRingHeader* ring_ = nullptr;
+  char* data_ = nullptr;
+  uint64_t max_payload_ = 0;
+  uint16_t next_stream_ = 0;
+  std::vector<std::chrono::steady_clock::time_point> last_flush_;  // per stream
+  bool fork_warned_ = false;
+};
+
+// Logger destination that forwards the output to the launcher
+class ShmRingSink : public LogSink {
+ public:
+  ShmRingSink(std::shared_ptr<ShmRingProducer> producer, const std::string& filename,
+              ShmRingOutputKind kind = SHM_RING_OUTPUT_PLAIN)
+    : producer_(std::move(producer)) {
+    stream_ = producer_->OpenStream(filename, kind);
+  }
+
+  void Write(const std::string& text) override {
+    producer_->Write(stream_, text.data(), text.size());
+  }
+
+  void Flush() override {
+    producer_->Flush(stream_);
+  }
+
+  void Close(bool empty) override {
+    producer_->CloseStream(stream_, empty);
+  }
+
+ private:
+  std::shared_ptr<ShmRingProducer> producer_;
+  uint16_t stream_;
+};
+
+// Consumer side, owned by the launcher
+class ShmTransportDrainer {
+ public:
+  ShmTransportDrainer(const ShmTransportDrainer& that) = delete;
+  ShmTransportDrainer& operator=(const ShmTransportDrainer& that) = delete;
+
+  // Creates the registry. The name is to be passed to the instrumented processes.
+  static ShmTransportDrainer* Create(uint32_t launcher_pid, uint64_t ring_size = kShmRingDefaultSize) {
+    ShmTransportDrainer* drainer = new ShmTransportDrainer(GetShmTransportRegistryName(launcher_pid));
+    if (drainer->registry_shm_.Create(drainer->registry_.c_str(), sizeof(ShmTransportRegistry), true) == SHM_FAILED) {
+      delete drainer;
+      return nullptr;
+    }
+    uint64_t capacity = kShmRingMinSize;
+    while (capacity < ring_size) {
+      capacity <<= 1;
+    }
+    auto* reg = reinterpret_cast<ShmTransportRegistry*>(drainer->registry_shm_.GetPtr());
+    reg->ring_size_ = capacity;
+    for (uint32_t i = 0; i < kShmTransportMaxProcesses; i++) {
+      reg->slots_[i].pid_ = 0;
+      reg->slots_[i].ring_size_ = 0;
+      reg->slots_[i].state_.store(SHM_TRANSPORT_SLOT_FREE, std::memory_order_release);
+    }
+    return drainer;
+  }
+
+  ~ShmTransportDrainer() {
+    Stop();
+    for (auto& ring : rings_) {
+      ring.second->shm_.Release();
+    }
+    rings_.clear();
+    for (auto& stream : streams_) {
+      stream.second->Close(false);
+    }
+    streams_.clear();
+    registry_shm_.Release();
+  }
+
+  const std::string& GetRegistryName() const {
+    return registry_;
+  }
+
+  // Rotation size in bytes of the outputs, 0 to disable rotation
+  void SetRotateSize(uint64_t rotate_size) {
+    rotate_size_ = rotate_size;
+  }
+
+  void Start(std::chrono::milliseconds interval = std::chrono::milliseconds(1)) {
+    if (thread_ == nullptr) {
+      stop_.store(false, std::memory_order_release);
+      thread_ = std::make_unique<std::thread>([this, interval]() {
+        while (!stop_.load(std::memory_order_acquire)) {
+          if (Drain() == 0) {
+            FlushPending();
+            std::this_thread::sleep_for(interval);
+          }
+        }
+      });
+    }
+  }
+
+  // Stops the background thread and drains whatever is left
+  void Stop() {
+    if (thread_ != nullptr) {
+      stop_.store(true, std::memory_order_release);
+      thread_->join();
+      thread_.reset();
+    }
+    Drain();
+    FlushPending();
+  }
+
+  // Flushes the output written to flushed streams since their last flush record
+  void FlushPending() {
+    const std::lock_guard<std::mutex> lock(drain_lock_);
+    for (const auto& key : unflushed_streams_) {
+      auto it = streams_.find(key);
+      if (it != streams_.end()) {
+        it->second->Flush();
+      }
+    }
+    unflushed_streams_.clear();
+  }
+
+  // Drains all rings once. Returns the number of bytes consumed.
+  uint64_t Drain() {
+    const std::lock_guard<std::mutex> lock(drain_lock_);
+    auto* reg = reinterpret_cast<ShmTransportRegistry*>(registry_shm_.GetPtr());
+    if (reg == nullptr) {
+      return 0;
+    }
+    uint64_t consumed = 0;
+    for (uint32_t i = 0; i < kShmTransportMaxProcesses; i++) {
+      ShmTransportSlot& slot = reg->slots_[i];
+      uint32_t state = slot.state_.load(std::memory_order_acquire);
+      if (state != SHM_TRANSPORT_SLOT_ACTIVE && state != SHM_TRANSPORT_SLOT_CLOSED) {
+        continue;
+      }
+
+      auto it = rings_.find(i);
+      if (it == rings_.end() || it->second->pid_ != slot.pid_) {
+        if (it != rings_.end()) {
+          ReleaseRing(i);
+        }
+        auto ring = std::make_unique<Ring>();
+        ring->pid_ = slot.pid_;
+        std::string name = GetShmRingName(registry_, slot.pid_);
+        if (ring->shm_.AttachWrite(name.c_str(), sizeof(ShmRingHeader) + slot.ring_size_) != SHM_SUCCESS) {
+          continue;
+        }
+        it = rings_.emplace(i, std::move(ring)).first;
+      }
+
+      consumed += DrainRing(*it->second);
+
+      // the producer is gone either normally or abnormally, nothing more will arrive
+      if (state == SHM_TRANSPORT_SLOT_CLOSED || (kill(slot.pid_, 0) != 0 && errno == ESRCH)) {
+        consumed += DrainRing(*it->second);
+        ReleaseRing(i);
+        slot.state_.store(SHM_TRANSPORT_SLOT_FREE, std::memory_order_release);
+      }
+    }
+    return consumed;
+  }
+
+ private:
+  struct Ring {
+    uint32_t pid_ = 0;
+    SharedMemory shm_;
+  };
+
+  explicit ShmTransportDrainer(std::string registry) : registry_(std::move(registry)) {}
+
+  uint64_t DrainRing(Ring& ring) {
+    auto* header = reinterpret_cast<ShmRingHeader*>(ring.shm_.GetPtr());
+    const char* data = reinterpret_cast<const char*>(header) + sizeof(ShmRingHeader);
+    uint64_t capacity = header->capacity_;
+    uint64_t tail = header->tail_.load(std::memory_order_relaxed);
+    uint64_t head = header->head_.load(std::memory_order_acquire);
+    uint64_t start = tail;
+
+    while (tail < head) {
+      uint64_t offset = tail & (capacity - 1);
+      ShmRingRecordHeader record;
+      memcpy(&record, data + offset, sizeof(record));
+      const char* payload = data + offset + sizeof(record);
+      if (record.type_ != SHM_RING_RECORD_PADDING) {
+        Process(ring.pid_, record, payload);
+      }
+      tail += AlignShmRingRecord(sizeof(record) + record.size_);
+    }
+    header->tail_.store(tail, std::memory_order_release);
+    return tail - start;
+  }
+
+  void Process(uint32_t pid, const ShmRingRecordHeader& record, const char* payload) {
+    auto key = std::make_pair(pid, record.stream_);
+    switch (record.type_) {
+      case SHM_RING_RECORD_OPEN: {
+        if (record.size_ < 1) {
+          break;
+        }
+        CloseStream(key, false);
+        std::string filename(payload + 1, record.size_ - 1);
+        std::unique_ptr<LogSink> sink;
+#if UNITRACE_COMPRESSION_ENABLED
+        if (payload[0] == SHM_RING_OUTPUT_COMPRESSED) {
+          sink = std::make_unique<CompressedFileSink>(filename, rotate_size_);
+        }
+#endif /* UNITRACE_COMPRESSION_ENABLED */
+        if (sink == nullptr) {
+          sink = std::make_unique<RotatingFileSink>(filename, rotate_size_);
+        }
+        streams_[key] = std::move(sink);
+        break;
+      }
+      case SHM_RING_RECORD_DATA: {
+        auto it = streams_.find(key);
+        if (it != streams_.end()) {
+          it->second->Write(std::string(payload, record.size_));
+          if (flushed_streams_.count(key) > 0) {
+            unflushed_streams_.insert(key);
+          }
+        }
+        break;
+      }
+      case SHM_RING_RECORD_FLUSH: {
+        auto it = streams_.find(key);
+        if (it != streams_.end()) {
+          it->second->Flush();
+          flushed_streams_.insert(key);
+          unflushed_streams_.erase(key);
+        }
+        break;
+      }
+      case SHM_RING_RECORD_CLOSE:
+        CloseStream(key, (record.size_ > 0) && (payload[0] != 0));
+        break;
+      default:
+        break;
+    }
+  }
+
+  void CloseStream(const std::pair<uint32_t, uint16_t>& key, bool empty) {
+    auto it = streams_.find(key);
+    if (it != streams_.end()) {
+      it->second->Close(empty);
+      streams_.erase(it);
+    }
+    flushed_streams_.erase(key);
+    unflushed_streams_.erase(key);
+  }
+
+  void ReleaseRing(uint32_t slot) {
+    auto it = rings_.find(slot);
+    if (it == rings_.end()) {
+      return;
+    }
+    uint32_t pid = it->second->pid_;
+    // files of a producer that died without closing them are kept as they are
+    for (auto s = streams_.begin(); s != streams_.end();) {
+      if (s->first.first == pid) {
+        s->second->Close(false);
+        flushed_streams_.erase(s->first);
+        unflushed_streams_.erase(s->first);
+        s = streams_.erase(s);
+      } else {
+        ++s;
+      }
+    }
+    it->second->shm_.Release();
+    rings_.erase(it);
+  }
+
+  std::string registry_;
+  SharedMemory registry_shm_;
+  std::mutex drain_lock_;
+  std::map<uint32_t, std::unique_ptr<Ring>> rings_;
+  std::map<std::pair<uint32_t, uint16_t>, std::unique_ptr<LogSink>> streams_;
+  std::set<std::pair<uint32_t, uint16_t>> flushed_streams_;     // streams with flush records
+  std::set<std::pair<uint32_t, uint16_t>> unflushed_streams_;   // written since the last flush
+  uint64_t rotate_size_ = 0;    // rotation size of outputs, 0 if not rotated
+  std::unique_ptr<std::thread> thread_;
+  std::atomic<bool> stop_{false};
+};
+
+#endif /* _WIN32 */
+
+#endif // PTI_TOOLS_UNITRACE_UTILS_SHM_TRANSPORT_H_
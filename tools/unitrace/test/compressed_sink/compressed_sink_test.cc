@@ -0,0 +1,271 @@
+//==============================================================
+// Copyright (C) Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+// =============================================================
+
+// Tests of compressed and rotated Logger output. No GPU is required.
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "compressed_sink.h"
+
+static constexpr int kThreads = 4;
+static constexpr int kLines = 50000;
+static constexpr size_t kBlockSize = 64 * 1024;
+static constexpr uint64_t kRotateSize = 256 * 1024;
+
+static std::string GetLine(int thread, int line) {
+  return "{\"ph\": \"X\", \"tid\": " + std::to_string(thread) + ", \"name\": \"kernel_" +
+    std::to_string(line % 17) + "\", \"ts\": " + std::to_string(line * 13 + thread) + "}\n";
+}
+
+// Reads the output back block by block using the block framing only
+static bool ReadBlocks(const std::string& filename, std::string& text, uint32_t& block_count) {
+  std::vector<CompressedBlockInfo> blocks;
+  if (!ReadCompressedBlockIndex(filename, blocks)) {
+    std::cerr << "[ERROR] Failed to read blocks of " << filename << std::endl;
+    return false;
+  }
+  std::ifstream in(filename, std::ios::in | std::ios::binary);
+  std::string block;
+  std::string raw;
+  // seek to the blocks in reverse order to make sure that every block stands on its own
+  std::vector<std::string> parts(blocks.size());
+  for (size_t i = blocks.size(); i-- > 0;) {
+    block.resize(blocks[i].size_);
+    in.seekg(blocks[i].offset_);
+    if (!in.read(&block[0], block.size()) || !DecompressBlock(block, raw) || raw.size() != blocks[i].raw_size_) {
+      std::cerr << "[ERROR] Failed to decompress block " << i << " of " << filename << std::endl;
+      return false;
+    }
+    parts[i] = raw;
+  }
+  for (const auto& part : parts) {
+    text += part;
+  }
+  block_count += static_cast<uint32_t>(blocks.size());
+  return true;
+}
+
+#if !BUILD_WITH_ZSTD
+// Reads the output back as a standard multi-member gzip file
+static bool ReadGzip(const std::string& filename, std::string& text) {
+  gzFile file = gzopen(filename.c_str(), "rb");
+  if (file == nullptr) {
+    return false;
+  }
+  char buffer[16384];
+  int size;
+  while ((size = gzread(file, buffer, sizeof(buffer))) > 0) {
+    text.append(buffer, size);
+  }
+  gzclose(file);
+  return size == 0;
+}
+#endif /* !BUILD_WITH_ZSTD */
+
+static std::string ReadFile(const std::string& filename) {
+  std::ifstream in(filename, std::ios::in | std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+// Flush hands a partial block over, it is written without further output
+static bool TestFlush(const std::string& dir) {
+  std::string filename = dir + "/flush.1234.txt" + GetCompressedFileExtension();
+  bool passed = true;
+  {
+    Logger logger(filename, std::make_unique<CompressedFileSink>(filename, 0, kBlockSize), true);
+    logger.Log("first line\n");
+    logger.Flush();
+    std::string text;
+    uint32_t block_count = 0;
+    for (int i = 0; i < 500 && block_count == 0; i++) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      text.clear();
+      block_count = 0;
+      std::vector<CompressedBlockInfo> blocks;
+      if (ReadCompressedBlockIndex(filename, blocks) && !blocks.empty()) {
+        passed = ReadBlocks(filename, text, block_count);
+      }
+    }
+    if (block_count != 1 || text != "first line\n") {
+      std::cerr << "[ERROR] Flushed data is not written (" << block_count << " blocks)" << std::endl;
+      passed = false;
+    }
+  }
+  std::remove(filename.c_str());
+  return passed;
+}
+
+// Uncompressed output is rotated between records
+static bool TestUncompressedRotation(const std::string& dir) {
+  std::string filename = dir + "/plain.1234.txt";
+  const uint64_t rotate_size = 1000;
+  const int lines = 200;
+  std::string expected;
+  {
+    Logger logger(filename, std::make_unique<RotatingFileSink>(filename, rotate_size));
+    for (int i = 0; i < lines; i++) {
+      std::string line = GetLine(0, i);
+      logger.Log(line);
+      expected += line;
+    }
+  }
+
+  bool passed = true;
+  std::string text;
+  uint32_t file_count = 0;
+  for (uint32_t i = 0; ; i++) {
+    std::string name = GetRotatedFileName(filename, i);
+    if (access(name.c_str(), F_OK) != 0) {
+      break;
+    }
+    std::string part = ReadFile(name);
+    if (part.size() > rotate_size || part.empty() || part.back() != '\n') {
+      std::cerr << "[ERROR] " << name << " exceeds the rotation size or splits a record" << std::endl;
+      passed = false;
+    }
+    text += part;
+    std::remove(name.c_str());
+    file_count++;
+  }
+  if (file_count < 2 || text != expected) {
+    std::cerr << "[ERROR] Uncompressed output is not rotated or has wrong content (" << file_count << " files)" << std::endl;
+    passed = false;
+  }
+  if (GetRotatedFileName(filename, 2) != dir + "/plain.1234.2.txt") {
+    std::cerr << "[ERROR] Wrong name of a rotated file: " << GetRotatedFileName(filename, 2) << std::endl;
+    passed = false;
+  }
+
+  std::string empty_filename = dir + "/empty.1234.txt";
+  {
+    Logger empty(empty_filename, std::make_unique<RotatingFileSink>(empty_filename, rotate_size));
+    empty.Log("header\n");
+    empty.SetEmptyPosition();
+  }
+  if (access(empty_filename.c_str(), F_OK) == 0) {
+    std::cerr << "[ERROR] Empty uncompressed output is not removed" << std::endl;
+    std::remove(empty_filename.c_str());
+    passed = false;
+  }
+  return passed;
+}
+
+int main() {
+  char pattern[] = "/tmp/compressed_sink_test.XXXXXX";
+  char* dir = mkdtemp(pattern);
+  if (dir == nullptr) {
+    std::cerr << "[ERROR] Failed to create temporary directory" << std::endl;
+    return -1;
+  }
+  std::string filename = std::string(dir) + "/trace.1234.json" + GetCompressedFileExtension();
+  std::string empty_filename = std::string(dir) + "/empty.1234.txt" + GetCompressedFileExtension();
+  bool passed = true;
+
+  {
+    Logger logger(filename, std::make_unique<CompressedFileSink>(filename, kRotateSize, kBlockSize), true);
+    Logger empty(empty_filename, std::make_unique<CompressedFileSink>(empty_filename, 0, kBlockSize), true);
+    logger.Log("{ \"traceEvents\":[\n");
+    logger.SetEmptyPosition();
+    empty.Log("header\n");
+    empty.SetEmptyPosition();
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; t++) {
+      threads.emplace_back([&logger, t]() {
+        for (int i = 0; i < kLines; i++) {
+          logger.Log(GetLine(t, i));
+        }
+      });
+    }
+    for (auto& t : threads) {
+      t.join();
+    }
+    logger.Log("\n]\n}\n");
+  }
+
+  // rotated files concatenated in order are the whole output
+  std::string text;
+  uint32_t file_count = 0;
+  uint32_t block_count = 0;
+  for (uint32_t i = 0; ; i++) {
+    std::string name = GetRotatedFileName(filename, i, GetCompressedFileExtension());
+    if (access(name.c_str(), F_OK) != 0) {
+      break;
+    }
+    std::ifstream in(name, std::ios::in | std::ios::binary | std::ios::ate);
+    if (static_cast<uint64_t>(in.tellg()) > kRotateSize) {
+      std::cerr << "[ERROR] " << name << " exceeds the rotation size" << std::endl;
+      passed = false;
+    }
+    if (!ReadBlocks(name, text, block_count)) {
+      passed = false;
+    }
+#if !BUILD_WITH_ZSTD
+    std::string gzip_text;
+    if (!ReadGzip(name, gzip_text) || gzip_text.size() == 0) {
+      std::cerr << "[ERROR] " << name << " is not a valid gzip file" << std::endl;
+      passed = false;
+    }
+#endif /* !BUILD_WITH_ZSTD */
+    std::remove(name.c_str());
+    file_count++;
+  }
+  if (file_count < 2 || block_count < file_count) {
+    std::cerr << "[ERROR] Output is not rotated (" << file_count << " files, " << block_count << " blocks)" << std::endl;
+    passed = false;
+  }
+
+  // lines of each thread are in order, lines of different threads are interleaved
+  std::vector<int> next(kThreads, 0);
+  size_t pos = text.find('\n') + 1;
+  if (text.compare(0, pos, "{ \"traceEvents\":[\n") != 0) {
+    std::cerr << "[ERROR] Output has wrong header" << std::endl;
+    passed = false;
+  }
+  while (passed && pos < text.size()) {
+    size_t end = text.find('\n', pos) + 1;
+    std::string line = text.substr(pos, end - pos);
+    pos = end;
+    if (line == "\n") {
+      break;
+    }
+    int thread = line[line.find("\"tid\": ") + 7] - '0';
+    if (thread < 0 || thread >= kThreads || line != GetLine(thread, next[thread])) {
+      std::cerr << "[ERROR] Unexpected line in output: " << line;
+      passed = false;
+      break;
+    }
+    next[thread]++;
+  }
+  for (int t = 0; passed && t < kThreads; t++) {
+    if (next[t] != kLines) {
+      std::cerr << "[ERROR] " << (kLines - next[t]) << " lines of thread " << t << " are lost" << std::endl;
+      passed = false;
+    }
+  }
+
+  if (access(empty_filename.c_str(), F_OK) == 0) {
+    std::cerr << "[ERROR] Empty output is not removed" << std::endl;
+    std::remove(empty_filename.c_str());
+    passed = false;
+  }
+  passed = TestFlush(dir) && passed;
+  passed = TestUncompressedRotation(dir) && passed;
+  rmdir(dir);
+
+  std::cout << (passed ? "[PASSED]" : "[FAILED]") << " compressed_sink_test" << std::endl;
+  return passed ? 0 : 1;
+}
@@ -0,0 +1,97 @@
+//==============================================================
+// Copyright (C) Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+// =============================================================
+
+// Measures the cost per call of OpenCL APIs that do next to nothing in the
+// runtime, so the time is spent mostly in the tracing callback. Run it with
+// and without unitrace and compare the options:
+//
+//   cl_api_overhead [-iters <n>]
+//   unitrace --opencl -d cl_api_overhead [-iters <n>]
+//   unitrace --opencl -h cl_api_overhead [-iters <n>]
+//   unitrace --opencl -c cl_api_overhead [-iters <n>]
+
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+#include <string>
+
+#include <CL/cl.h>
+
+#include "cl_utils.h"
+
+template <typename F>
+static double MeasureCall(uint32_t iters, F call) {
+  for (uint32_t i = 0; i < iters / 10; ++i) {  // warm up
+    call();
+  }
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < iters; ++i) {
+    call();
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - start).count() / iters;
+}
+
+int main(int argc, char* argv[]) {
+  uint32_t iters = 100000;
+
+  for (int i = 0; i < argc; i++) {
+    if (!strcmp(argv[i], "-iters") && i+1 < argc) {
+      iters = std::stoi(argv[++i]);
+    }
+  }
+
+  cl_device_id device = utils::cl::GetIntelDevice(CL_DEVICE_TYPE_GPU);
+  if (device == nullptr) {
+    printf("[ERROR] Unable to find GPU device\n");
+    return -1;
+  }
+
+  cl_int status = CL_SUCCESS;
+  cl_context context = clCreateContext(nullptr, 1, &device, nullptr,
+                                       nullptr, &status);
+  if (status != CL_SUCCESS || context == nullptr) {
+    printf("clCreateContext status=%d\n", status);
+    return -1;
+  }
+
+  cl_event event = clCreateUserEvent(context, &status);
+  if (status != CL_SUCCESS || event == nullptr) {
+    printf("clCreateUserEvent status=%d\n", status);
+    return -1;
+  }
+
+  // Not traced unless API data is requested
+  double device_info = MeasureCall(iters, [device]() {
+    cl_uint units = 0;
+    clGetDeviceInfo(device, CL_DEVICE_MAX_COMPUTE_UNITS,
+                    sizeof(units), &units, nullptr);
+  });
+
+  double event_info = MeasureCall(iters, [event]() {
+    cl_int event_status = CL_SUCCESS;
+    clGetEventInfo(event, CL_EVENT_COMMAND_EXECUTION_STATUS,
+                   sizeof(event_status), &event_status, nullptr);
+  });
+
+  // clReleaseEvent is traced for kernels as well
+  double retain_release_event = MeasureCall(iters, [event]() {
+    clRetainEvent(event);
+    clReleaseEvent(event);
+  });
+
+  printf("%-24s %10.1f ns/call\n", "clGetDeviceInfo", device_info);
+  printf("%-24s %10.1f ns/call\n", "clGetEventInfo", event_info);
+  printf("%-24s %10.1f ns/pair\n", "clRetain/ReleaseEvent",
+         retain_release_event);
+
+  clSetUserEventStatus(event, CL_COMPLETE);
+  clReleaseEvent(event);
+  clReleaseContext(context);
+
+  return 0;
+}
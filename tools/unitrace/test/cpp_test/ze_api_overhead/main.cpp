@@ -0,0 +1,121 @@
+//==============================================================
+// Copyright (C) Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+// =============================================================
+
+// Measures the cost per call of Level Zero APIs the tracer does not need
+// for the requested options, e.g. with --device-timing only, next to APIs
+// it always traces. Run it with and without unitrace and compare:
+//
+//   ze_api_overhead [-iters <n>]
+//   unitrace -d ze_api_overhead [-iters <n>]
+//   unitrace -h ze_api_overhead [-iters <n>]
+
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+#include <string>
+
+#include "ze_utils.h"
+
+template <typename F>
+static double MeasureCall(uint32_t iters, F call) {
+  for (uint32_t i = 0; i < iters / 10; ++i) {  // warm up
+    call();
+  }
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < iters; ++i) {
+    call();
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - start).count() / iters;
+}
+
+int main(int argc, char* argv[])
+{
+  uint32_t iters = 100000;
+
+  for (int i = 0; i < argc; i++) {
+    if (!strcmp(argv[i], "-iters") && i+1 < argc) {
+      iters = std::stoi(argv[++i]);
+    }
+  }
+
+  ze_result_t rc = ZE_RESULT_SUCCESS;
+  rc = zeInit(ZE_INIT_FLAG_GPU_ONLY);
+  if (rc != ZE_RESULT_SUCCESS) {
+      printf("[ERROR] Failed to init GPU device: 0x%x\n", rc);
+      return -1;
+  }
+
+  ze_device_handle_t device = utils::ze::GetGpuDevice();
+  ze_driver_handle_t driver = utils::ze::GetGpuDriver();
+  if (device == nullptr || driver == nullptr) {
+      printf("[ERROR] Unable to find GPU device\n");
+      return -1;
+  }
+
+  ze_context_handle_t context = utils::ze::GetContext(driver);
+
+  ze_event_pool_desc_t pool_desc = {
+      .stype = ZE_STRUCTURE_TYPE_EVENT_POOL_DESC,
+      .pNext = nullptr,
+      .flags = ZE_EVENT_POOL_FLAG_HOST_VISIBLE,
+      .count = 1
+  };
+
+  ze_event_pool_handle_t pool;
+  rc = zeEventPoolCreate(context, &pool_desc, 1, &device, &pool);
+  if (rc != ZE_RESULT_SUCCESS) {
+      printf("zeEventPoolCreate rc=%d\n", rc);
+      return -1;
+  }
+
+  ze_event_desc_t ev_desc = {
+      .stype = ZE_STRUCTURE_TYPE_EVENT_DESC,
+      .pNext = nullptr,
+      .index = 0,
+      .signal = ZE_EVENT_SCOPE_FLAG_HOST,
+      .wait = ZE_EVENT_SCOPE_FLAG_HOST,
+  };
+
+  ze_event_handle_t ev;
+  rc = zeEventCreate(pool, &ev_desc, &ev);
+  if (rc != ZE_RESULT_SUCCESS) {
+      printf("zeEventCreate rc=%d\n", rc);
+      return -1;
+  }
+
+  rc = zeEventHostSignal(ev);
+  if (rc != ZE_RESULT_SUCCESS) {
+      printf("zeEventHostSignal rc=%d\n", rc);
+      return -1;
+  }
+
+  // Not needed for device activities
+  double device_props = MeasureCall(iters, [device]() {
+    ze_device_properties_t props{ZE_STRUCTURE_TYPE_DEVICE_PROPERTIES, };
+    zeDeviceGetProperties(device, &props);
+  });
+
+  double context_status = MeasureCall(iters, [context]() {
+    zeContextGetStatus(context);
+  });
+
+  // Synchronization point device activities are collected at
+  double event_status = MeasureCall(iters, [ev]() {
+    zeEventQueryStatus(ev);
+  });
+
+  printf("%-24s %10.1f ns/call\n", "zeDeviceGetProperties", device_props);
+  printf("%-24s %10.1f ns/call\n", "zeContextGetStatus", context_status);
+  printf("%-24s %10.1f ns/call\n", "zeEventQueryStatus", event_status);
+
+  zeEventDestroy(ev);
+  zeEventPoolDestroy(pool);
+  zeContextDestroy(context);
+
+  return 0;
+}
@@ -0,0 +1,164 @@
+//==============================================================
+// Copyright (C) Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+// =============================================================
+
+// Tests of the live event stream with an in-process consumer. No GPU is required.
+
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "event_stream.h"
+
+static constexpr int kThreads = 4;
+static constexpr int kEvents = 20000;
+static constexpr int kNames = 37;
+
+static std::string GetName(int thread, int event) {
+  return "zeCommandListAppendLaunchKernel_" + std::to_string((thread * 7 + event) % kNames);
+}
+
+struct ConsumerResult {
+  uint64_t received_ = 0;
+  uint64_t dropped_ = 0;
+  bool valid_ = true;
+  std::string process_name_;
+};
+
+// Accepts one connection and checks every event received against the name it is sent with
+static void Consume(int listen_fd, int delay_ms, ConsumerResult& result) {
+  int fd = accept(listen_fd, nullptr, nullptr);
+  if (fd < 0) {
+    result.valid_ = false;
+    return;
+  }
+  // a slow consumer lets the producer queue fill up
+  std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
+  EventStreamDecoder decoder;
+  std::vector<uint64_t> next(kThreads, 0);
+  char buffer[4096];
+  while (true) {
+    ssize_t size = recv(fd, buffer, sizeof(buffer), 0);
+    if (size <= 0) {
+      break;
+    }
+    bool valid = decoder.Feed(buffer, size, [&](uint32_t pid, const EventStreamRecord& rec, const std::string& name) {
+      int thread = rec.tid_;
+      int event = static_cast<int>(rec.id_);
+      if (pid != static_cast<uint32_t>(getpid()) || thread < 0 || thread >= kThreads || name != GetName(thread, event) ||
+          rec.start_ != static_cast<uint64_t>(event) * 1000 || rec.dur_ != static_cast<uint64_t>(thread + 1) ||
+          rec.id_ < next[thread]) {
+        result.valid_ = false;
+      }
+      next[thread] = rec.id_ + 1;   // events of a thread arrive in order, dropped ones leave gaps
+      result.received_++;
+    });
+    if (!valid) {
+      result.valid_ = false;
+      break;
+    }
+  }
+  result.dropped_ = decoder.GetDroppedCount();
+  result.process_name_ = decoder.GetProcessName();
+  close(fd);
+}
+
+static void Produce(EventStreamer* streamer) {
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; t++) {
+    threads.emplace_back([streamer, t]() {
+      for (int i = 0; i < kEvents; i++) {
+        EventStreamRecord rec;
+        rec.start_ = static_cast<uint64_t>(i) * 1000;
+        rec.dur_ = t + 1;
+        rec.id_ = i;
+        rec.tid_ = t;
+        rec.kind_ = EVENT_STREAM_HOST;
+        rec.ph_ = 'X';
+        rec.tile_ = -1;
+        rec.engine_ = 0;
+        streamer->Add(rec, GetName(t, i));
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+}
+
+static bool RunTest(const std::string& path, EventStreamDropPolicy policy, int delay_ms, const char* test_name) {
+  std::string address = "unix:" + path;
+  sockaddr_storage addr;
+  socklen_t len;
+  ParseEventStreamAddress(address, addr, len);
+  unlink(path.c_str());
+  int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listen_fd < 0 || bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), len) != 0 || listen(listen_fd, 1) != 0) {
+    std::cerr << "[ERROR] Failed to listen on " << path << std::endl;
+    return false;
+  }
+
+  ConsumerResult result;
+  std::thread consumer(Consume, listen_fd, delay_ms, std::ref(result));
+  // small batches and a short queue to exercise the drop policies
+  EventStreamer* streamer = EventStreamer::Create(address, policy, "event_stream_test", 64, 4);
+  bool passed = (streamer != nullptr);
+  uint64_t dropped = 0;
+  if (streamer != nullptr) {
+    Produce(streamer);
+    dropped = streamer->GetDroppedCount();
+    delete streamer;   // sends the remaining batches and closes the connection
+  }
+  consumer.join();
+  close(listen_fd);
+  unlink(path.c_str());
+
+  uint64_t sent = static_cast<uint64_t>(kThreads) * kEvents;
+  if (!result.valid_ || result.process_name_ != "event_stream_test") {
+    std::cerr << "[ERROR] " << test_name << ": unexpected events received" << std::endl;
+    passed = false;
+  }
+  if (result.received_ + dropped != sent || result.dropped_ != dropped) {
+    std::cerr << "[ERROR] " << test_name << ": " << result.received_ << " events received and " << dropped <<
+      " (" << result.dropped_ << " reported) dropped out of " << sent << std::endl;
+    passed = false;
+  }
+  if (policy == EVENT_STREAM_BLOCK && dropped != 0) {
+    std::cerr << "[ERROR] " << test_name << ": events are dropped in blocking mode" << std::endl;
+    passed = false;
+  }
+  if (policy != EVENT_STREAM_BLOCK && dropped == 0) {
+    std::cerr << "[ERROR] " << test_name << ": slow consumer does not cause any drop" << std::endl;
+    passed = false;
+  }
+  std::cout << (passed ? "[PASSED] " : "[FAILED] ") << test_name << " (" << result.received_ << " received, " <<
+    dropped << " dropped)" << std::endl;
+  return passed;
+}
+
+int main() {
+  char pattern[] = "/tmp/event_stream_test.XXXXXX";
+  char* dir = mkdtemp(pattern);
+  if (dir == nullptr) {
+    std::cerr << "[ERROR] Failed to create temporary directory" << std::endl;
+    return -1;
+  }
+  std::string path = std::string(dir) + "/stream.sock";
+
+  bool passed = true;
+  passed = RunTest(path, EVENT_STREAM_BLOCK, 200, "block") && passed;
+  passed = RunTest(path, EVENT_STREAM_DROP_NEWEST, 500, "drop-newest") && passed;
+  passed = RunTest(path, EVENT_STREAM_DROP_OLDEST, 500, "drop-oldest") && passed;
+  rmdir(dir);
+
+  std::cout << (passed ? "[PASSED]" : "[FAILED]") << " event_stream_test" << std::endl;
+  return passed ? 0 : 1;
+}
@@ -0,0 +1,212 @@
+//==============================================================
+// Copyright (C) Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+// =============================================================
+
+// Tests of the shared memory transport between application processes and the launcher.
+// No GPU is required.
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "shm_transport.h"
+
+static constexpr int kProcesses = 4;
+static constexpr int kThreads = 4;
+static constexpr int kLines = 20000;
+
+static std::string GetLine(int process, int thread, int line) {
+  return "{\"ph\": \"X\", \"pid\": " + std::to_string(process) + ", \"tid\": " + std::to_string(thread) +
+    ", \"name\": \"kernel_" + std::to_string(line % 17) + "\", \"id\": " + std::to_string(line) + "}\n";
+}
+
+static std::string GetFileName(const std::string& dir, int process, const char* suffix) {
+  return dir + "/out." + std::to_string(process) + suffix;
+}
+
+// Body of an application process
+static void Produce(const std::string& registry, const std::string& dir, int process) {
+  auto producer = ShmRingProducer::Create(registry);
+  if (producer == nullptr) {
+    std::_Exit(2);
+  }
+  {
+    Logger trace(GetFileName(dir, process, ".json"),
+      std::make_unique<ShmRingSink>(producer, GetFileName(dir, process, ".json")), true);
+    Logger empty(GetFileName(dir, process, ".empty"),
+      std::make_unique<ShmRingSink>(producer, GetFileName(dir, process, ".empty")), true);
+    trace.Log("{ \"traceEvents\":[\n");
+    trace.SetEmptyPosition();
+    empty.Log("header\n");
+    empty.SetEmptyPosition();
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; t++) {
+      threads.emplace_back([&trace, process, t]() {
+        for (int i = 0; i < kLines; i++) {
+          trace.Log(GetLine(process, t, i));
+          if (i % 1000 == 0) {
+            trace.Flush();
+          }
+        }
+      });
+    }
+    for (auto& t : threads) {
+      t.join();
+    }
+    // a text larger than the ring
+    trace.Log(std::string(300 * 1024, 'x') + "\n");
+  }
+  producer.reset();
+  std::_Exit(0);
+}
+
+static bool Check(const std::string& dir, int process) {
+  std::ifstream in(GetFileName(dir, process, ".json"));
+  if (!in.is_open()) {
+    std::cerr << "[ERROR] Output of process " << process << " is missing" << std::endl;
+    return false;
+  }
+  std::string line;
+  std::getline(in, line);
+  if (line != "{ \"traceEvents\":[") {
+    std::cerr << "[ERROR] Output of process " << process << " has wrong header" << std::endl;
+    return false;
+  }
+  std::vector<int> next(kThreads, 0);
+  while (std::getline(in, line)) {
+    if (line[0] == 'x') {
+      if (line.size() != 300 * 1024) {
+        std::cerr << "[ERROR] Large record of process " << process << " is corrupted" << std::endl;
+        return false;
+      }
+      continue;
+    }
+    int thread = line[line.find("\"tid\": ") + 7] - '0';
+    // lines of each thread are in order, lines of different threads are interleaved
+    if (thread < 0 || thread >= kThreads || line + "\n" != GetLine(process, thread, next[thread])) {
+      std::cerr << "[ERROR] Unexpected line in output of process " << process << ": " << line << std::endl;
+      return false;
+    }
+    next[thread]++;
+  }
+  for (int t = 0; t < kThreads; t++) {
+    if (next[t] != kLines) {
+      std::cerr << "[ERROR] " << (kLines - next[t]) << " lines of process " << process << " thread " << t << " are lost" << std::endl;
+      return false;
+    }
+  }
+  if (std::ifstream(GetFileName(dir, process, ".empty")).is_open()) {
+    std::cerr << "[ERROR] Empty output of process " << process << " is not removed" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// Flush records are rate limited, the launcher flushes the rest once the rings are drained, so a
+// file flushed after every record is complete on disk while it is still open
+static bool TestFlushedOutput(const std::string& dir) {
+  ShmTransportDrainer* drainer = ShmTransportDrainer::Create(getpid(), kShmRingMinSize);
+  if (drainer == nullptr) {
+    std::cerr << "[ERROR] Failed to create shared memory transport" << std::endl;
+    return false;
+  }
+  drainer->Start();
+  auto producer = ShmRingProducer::Create(drainer->GetRegistryName());
+  if (producer == nullptr) {
+    std::cerr << "[ERROR] Failed to create shared memory producer" << std::endl;
+    delete drainer;
+    return false;
+  }
+
+  std::string filename = GetFileName(dir, 0, ".flushed");
+  bool passed = true;
+  {
+    Logger log(filename, std::make_unique<ShmRingSink>(producer, filename), false);
+    size_t size = 0;
+    for (int i = 0; i < 1000; i++) {
+      std::string line = GetLine(0, 0, i);
+      log.Log(line);
+      size += line.size();
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    size_t written = 0;
+    while (std::chrono::steady_clock::now() < deadline) {
+      std::ifstream in(filename, std::ios::binary | std::ios::ate);
+      written = in.is_open() ? static_cast<size_t>(in.tellg()) : 0;
+      if (written == size) {
+        break;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    if (written != size) {
+      std::cerr << "[ERROR] " << written << " bytes of " << size << " are flushed" << std::endl;
+      passed = false;
+    }
+  }
+  producer.reset();
+  delete drainer;
+  std::remove(filename.c_str());
+  return passed;
+}
+
+int main() {
+  char pattern[] = "/tmp/shm_transport_test.XXXXXX";
+  char* dir = mkdtemp(pattern);
+  if (dir == nullptr) {
+    std::cerr << "[ERROR] Failed to create temporary directory" << std::endl;
+    return -1;
+  }
+
+  // a small ring so that records wrap around and producers wait for the consumer
+  ShmTransportDrainer* drainer = ShmTransportDrainer::Create(getpid(), kShmRingMinSize);
+  if (drainer == nullptr) {
+    std::cerr << "[ERROR] Failed to create shared memory transport" << std::endl;
+    return -1;
+  }
+  std::string registry = drainer->GetRegistryName();
+
+  for (int p = 0; p < kProcesses; p++) {
+    pid_t child = fork();
+    if (child == 0) {
+      Produce(registry, dir, p);
+    } else if (child < 0) {
+      std::cerr << "[ERROR] Failed to create child process" << std::endl;
+      return -1;
+    }
+  }
+  drainer->Start();
+
+  int status;
+  bool passed = true;
+  while (wait(&status) > 0) {
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+      std::cerr << "[ERROR] Child process failed" << std::endl;
+      passed = false;
+    }
+  }
+  delete drainer;
+
+  for (int p = 0; p < kProcesses; p++) {
+    passed = Check(dir, p) && passed;
+    std::remove(GetFileName(dir, p, ".json").c_str());
+    std::remove(GetFileName(dir, p, ".empty").c_str());
+  }
+  passed = TestFlushedOutput(dir) && passed;
+  rmdir(dir);
+
+  std::cout << (passed ? "[PASSED]" : "[FAILED]") << " shm_transport_test" << std::endl;
+  return passed ? 0 : 1;
+}
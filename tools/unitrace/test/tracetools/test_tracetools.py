@@ -0,0 +1,187 @@
+#!/usr/bin/env python3
+# ==============================================================
+# Copyright (C) Intel Corporation
+#
+# SPDX-License-Identifier: MIT
+# =============================================================
+
+# Tests of the native trace tools (unitrace_index, unitrace_query, unitrace_merge) on synthetic traces.
+# No GPU is required.
+
+import argparse
+import json
+import os
+import random
+import shutil
+import subprocess
+import sys
+import tempfile
+
+KERNELS = ['gemm', 'vec_add', 'zeCommandListAppendLaunchKernel',
+           'typeinfo name for main::{lambda(sycl::_V1::handler&)#1}::operator()(sycl::_V1::handler&) const::{lambda(sycl::_V1::nd_item<2>)#1}[SIMD32 {1024; 1; 1} {256; 1; 1}]']
+
+def generate_trace(path, pid, events, seed, start = 1729012345678901.0, truncate = False):
+    rnd = random.Random(seed)
+    generated = []
+    with open(path, 'w') as fp:
+        # same framing as ChromeLogger
+        fp.write('{ "traceEvents":[\n')
+        fp.write('{"ph": "M", "name": "process_name", "pid": ' + str(pid) + ', "ts": ' + '%.6f' % start +
+                 ', "args": {"name": "RANK 0 HOST<node>"}}')
+        for i in range(events):
+            tid = pid + rnd.randint(0, 3)
+            ts = start + rnd.randint(0, 1000000) + rnd.randint(0, 999) / 1000.0
+            dur = rnd.randint(1, 5000) + rnd.randint(0, 999) / 1000.0
+            name = rnd.choice(KERNELS)
+            cat = 'gpu_op' if i % 2 else 'cpu_op'
+            fp.write(',\n{"ph": "X", "tid": %d, "pid": %d, "name": "%s", "cat": "%s", "ts": %.6f, "dur": %.6f, '
+                     '"args": {"id": "%d", "name": "shadow"}}' % (tid, pid, name, cat, ts, dur, i))
+            generated.append({'tid': tid, 'pid': pid, 'name': name, 'ts': ts, 'dur': dur, 'id': str(i)})
+        if not truncate:
+            fp.write('\n]\n}\n')
+    return generated
+
+def run(args, **kwargs):
+    result = subprocess.run(args, stdout = subprocess.PIPE, stderr = subprocess.PIPE, universal_newlines = True, **kwargs)
+    if result.returncode != 0:
+        print(result.stdout)
+        print(result.stderr)
+        raise RuntimeError('Command failed: ' + ' '.join(args))
+    return result.stdout
+
+def ids(events):
+    return sorted(int(e['args']['id']) for e in events if e['ph'] != 'M')
+
+def ref_ids(events, pred):
+    return sorted(int(e['id']) for e in events if pred(e))
+
+def test_query(bin_dir, work_dir):
+    trace = os.path.join(work_dir, 'app.1000.json')
+    events = generate_trace(trace, 1000, 20000, 1)
+    run([os.path.join(bin_dir, 'unitrace_index'), '-w', '100', trace])
+    query = os.path.join(bin_dir, 'unitrace_query')
+
+    # time range, overlapping events included
+    t0 = 1729012345678901.0 + 250000.5
+    t1 = t0 + 1000.25
+    out = json.loads(run([query, '--from', '%.6f' % t0, '--to', '%.6f' % t1, trace]))
+    expected = ref_ids(events, lambda e: e['ts'] <= t1 + 1e-4 and e['ts'] + e['dur'] >= t0 - 1e-4)
+    assert ids(out['traceEvents']) == expected, 'time range query mismatch'
+    assert any(e['ph'] == 'M' for e in out['traceEvents']), 'process name is missing'
+
+    # open time ranges
+    out = json.loads(run([query, '--to', '%.6f' % t1, trace]))
+    expected = ref_ids(events, lambda e: e['ts'] <= t1 + 1e-4)
+    assert ids(out['traceEvents']) == expected, 'time range query without lower bound mismatch'
+    out = json.loads(run([query, '--from', '%.6f' % t0, trace]))
+    expected = ref_ids(events, lambda e: e['ts'] + e['dur'] >= t0 - 1e-4)
+    assert ids(out['traceEvents']) == expected, 'time range query without upper bound mismatch'
+
+    # relative time range
+    first = min(e['ts'] for e in events)
+    out = json.loads(run([query, '--relative', '--from', '0', '--to', '10', trace]))
+    expected = ref_ids(events, lambda e: e['ts'] <= first + 10 + 1e-4)
+    assert ids(out['traceEvents']) == expected, 'relative time range query mismatch'
+
+    # kernel instances
+    out = json.loads(run([query, '--name', 'gemm', trace]))
+    assert ids(out['traceEvents']) == ref_ids(events, lambda e: e['name'] == 'gemm'), 'name query mismatch'
+
+    out = json.loads(run([query, '--name-contains', 'SIMD32', '--from', '%.6f' % t0, '--to', '%.6f' % (t0 + 100000), trace]))
+    expected = ref_ids(events, lambda e: 'SIMD32' in e['name'] and e['ts'] <= t0 + 100000 + 1e-4 and e['ts'] + e['dur'] >= t0 - 1e-4)
+    assert ids(out['traceEvents']) == expected, 'substring name query mismatch'
+
+    # threads
+    out = json.loads(run([query, '--tid', '1002', trace]))
+    assert ids(out['traceEvents']) == ref_ids(events, lambda e: e['tid'] == 1002), 'thread query mismatch'
+
+    # csv
+    csv = run([query, '--csv', '--limit', '10', trace]).splitlines()
+    assert len(csv) == 11 and csv[0] == 'ts,dur,pid,tid,name', 'csv output mismatch'
+
+    names = run([query, '--list-names', trace]).splitlines()
+    counts = {line.split('\t', 1)[1]: int(line.split('\t', 1)[0]) for line in names}
+    for k in KERNELS:
+        assert counts.get(k, 0) == len([e for e in events if e['name'] == k]), 'name count mismatch'
+
+    # truncated traces (closing tags missing) are still indexed, stale indices are rejected
+    truncated = os.path.join(work_dir, 'app.1001.json')
+    events = generate_trace(truncated, 1001, 1000, 2, truncate = True)
+    out = json.loads(run([query, truncated]))
+    assert ids(out['traceEvents']) == ref_ids(events, lambda e: True), 'truncated trace query mismatch'
+    with open(truncated, 'a') as fp:
+        fp.write('\n]\n}\n')
+    result = subprocess.run([query, truncated], stdout = subprocess.PIPE, stderr = subprocess.PIPE)
+    assert result.returncode != 0, 'stale index is not detected'
+
+def test_merge(bin_dir, work_dir):
+    merge = os.path.join(bin_dir, 'unitrace_merge')
+    traces = []
+    generated = []
+    for rank in range(3):
+        trace = os.path.join(work_dir, 'rank%d.json' % rank)
+        # ranks 0 and 1 run on different nodes with the same pid
+        generated.append(generate_trace(trace, 2000 if rank < 2 else 3000, 5000, 10 + rank, truncate = (rank == 2)))
+        traces.append(trace)
+
+    def check_merged(merged, offsets):
+        with open(merged) as fp:
+            out = json.load(fp)['traceEvents']
+        events = [e for e in out if e['ph'] != 'M']
+        assert len(events) == sum(len(g) for g in generated), 'merged event count mismatch'
+        assert all(events[i]['ts'] <= events[i + 1]['ts'] for i in range(len(events) - 1)), 'merged events are not ordered'
+        pids = set(e['pid'] for e in out if e['ph'] == 'M')
+        assert len(pids) == 3, 'colliding pids are not remapped'
+
+        for rank in range(3):
+            pid_events = {}
+            for e in generated[rank]:
+                pid_events[e['id']] = e['ts'] + offsets[rank]
+            remapped = [e for e in events if e['name'] != 'process_name' and e['pid'] == [e2['pid'] for e2 in out if e2['ph'] == 'M'][rank]]
+            assert len(remapped) == len(generated[rank]), 'remapped pid event count mismatch'
+            for e in remapped:
+                assert abs(e['ts'] - pid_events[e['args']['id']]) < 2e-3, 'clock offset is not applied'
+
+    merged = os.path.join(work_dir, 'merged.json')
+    run([merge, '--batch', '100', '--offsets', '0,-1000.5,2000', '-o', merged] + traces)
+    check_merged(merged, [0, -1000.5, 2000])
+
+    # a skipped input does not shift the offsets of the inputs after it
+    missing = os.path.join(work_dir, 'missing.json')
+    merged = os.path.join(work_dir, 'merged_skipped.json')
+    run([merge, '--offsets', '0,500,-1000.5,2000', '-o', merged, traces[0], missing, traces[1], traces[2]])
+    check_merged(merged, [0, -1000.5, 2000])
+
+    # time slices
+    sliced = os.path.join(work_dir, 'sliced.json')
+    run([merge, '--slice', '100000', '-o', sliced] + traces)
+    total = 0
+    for name in sorted(os.listdir(work_dir)):
+        if name.startswith('sliced.') and name.endswith('.json'):
+            with open(os.path.join(work_dir, name)) as fp:
+                data = json.load(fp)['traceEvents']
+            slice_events = [e for e in data if e['ph'] != 'M']
+            assert len(data) > len(slice_events), 'slice has no metadata'
+            assert max(e['ts'] for e in slice_events) - min(e['ts'] for e in slice_events) < 100000, 'slice is too long'
+            total += len(slice_events)
+    assert total == sum(len(g) for g in generated), 'sliced event count mismatch'
+
+def main():
+    parser = argparse.ArgumentParser(description = 'Test native trace tools')
+    parser.add_argument('--bin-dir', required = True, help = 'directory of unitrace_index, unitrace_query and unitrace_merge')
+    args = parser.parse_args()
+
+    work_dir = tempfile.mkdtemp(prefix = 'unitrace_tracetools_')
+    try:
+        for test in [test_query, test_merge]:
+            test(args.bin_dir, work_dir)
+            print('[PASSED] ' + test.__name__)
+    except Exception as ex:
+        print('[FAILED] ' + str(ex))
+        return 1
+    finally:
+        shutil.rmtree(work_dir, ignore_errors = True)
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(main())
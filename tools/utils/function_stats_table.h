@@ -0,0 +1,101 @@
+//==============================================================
+// Copyright (C) Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+// =============================================================
+
+#ifndef PTI_TOOLS_UTILS_FUNCTION_STATS_TABLE_H_
+#define PTI_TOOLS_UTILS_FUNCTION_STATS_TABLE_H_
+
+#include <stdint.h>
+
+#include <array>
+#include <map>
+#include <mutex>
+#include <string>
+
+#include "pti_assert.h"
+#include "thread_tables.h"
+
+// Host timing statistics of API functions, indexed by function id.
+// Every thread adds call times to its own flat array, so the hot path takes
+// only a lock nobody else holds unless a report is being built. Arrays are
+// merged and function names are turned into strings only at report time.
+// Function must be an aggregate of total_time, min_time, max_time and
+// call_count, e.g. ClFunction or ZeFunction.
+template <typename Function, uint32_t FunctionCount>
+class FunctionStatsTable {
+ public:
+  FunctionStatsTable() = default;
+
+  FunctionStatsTable(const FunctionStatsTable& copy) = delete;
+  FunctionStatsTable& operator=(const FunctionStatsTable& copy) = delete;
+
+  // name must stay valid while the table exists, e.g. a string literal
+  void AddFunctionTime(uint32_t function, const char* name, uint64_t time) {
+    PTI_ASSERT(function < FunctionCount);
+    ThreadTable* table = tables_.Get();
+    const std::lock_guard<std::mutex> lock(table->lock_);
+    Entry& entry = table->entries[function];
+    if (entry.function.call_count == 0) {
+      entry.name = name;
+      entry.function = {time, time, time, 1};
+    } else {
+      Add(entry.function, time);
+    }
+  }
+
+  // Merges tables of all threads into the map, keyed by function name
+  void Merge(std::map<std::string, Function>& function_info_map) const {
+    tables_.ForEach([&function_info_map](const ThreadTable& table) {
+      for (const Entry& entry : table.entries) {
+        if (entry.function.call_count == 0) {
+          continue;
+        }
+        auto it = function_info_map.find(entry.name);
+        if (it == function_info_map.end()) {
+          function_info_map.emplace(entry.name, entry.function);
+        } else {
+          Merge(it->second, entry.function);
+        }
+      }
+    });
+  }
+
+  static void Add(Function& function, uint64_t time) {
+    function.total_time += time;
+    if (time < function.min_time) {
+      function.min_time = time;
+    }
+    if (time > function.max_time) {
+      function.max_time = time;
+    }
+    ++function.call_count;
+  }
+
+  static void Merge(Function& function, const Function& other) {
+    function.total_time += other.total_time;
+    if (other.min_time < function.min_time) {
+      function.min_time = other.min_time;
+    }
+    if (other.max_time > function.max_time) {
+      function.max_time = other.max_time;
+    }
+    function.call_count += other.call_count;
+  }
+
+ private:
+  struct Entry {
+    const char* name = nullptr;
+    Function function = {0, 0, 0, 0};
+  };
+
+  struct ThreadTable {
+    std::mutex lock_;
+    std::array<Entry, FunctionCount> entries;
+  };
+
+  utils::ThreadTables<ThreadTable> tables_;
+};
+
+#endif // PTI_TOOLS_UTILS_FUNCTION_STATS_TABLE_H_
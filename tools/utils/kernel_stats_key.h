@@ -0,0 +1,145 @@
+//==============================================================
+// Copyright (C) Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+// =============================================================
+
+#ifndef PTI_TOOLS_UTILS_KERNEL_STATS_KEY_H_
+#define PTI_TOOLS_UTILS_KERNEL_STATS_KEY_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "demangle.h"
+#include "pti_assert.h"
+
+// Launch configuration kernel statistics are aggregated on. Kernel names are
+// interned into ids, so keys are hashed and compared without touching
+// strings. Sizes are left zero unless verbose names are requested.
+struct KernelStatsKey {
+  uint32_t name_id = 0;
+  uint32_t simd_width = 0;
+  uint64_t bytes_transferred = 0;
+  uint64_t global_size[3] = {0, 0, 0};
+  uint64_t local_size[3] = {0, 0, 0};
+  int32_t tile = -1;
+
+  bool operator==(const KernelStatsKey& r) const {
+    return name_id == r.name_id && simd_width == r.simd_width &&
+      bytes_transferred == r.bytes_transferred &&
+      global_size[0] == r.global_size[0] &&
+      global_size[1] == r.global_size[1] &&
+      global_size[2] == r.global_size[2] &&
+      local_size[0] == r.local_size[0] &&
+      local_size[1] == r.local_size[1] &&
+      local_size[2] == r.local_size[2] &&
+      tile == r.tile;
+  }
+};
+
+struct KernelStatsKeyHash {
+  size_t operator()(const KernelStatsKey& key) const {
+    uint64_t hash = 14695981039346656037ULL;
+    auto combine = [&hash](uint64_t value) {
+      hash ^= value;
+      hash *= 1099511628211ULL;
+    };
+    combine((static_cast<uint64_t>(key.name_id) << 32) | key.simd_width);
+    combine(key.bytes_transferred);
+    for (int i = 0; i < 3; ++i) {
+      combine(key.global_size[i]);
+      combine(key.local_size[i]);
+    }
+    combine(static_cast<uint32_t>(key.tile));
+    return static_cast<size_t>(hash);
+  }
+};
+
+// Interns kernel names and turns keys into the names shown in reports,
+// e.g. "name[SIMD32 {1024; 1; 1} {32; 1; 1}](0T)" or "name[64 bytes]".
+// Not thread-safe, callers hold the lock of their collector.
+class KernelStatsNames {
+ public:
+  explicit KernelStatsNames(const char* bytes_suffix = " bytes")
+      : bytes_suffix_(bytes_suffix) {}
+  KernelStatsNames(const KernelStatsNames& copy) = delete;
+  KernelStatsNames& operator=(const KernelStatsNames& copy) = delete;
+
+  uint32_t GetId(const std::string& name) {
+    auto it = ids_.find(name);
+    if (it != ids_.end()) {
+      return it->second;
+    }
+    uint32_t id = static_cast<uint32_t>(names_.size());
+    names_.push_back(name);
+    ids_.emplace(name, id);
+    return id;
+  }
+
+  const std::string& GetName(uint32_t id) const {
+    PTI_ASSERT(id < names_.size());
+    return names_[id];
+  }
+
+  // Formats the name, call once per key, e.g. while building a report.
+  // The kernel name itself is shortened to max_name_length characters if it
+  // is not 0, the launch configuration is kept
+  std::string Format(const KernelStatsKey& key, bool verbose,
+                     size_t max_name_length = 0) const {
+    std::string name = (max_name_length == 0) ?
+      GetName(key.name_id) :
+      utils::ShortenName(GetName(key.name_id), max_name_length);
+    PTI_ASSERT(!name.empty());
+
+    if (verbose) {
+      if (key.simd_width > 0) {
+        name += "[SIMD";
+        if (key.simd_width == 1) {
+          name += "_ANY";
+        } else {
+          name += std::to_string(key.simd_width);
+        }
+        name += " {" +
+          std::to_string(key.global_size[0]) + "; " +
+          std::to_string(key.global_size[1]) + "; " +
+          std::to_string(key.global_size[2]) + "} {" +
+          std::to_string(key.local_size[0]) + "; " +
+          std::to_string(key.local_size[1]) + "; " +
+          std::to_string(key.local_size[2]) + "}]";
+      } else if (key.bytes_transferred > 0) {
+        name += "[" + std::to_string(key.bytes_transferred) +
+          bytes_suffix_ + "]";
+      }
+    }
+
+    if (key.tile >= 0) {
+      name += "(" + std::to_string(key.tile) + "T)";
+    }
+
+    return name;
+  }
+
+  // Name of the key formatted on the first request only, for the paths
+  // that need a name per kernel instance, e.g. trace callbacks
+  const std::string& Get(const KernelStatsKey& key, bool verbose) {
+    auto it = formatted_.find(key);
+    if (it == formatted_.end()) {
+      it = formatted_.emplace(key, Format(key, verbose)).first;
+    }
+    return it->second;
+  }
+
+ private:
+  const char* bytes_suffix_;
+  std::unordered_map<std::string, uint32_t> ids_;
+  std::vector<std::string> names_;
+  std::unordered_map<
+      KernelStatsKey, std::string, KernelStatsKeyHash> formatted_;
+};
+
+#endif // PTI_TOOLS_UTILS_KERNEL_STATS_KEY_H_
@@ -9,13 +9,31 @@
 
 #include <iostream>
 #include <fstream>
+#include <memory>
 #include <mutex>
 #include <string>
 
 #include "pti_assert.h"
 
+// Destination of a Logger other than a local file, e.g. a transport to another process that
+// owns the file. Calls are serialized by the Logger unless it is lock free.
+class LogSink {
+ public:
+  virtual ~LogSink() = default;
+  virtual void Write(const std::string& text) = 0;
+  virtual void Flush() = 0;
+  // Called once when the Logger is destroyed. empty is true if nothing was logged after
+  // the empty position, in which case the destination file is not expected to be kept.
+  virtual void Close(bool empty) = 0;
+};
+
 class Logger {
  public:
+  Logger(const std::string& filename, std::unique_ptr<LogSink> sink, bool lazy_flush = false, bool lock_free = false)
+    : log_file_name_(filename), sink_(std::move(sink)), lazy_flush_(lazy_flush), lock_free_(lock_free) {
+    PTI_ASSERT(sink_ != nullptr);
+  }
+
   Logger(const std::string& filename, bool lazy_flush = false, bool lock_free = false) {
     if (!filename.empty()) {
       file_.open(filename);
@@ -32,7 +50,11 @@ class Logger {
   Logger(const Logger& that) = delete;
 
   ~Logger() {
-    if (file_.is_open()) {
+    if (sink_ != nullptr) {
+      sink_->Close(IsEmpty());
+      sink_.reset();
+    }
+    else if (file_.is_open()) {
       // Only flush and close if something was written
       if (IsEmpty()) {
         // If the file is empty, we can just close it without flushing
@@ -48,7 +70,15 @@ class Logger {
   }
 
   void Log(const std::string& text) {
-    if (file_.is_open()) {
+    if (sink_ != nullptr) {
+      if (lock_free_) {
+        LogToSink(text);
+      }
+      else {
+        const std::lock_guard<std::mutex> lock(lock_);
+        LogToSink(text);
+      }
+    } else if (file_.is_open()) {
       if (lock_free_) {
         file_ << text;
         if (!lazy_flush_) {
@@ -71,7 +101,15 @@ class Logger {
   }
 
   void Flush() {
-    if (file_.is_open()) {
+    if (sink_ != nullptr) {
+      if (lock_free_) {
+        sink_->Flush();
+      }
+      else {
+        const std::lock_guard<std::mutex> lock(lock_);
+        sink_->Flush();
+      }
+    } else if (file_.is_open()) {
       if (lock_free_) {
         file_ << std::flush;
       }
@@ -89,16 +127,25 @@ class Logger {
   }
 
   std::iostream::pos_type GetLogFilePosition() {
+    if (sink_ != nullptr) {
+      return sink_pos_;
+    }
     return file_.tellp();
   }
 
   void SetEmptyPosition() {
-    if (file_.is_open()) {
+    if (sink_ != nullptr) {
+      empty_pos_ = sink_pos_;
+    }
+    else if (file_.is_open()) {
       empty_pos_ = file_.tellp();
     }
   }
 
   bool IsEmpty() {
+    if (sink_ != nullptr) {
+      return sink_pos_ == empty_pos_;
+    }
     if (file_.is_open()) {
       return file_.tellp() == empty_pos_;
     }
@@ -107,13 +154,23 @@ class Logger {
 
   // Returns true if logging to file, false if logging to screen
   bool IsLogToFile() const {
-    return file_.is_open();
+    return (sink_ != nullptr) || file_.is_open();
   }
 
  private:
+  void LogToSink(const std::string& text) {
+    sink_->Write(text);
+    sink_pos_ += text.size();
+    if (!lazy_flush_) {
+      sink_->Flush();
+    }
+  }
+
   std::string log_file_name_;
   std::mutex lock_;
   std::ofstream file_;
+  std::unique_ptr<LogSink> sink_;
+  std::streamoff sink_pos_ = 0;    // bytes logged to the sink
   std::iostream::pos_type empty_pos_ = 0;
   bool lazy_flush_;
   bool lock_free_;	// caller deal with concurrency?
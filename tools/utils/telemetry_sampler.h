@@ -0,0 +1,353 @@
+//==============================================================
+// Copyright (C) Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+// =============================================================
+
+#ifndef PTI_TOOLS_UTILS_TELEMETRY_SAMPLER_H_
+#define PTI_TOOLS_UTILS_TELEMETRY_SAMPLER_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <vector>
+
+#include "pti_assert.h"
+
+enum TelemetryEngine {
+  TELEMETRY_ENGINE_ALL,
+  TELEMETRY_ENGINE_COMPUTE,
+  TELEMETRY_ENGINE_RENDER,
+  TELEMETRY_ENGINE_MEDIA,
+  TELEMETRY_ENGINE_COPY,
+  TELEMETRY_ENGINE_COUNT
+};
+
+// Bits of TelemetrySample::valid, engines follow the fields
+enum TelemetryField {
+  TELEMETRY_FIELD_FREQUENCY,
+  TELEMETRY_FIELD_POWER,
+  TELEMETRY_FIELD_TEMPERATURE,
+  TELEMETRY_FIELD_READ_BANDWIDTH,
+  TELEMETRY_FIELD_WRITE_BANDWIDTH,
+  TELEMETRY_FIELD_UTILIZATION,
+  TELEMETRY_FIELD_COUNT = TELEMETRY_FIELD_UTILIZATION + TELEMETRY_ENGINE_COUNT
+};
+
+// Monotonic counter read together with its own timestamp (us)
+struct TelemetryCounter {
+  uint64_t value = 0;
+  uint64_t timestamp = 0;
+  bool valid = false;
+};
+
+// Raw device readings, gauges are negative if not available
+struct TelemetryReading {
+  double frequency = -1.0;  // MHz
+  double temperature = -1.0;  // C
+  TelemetryCounter energy;  // uJ
+  TelemetryCounter read_bytes;
+  TelemetryCounter write_bytes;
+  TelemetryCounter engine_active[TELEMETRY_ENGINE_COUNT];  // us
+  uint32_t engine_count[TELEMETRY_ENGINE_COUNT] = {0, };
+};
+
+// Source of device readings: Sysman in sysmon and unitrace, a stub in tests.
+// Read() is called once per device and sample, implementations are expected
+// to cache handles and properties so that it does no lookups.
+class TelemetryBackend {
+ public:
+  virtual ~TelemetryBackend() = default;
+  virtual uint32_t GetDeviceCount() const = 0;
+  virtual void Read(uint32_t device, TelemetryReading* reading) = 0;
+};
+
+// Binary record layout, written as is in native byte order after the
+// TelemetryFileHeader
+struct TelemetrySample {
+  uint64_t timestamp;  // ns since epoch
+  uint32_t device;
+  uint32_t valid;  // bit per TelemetryField
+  float frequency;  // MHz
+  float power;  // W
+  float temperature;  // C
+  float read_bandwidth;  // bytes/s
+  float write_bandwidth;  // bytes/s
+  float utilization[TELEMETRY_ENGINE_COUNT];  // 0..1
+
+  bool IsValid(uint32_t field) const {
+    return (valid & (1u << field)) != 0;
+  }
+};
+
+struct TelemetryFileHeader {
+  char magic[8];  // "PTISMON"
+  uint32_t version;
+  uint32_t record_size;
+};
+
+static_assert(TELEMETRY_FIELD_COUNT <= 32, "Too many telemetry fields");
+
+// Turns readings into samples and keeps the last samples of every device in
+// preallocated rings. Rates are computed from the previous reading of the
+// device only, no sampling step allocates.
+class TelemetrySampler {
+ public:
+  TelemetrySampler(TelemetryBackend* backend, uint32_t capacity)
+      : backend_(backend), capacity_(capacity) {
+    PTI_ASSERT(backend_ != nullptr);
+    PTI_ASSERT(capacity_ > 0);
+    uint32_t device_count = backend_->GetDeviceCount();
+    devices_.resize(device_count);
+    for (uint32_t i = 0; i < device_count; ++i) {
+      devices_[i].ring.resize(capacity_);
+    }
+  }
+
+  TelemetrySampler(const TelemetrySampler& copy) = delete;
+  TelemetrySampler& operator=(const TelemetrySampler& copy) = delete;
+
+  uint32_t GetDeviceCount() const {
+    return static_cast<uint32_t>(devices_.size());
+  }
+
+  // The first sample of a device has gauges only, rates need two readings
+  void Sample(uint64_t timestamp) {
+    for (uint32_t i = 0; i < devices_.size(); ++i) {
+      Device& device = devices_[i];
+      TelemetryReading& current = device.readings[device.current];
+      const TelemetryReading& previous = device.readings[device.current ^ 1];
+
+      current = TelemetryReading();
+      backend_->Read(i, &current);
+
+      TelemetrySample& sample = device.ring[device.head];
+      Compute(i, timestamp, current, device.has_previous ? &previous : nullptr,
+              &sample);
+
+      device.head = (device.head + 1) % capacity_;
+      if (device.size < capacity_) {
+        ++device.size;
+      }
+      if (device.pending < capacity_) {
+        ++device.pending;
+      }
+      device.current ^= 1;
+      device.has_previous = true;
+    }
+  }
+
+  // Number of samples of the device kept, the newest has index 0
+  uint32_t GetSampleCount(uint32_t device) const {
+    PTI_ASSERT(device < devices_.size());
+    return devices_[device].size;
+  }
+
+  const TelemetrySample& GetSample(uint32_t device, uint32_t index) const {
+    PTI_ASSERT(device < devices_.size());
+    const Device& data = devices_[device];
+    PTI_ASSERT(index < data.size);
+    return data.ring[(data.head + capacity_ - 1 - index) % capacity_];
+  }
+
+  uint32_t GetPendingCount() const {
+    uint32_t count = 0;
+    for (const Device& device : devices_) {
+      count += device.pending;
+    }
+    return count;
+  }
+
+  // Hands the samples not taken yet to f(sample), oldest first. Samples
+  // overwritten before they were taken are lost.
+  template <typename F>
+  void TakePending(F f) {
+    for (Device& device : devices_) {
+      uint32_t first = (device.head + capacity_ - device.pending) % capacity_;
+      for (uint32_t i = 0; i < device.pending; ++i) {
+        f(device.ring[(first + i) % capacity_]);
+      }
+      device.pending = 0;
+    }
+  }
+
+ private:
+  struct Device {
+    std::vector<TelemetrySample> ring;
+    uint32_t head = 0;
+    uint32_t size = 0;
+    uint32_t pending = 0;
+    TelemetryReading readings[2];
+    uint32_t current = 0;
+    bool has_previous = false;
+  };
+
+  // Rate of the counter per second, false if it is unknown or restarted
+  static bool GetRate(
+      const TelemetryCounter& current, const TelemetryCounter* previous,
+      double* rate) {
+    if (previous == nullptr || !current.valid || !previous->valid ||
+        current.timestamp <= previous->timestamp ||
+        current.value < previous->value) {
+      return false;
+    }
+    *rate = static_cast<double>(current.value - previous->value) * 1e6 /
+      static_cast<double>(current.timestamp - previous->timestamp);
+    return true;
+  }
+
+  static void Compute(
+      uint32_t device, uint64_t timestamp,
+      const TelemetryReading& current, const TelemetryReading* previous,
+      TelemetrySample* sample) {
+    memset(sample, 0, sizeof(TelemetrySample));
+    sample->timestamp = timestamp;
+    sample->device = device;
+
+    if (current.frequency >= 0) {
+      sample->frequency = static_cast<float>(current.frequency);
+      sample->valid |= 1u << TELEMETRY_FIELD_FREQUENCY;
+    }
+    if (current.temperature >= 0) {
+      sample->temperature = static_cast<float>(current.temperature);
+      sample->valid |= 1u << TELEMETRY_FIELD_TEMPERATURE;
+    }
+
+    double rate = 0.0;
+    if (GetRate(current.energy,
+                previous ? &previous->energy : nullptr, &rate)) {
+      sample->power = static_cast<float>(rate * 1e-6);  // uJ/s to W
+      sample->valid |= 1u << TELEMETRY_FIELD_POWER;
+    }
+    if (GetRate(current.read_bytes,
+                previous ? &previous->read_bytes : nullptr, &rate)) {
+      sample->read_bandwidth = static_cast<float>(rate);
+      sample->valid |= 1u << TELEMETRY_FIELD_READ_BANDWIDTH;
+    }
+    if (GetRate(current.write_bytes,
+                previous ? &previous->write_bytes : nullptr, &rate)) {
+      sample->write_bandwidth = static_cast<float>(rate);
+      sample->valid |= 1u << TELEMETRY_FIELD_WRITE_BANDWIDTH;
+    }
+
+    for (uint32_t i = 0; i < TELEMETRY_ENGINE_COUNT; ++i) {
+      if (current.engine_count[i] == 0 ||
+          !GetRate(current.engine_active[i],
+                   previous ? &previous->engine_active[i] : nullptr, &rate)) {
+        continue;
+      }
+      // Active time of all engines of the kind per second
+      double utilization = rate * 1e-6 / current.engine_count[i];
+      sample->utilization[i] =
+        static_cast<float>(utilization > 1.0 ? 1.0 : utilization);
+      sample->valid |= 1u << (TELEMETRY_FIELD_UTILIZATION + i);
+    }
+  }
+
+  TelemetryBackend* backend_;
+  uint32_t capacity_;
+  std::vector<Device> devices_;
+};
+
+enum TelemetryFormat {
+  TELEMETRY_FORMAT_LINE,
+  TELEMETRY_FORMAT_BINARY
+};
+
+// Writes samples as InfluxDB line protocol records, e.g.
+// "gpu,device=0 freq_mhz=1550.0,power_w=72.41,util_all=0.873 <ns>",
+// or as binary TelemetrySample records. Unknown fields are omitted.
+class TelemetryWriter {
+ public:
+  TelemetryWriter(FILE* output, TelemetryFormat format)
+      : output_(output), format_(format) {
+    PTI_ASSERT(output_ != nullptr);
+    if (format_ == TELEMETRY_FORMAT_BINARY) {
+      TelemetryFileHeader header{{'P', 'T', 'I', 'S', 'M', 'O', 'N', '\0'},
+                                 kVersion, sizeof(TelemetrySample)};
+      fwrite(&header, sizeof(header), 1, output_);
+    }
+  }
+
+  TelemetryWriter(const TelemetryWriter& copy) = delete;
+  TelemetryWriter& operator=(const TelemetryWriter& copy) = delete;
+
+  void Write(const TelemetrySample& sample) {
+    if (format_ == TELEMETRY_FORMAT_BINARY) {
+      fwrite(&sample, sizeof(sample), 1, output_);
+      return;
+    }
+
+    size_t length = FormatLine(sample, line_, sizeof(line_));
+    if (length > 0) {
+      fwrite(line_, 1, length, output_);
+    }
+  }
+
+  void Flush() {
+    fflush(output_);
+  }
+
+  // Returns the length of the record, 0 if the sample has no fields
+  static size_t FormatLine(
+      const TelemetrySample& sample, char* buffer, size_t size) {
+    static const char* const kFieldNames[TELEMETRY_FIELD_COUNT] = {
+      "freq_mhz", "power_w", "temp_c", "mem_read_bps", "mem_write_bps",
+      "util_all", "util_compute", "util_render", "util_media", "util_copy"};
+    static const char* const kFieldFormats[TELEMETRY_FIELD_COUNT] = {
+      "%.1f", "%.2f", "%.1f", "%.0f", "%.0f",
+      "%.3f", "%.3f", "%.3f", "%.3f", "%.3f"};
+
+    if (sample.valid == 0) {
+      return 0;
+    }
+
+    float values[TELEMETRY_FIELD_COUNT] = {
+      sample.frequency, sample.power, sample.temperature,
+      sample.read_bandwidth, sample.write_bandwidth};
+    for (uint32_t i = 0; i < TELEMETRY_ENGINE_COUNT; ++i) {
+      values[TELEMETRY_FIELD_UTILIZATION + i] = sample.utilization[i];
+    }
+
+    size_t length = 0;
+    int written = snprintf(buffer, size, "gpu,device=%u", sample.device);
+    PTI_ASSERT(written > 0);
+    length += written;
+
+    char separator = ' ';
+    for (uint32_t i = 0; i < TELEMETRY_FIELD_COUNT; ++i) {
+      if (!sample.IsValid(i)) {
+        continue;
+      }
+      PTI_ASSERT(length < size);
+      written = snprintf(buffer + length, size - length, "%c%s=",
+                         separator, kFieldNames[i]);
+      PTI_ASSERT(written > 0);
+      length += written;
+      PTI_ASSERT(length < size);
+      written = snprintf(buffer + length, size - length, kFieldFormats[i],
+                         static_cast<double>(values[i]));
+      PTI_ASSERT(written > 0);
+      length += written;
+      separator = ',';
+    }
+
+    PTI_ASSERT(length < size);
+    written = snprintf(buffer + length, size - length, " %llu\n",
+                       static_cast<unsigned long long>(sample.timestamp));
+    PTI_ASSERT(written > 0);
+    length += written;
+    PTI_ASSERT(length < size);
+    return length;
+  }
+
+ private:
+  static const uint32_t kVersion = 1;
+
+  FILE* output_;
+  TelemetryFormat format_;
+  char line_[512];
+};
+
+#endif // PTI_TOOLS_UTILS_TELEMETRY_SAMPLER_H_
@@ -0,0 +1,245 @@
+//==============================================================
+// Copyright (C) Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+// =============================================================
+
+// Tests of TelemetrySampler and TelemetryWriter. A stub backend hands out scripted readings
+// instead of Sysman, no GPU is required.
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "telemetry_sampler.h"
+
+// Returns the readings set for each device, the same reading until it is changed
+class StubBackend : public TelemetryBackend {
+ public:
+  explicit StubBackend(uint32_t device_count) : readings_(device_count) {}
+
+  uint32_t GetDeviceCount() const override {
+    return static_cast<uint32_t>(readings_.size());
+  }
+
+  void Read(uint32_t device, TelemetryReading* reading) override {
+    PTI_ASSERT(device < readings_.size());
+    *reading = readings_[device];
+  }
+
+  TelemetryReading& Get(uint32_t device) { return readings_[device]; }
+
+ private:
+  std::vector<TelemetryReading> readings_;
+};
+
+static void SetCounter(TelemetryCounter* counter, uint64_t value, uint64_t timestamp) {
+  counter->value = value;
+  counter->timestamp = timestamp;
+  counter->valid = true;
+}
+
+static bool Check(bool condition, const char* message) {
+  if (!condition) {
+    std::cerr << "[ERROR] " << message << std::endl;
+  }
+  return condition;
+}
+
+static bool Near(float value, double expected) {
+  return std::fabs(value - expected) <= std::fabs(expected) * 1e-5 + 1e-6;
+}
+
+static bool TestFirstSampleHasGaugesOnly() {
+  StubBackend backend(1);
+  TelemetryReading& reading = backend.Get(0);
+  reading.frequency = 1550.0;
+  reading.temperature = 61.5;
+  SetCounter(&reading.energy, 1000000, 10);
+  SetCounter(&reading.read_bytes, 4096, 10);
+  reading.engine_count[TELEMETRY_ENGINE_ALL] = 1;
+  SetCounter(&reading.engine_active[TELEMETRY_ENGINE_ALL], 5, 10);
+
+  TelemetrySampler sampler(&backend, 4);
+  sampler.Sample(1000);
+  if (!Check(sampler.GetSampleCount(0) == 1, "first sample is not kept")) {
+    return false;
+  }
+  const TelemetrySample& sample = sampler.GetSample(0, 0);
+  bool passed = Check(sample.timestamp == 1000 && sample.device == 0,
+                      "first sample has wrong timestamp or device");
+  passed = Check(sample.valid == ((1u << TELEMETRY_FIELD_FREQUENCY) |
+                                  (1u << TELEMETRY_FIELD_TEMPERATURE)),
+                 "first sample has fields other than gauges") && passed;
+  passed = Check(sample.frequency == 1550.0f && sample.temperature == 61.5f,
+                 "first sample has wrong gauges") && passed;
+  return passed;
+}
+
+static bool TestRates() {
+  StubBackend backend(2);
+  TelemetrySampler sampler(&backend, 4);
+
+  // Device 1 has no counters at all
+  backend.Get(1).frequency = 300.0;
+
+  TelemetryReading& reading = backend.Get(0);
+  SetCounter(&reading.energy, 1000000, 1000000);  // uJ at 1 s
+  SetCounter(&reading.read_bytes, 0, 1000000);
+  SetCounter(&reading.write_bytes, 100, 1000000);
+  reading.engine_count[TELEMETRY_ENGINE_COMPUTE] = 2;
+  SetCounter(&reading.engine_active[TELEMETRY_ENGINE_COMPUTE], 0, 1000000);
+  reading.engine_count[TELEMETRY_ENGINE_COPY] = 1;
+  SetCounter(&reading.engine_active[TELEMETRY_ENGINE_COPY], 0, 1000000);
+  sampler.Sample(1000);
+
+  // 0.5 s later
+  SetCounter(&reading.energy, 1000000 + 36000000, 1500000);  // 36 J in 0.5 s
+  SetCounter(&reading.read_bytes, 1 << 20, 1500000);
+  SetCounter(&reading.write_bytes, 100, 1500000);
+  SetCounter(&reading.engine_active[TELEMETRY_ENGINE_COMPUTE], 600000, 1500000);
+  SetCounter(&reading.engine_active[TELEMETRY_ENGINE_COPY], 900000, 1500000);
+  sampler.Sample(2000);
+
+  const TelemetrySample& sample = sampler.GetSample(0, 0);
+  bool passed = Check(sample.timestamp == 2000, "newest sample is not at index 0");
+  passed = Check(sample.IsValid(TELEMETRY_FIELD_POWER) && Near(sample.power, 72.0),
+                 "power is not the energy rate") && passed;
+  passed = Check(sample.IsValid(TELEMETRY_FIELD_READ_BANDWIDTH) &&
+                 Near(sample.read_bandwidth, 2.0 * (1 << 20)),
+                 "read bandwidth is not the byte rate") && passed;
+  passed = Check(sample.IsValid(TELEMETRY_FIELD_WRITE_BANDWIDTH) &&
+                 sample.write_bandwidth == 0.0f,
+                 "unchanged write counter is not a zero rate") && passed;
+  // 0.6 s active of two engines in 0.5 s
+  passed = Check(sample.IsValid(TELEMETRY_FIELD_UTILIZATION + TELEMETRY_ENGINE_COMPUTE) &&
+                 Near(sample.utilization[TELEMETRY_ENGINE_COMPUTE], 0.6),
+                 "utilization is not averaged over engines") && passed;
+  // 0.9 s active of one engine in 0.5 s
+  passed = Check(sample.IsValid(TELEMETRY_FIELD_UTILIZATION + TELEMETRY_ENGINE_COPY) &&
+                 sample.utilization[TELEMETRY_ENGINE_COPY] == 1.0f,
+                 "utilization is not clamped to 1") && passed;
+  passed = Check(!sample.IsValid(TELEMETRY_FIELD_UTILIZATION + TELEMETRY_ENGINE_ALL) &&
+                 !sample.IsValid(TELEMETRY_FIELD_FREQUENCY),
+                 "fields without readings are valid") && passed;
+
+  const TelemetrySample& other = sampler.GetSample(1, 0);
+  passed = Check(other.device == 1 && other.valid == (1u << TELEMETRY_FIELD_FREQUENCY),
+                 "device without counters has rates") && passed;
+  return passed;
+}
+
+static bool TestCounterWrap() {
+  StubBackend backend(1);
+  TelemetrySampler sampler(&backend, 4);
+  TelemetryReading& reading = backend.Get(0);
+
+  SetCounter(&reading.energy, 5000000, 1000000);
+  SetCounter(&reading.read_bytes, 1000, 1000000);
+  sampler.Sample(1);
+
+  // The energy counter restarted, the timestamp of the byte counter did not move
+  SetCounter(&reading.energy, 1000, 2000000);
+  SetCounter(&reading.read_bytes, 2000, 1000000);
+  sampler.Sample(2);
+  const TelemetrySample& wrapped = sampler.GetSample(0, 0);
+  bool passed = Check(!wrapped.IsValid(TELEMETRY_FIELD_POWER) && wrapped.power == 0.0f,
+                      "restarted counter has a rate");
+  passed = Check(!wrapped.IsValid(TELEMETRY_FIELD_READ_BANDWIDTH),
+                 "counter with the same timestamp has a rate") && passed;
+
+  // Rates are back once the counter grows from the restarted value
+  SetCounter(&reading.energy, 1000 + 10000000, 3000000);
+  SetCounter(&reading.read_bytes, 3000, 2000000);
+  sampler.Sample(3);
+  const TelemetrySample& next = sampler.GetSample(0, 0);
+  passed = Check(next.IsValid(TELEMETRY_FIELD_POWER) && Near(next.power, 10.0),
+                 "rate is not computed after the restart") && passed;
+  passed = Check(next.IsValid(TELEMETRY_FIELD_READ_BANDWIDTH) &&
+                 Near(next.read_bandwidth, 1000.0),
+                 "rate is not computed once the timestamp moves") && passed;
+  return passed;
+}
+
+static bool TestRingOverwrite() {
+  StubBackend backend(2);
+  TelemetrySampler sampler(&backend, 3);
+  backend.Get(0).frequency = 100.0;
+  backend.Get(1).frequency = 200.0;
+
+  std::vector<uint64_t> taken;
+  auto take = [&taken](const TelemetrySample& sample) {
+    taken.push_back(sample.device * 1000 + sample.timestamp);
+  };
+
+  sampler.Sample(1);
+  sampler.Sample(2);
+  bool passed = Check(sampler.GetPendingCount() == 4, "pending samples are not counted");
+  sampler.TakePending(take);
+  passed = Check(taken == std::vector<uint64_t>({1, 2, 1001, 1002}),
+                 "pending samples are not taken oldest first") && passed;
+  passed = Check(sampler.GetPendingCount() == 0, "taken samples are still pending") && passed;
+
+  // Five samples in a ring of three, the two oldest are lost
+  taken.clear();
+  for (uint64_t timestamp = 3; timestamp <= 7; ++timestamp) {
+    sampler.Sample(timestamp);
+  }
+  passed = Check(sampler.GetPendingCount() == 6, "pending samples exceed the ring") && passed;
+  sampler.TakePending(take);
+  passed = Check(taken == std::vector<uint64_t>({5, 6, 7, 1005, 1006, 1007}),
+                 "overwritten samples are taken") && passed;
+
+  passed = Check(sampler.GetSampleCount(0) == 3 && sampler.GetSample(0, 0).timestamp == 7 &&
+                 sampler.GetSample(0, 2).timestamp == 5,
+                 "kept samples are not the newest") && passed;
+
+  taken.clear();
+  sampler.TakePending(take);
+  passed = Check(taken.empty(), "samples are taken twice") && passed;
+  return passed;
+}
+
+static bool TestFormatLine() {
+  TelemetrySample sample;
+  memset(&sample, 0, sizeof(sample));
+  sample.timestamp = 1700000000123456789ULL;
+  sample.device = 1;
+  char buffer[512];
+  bool passed = Check(TelemetryWriter::FormatLine(sample, buffer, sizeof(buffer)) == 0,
+                      "sample without fields is written");
+
+  sample.frequency = 1550.0f;
+  sample.power = 72.414f;
+  sample.read_bandwidth = 1048576.0f;
+  sample.utilization[TELEMETRY_ENGINE_ALL] = 0.8734f;
+  sample.utilization[TELEMETRY_ENGINE_COPY] = 0.5f;
+  sample.temperature = 99.0f;  // not valid, not written
+  sample.valid = (1u << TELEMETRY_FIELD_FREQUENCY) | (1u << TELEMETRY_FIELD_POWER) |
+                 (1u << TELEMETRY_FIELD_READ_BANDWIDTH) |
+                 (1u << (TELEMETRY_FIELD_UTILIZATION + TELEMETRY_ENGINE_ALL)) |
+                 (1u << (TELEMETRY_FIELD_UTILIZATION + TELEMETRY_ENGINE_COPY));
+  size_t length = TelemetryWriter::FormatLine(sample, buffer, sizeof(buffer));
+  std::string expected =
+      "gpu,device=1 freq_mhz=1550.0,power_w=72.41,mem_read_bps=1048576,"
+      "util_all=0.873,util_copy=0.500 1700000000123456789\n";
+  if (length != expected.size() || std::string(buffer, length) != expected) {
+    std::cerr << "[ERROR] Line record is \"" << std::string(buffer, length) << "\"" << std::endl;
+    passed = false;
+  }
+  return passed;
+}
+
+int main() {
+  bool passed = true;
+  passed = TestFirstSampleHasGaugesOnly() && passed;
+  passed = TestRates() && passed;
+  passed = TestCounterWrap() && passed;
+  passed = TestRingOverwrite() && passed;
+  passed = TestFormatLine() && passed;
+  std::cout << (passed ? "[PASSED]" : "[FAILED]") << " telemetry_sampler_test" << std::endl;
+  return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,273 @@
+//==============================================================
+// Copyright (C) Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+// =============================================================
+
+#ifndef PTI_TOOLS_UTILS_ZES_TELEMETRY_BACKEND_H_
+#define PTI_TOOLS_UTILS_ZES_TELEMETRY_BACKEND_H_
+
+#include <vector>
+
+#include <level_zero/zes_api.h>
+
+#include "pti_assert.h"
+#include "telemetry_sampler.h"
+
+// Tools loading Level Zero at runtime define this before the include to
+// call Sysman through their loader
+#ifndef ZES_FUNC
+#define ZES_FUNC(X) X
+#endif
+
+// Reads telemetry through Sysman. Handles of the device level frequency,
+// power, temperature, memory and engine group domains are looked up once,
+// so a reading is a handful of state queries per device.
+class ZesTelemetryBackend : public TelemetryBackend {
+ public:
+  explicit ZesTelemetryBackend(
+      const std::vector<zes_device_handle_t>& device_list) {
+    for (auto device : device_list) {
+      PTI_ASSERT(device != nullptr);
+      devices_.push_back(GetHandles(device));
+    }
+  }
+
+  uint32_t GetDeviceCount() const override {
+    return static_cast<uint32_t>(devices_.size());
+  }
+
+  void Read(uint32_t device, TelemetryReading* reading) override {
+    PTI_ASSERT(device < devices_.size());
+    PTI_ASSERT(reading != nullptr);
+    const Handles& handles = devices_[device];
+    ze_result_t status = ZE_RESULT_SUCCESS;
+
+    if (handles.frequency != nullptr) {
+      zes_freq_state_t state{ZES_STRUCTURE_TYPE_FREQ_STATE, };
+      status = ZES_FUNC(zesFrequencyGetState)(handles.frequency, &state);
+      if (status == ZE_RESULT_SUCCESS && state.actual >= 0) {
+        reading->frequency = state.actual;
+      }
+    }
+
+    if (handles.temperature != nullptr) {
+      double temperature = 0.0;
+      status = ZES_FUNC(zesTemperatureGetState)(
+          handles.temperature, &temperature);
+      if (status == ZE_RESULT_SUCCESS) {
+        reading->temperature = temperature;
+      }
+    }
+
+    if (handles.power != nullptr) {
+      zes_power_energy_counter_t energy{};
+      status = ZES_FUNC(zesPowerGetEnergyCounter)(handles.power, &energy);
+      if (status == ZE_RESULT_SUCCESS) {
+        reading->energy = {energy.energy, energy.timestamp, true};
+      }
+    }
+
+    if (!handles.memory.empty()) {
+      bool valid = true;
+      uint64_t read_bytes = 0, write_bytes = 0, timestamp = 0;
+      for (auto memory : handles.memory) {
+        zes_mem_bandwidth_t bandwidth{};
+        status = ZES_FUNC(zesMemoryGetBandwidth)(memory, &bandwidth);
+        if (status != ZE_RESULT_SUCCESS) {
+          valid = false;
+          break;
+        }
+        read_bytes += bandwidth.readCounter;
+        write_bytes += bandwidth.writeCounter;
+        if (bandwidth.timestamp > timestamp) {
+          timestamp = bandwidth.timestamp;
+        }
+      }
+      if (valid) {
+        reading->read_bytes = {read_bytes, timestamp, true};
+        reading->write_bytes = {write_bytes, timestamp, true};
+      }
+    }
+
+    for (uint32_t i = 0; i < TELEMETRY_ENGINE_COUNT; ++i) {
+      const std::vector<zes_engine_handle_t>& engines = handles.engines[i];
+      if (engines.empty()) {
+        continue;
+      }
+      bool valid = true;
+      uint64_t active_time = 0, timestamp = 0;
+      for (auto engine : engines) {
+        zes_engine_stats_t stats{};
+        status = ZES_FUNC(zesEngineGetActivity)(engine, &stats);
+        if (status != ZE_RESULT_SUCCESS) {
+          valid = false;
+          break;
+        }
+        active_time += stats.activeTime;
+        if (stats.timestamp > timestamp) {
+          timestamp = stats.timestamp;
+        }
+      }
+      if (valid) {
+        reading->engine_active[i] = {active_time, timestamp, true};
+        reading->engine_count[i] = static_cast<uint32_t>(engines.size());
+      }
+    }
+  }
+
+ private:
+  struct Handles {
+    zes_freq_handle_t frequency = nullptr;
+    zes_temp_handle_t temperature = nullptr;
+    zes_pwr_handle_t power = nullptr;
+    std::vector<zes_mem_handle_t> memory;
+    // Engine group of all engines of the kind if available, single engines
+    // otherwise
+    std::vector<zes_engine_handle_t> engines[TELEMETRY_ENGINE_COUNT];
+  };
+
+  static Handles GetHandles(zes_device_handle_t device) {
+    Handles handles;
+    ze_result_t status = ZE_RESULT_SUCCESS;
+
+    uint32_t count = 0;
+    status = ZES_FUNC(zesDeviceEnumFrequencyDomains)(device, &count, nullptr);
+    if (status == ZE_RESULT_SUCCESS && count > 0) {
+      std::vector<zes_freq_handle_t> domain_list(count);
+      status = ZES_FUNC(zesDeviceEnumFrequencyDomains)(
+          device, &count, domain_list.data());
+      PTI_ASSERT(status == ZE_RESULT_SUCCESS);
+      for (auto domain : domain_list) {
+        zes_freq_properties_t props{ZES_STRUCTURE_TYPE_FREQ_PROPERTIES, };
+        status = ZES_FUNC(zesFrequencyGetProperties)(domain, &props);
+        if (status == ZE_RESULT_SUCCESS &&
+            props.type == ZES_FREQ_DOMAIN_GPU && !props.onSubdevice) {
+          handles.frequency = domain;
+          break;
+        }
+      }
+    }
+
+    count = 0;
+    status = ZES_FUNC(zesDeviceEnumTemperatureSensors)(device, &count, nullptr);
+    if (status == ZE_RESULT_SUCCESS && count > 0) {
+      std::vector<zes_temp_handle_t> sensor_list(count);
+      status = ZES_FUNC(zesDeviceEnumTemperatureSensors)(
+          device, &count, sensor_list.data());
+      PTI_ASSERT(status == ZE_RESULT_SUCCESS);
+      for (auto sensor : sensor_list) {
+        zes_temp_properties_t props{ZES_STRUCTURE_TYPE_TEMP_PROPERTIES, };
+        status = ZES_FUNC(zesTemperatureGetProperties)(sensor, &props);
+        if (status == ZE_RESULT_SUCCESS &&
+            props.type == ZES_TEMP_SENSORS_GPU && !props.onSubdevice) {
+          handles.temperature = sensor;
+          break;
+        }
+      }
+    }
+
+    zes_pwr_handle_t card_power = nullptr;
+    status = ZES_FUNC(zesDeviceGetCardPowerDomain)(device, &card_power);
+    if (status == ZE_RESULT_SUCCESS && card_power != nullptr) {
+      handles.power = card_power;
+    } else {
+      count = 0;
+      status = ZES_FUNC(zesDeviceEnumPowerDomains)(device, &count, nullptr);
+      if (status == ZE_RESULT_SUCCESS && count > 0) {
+        std::vector<zes_pwr_handle_t> domain_list(count);
+        status = ZES_FUNC(zesDeviceEnumPowerDomains)(
+            device, &count, domain_list.data());
+        PTI_ASSERT(status == ZE_RESULT_SUCCESS);
+        for (auto domain : domain_list) {
+          zes_power_properties_t props{
+              ZES_STRUCTURE_TYPE_POWER_PROPERTIES, };
+          status = ZES_FUNC(zesPowerGetProperties)(domain, &props);
+          if (status == ZE_RESULT_SUCCESS && !props.onSubdevice) {
+            handles.power = domain;
+            break;
+          }
+        }
+      }
+    }
+
+    count = 0;
+    status = ZES_FUNC(zesDeviceEnumMemoryModules)(device, &count, nullptr);
+    if (status == ZE_RESULT_SUCCESS && count > 0) {
+      handles.memory.resize(count);
+      status = ZES_FUNC(zesDeviceEnumMemoryModules)(
+          device, &count, handles.memory.data());
+      PTI_ASSERT(status == ZE_RESULT_SUCCESS);
+    }
+
+    count = 0;
+    status = ZES_FUNC(zesDeviceEnumEngineGroups)(device, &count, nullptr);
+    if (status == ZE_RESULT_SUCCESS && count > 0) {
+      std::vector<zes_engine_handle_t> engine_list(count);
+      status = ZES_FUNC(zesDeviceEnumEngineGroups)(
+          device, &count, engine_list.data());
+      PTI_ASSERT(status == ZE_RESULT_SUCCESS);
+
+      std::vector<zes_engine_handle_t> groups[TELEMETRY_ENGINE_COUNT];
+      for (auto engine : engine_list) {
+        zes_engine_properties_t props{
+            ZES_STRUCTURE_TYPE_ENGINE_PROPERTIES, };
+        status = ZES_FUNC(zesEngineGetProperties)(engine, &props);
+        if (status != ZE_RESULT_SUCCESS || props.onSubdevice) {
+          continue;
+        }
+        bool group = false;
+        int kind = GetEngineKind(props.type, &group);
+        if (kind < 0) {
+          continue;
+        }
+        (group ? groups : handles.engines)[kind].push_back(engine);
+      }
+
+      for (uint32_t i = 0; i < TELEMETRY_ENGINE_COUNT; ++i) {
+        if (!groups[i].empty()) {
+          handles.engines[i].assign(1, groups[i].front());
+        }
+      }
+    }
+
+    return handles;
+  }
+
+  static int GetEngineKind(zes_engine_group_t type, bool* group) {
+    *group = true;
+    switch (type) {
+      case ZES_ENGINE_GROUP_ALL:
+        return TELEMETRY_ENGINE_ALL;
+      case ZES_ENGINE_GROUP_COMPUTE_ALL:
+        return TELEMETRY_ENGINE_COMPUTE;
+      case ZES_ENGINE_GROUP_RENDER_ALL:
+        return TELEMETRY_ENGINE_RENDER;
+      case ZES_ENGINE_GROUP_MEDIA_ALL:
+        return TELEMETRY_ENGINE_MEDIA;
+      case ZES_ENGINE_GROUP_COPY_ALL:
+        return TELEMETRY_ENGINE_COPY;
+      default:
+        break;
+    }
+    *group = false;
+    switch (type) {
+      case ZES_ENGINE_GROUP_COMPUTE_SINGLE:
+        return TELEMETRY_ENGINE_COMPUTE;
+      case ZES_ENGINE_GROUP_RENDER_SINGLE:
+        return TELEMETRY_ENGINE_RENDER;
+      case ZES_ENGINE_GROUP_MEDIA_DECODE_SINGLE:
+      case ZES_ENGINE_GROUP_MEDIA_ENCODE_SINGLE:
+      case ZES_ENGINE_GROUP_MEDIA_ENHANCEMENT_SINGLE:
+        return TELEMETRY_ENGINE_MEDIA;
+      case ZES_ENGINE_GROUP_COPY_SINGLE:
+        return TELEMETRY_ENGINE_COPY;
+      default:
+        return -1;
+    }
+  }
+
+  std::vector<Handles> devices_;
+};
+
+#endif // PTI_TOOLS_UTILS_ZES_TELEMETRY_BACKEND_H_
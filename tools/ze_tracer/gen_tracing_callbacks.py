@@ -237,6 +237,16 @@ def get_enum_map(include_path):
 
 # Generate Callbacks ##########################################################
 
+def gen_function_ids(f, func_list, group_map):
+  f.write("enum ZeFunctionId {\n")
+  for func in func_list:
+    if not func in group_map:
+      continue
+    f.write("  ZE_FUNCTION_" + func + ",\n")
+  f.write("  ZE_FUNCTION_COUNT\n")
+  f.write("};\n")
+  f.write("\n")
+
 def gen_api(f, func_list, group_map):
   f.write("static void SetTracingAPIs(zel_tracer_handle_t tracer) {\n")
   f.write("  zet_core_callbacks_t prologue = {};\n")
@@ -548,7 +558,7 @@ def gen_exit_callback(f, func, params, enum_map):
   f.write("\n")
   f.write("  PTI_ASSERT(start_time <= end_time);\n")
   f.write("  uint64_t time = end_time - start_time;\n")
-  f.write("  collector->AddFunctionTime(\"" + func + "\", time);\n")
+  f.write("  collector->AddFunctionTime(ZE_FUNCTION_" + func + ", \"" + func + "\", time);\n")
   f.write("  if (collector->options_.call_tracing) {\n")
   f.write("    std::stringstream stream;\n")
   f.write("    stream << \"<<<< [\" << end_time << \"] \";\n")
@@ -749,6 +759,7 @@ def main():
   param_map = get_param_map(l0_file)
   enum_map = get_enum_map(l0_path)
 
+  gen_function_ids(dst_file, func_list, group_map)
   gen_result_converter(dst_file, enum_map)
   gen_structure_type_converter(dst_file, enum_map)
   gen_callbacks(dst_file, func_list, group_map, param_map, enum_map)
@@ -17,6 +17,7 @@
 #include <level_zero/layers/zel_tracing_api.h>
 
 #include "correlator.h"
+#include "function_stats_table.h"
 #include "utils.h"
 #include "ze_utils.h"
 
@@ -88,14 +89,17 @@ class ZeApiCollector {
 #endif
   }
 
-  const ZeFunctionInfoMap& GetFunctionInfoMap() const {
-    return function_info_map_;
+  ZeFunctionInfoMap GetFunctionInfoMap() const {
+    ZeFunctionInfoMap function_info_map;
+    function_stats_.Merge(function_info_map);
+    return function_info_map;
   }
 
   void PrintFunctionsTable() const {
+    ZeFunctionInfoMap function_info_map = GetFunctionInfoMap();
     std::set< std::pair<std::string, ZeFunction>,
               utils::Comparator > sorted_list(
-        function_info_map_.begin(), function_info_map_.end());
+        function_info_map.begin(), function_info_map.end());
 
     uint64_t total_duration = 0;
     size_t max_name_length = kFunctionLength;
@@ -156,21 +160,8 @@ class ZeApiCollector {
     return correlator_->GetTimestamp();
   }
 
-  void AddFunctionTime(const std::string& name, uint64_t time) {
-    const std::lock_guard<std::mutex> lock(lock_);
-    if (function_info_map_.count(name) == 0) {
-      function_info_map_[name] = {time, time, time, 1};
-    } else {
-      ZeFunction& function = function_info_map_[name];
-      function.total_time += time;
-      if (time < function.min_time) {
-        function.min_time = time;
-      }
-      if (time > function.max_time) {
-        function.max_time = time;
-      }
-      ++function.call_count;
-    }
+  void AddFunctionTime(uint32_t function, const char* name, uint64_t time) {
+    function_stats_.AddFunctionTime(function, name, time);
   }
 
  private: // Implementation Details
@@ -187,8 +178,7 @@ class ZeApiCollector {
  private: // Data
   zel_tracer_handle_t tracer_ = nullptr;
 
-  ZeFunctionInfoMap function_info_map_;
-  std::mutex lock_;
+  FunctionStatsTable<ZeFunction, ZE_FUNCTION_COUNT> function_stats_;
 
   Correlator* correlator_ = nullptr;
   ApiCollectorOptions options_;
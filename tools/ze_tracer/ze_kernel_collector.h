@@ -16,11 +16,13 @@
 #include <set>
 #include <sstream>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <level_zero/layers/zel_tracing_api.h>
 
 #include "correlator.h"
+#include "kernel_stats_key.h"
 #include "utils.h"
 #include "ze_event_cache.h"
 #include "ze_utils.h"
@@ -173,9 +175,10 @@ class ZeKernelCollector {
   }
 
   void PrintKernelsTable() const {
+    ZeKernelInfoMap kernel_info_map = GetKernelInfoMap();
     std::set< std::pair<std::string, ZeKernelInfo>,
               utils::Comparator > sorted_list(
-        kernel_info_map_.begin(), kernel_info_map_.end());
+        kernel_info_map.begin(), kernel_info_map.end());
 
     uint64_t total_duration = 0;
     size_t max_name_length = kKernelLength;
@@ -222,9 +225,10 @@ class ZeKernelCollector {
   }
 
   void PrintSubmissionTable() const {
+    ZeKernelInfoMap kernel_info_map = GetKernelInfoMap();
     std::set< std::pair<std::string, ZeKernelInfo>,
               utils::Comparator > sorted_list(
-        kernel_info_map_.begin(), kernel_info_map_.end());
+        kernel_info_map.begin(), kernel_info_map.end());
 
     uint64_t total_append_duration = 0;
     uint64_t total_submit_duration = 0;
@@ -290,8 +294,19 @@ class ZeKernelCollector {
 #endif
   }
 
-  const ZeKernelInfoMap& GetKernelInfoMap() const {
-    return kernel_info_map_;
+  // Kernel names are formatted here, once per launch configuration
+  ZeKernelInfoMap GetKernelInfoMap() const {
+    ZeKernelInfoMap kernel_info_map;
+    for (const auto& value : kernel_stats_) {
+      std::string name = kernel_names_.Format(value.first, options_.verbose);
+      auto it = kernel_info_map.find(name);
+      if (it == kernel_info_map.end()) {
+        kernel_info_map.emplace(std::move(name), value.second);
+      } else {
+        MergeKernelInfo(it->second, value.second);
+      }
+    }
+    return kernel_info_map;
   }
 
 #ifdef PTI_KERNEL_INTERVALS
@@ -749,16 +764,7 @@ class ZeKernelCollector {
     GetHostTime(call, timestamp, host_start, host_end);
     PTI_ASSERT(host_start <= host_end);
 
-    std::string name = command->props.name;
-    PTI_ASSERT(!name.empty());
-
-    if (options_.verbose) {
-      name = GetVerboseName(&command->props);
-    }
-
-    if (tile >= 0) {
-      name += "(" + std::to_string(tile) + "T)";
-    }
+    KernelStatsKey key = GetStatsKey(&command->props, tile);
 
     if (in_summary) {
       PTI_ASSERT(command->append_time > 0);
@@ -768,7 +774,7 @@ class ZeKernelCollector {
       uint64_t submit_time = host_start - call->submit_time;
       PTI_ASSERT(host_start <= host_end);
       uint64_t execute_time = host_end - host_start;
-      AddKernelInfo(append_time, submit_time, execute_time, name);
+      AddKernelInfo(append_time, submit_time, execute_time, key);
     }
 
     if (callback_ != nullptr) {
@@ -787,7 +793,8 @@ class ZeKernelCollector {
       }
 
       callback_(
-          callback_data_, stream.str(), id, name,
+          callback_data_, stream.str(), id,
+          kernel_names_.Get(key, options_.verbose),
           command->append_time, call->submit_time,
           host_start, host_end);
     }
@@ -878,39 +885,43 @@ class ZeKernelCollector {
     }
   }
 
-  static std::string GetVerboseName(const ZeKernelProps* props) {
+  // Sizes are keyed only if they are shown in kernel names
+  KernelStatsKey GetStatsKey(const ZeKernelProps* props, int tile) {
     PTI_ASSERT(props != nullptr);
     PTI_ASSERT(!props->name.empty());
 
-    std::stringstream sstream;
-    sstream << props->name;
-    if (props->simd_width > 0) {
-      sstream << "[SIMD";
-      if (props->simd_width == 1) {
-        sstream << "_ANY";
-      } else {
-        sstream << props->simd_width;
+    KernelStatsKey key;
+    key.name_id = kernel_names_.GetId(props->name);
+    key.tile = tile;
+    if (options_.verbose) {
+      key.simd_width = static_cast<uint32_t>(props->simd_width);
+      key.bytes_transferred = props->bytes_transferred;
+      for (int i = 0; i < 3; ++i) {
+        key.global_size[i] = props->group_count[i];
+        key.local_size[i] = props->group_size[i];
       }
-      sstream << " {" <<
-        props->group_count[0] << "; " <<
-        props->group_count[1] << "; " <<
-        props->group_count[2] << "} {" <<
-        props->group_size[0] << "; " <<
-        props->group_size[1] << "; " <<
-        props->group_size[2] << "}]";
-    } else if (props->bytes_transferred > 0) {
-      sstream << "[" << props->bytes_transferred << " bytes]";
     }
+    return key;
+  }
 
-    return sstream.str();
+  static void MergeKernelInfo(ZeKernelInfo& kernel, const ZeKernelInfo& r) {
+    kernel.append_time += r.append_time;
+    kernel.submit_time += r.submit_time;
+    kernel.execute_time += r.execute_time;
+    if (r.max_time > kernel.max_time) {
+      kernel.max_time = r.max_time;
+    }
+    if (r.min_time < kernel.min_time) {
+      kernel.min_time = r.min_time;
+    }
+    kernel.call_count += r.call_count;
   }
 
   void AddKernelInfo(
       uint64_t append_time, uint64_t submit_time,
-      uint64_t execute_time, const std::string& name) {
-    PTI_ASSERT(!name.empty());
-
-    if (kernel_info_map_.count(name) == 0) {
+      uint64_t execute_time, const KernelStatsKey& key) {
+    auto it = kernel_stats_.find(key);
+    if (it == kernel_stats_.end()) {
       ZeKernelInfo info;
       info.append_time = append_time;
       info.submit_time = submit_time;
@@ -918,9 +929,9 @@ class ZeKernelCollector {
       info.min_time = execute_time;
       info.max_time = execute_time;
       info.call_count = 1;
-      kernel_info_map_[name] = info;
+      kernel_stats_.emplace(key, info);
     } else {
-      ZeKernelInfo& kernel = kernel_info_map_[name];
+      ZeKernelInfo& kernel = it->second;
       kernel.append_time += append_time;
       kernel.submit_time +=  submit_time;
       kernel.execute_time += execute_time;
@@ -945,12 +956,8 @@ class ZeKernelCollector {
       return; // Process user kernels only
     }
 
-    std::string name = command->props.name;
-    PTI_ASSERT(!name.empty());
-
-    if (options_.verbose) {
-      name = GetVerboseName(&command->props);
-    }
+    const std::string& name = kernel_names_.Get(
+        GetStatsKey(&command->props, -1), options_.verbose);
 
     ze_result_t status = zeEventQueryStatus(command->event);
     PTI_ASSERT(status == ZE_RESULT_SUCCESS);
@@ -2092,7 +2099,9 @@ class ZeKernelCollector {
   void* callback_data_ = nullptr;
 
   std::mutex lock_;
-  ZeKernelInfoMap kernel_info_map_;
+  KernelStatsNames kernel_names_;
+  std::unordered_map<
+      KernelStatsKey, ZeKernelInfo, KernelStatsKeyHash> kernel_stats_;
   std::list<ZeKernelCall*> kernel_call_list_;
   ZeCommandListMap command_list_map_;
   ZeImageSizeMap image_size_map_;
@@ -135,7 +135,7 @@ inline std::string GetKernelName(cl_kernel kernel, bool demangle = false) {
   PTI_ASSERT(status == CL_SUCCESS);
 
   if (demangle) {
-    return utils::Demangle(name);
+    return std::string(utils::DemangleCached(name));
   }
   return name;
 }
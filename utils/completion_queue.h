@@ -0,0 +1,181 @@
+//==============================================================
+// Copyright (C) Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+// =============================================================
+
+#ifndef PTI_UTILS_COMPLETION_QUEUE_H_
+#define PTI_UTILS_COMPLETION_QUEUE_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "pti_assert.h"
+
+namespace utils {
+
+// Lock-free multi-producer queue of completed commands, e.g. pushed from
+// OpenCL event callbacks on runtime threads. T is linked through its own
+// "T* next_completed" member, so pushing never allocates.
+template <typename T>
+class CompletionQueue {
+ public:
+  CompletionQueue() = default;
+  CompletionQueue(const CompletionQueue& copy) = delete;
+  CompletionQueue& operator=(const CompletionQueue& copy) = delete;
+
+  // Called when a command is submitted, before its completion can be pushed
+  void AddInFlight() {
+    in_flight_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // The caller keeps the queue alive until the call returns, as the item
+  // may already be drained and freed by then
+  void Push(T* item) {
+    PTI_ASSERT(item != nullptr);
+    T* head = head_.load(std::memory_order_relaxed);
+    do {
+      item->next_completed = head;
+    } while (!head_.compare_exchange_weak(
+        head, item, std::memory_order_seq_cst, std::memory_order_relaxed));
+    in_flight_.fetch_sub(1, std::memory_order_release);
+    // The lock is taken only when the drainer sleeps or is about to: either
+    // it sees the item before sleeping or it gets the notification
+    if (waiting_.load(std::memory_order_seq_cst)) {
+      const std::lock_guard<std::mutex> lock(wait_lock_);
+      cv_.notify_one();
+    }
+  }
+
+  // Takes all completed items, in completion order
+  T* PopAll() {
+    T* head = head_.exchange(nullptr, std::memory_order_acquire);
+    T* ordered = nullptr;
+    while (head != nullptr) {
+      T* next = head->next_completed;
+      head->next_completed = ordered;
+      ordered = head;
+      head = next;
+    }
+    return ordered;
+  }
+
+  bool IsEmpty() const {
+    return head_.load(std::memory_order_relaxed) == nullptr;
+  }
+
+  uint64_t GetInFlightCount() const {
+    return in_flight_.load(std::memory_order_acquire);
+  }
+
+  // Waits for an item to be pushed or for Interrupt(), an idle waiter does
+  // not wake up
+  void Wait() {
+    std::unique_lock<std::mutex> lock(wait_lock_);
+    waiting_.store(true, std::memory_order_seq_cst);
+    cv_.wait(lock, [this] {
+      return head_.load(std::memory_order_seq_cst) != nullptr || interrupted_;
+    });
+    waiting_.store(false, std::memory_order_relaxed);
+  }
+
+  // Makes current and future Wait() calls return
+  void Interrupt() {
+    const std::lock_guard<std::mutex> lock(wait_lock_);
+    interrupted_ = true;
+    cv_.notify_all();
+  }
+
+  // Waits for all in-flight commands to complete, at most for the timeout
+  bool WaitForInFlight(std::chrono::milliseconds timeout) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (GetInFlightCount() > 0) {
+      if (std::chrono::steady_clock::now() >= deadline) {
+        return false;
+      }
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    return true;
+  }
+
+ private:
+  std::atomic<T*> head_{nullptr};
+  std::atomic<uint64_t> in_flight_{0};
+  std::atomic<bool> waiting_{false};
+  std::mutex wait_lock_;
+  std::condition_variable cv_;
+  bool interrupted_ = false;
+};
+
+// Background thread handing completed items to the handler one by one.
+// Drain() may also be called from other threads, e.g. at synchronization
+// points, handler calls never overlap.
+template <typename T>
+class CompletionDrainer {
+ public:
+  CompletionDrainer(
+      std::shared_ptr<CompletionQueue<T>> queue,
+      std::function<void(T*)> handler,
+      std::function<void()> thread_init = nullptr)
+      : queue_(std::move(queue)), handler_(std::move(handler)) {
+    PTI_ASSERT(queue_ != nullptr);
+    PTI_ASSERT(handler_ != nullptr);
+    thread_ = std::thread([this, thread_init]() {
+      if (thread_init != nullptr) {
+        thread_init();
+      }
+      while (!stop_.load(std::memory_order_acquire)) {
+        queue_->Wait();
+        Drain();
+      }
+    });
+  }
+
+  CompletionDrainer(const CompletionDrainer& copy) = delete;
+  CompletionDrainer& operator=(const CompletionDrainer& copy) = delete;
+
+  ~CompletionDrainer() {
+    Stop();
+  }
+
+  void Drain() {
+    if (queue_->IsEmpty()) {
+      return;
+    }
+    const std::lock_guard<std::mutex> lock(drain_lock_);
+    T* item = queue_->PopAll();
+    while (item != nullptr) {
+      T* next = item->next_completed;
+      handler_(item);  // may free the item
+      item = next;
+    }
+  }
+
+  // Stops the thread, the items completed so far are drained by the caller
+  void Stop() {
+    if (thread_.joinable()) {
+      stop_.store(true, std::memory_order_release);
+      queue_->Interrupt();
+      thread_.join();
+    }
+    Drain();
+  }
+
+ private:
+  std::shared_ptr<CompletionQueue<T>> queue_;
+  std::function<void(T*)> handler_;
+  std::atomic<bool> stop_{false};
+  std::mutex drain_lock_;
+  std::thread thread_;
+};
+
+} // namespace utils
+
+#endif // PTI_UTILS_COMPLETION_QUEUE_H_
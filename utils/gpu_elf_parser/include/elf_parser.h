@@ -93,6 +93,25 @@ pti_result ptiElfParserGetSourceMapping(/*IN*/ elf_parser_handle_t parser,
                                         /*OUT*/ SourceMapping* mappings,
                                         /*OUT*/ uint32_t* num_mappings);
 
+/**
+ * @brief Get source mapping rows for many addresses of kernel with index kernel_index at once. The
+ * row of an address is the last row of the line table with address not greater than it. Line
+ * tables are decoded once per kernel and reused by all calls.
+ * @param parser - parser handle.
+ * @param kernel_index - index of kernel
+ * @param num_addresses - number of addresses to look up
+ * @param addresses - array of num_addresses addresses. Lookup is faster if they are sorted.
+ * @param mappings - array of num_addresses SourceMapping structures, mappings[i] is the row for
+ * addresses[i]. Addresses below the first row get a mapping with line 0 and null file names.
+ * @return PTI_SUCCESS if success, PTI_ERROR_BAD_ARGUMENT if invalid argument,
+ * PTI_DEBUG_INFO_NOT_FOUND if no mapping found for specified kernel
+ */
+pti_result ptiElfParserLookupSourceMapping(/*IN*/ elf_parser_handle_t parser,
+                                           /*IN*/ uint32_t kernel_index,
+                                           /*IN*/ uint32_t num_addresses,
+                                           /*IN*/ const uint64_t* addresses,
+                                           /*OUT*/ SourceMapping* mappings);
+
 /**
  * @brief Get pointer to binary data in original data for kernel with index kernel_index. All
  * arguments are required.
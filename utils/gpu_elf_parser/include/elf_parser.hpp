@@ -14,12 +14,16 @@
 
 #include <cstdint>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 #include "elf_parser_def.hpp"
 #include "elf_parser_mapping.h"
+#include "line_table.hpp"
+#include "module_cache.hpp"
 
 namespace elf_parser {
 
@@ -30,6 +34,8 @@ class ElfParser {
    * This constructor initializes an ElfParser object with the provided ELF binary data and size.
    * memory is managed by caller, but should be available until ElfParser object is destroyed.
    * ElfParser object does not copy the data.
+   * If the module cache is enabled (PTI_MODULE_CACHE_DIR) and has an entry for the data, line
+   * tables and demangled names are taken from the entry instead of being decoded.
    *
    * @param data A pointer to the ELF binary data.
    * @param size The size of the ELF binary data.
@@ -72,14 +78,29 @@ class ElfParser {
 
   uint32_t GetKernelIndex(std::string kernel_name) const;
 
+  /**
+   * @brief Retrieves the demangled name of the specified kernel. Empty string in case of error
+   */
+  std::string GetDemangledKernelName(uint32_t kernel_index) const;
+
   uint32_t GetGfxCore() const;
 
   /**
    * @brief Retrieves the source mapping data for the specified kernel in dwarf state machine matrix
-   * format. Returns emtpy vector in case of error
+   * format, sorted by address. Returns emtpy vector in case of error. Copies the rows, use
+   * GetLineTable to access them in place
    */
   std::vector<SourceMapping> GetSourceMappingMatrix(uint32_t kernel_index);
 
+  /**
+   * @brief Retrieves the line table of the specified kernel. The table is decoded on the first call
+   * for the kernel and shared by the next calls, from any thread. Empty table in case of error.
+   * With the module cache enabled, the table is read from the cache entry, or the tables of all
+   * kernels are decoded at once and stored to the cache if there is no entry yet
+   */
+  std::shared_ptr<const LineTable> GetLineTable(uint32_t kernel_index);
+  std::shared_ptr<const LineTable> GetLineTable(std::string kernel_name);
+
   /**
    * @brief Get the Source Mapping object, map provided for addresses with step of
    * MIN_INSTRUCTION_SIZE (8 bytes) For performance sensetive cases, use GetSourceMappingMatrix
@@ -120,6 +141,12 @@ class ElfParser {
   static RelaEntry ConstructRelaEntry(RelaEntry64 entry);
   static RelaEntry ConstructRelaEntry(RelaEntry32 entry);
 
+  // true if the kernels of the cache entry are the kernels of the module
+  bool IsCachedModuleValid() const;
+
+  // decodes line tables of all kernels into line_tables_ and writes the module cache entry
+  void StoreModuleMetadata(const ModuleCache& cache);
+
   const uint8_t* data_;
   const uint32_t size_;
   uint32_t address_width_ = 0;
@@ -129,7 +156,10 @@ class ElfParser {
   std::unordered_map<uint32_t, uint32_t> kernel_name_offset_map_;
   std::vector<SymtabEntry> symtab_;
   std::unordered_map<std::string, const Section> sections_;
-  std::unordered_map<uint32_t, std::vector<SourceMapping>> source_mapping_;
+  std::unordered_map<uint32_t, std::shared_ptr<const LineTable>> line_tables_;
+  std::mutex line_tables_mutex_;
+  std::shared_ptr<const CachedModule> cached_module_;
+  bool metadata_stored_ = false;
 
   bool initialized_ = false;
 };
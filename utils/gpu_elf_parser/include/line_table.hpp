@@ -0,0 +1,98 @@
+//==============================================================
+// Copyright (C) Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+// =============================================================
+
+/**
+ * @file line_table.hpp
+ * @brief This file contains the declaration of the immutable address to source line table of a
+ * kernel.
+ */
+
+#ifndef PTI_ELF_PARSER_LINE_TABLE_HPP_
+#define PTI_ELF_PARSER_LINE_TABLE_HPP_
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "elf_parser_mapping.h"
+
+namespace elf_parser {
+
+/**
+ * @brief Rows of the DWARF line number matrix of a kernel, sorted by address. The table is not
+ * modified after construction, so one instance may be shared by any number of threads.
+ */
+class LineTable {
+ public:
+  /**
+   * @brief Constructs a LineTable object from the rows of the line number matrix. Rows are sorted
+   * by address, rows with the same address keep their order. The file names of the rows may point
+   * into storage, which is then kept alive as long as the table.
+   */
+  explicit LineTable(std::vector<SourceMapping> rows, std::shared_ptr<const void> storage = nullptr)
+      : rows_(std::move(rows)), storage_(std::move(storage)) {
+    std::stable_sort(rows_.begin(), rows_.end(),
+                     [](const SourceMapping& lhs, const SourceMapping& rhs) {
+                       return lhs.address < rhs.address;
+                     });
+  }
+
+  LineTable(const LineTable& other) = delete;
+  LineTable& operator=(const LineTable& other) = delete;
+
+  const std::vector<SourceMapping>& GetRows() const { return rows_; }
+  bool IsEmpty() const { return rows_.empty(); }
+
+  /**
+   * @brief Finds the row describing the instruction at the address: the last row with the highest
+   * address not greater than the given one. O(log n).
+   * @return pointer to the row, nullptr if the address is below the first row
+   */
+  const SourceMapping* Lookup(uint64_t address) const {
+    return Find(rows_.begin(), address);
+  }
+
+  /**
+   * @brief Looks up count addresses at once, result[i] is Lookup(addresses[i]). Ascending runs of
+   * addresses, typical for samples sorted by IP, continue the search from the previous row
+   * instead of the whole table.
+   */
+  void Lookup(const uint64_t* addresses, uint32_t count, const SourceMapping** result) const {
+    auto from = rows_.begin();
+    uint64_t prev = 0;
+    for (uint32_t i = 0; i < count; i++) {
+      if (addresses[i] < prev) {
+        from = rows_.begin();
+      }
+      result[i] = Find(from, addresses[i]);
+      if (result[i] != nullptr) {
+        from = rows_.begin() + (result[i] - rows_.data());
+      }
+      prev = addresses[i];
+    }
+  }
+
+ private:
+  const SourceMapping* Find(std::vector<SourceMapping>::const_iterator from,
+                            uint64_t address) const {
+    auto it = std::upper_bound(
+        from, rows_.end(), address,
+        [](uint64_t value, const SourceMapping& row) { return value < row.address; });
+    if (it == rows_.begin()) {
+      return nullptr;
+    }
+    return &*(--it);
+  }
+
+  std::vector<SourceMapping> rows_;
+  std::shared_ptr<const void> storage_;
+};
+
+}  // namespace elf_parser
+
+#endif  // PTI_ELF_PARSER_LINE_TABLE_HPP_
@@ -0,0 +1,115 @@
+//==============================================================
+// Copyright (C) Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+// =============================================================
+
+/**
+ * @file module_cache.hpp
+ * @brief This file contains the declaration of the persistent cache of GPU module metadata: kernel
+ * names, demangled names and line tables, keyed by a content hash of the module binary.
+ */
+
+#ifndef PTI_ELF_PARSER_MODULE_CACHE_HPP_
+#define PTI_ELF_PARSER_MODULE_CACHE_HPP_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "line_table.hpp"
+
+namespace elf_parser {
+
+struct CacheKernelRecord;
+
+/**
+ * @brief Metadata of one kernel to be stored in the cache.
+ */
+struct KernelMetadata {
+  std::string name;  ///< Checked on load, modules with the same hash have different kernels
+  std::string demangled_name;
+  std::shared_ptr<const LineTable> line_table;
+};
+
+/**
+ * @brief Module metadata loaded from the cache. The cache file is memory-mapped, names and file
+ * paths point into the mapping and stay valid as long as the object exists. Line tables keep the
+ * object alive, so their file paths stay valid as long as the tables.
+ */
+class CachedModule : public std::enable_shared_from_this<CachedModule> {
+ public:
+  ~CachedModule();
+
+  CachedModule(const CachedModule& other) = delete;
+  CachedModule& operator=(const CachedModule& other) = delete;
+
+  uint32_t GetKernelNum() const;
+  const char* GetKernelName(uint32_t kernel_index) const;
+  const char* GetDemangledKernelName(uint32_t kernel_index) const;
+
+  /**
+   * @brief Builds the line table of the kernel from the mapped rows, no DWARF decoding is needed.
+   * Empty table if the index is out of range
+   */
+  std::shared_ptr<const LineTable> GetLineTable(uint32_t kernel_index) const;
+
+ private:
+  friend class ModuleCache;
+
+  CachedModule(const uint8_t* data, size_t size, void* mapping);
+
+  // returns nullptr if the record is out of range
+  const CacheKernelRecord* GetKernelRecord(uint32_t kernel_index) const;
+  const char* GetString(uint32_t offset) const;
+
+  const uint8_t* data_;
+  const size_t size_;
+  void* mapping_;  // mapping handle on Windows
+};
+
+/**
+ * @brief Directory of module metadata files named by the content hash of the module binary. Tools
+ * profiling the same application repeatedly find the metadata of already seen modules there
+ * instead of querying the driver and decoding DWARF again. Files are written to a temporary name
+ * and renamed, so concurrent processes never read a partially written entry.
+ */
+class ModuleCache {
+ public:
+  explicit ModuleCache(std::string directory) : directory_(std::move(directory)) {}
+
+  /**
+   * @brief Process-wide cache in the directory set by PTI_MODULE_CACHE_DIR environment variable.
+   * @return nullptr if the variable is not set, i.e. caching is disabled
+   */
+  static ModuleCache* GetInstance();
+
+  /**
+   * @brief Content hash of the module binary, the key of the cache entry
+   */
+  static uint64_t Hash(const uint8_t* data, size_t size);
+
+  /**
+   * @brief Maps the entry of the module binary. Only the hash and the size of the binary are
+   * compared, callers check that the kernels of the entry are the ones of the binary.
+   * @return nullptr if there is no valid entry for the binary
+   */
+  std::shared_ptr<const CachedModule> Load(const uint8_t* data, size_t size) const;
+
+  /**
+   * @brief Writes the entry of the module binary, replacing the existing one.
+   * @return false if the entry cannot be written, the cache stays unchanged in this case
+   */
+  bool Store(const uint8_t* data, size_t size, const std::vector<KernelMetadata>& kernels) const;
+
+ private:
+  std::string GetEntryPath(uint64_t hash) const;
+
+  std::string directory_;
+};
+
+}  // namespace elf_parser
+
+#endif  // PTI_ELF_PARSER_MODULE_CACHE_HPP_
@@ -16,6 +16,7 @@
 #include <iomanip>
 #include <iostream>
 
+#include "demangle.h"
 #include "elf_parser.hpp"
 #include "pti_assert.h"
 #include "section_debug_abbrev.hpp"
@@ -89,7 +90,8 @@ pti_result ptiElfParserGetSourceMapping(elf_parser_handle_t parser, uint32_t ker
     return PTI_ERROR_BAD_ARGUMENT;
   }
 
-  auto mapping_ = parser_->GetSourceMappingMatrix(kernel_index);
+  auto table = parser_->GetLineTable(kernel_index);
+  const std::vector<SourceMapping>& mapping_ = table->GetRows();
 
   const uint32_t mapping_size = mapping_.size();
   if (num_mappings != nullptr) {
@@ -116,6 +118,36 @@ pti_result ptiElfParserGetSourceMapping(elf_parser_handle_t parser, uint32_t ker
   return PTI_SUCCESS;
 }
 
+pti_result ptiElfParserLookupSourceMapping(elf_parser_handle_t parser, uint32_t kernel_index,
+                                           uint32_t num_addresses, const uint64_t* addresses,
+                                           SourceMapping* mappings) {
+  if (parser == nullptr || addresses == nullptr || mappings == nullptr) {
+    return PTI_ERROR_BAD_ARGUMENT;
+  }
+
+  ElfParser* parser_ = reinterpret_cast<ElfParser*>(parser);
+  if (parser_->IsValid() == false || kernel_index >= parser_->GetKernelNames().size()) {
+    return PTI_ERROR_BAD_ARGUMENT;
+  }
+
+  auto table = parser_->GetLineTable(kernel_index);
+  if (table->IsEmpty()) {
+    return PTI_DEBUG_INFO_NOT_FOUND;
+  }
+
+  std::vector<const SourceMapping*> rows(num_addresses);
+  table->Lookup(addresses, num_addresses, rows.data());
+  for (uint32_t i = 0; i < num_addresses; i++) {
+    if (rows[i] != nullptr) {
+      mappings[i] = *rows[i];
+    } else {
+      mappings[i] = SourceMapping{0, nullptr, nullptr, addresses[i], 0, 0};
+    }
+  }
+
+  return PTI_SUCCESS;
+}
+
 pti_result ptiElfParserGetBinaryPtr(elf_parser_handle_t parser, uint32_t kernel_index,
                                     const uint8_t** binary, uint32_t* binary_size,
                                     uint64_t* kernel_address) {
@@ -192,6 +224,14 @@ ElfParser::ElfParser(const uint8_t* data, uint32_t size) : data_(data), size_(si
       return;
   }
   this->initialized_ = true;
+
+  const ModuleCache* cache = ModuleCache::GetInstance();
+  if (cache != nullptr) {
+    cached_module_ = cache->Load(data_, size_);
+    if (cached_module_ != nullptr && !IsCachedModuleValid()) {
+      cached_module_ = nullptr;  // content hash collision, the entry belongs to another module
+    }
+  }
 }
 
 bool ElfParser::IsValid(const uint8_t* data, uint32_t size) {
@@ -299,6 +339,19 @@ uint32_t ElfParser::GetKernelIndex(std::string kernel_name) const {
   return -1;
 }
 
+std::string ElfParser::GetDemangledKernelName(uint32_t kernel_index) const {
+  if (kernel_index >= kernel_names_.size()) {
+    return std::string();
+  }
+  if (cached_module_ != nullptr) {
+    const char* name = cached_module_->GetDemangledKernelName(kernel_index);
+    if (name != nullptr) {
+      return name;
+    }
+  }
+  return utils::Demangle(kernel_names_[kernel_index]);
+}
+
 uint32_t ElfParser::GetGfxCore() const {
   const auto& section = GetSection(".note.intelgt.compat");
   if (section.data == nullptr) {
@@ -324,14 +377,65 @@ uint32_t ElfParser::GetGfxCore() const {
 }
 
 std::vector<SourceMapping> ElfParser::GetSourceMappingMatrix(uint32_t kernel_index) {
-  if (source_mapping_.find(kernel_index) == source_mapping_.end()) {
-    source_mapping_[kernel_index] = GetSourceMappingNonCached(kernel_index);
+  return GetLineTable(kernel_index)->GetRows();
+}
+
+std::shared_ptr<const LineTable> ElfParser::GetLineTable(uint32_t kernel_index) {
+  std::lock_guard<std::mutex> lock(line_tables_mutex_);
+  // references to elements of unordered_map stay valid when other elements are inserted
+  auto& table = line_tables_[kernel_index];
+  if (table == nullptr && cached_module_ != nullptr) {
+    table = cached_module_->GetLineTable(kernel_index);
+  }
+  if (table == nullptr && !metadata_stored_ && IsValid()) {
+    const ModuleCache* cache = ModuleCache::GetInstance();
+    if (cache != nullptr) {
+      StoreModuleMetadata(*cache);
+    }
+  }
+  if (table == nullptr) {
+    // decoded once under the lock, concurrent callers for the same kernel wait for it
+    table = std::make_shared<const LineTable>(GetSourceMappingNonCached(kernel_index));
+  }
+  return table;
+}
+
+bool ElfParser::IsCachedModuleValid() const {
+  if (cached_module_->GetKernelNum() != kernel_names_.size()) {
+    return false;
+  }
+  for (uint32_t i = 0; i < kernel_names_.size(); i++) {
+    const char* name = cached_module_->GetKernelName(i);
+    if (name == nullptr || strcmp(name, kernel_names_[i]) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void ElfParser::StoreModuleMetadata(const ModuleCache& cache) {
+  metadata_stored_ = true;
+
+  std::vector<KernelMetadata> kernels;
+  for (uint32_t i = 0; i < kernel_names_.size(); i++) {
+    auto& table = line_tables_[i];
+    if (table == nullptr) {
+      table = std::make_shared<const LineTable>(GetSourceMappingNonCached(i));
+    }
+    kernels.push_back({kernel_names_[i], GetDemangledKernelName(i), table});
   }
-  return source_mapping_[kernel_index];
+
+  // caching is best effort, the tables are already decoded for this run
+  cache.Store(data_, size_, kernels);
+}
+
+std::shared_ptr<const LineTable> ElfParser::GetLineTable(std::string kernel_name) {
+  return GetLineTable(GetKernelIndex(std::move(kernel_name)));
 }
 
 std::map<uint64_t, SourceMapping> ElfParser::GetSourceMapping(uint32_t kernel_index) {
-  auto mapping = this->GetSourceMappingMatrix(kernel_index);
+  auto table = this->GetLineTable(kernel_index);
+  const std::vector<SourceMapping>& mapping = table->GetRows();
   if (mapping.size() == 0) {
     return {};
   }
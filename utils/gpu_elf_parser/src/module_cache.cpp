@@ -0,0 +1,330 @@
+//==============================================================
+// Copyright (C) Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+// =============================================================
+
+#include "module_cache.hpp"
+
+#include <string.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <unordered_map>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "utils.h"
+
+namespace elf_parser {
+
+// Cache entry layout: CacheHeader, kernel_num CacheKernelRecord, rows_num CacheRowRecord, string
+// table of null terminated strings. All offsets are relative to the beginning of the entry
+
+constexpr char CACHE_MAGIC[8] = "PTIMODC";
+constexpr uint32_t CACHE_VERSION = 2;
+constexpr uint32_t CACHE_NO_STRING = 0xFFFFFFFF;
+
+struct CacheHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t kernel_num;
+  uint64_t module_hash;
+  uint64_t module_size;
+  uint64_t rows_offset;
+  uint64_t rows_num;
+  uint64_t strings_offset;
+  uint64_t strings_size;
+};
+
+struct CacheKernelRecord {
+  uint32_t name;            // offset in the string table
+  uint32_t demangled_name;  // offset in the string table
+  uint32_t first_row;
+  uint32_t row_num;
+};
+
+struct CacheRowRecord {
+  uint64_t address;
+  uint32_t file_id;
+  uint32_t file_path;  // offset in the string table
+  uint32_t file_name;  // offset in the string table
+  uint32_t line;
+  uint32_t column;
+  uint32_t reserved;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// CachedModule implementation
+
+CachedModule::CachedModule(const uint8_t* data, size_t size, void* mapping)
+    : data_(data), size_(size), mapping_(mapping) {}
+
+CachedModule::~CachedModule() {
+#if defined(_WIN32)
+  UnmapViewOfFile(data_);
+  CloseHandle(reinterpret_cast<HANDLE>(mapping_));
+#else
+  munmap(const_cast<uint8_t*>(data_), size_);
+#endif
+}
+
+uint32_t CachedModule::GetKernelNum() const {
+  return reinterpret_cast<const CacheHeader*>(data_)->kernel_num;
+}
+
+const CacheKernelRecord* CachedModule::GetKernelRecord(uint32_t kernel_index) const {
+  if (kernel_index >= GetKernelNum()) {
+    return nullptr;
+  }
+  return reinterpret_cast<const CacheKernelRecord*>(data_ + sizeof(CacheHeader)) + kernel_index;
+}
+
+const char* CachedModule::GetString(uint32_t offset) const {
+  const CacheHeader* header = reinterpret_cast<const CacheHeader*>(data_);
+  if (offset >= header->strings_size) {
+    return nullptr;
+  }
+  return reinterpret_cast<const char*>(data_ + header->strings_offset + offset);
+}
+
+const char* CachedModule::GetKernelName(uint32_t kernel_index) const {
+  const CacheKernelRecord* record = GetKernelRecord(kernel_index);
+  return (record == nullptr) ? nullptr : GetString(record->name);
+}
+
+const char* CachedModule::GetDemangledKernelName(uint32_t kernel_index) const {
+  const CacheKernelRecord* record = GetKernelRecord(kernel_index);
+  return (record == nullptr) ? nullptr : GetString(record->demangled_name);
+}
+
+std::shared_ptr<const LineTable> CachedModule::GetLineTable(uint32_t kernel_index) const {
+  std::vector<SourceMapping> rows;
+  const CacheKernelRecord* record = GetKernelRecord(kernel_index);
+  if (record != nullptr) {
+    const CacheHeader* header = reinterpret_cast<const CacheHeader*>(data_);
+    const CacheRowRecord* row =
+        reinterpret_cast<const CacheRowRecord*>(data_ + header->rows_offset) + record->first_row;
+    rows.reserve(record->row_num);
+    for (uint32_t i = 0; i < record->row_num; i++, row++) {
+      rows.push_back({row->file_id, GetString(row->file_path), GetString(row->file_name),
+                      row->address, row->line, row->column});
+    }
+  }
+  // rows were stored sorted, so the sort in LineTable is a single pass. File paths point into the
+  // mapping, the table keeps it alive after the parser and its reference are gone
+  return std::make_shared<const LineTable>(std::move(rows), shared_from_this());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// ModuleCache implementation
+
+ModuleCache* ModuleCache::GetInstance() {
+  static std::unique_ptr<ModuleCache> instance = []() -> std::unique_ptr<ModuleCache> {
+    std::string directory = utils::GetEnv("PTI_MODULE_CACHE_DIR");
+    if (directory.empty()) {
+      return nullptr;
+    }
+    return std::make_unique<ModuleCache>(directory);
+  }();
+  return instance.get();
+}
+
+uint64_t ModuleCache::Hash(const uint8_t* data, size_t size) {
+  // FNV-1a over 8-byte words with an extra shift to mix the high bits down, modules are large so
+  // hashing byte by byte would be noticeable at module load
+  constexpr uint64_t prime = 0x100000001b3ull;
+  uint64_t hash = 0xcbf29ce484222325ull ^ size;
+
+  size_t i = 0;
+  for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+    uint64_t word;
+    memcpy(&word, data + i, sizeof(word));
+    hash = (hash ^ word) * prime;
+    hash ^= hash >> 29;
+  }
+  for (; i < size; i++) {
+    hash = (hash ^ data[i]) * prime;
+  }
+  return hash;
+}
+
+std::string ModuleCache::GetEntryPath(uint64_t hash) const {
+  std::stringstream path;
+  path << directory_ << "/" << std::hex << std::setw(16) << std::setfill('0') << hash << ".ptimod";
+  return path.str();
+}
+
+std::shared_ptr<const CachedModule> ModuleCache::Load(const uint8_t* data, size_t size) const {
+  if (data == nullptr || size == 0) {
+    return nullptr;
+  }
+
+  const uint64_t hash = Hash(data, size);
+  const std::string path = GetEntryPath(hash);
+
+  const uint8_t* entry = nullptr;
+  size_t entry_size = 0;
+  void* mapping = nullptr;
+#if defined(_WIN32)
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return nullptr;
+  }
+  LARGE_INTEGER file_size;
+  if (GetFileSizeEx(file, &file_size) &&
+      file_size.QuadPart >= static_cast<LONGLONG>(sizeof(CacheHeader))) {
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping != nullptr) {
+      entry = reinterpret_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+      if (entry == nullptr) {
+        CloseHandle(mapping);
+        mapping = nullptr;
+      }
+      entry_size = file_size.QuadPart;
+    }
+  }
+  CloseHandle(file);  // the mapping keeps the file open
+#else
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return nullptr;
+  }
+  struct stat stat_buffer;
+  if (fstat(fd, &stat_buffer) == 0 && stat_buffer.st_size >= (off_t)sizeof(CacheHeader)) {
+    void* address = mmap(nullptr, stat_buffer.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (address != MAP_FAILED) {
+      entry = reinterpret_cast<const uint8_t*>(address);
+      entry_size = stat_buffer.st_size;
+    }
+  }
+  close(fd);
+#endif
+  if (entry == nullptr) {
+    return nullptr;
+  }
+
+  std::shared_ptr<const CachedModule> module(new CachedModule(entry, entry_size, mapping));
+
+  // the entry may come from another version of the tool, it is ignored and will be overwritten by
+  // the next Store. A binary of the same size colliding with the hash is not detected here
+  const CacheHeader* header = reinterpret_cast<const CacheHeader*>(entry);
+  if (memcmp(header->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 ||
+      header->version != CACHE_VERSION || header->module_hash != hash ||
+      header->module_size != size) {
+    return nullptr;
+  }
+
+  const uint64_t kernels_end =
+      sizeof(CacheHeader) + static_cast<uint64_t>(header->kernel_num) * sizeof(CacheKernelRecord);
+  if (kernels_end > header->rows_offset || header->rows_offset > entry_size ||
+      header->rows_num > (entry_size - header->rows_offset) / sizeof(CacheRowRecord) ||
+      header->rows_offset + header->rows_num * sizeof(CacheRowRecord) > header->strings_offset ||
+      header->strings_offset > entry_size || header->strings_size == 0 ||
+      header->strings_size > entry_size - header->strings_offset ||
+      entry[header->strings_offset + header->strings_size - 1] != '\0') {
+    return nullptr;
+  }
+
+  const CacheKernelRecord* records =
+      reinterpret_cast<const CacheKernelRecord*>(entry + sizeof(CacheHeader));
+  for (uint32_t i = 0; i < header->kernel_num; i++) {
+    if (static_cast<uint64_t>(records[i].first_row) + records[i].row_num > header->rows_num) {
+      return nullptr;
+    }
+  }
+
+  return module;
+}
+
+bool ModuleCache::Store(const uint8_t* data, size_t size,
+                        const std::vector<KernelMetadata>& kernels) const {
+  if (data == nullptr || size == 0) {
+    return false;
+  }
+
+  std::string strings;
+  std::unordered_map<std::string, uint32_t> string_offsets;  // file paths repeat in every row
+  auto add_string = [&strings, &string_offsets](const char* str) -> uint32_t {
+    if (str == nullptr) {
+      return CACHE_NO_STRING;
+    }
+    auto result = string_offsets.emplace(str, static_cast<uint32_t>(strings.size()));
+    if (result.second) {
+      strings.append(str);
+      strings.push_back('\0');
+    }
+    return result.first->second;
+  };
+
+  std::vector<CacheKernelRecord> records;
+  std::vector<CacheRowRecord> rows;
+  for (const auto& kernel : kernels) {
+    CacheKernelRecord record{};
+    record.name = add_string(kernel.name.c_str());
+    record.demangled_name = add_string(kernel.demangled_name.c_str());
+    record.first_row = static_cast<uint32_t>(rows.size());
+    if (kernel.line_table != nullptr) {
+      for (const auto& mapping : kernel.line_table->GetRows()) {
+        rows.push_back({mapping.address, mapping.file_id, add_string(mapping.file_path),
+                        add_string(mapping.file_name), mapping.line, mapping.column, 0});
+      }
+    }
+    record.row_num = static_cast<uint32_t>(rows.size()) - record.first_row;
+    records.push_back(record);
+  }
+  if (strings.empty()) {
+    strings.push_back('\0');
+  }
+
+  CacheHeader header{};
+  memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+  header.version = CACHE_VERSION;
+  header.kernel_num = static_cast<uint32_t>(records.size());
+  header.module_hash = Hash(data, size);
+  header.module_size = size;
+  header.rows_offset = sizeof(CacheHeader) + records.size() * sizeof(CacheKernelRecord);
+  header.rows_num = rows.size();
+  header.strings_offset = header.rows_offset + rows.size() * sizeof(CacheRowRecord);
+  header.strings_size = strings.size();
+
+  const std::string path = GetEntryPath(header.module_hash);
+  const std::string temp_path = path + "." + std::to_string(utils::GetPid()) + ".tmp";
+  {
+    std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+      return false;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(records.data()),
+               records.size() * sizeof(CacheKernelRecord));
+    file.write(reinterpret_cast<const char*>(rows.data()), rows.size() * sizeof(CacheRowRecord));
+    file.write(strings.data(), strings.size());
+    if (!file.good()) {
+      file.close();
+      std::remove(temp_path.c_str());
+      return false;
+    }
+  }
+
+#if defined(_WIN32)
+  std::remove(path.c_str());  // rename does not replace existing files on Windows
+#endif
+  if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+    std::remove(temp_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+}  // namespace elf_parser
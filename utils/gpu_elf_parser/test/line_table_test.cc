@@ -0,0 +1,138 @@
+//==============================================================
+// Copyright (C) Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+// =============================================================
+
+// Tests of LineTable lookups on synthetic rows, no GPU binary is required
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "line_table.hpp"
+
+using elf_parser::LineTable;
+
+static SourceMapping Row(uint64_t address, uint32_t line, uint32_t column = 0) {
+  return SourceMapping{1, "/src", "kernel.cl", address, line, column};
+}
+
+static bool Check(bool condition, const char* message) {
+  if (!condition) {
+    std::cerr << "[ERROR] " << message << std::endl;
+  }
+  return condition;
+}
+
+static bool CheckLine(const SourceMapping* row, uint32_t line, const char* message) {
+  return Check(row != nullptr && row->line == line, message);
+}
+
+// Rows are given out of order: 0x10 -> 1, 0x20 -> 2, 0x40 -> 4 (0x30 is a gap)
+static std::vector<SourceMapping> GapRows() {
+  return {Row(0x40, 4), Row(0x10, 1), Row(0x20, 2)};
+}
+
+static bool TestEmptyTable() {
+  LineTable table({});
+  bool passed = Check(table.IsEmpty(), "empty table is not empty");
+  passed = Check(table.Lookup(0) == nullptr, "lookup in empty table found a row") && passed;
+  uint64_t addresses[] = {0, 0x10};
+  SourceMapping stale = Row(0, 0);
+  const SourceMapping* result[] = {&stale, &stale};
+  table.Lookup(addresses, 2, result);
+  passed = Check(result[0] == nullptr && result[1] == nullptr,
+                 "batch lookup in empty table found a row") && passed;
+  return passed;
+}
+
+static bool TestSortedOnConstruction() {
+  LineTable table(GapRows());
+  const auto& rows = table.GetRows();
+  return Check(rows.size() == 3 && rows[0].address == 0x10 && rows[1].address == 0x20 &&
+               rows[2].address == 0x40, "rows are not sorted by address");
+}
+
+static bool TestLookupExactAndGaps() {
+  LineTable table(GapRows());
+  bool passed = true;
+  passed = CheckLine(table.Lookup(0x10), 1, "exact address of the first row") && passed;
+  passed = CheckLine(table.Lookup(0x20), 2, "exact address of a middle row") && passed;
+  passed = CheckLine(table.Lookup(0x40), 4, "exact address of the last row") && passed;
+  passed = CheckLine(table.Lookup(0x18), 1, "address between rows") && passed;
+  passed = CheckLine(table.Lookup(0x30), 2, "address in a gap of the table") && passed;
+  passed = CheckLine(table.Lookup(0x3f), 2, "address right before a row") && passed;
+  return passed;
+}
+
+static bool TestOutOfRange() {
+  LineTable table(GapRows());
+  bool passed = true;
+  passed = Check(table.Lookup(0) == nullptr, "address 0 below the table found a row") && passed;
+  passed = Check(table.Lookup(0xf) == nullptr, "address below the table found a row") && passed;
+  // The table has no end of sequence, addresses past the last row belong to it
+  passed = CheckLine(table.Lookup(0x1000), 4, "address above the table") && passed;
+  passed = CheckLine(table.Lookup(UINT64_MAX), 4, "maximal address") && passed;
+  return passed;
+}
+
+static bool TestDuplicateAddresses() {
+  // Rows with the same address keep their order, the last one describes the instruction
+  LineTable table({Row(0x20, 7, 1), Row(0x10, 1), Row(0x20, 7, 2), Row(0x20, 8, 3)});
+  const SourceMapping* row = table.Lookup(0x20);
+  bool passed = Check(row != nullptr && row->line == 8 && row->column == 3,
+                      "duplicate address is not resolved to its last row");
+  row = table.Lookup(0x28);
+  passed = Check(row != nullptr && row->line == 8 && row->column == 3,
+                 "address after duplicates is not resolved to their last row") && passed;
+  const auto& rows = table.GetRows();
+  passed = Check(rows[1].column == 1 && rows[2].column == 2 && rows[3].column == 3,
+                 "rows with the same address are reordered") && passed;
+  return passed;
+}
+
+// Batch lookup must agree with single lookups for ascending runs, descending addresses
+// restarting the search, repeated addresses and addresses out of range
+static bool TestBatchLookup() {
+  std::vector<SourceMapping> rows;
+  for (uint64_t i = 0; i < 64; ++i) {
+    rows.push_back(Row(0x100 + i * 0x10, static_cast<uint32_t>(i)));
+    if (i % 8 == 0) {
+      rows.push_back(Row(0x100 + i * 0x10, static_cast<uint32_t>(1000 + i)));
+    }
+  }
+  LineTable table(std::move(rows));
+
+  std::vector<uint64_t> addresses = {0,     0x100, 0x108, 0x180, 0x180, 0x170, 0x4f0,
+                                     0x500, 0x10,  0x200, 0x1f8, 0x500, 0x100, UINT64_MAX,
+                                     0x0ff, 0x300};
+  for (uint64_t address = 0xf0; address < 0x520; address += 0x7) {
+    addresses.push_back(address);
+  }
+
+  std::vector<const SourceMapping*> result(addresses.size(), nullptr);
+  table.Lookup(addresses.data(), static_cast<uint32_t>(addresses.size()), result.data());
+  for (size_t i = 0; i < addresses.size(); ++i) {
+    if (result[i] != table.Lookup(addresses[i])) {
+      std::cerr << "[ERROR] batch lookup of 0x" << std::hex << addresses[i] << std::dec <<
+        " differs from single lookup" << std::endl;
+      return false;
+    }
+  }
+  return CheckLine(result[1], 1000, "batch lookup of a duplicate address") &&
+         Check(result[0] == nullptr && result[8] == nullptr, "batch lookup below the table");
+}
+
+int main() {
+  bool passed = true;
+  passed = TestEmptyTable() && passed;
+  passed = TestSortedOnConstruction() && passed;
+  passed = TestLookupExactAndGaps() && passed;
+  passed = TestOutOfRange() && passed;
+  passed = TestDuplicateAddresses() && passed;
+  passed = TestBatchLookup() && passed;
+  std::cout << (passed ? "[PASSED]" : "[FAILED]") << " line_table_test" << std::endl;
+  return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,173 @@
+//==============================================================
+// Copyright (C) Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+// =============================================================
+
+// Tests of ModuleCache entries written and mapped back, on a synthetic module binary. Entries are
+// written to the current directory and removed at the end
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "module_cache.hpp"
+
+using elf_parser::CachedModule;
+using elf_parser::KernelMetadata;
+using elf_parser::LineTable;
+using elf_parser::ModuleCache;
+
+static const char* const kDirectory = ".";
+
+static bool Check(bool condition, const char* message) {
+  if (!condition) {
+    std::cerr << "[ERROR] " << message << std::endl;
+  }
+  return condition;
+}
+
+static bool IsSameString(const char* str, const char* expected) {
+  return str != nullptr && strcmp(str, expected) == 0;
+}
+
+static std::vector<uint8_t> MakeBinary(size_t size, uint32_t seed) {
+  std::vector<uint8_t> binary(size);
+  for (size_t i = 0; i < size; ++i) {
+    seed = seed * 1103515245 + 12345;
+    binary[i] = static_cast<uint8_t>(seed >> 16);
+  }
+  return binary;
+}
+
+static std::string GetEntryPath(const std::vector<uint8_t>& binary) {
+  std::stringstream path;
+  path << kDirectory << "/" << std::hex << std::setw(16) << std::setfill('0')
+       << ModuleCache::Hash(binary.data(), binary.size()) << ".ptimod";
+  return path.str();
+}
+
+// Two kernels, the second one without debug information
+static std::vector<KernelMetadata> MakeKernels() {
+  std::vector<SourceMapping> rows = {{1, "/src", "kernel.cl", 0x10, 3, 1},
+                                     {2, "/include", "helper.h", 0x20, 40, 5},
+                                     {1, "/src", "kernel.cl", 0x40, 7, 0}};
+  return {{"_Z3fooi", "foo(int)", std::make_shared<const LineTable>(std::move(rows))},
+          {"bar", "bar", nullptr}};
+}
+
+static bool TestRoundTrip() {
+  std::vector<uint8_t> binary = MakeBinary(1003, 1);
+  ModuleCache cache(kDirectory);
+  if (!Check(cache.Store(binary.data(), binary.size(), MakeKernels()), "entry is not written")) {
+    return false;
+  }
+
+  std::shared_ptr<const CachedModule> module = cache.Load(binary.data(), binary.size());
+  if (!Check(module != nullptr, "written entry is not loaded")) {
+    return false;
+  }
+  bool passed = Check(module->GetKernelNum() == 2, "wrong number of kernels");
+  passed = Check(IsSameString(module->GetKernelName(0), "_Z3fooi") &&
+                 IsSameString(module->GetKernelName(1), "bar"), "wrong kernel names") && passed;
+  passed = Check(IsSameString(module->GetDemangledKernelName(0), "foo(int)") &&
+                 IsSameString(module->GetDemangledKernelName(1), "bar"),
+                 "wrong demangled kernel names") && passed;
+  passed = Check(module->GetKernelName(2) == nullptr && module->GetLineTable(2)->IsEmpty(),
+                 "kernel out of range is found") && passed;
+  passed = Check(module->GetLineTable(1)->IsEmpty(), "kernel without rows has rows") && passed;
+
+  // The table keeps the mapping alive, file paths stay valid without the module
+  std::shared_ptr<const LineTable> table = module->GetLineTable(0);
+  module.reset();
+  std::vector<KernelMetadata> expected = MakeKernels();
+  const auto& rows = table->GetRows();
+  const auto& expected_rows = expected[0].line_table->GetRows();
+  if (!Check(rows.size() == expected_rows.size(), "wrong number of rows")) {
+    return false;
+  }
+  for (size_t i = 0; i < rows.size(); ++i) {
+    if (rows[i].address != expected_rows[i].address || rows[i].line != expected_rows[i].line ||
+        rows[i].column != expected_rows[i].column ||
+        rows[i].file_id != expected_rows[i].file_id ||
+        !IsSameString(rows[i].file_path, expected_rows[i].file_path) ||
+        !IsSameString(rows[i].file_name, expected_rows[i].file_name)) {
+      std::cerr << "[ERROR] row " << i << " differs from the stored one" << std::endl;
+      passed = false;
+    }
+  }
+  passed = Check(table->Lookup(0x30) != nullptr && table->Lookup(0x30)->line == 40,
+                 "lookup in the loaded table") && passed;
+
+  std::remove(GetEntryPath(binary).c_str());
+  return passed;
+}
+
+static bool TestOtherBinaries() {
+  std::vector<uint8_t> binary = MakeBinary(512, 2);
+  ModuleCache cache(kDirectory);
+  if (!Check(cache.Store(binary.data(), binary.size(), MakeKernels()), "entry is not written")) {
+    return false;
+  }
+
+  std::vector<uint8_t> changed = binary;
+  changed[100] ^= 1;
+  bool passed = Check(cache.Load(changed.data(), changed.size()) == nullptr,
+                      "entry is loaded for a changed binary");
+  passed = Check(cache.Load(binary.data(), binary.size() - 1) == nullptr,
+                 "entry is loaded for a shorter binary") && passed;
+  passed = Check(cache.Load(nullptr, 0) == nullptr, "entry is loaded for no binary") && passed;
+
+  std::remove(GetEntryPath(binary).c_str());
+  passed = Check(cache.Load(binary.data(), binary.size()) == nullptr,
+                 "removed entry is loaded") && passed;
+  return passed;
+}
+
+static bool TestReplacedAndTruncated() {
+  std::vector<uint8_t> binary = MakeBinary(64, 3);
+  ModuleCache cache(kDirectory);
+  cache.Store(binary.data(), binary.size(), MakeKernels());
+  std::vector<KernelMetadata> kernels = {{"baz", "baz", nullptr}};
+  if (!Check(cache.Store(binary.data(), binary.size(), kernels), "entry is not replaced")) {
+    return false;
+  }
+  std::shared_ptr<const CachedModule> module = cache.Load(binary.data(), binary.size());
+  bool passed = Check(module != nullptr && module->GetKernelNum() == 1 &&
+                      IsSameString(module->GetKernelName(0), "baz"),
+                      "replaced entry is not loaded");
+  module.reset();
+
+  // A partially written entry, e.g. from a tool that crashed without the rename
+  const std::string path = GetEntryPath(binary);
+  std::string content;
+  {
+    std::ifstream file(path, std::ios::binary);
+    content.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  }
+  {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(content.data(), content.size() - 3);
+  }
+  passed = Check(cache.Load(binary.data(), binary.size()) == nullptr,
+                 "truncated entry is loaded") && passed;
+
+  std::remove(path.c_str());
+  return passed;
+}
+
+int main() {
+  bool passed = true;
+  passed = TestRoundTrip() && passed;
+  passed = TestOtherBinaries() && passed;
+  passed = TestReplacedAndTruncated() && passed;
+  std::cout << (passed ? "[PASSED]" : "[FAILED]") << " module_cache_test" << std::endl;
+  return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,99 @@
+//==============================================================
+// Copyright (C) Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+// =============================================================
+
+#ifndef PTI_GTPIN_POST_PROCESSING_H
+#define PTI_GTPIN_POST_PROCESSING_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "record_batch.hpp"
+
+/**
+ * @file post_processing.hpp
+ * @brief This file contains the declaration of the PostProcessingPool class, a pool of worker
+ * threads that accumulates profile data snapshots out of the kernel completion path.
+ */
+
+namespace gtpin_prof {
+
+/**
+ * @class PostProcessingPool
+ * @brief PostProcessingPool runs post-processing tasks on worker threads. Each task owns a snapshot
+ * of the profile array taken from a pool of record buffers, which is returned to the pool once the
+ * task is done. The number of pending tasks is bounded, so a slow post-processing stalls the
+ * application instead of growing the memory without limit.
+ */
+class PostProcessingPool {
+ public:
+  using Task = std::function<void(ProfileRecordBuffer&)>;
+
+  /**
+   * @brief Constructs a PostProcessingPool object and starts the worker threads.
+   * @param threadsNum Number of worker threads, should be greater than zero.
+   */
+  explicit PostProcessingPool(size_t threadsNum);
+
+  /// Processes all pending tasks and stops the worker threads
+  ~PostProcessingPool();
+
+  PostProcessingPool(const PostProcessingPool&) = delete;
+  PostProcessingPool& operator=(const PostProcessingPool&) = delete;
+
+  /**
+   * @brief Gets a record buffer of the requested shape, reusing a released buffer if there is one.
+   * @param recordSize Size of one record in bytes.
+   * @param recordNum Number of records in one thread bucket.
+   * @param bucketNum Number of thread buckets.
+   * @return The record buffer.
+   */
+  std::unique_ptr<ProfileRecordBuffer> AcquireBuffer(size_t recordSize, size_t recordNum,
+                                                     size_t bucketNum);
+
+  /**
+   * @brief Returns a buffer that is not submitted, e.g. when reading the profile array failed.
+   * @param buffer The record buffer.
+   */
+  void ReleaseBuffer(std::unique_ptr<ProfileRecordBuffer> buffer);
+
+  /**
+   * @brief Schedules the task on the buffer. Blocks while the number of pending tasks is at the
+   * limit.
+   * @param buffer The record buffer, returned to the pool after the task.
+   * @param task The task.
+   */
+  void Submit(std::unique_ptr<ProfileRecordBuffer> buffer, Task task);
+
+  /// Waits until all submitted tasks are done
+  void Drain();
+
+  size_t GetThreadsNum() const { return m_threads.size(); }
+
+ private:
+  void Worker();
+  void ReleaseBufferLocked(std::unique_ptr<ProfileRecordBuffer> buffer);
+
+  std::vector<std::thread> m_threads;
+  std::deque<std::pair<std::unique_ptr<ProfileRecordBuffer>, Task>> m_queue;
+  std::vector<std::unique_ptr<ProfileRecordBuffer>> m_freeBuffers;
+  size_t m_maxPending;
+  size_t m_pending = 0;  ///< Tasks queued or running
+  bool m_stop = false;
+
+  std::mutex m_lock;
+  std::condition_variable m_taskReady;  ///< Signals workers: new task or stop
+  std::condition_variable m_taskDone;   ///< Signals submitters and Drain: a task is done
+};
+
+}  // namespace gtpin_prof
+
+#endif  // PTI_GTPIN_POST_PROCESSING_H
@@ -0,0 +1,142 @@
+//==============================================================
+// Copyright (C) Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+// =============================================================
+
+#ifndef PTI_GTPIN_RECORD_BATCH_H
+#define PTI_GTPIN_RECORD_BATCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "pti_assert.h"
+
+/**
+ * @file record_batch.hpp
+ * @brief This file contains the declaration of the RawRecord struct and of the host side buffers
+ * used to process the profile array in bulk: ProfileRecordBuffer holds a copy of the whole
+ * profile array and RawRecordBatch is a view over all thread buckets of one record. Both do not
+ * depend on GTPin, so the batching can be checked with synthetic record arrays.
+ */
+
+namespace gtpin_prof {
+
+/**
+ * @brief RawRecord is a base class that is used as an indivisible unit of profiling. One record is
+ * used for one instrumentation site of instrument.
+ */
+struct RawRecord {};
+
+/**
+ * @class RawRecordBatch
+ * @brief RawRecordBatch is a strided view over the copies of one record in all thread buckets.
+ * The records of a batch are accumulated into the same result data.
+ */
+class RawRecordBatch {
+ public:
+  RawRecordBatch(uint8_t* data, size_t num, size_t stride)
+      : m_data(data), m_num(num), m_stride(stride) {}
+
+  /// Number of records in the batch
+  size_t Size() const { return m_num; }
+
+  /// Record of the batch
+  RawRecord* operator[](size_t idx) const {
+    PTI_ASSERT(idx < m_num);
+    return reinterpret_cast<RawRecord*>(m_data + idx * m_stride);
+  }
+
+  /**
+   * @brief Sums a 64-bit counter over all records of the batch.
+   * @param offset Offset of the counter in the record, e.g. offsetof(Record, counter).
+   * @return The sum of the counter.
+   */
+  uint64_t Sum(size_t offset) const {
+    uint64_t sum = 0;
+    const uint8_t* ptr = m_data + offset;
+    for (size_t idx = 0; idx < m_num; idx++, ptr += m_stride) {
+      uint64_t value;
+      std::memcpy(&value, ptr, sizeof(value));
+      sum += value;
+    }
+    return sum;
+  }
+
+  /**
+   * @brief Adds an array of 64-bit counters of all records of the batch element-wise to dst.
+   * @param offset Offset of the first counter in the record.
+   * @param count Number of counters in the array.
+   * @param dst Array of count elements the sums are added to.
+   */
+  void SumArray(size_t offset, size_t count, uint64_t* dst) const {
+    PTI_ASSERT(dst != nullptr || count == 0);
+    for (size_t idx = 0; idx < m_num; idx++) {
+      const uint8_t* src = m_data + idx * m_stride + offset;
+      // contiguous elements of one record, the loop is vectorized by the compiler
+      for (size_t i = 0; i < count; i++) {
+        uint64_t value;
+        std::memcpy(&value, src + i * sizeof(uint64_t), sizeof(value));
+        dst[i] += value;
+      }
+    }
+  }
+
+ private:
+  uint8_t* m_data;
+  size_t m_num;
+  size_t m_stride;
+};
+
+/**
+ * @class ProfileRecordBuffer
+ * @brief Host copy of the whole profile array, read from the profile buffer thread bucket by
+ * thread bucket. Records are laid out as [thread bucket][record index].
+ */
+class ProfileRecordBuffer {
+ public:
+  ProfileRecordBuffer(size_t recordSize, size_t recordNum, size_t bucketNum)
+      : m_recordSize(recordSize),
+        m_recordNum(recordNum),
+        m_bucketNum(bucketNum),
+        m_data(recordSize * recordNum * bucketNum) {
+    PTI_ASSERT(recordSize > 0);
+  }
+
+  /// Reshapes the buffer for reuse, the memory already allocated is kept
+  void Reset(size_t recordSize, size_t recordNum, size_t bucketNum) {
+    PTI_ASSERT(recordSize > 0);
+    m_recordSize = recordSize;
+    m_recordNum = recordNum;
+    m_bucketNum = bucketNum;
+    m_data.resize(recordSize * recordNum * bucketNum);
+  }
+
+  size_t GetRecordNum() const { return m_recordNum; }
+  size_t GetBucketsNum() const { return m_bucketNum; }
+
+  /// Destination of all records of a thread bucket
+  uint8_t* GetBucket(size_t bucket) {
+    PTI_ASSERT(bucket < m_bucketNum);
+    return m_data.data() + bucket * m_recordNum * m_recordSize;
+  }
+
+  /// Copies of the record in all thread buckets
+  RawRecordBatch GetBatch(size_t recordIdx) {
+    PTI_ASSERT(recordIdx < m_recordNum);
+    return RawRecordBatch(m_data.data() + recordIdx * m_recordSize, m_bucketNum,
+                          m_recordNum * m_recordSize);
+  }
+
+ private:
+  size_t m_recordSize;
+  size_t m_recordNum;
+  size_t m_bucketNum;
+  std::vector<uint8_t> m_data;
+};
+
+}  // namespace gtpin_prof
+
+#endif  // PTI_GTPIN_RECORD_BATCH_H
@@ -92,8 +92,8 @@ class InvocationData {
   const KernelRun GetGlobalRunNum() const;
   const DispatchId GetDispatchId() const;
   size_t GetCollectedTilesNum() const;
-  const std::vector<ResultDataSPtr> GetResults(size_t tileId) const;
-  const ResultDataSPtr GetResultData(size_t tileId, size_t idx) const;
+  const std::vector<ResultDataSPtr>& GetResults(size_t tileId) const;
+  const ResultDataSPtr& GetResultData(size_t tileId, size_t idx) const;
   bool IsCollected() const;
 
  private:
@@ -13,6 +13,8 @@
 #include "api/gtpin_api.h"
 #include "control.hpp"
 #include "def_gpu.hpp"
+#include "post_processing.hpp"
+#include "record_batch.hpp"
 #include "results.hpp"
 #include "tool_factory.hpp"
 #include "writer.hpp"
@@ -20,18 +22,12 @@
 /**
  * @file tool.hpp
  * @brief This file contains the declaration of the GTPinTool class, which implements the gtpin
- * IGtTool interface for tool registration in the GTPin framework. It also includes the declaration
- * of the RawRecord struct, which is used as the base class for profiling records.
+ * IGtTool interface for tool registration in the GTPin framework. The RawRecord struct, which is
+ * used as the base class for profiling records, is declared in record_batch.hpp.
  */
 
 namespace gtpin_prof {
 
-/**
- * @brief RawRecord is a base class that is used as an indivisible unit of profiling. One record is
- * used for one instrumentation site of instrument.
- */
-struct RawRecord {};
-
 /**
  * @class GTPinTool
  * @brief GTPinTool class implements the gtpin IGtTool interface, which is used for tool
@@ -54,7 +50,7 @@ class GTPinTool : public gtpin::IGtTool {
   GTPinTool& operator=(const GTPinTool&) = delete;
 
   /**
-   * @brief Runs the writer after profiling finishes.
+   * @brief Runs the writer after profiling finishes. Pending post-processing is drained first.
    * @param writer A shared pointer to the WriterBase object.
    * @return The status of the operation.
    */
@@ -86,6 +82,12 @@ class GTPinTool : public gtpin::IGtTool {
    */
   const ApplicationDataSPtr GetProfilingData() const;
 
+  /**
+   * @brief Waits until the profile data of all completed kernels is accumulated. Does nothing if
+   * post-processing is synchronous.
+   */
+  void WaitPostProcessing() const;
+
   // IGtTool interface
   const char* Name() const override = 0;
   void OnKernelBuild(gtpin::IGtKernelInstrument& instrumentor) final;
@@ -143,6 +145,21 @@ class GTPinTool : public gtpin::IGtTool {
   virtual PROF_STATUS Accumulate(KernelDataSPtr kernelData, ResultDataSPtr profilingResult,
                                  SiteOfInstrumentSPtr siteOfInstrument, RawRecord* record) = 0;
 
+  /**
+   * @brief Accumulates a batch of records into the profiling results.
+   * All records of the batch belong to the same site of instrument and tile (one per thread
+   * bucket) and are accumulated into the same ResultData. The default implementation calls
+   * "Accumulate" for every record. Tools may override it with reductions over the whole batch.
+   * @param kernelData A shared pointer to the KernelData object.
+   * @param profilingResult A shared pointer to the ResultData object.
+   * @param siteOfInstrument A shared pointer to the SiteOfInstrument object.
+   * @param records The batch of records.
+   * @return The status of the operation.
+   */
+  virtual PROF_STATUS AccumulateBatch(KernelDataSPtr kernelData, ResultDataSPtr profilingResult,
+                                      SiteOfInstrumentSPtr siteOfInstrument,
+                                      const RawRecordBatch& records);
+
   /**
    * @brief Processes the profiling data after it has been collected.
    * @param kernelData A shared pointer to the KernelData object.
@@ -183,8 +200,10 @@ class GTPinTool : public gtpin::IGtTool {
   PROF_STATUS InitBuffer(KernelDataSPtr kernelData, gtpin::IGtKernelDispatch& dispatcher);
 
   /**
-   * @brief Reads profiling data from the GTPin buffer into the profiling data (results) using the
-   * "Accumulate" function.
+   * @brief Reads profiling data from the GTPin buffer into the profiling data (results). The whole
+   * profile array is copied to the host, one read per thread bucket, and passed to
+   * "ProcessProfileData". With asynchronous post-processing ("post-proc-threads" knob) the copy is
+   * processed by a worker thread and the function returns right after the copy.
    * @param kernelData A shared pointer to the KernelData object.
    * @param dispatcher A reference to the IGtKernelDispatch object.
    * @return The status of the operation.
@@ -192,6 +211,19 @@ class GTPinTool : public gtpin::IGtTool {
   PROF_STATUS ReadProfileData(KernelDataSPtr kernelData, gtpin::IGtKernelDispatch& dispatcher,
                               const ToolFactorySPtr factory);
 
+  /**
+   * @brief Accumulates a copy of the profile array into the invocation results using the
+   * "AccumulateBatch" function, runs "PostProcData" and marks the invocation as collected. May run
+   * on a worker thread: invocations are processed concurrently, so tool implementations of
+   * "AccumulateBatch" and "PostProcData" should modify only the data of the given invocation.
+   * @param kernelData A shared pointer to the KernelData object.
+   * @param invocation A shared pointer to the InvocationData object.
+   * @param records The copy of the profile array.
+   * @return The status of the operation.
+   */
+  PROF_STATUS ProcessProfileData(KernelDataSPtr kernelData, InvocationDataSPtr invocation,
+                                 ProfileRecordBuffer& records);
+
   /// Functions for manipulating KernelData
   KernelDataSPtr CreateKernelInStorage(const gtpin::IGtKernelInstrument& instrumentor);
   bool IsKernelInStorage(const KernelId& kernelId) const;
@@ -207,7 +239,6 @@ class GTPinTool : public gtpin::IGtTool {
   void AddSiteOfInstrument(KernelDataSPtr kernelData, SiteOfInstrumentSPtr siteOfInstrument);
   SiteOfInstrumentSPtr GetSiteOfInstrument(KernelDataSPtr kernelData, size_t idx);
   gtpin::GtProfileArray& GetProfileArray(KernelDataSPtr kernelData);
-  void SetInvocationCollected(KernelDataSPtr kernelData, gtpin::IGtKernelDispatch& dispatcher);
 
   void MapResultData(SiteOfInstrumentSPtr siteOfInstrument, size_t resultDataIdx);
   std::vector<ResultDataSPtr> GetResultDataForSiteOfInstrument(
@@ -227,6 +258,10 @@ class GTPinTool : public gtpin::IGtTool {
 
   const ToolFactorySPtr m_factory;
   const ControlBaseSPtr m_control;
+
+  /// Worker threads of asynchronous post-processing, nullptr if it is synchronous. Tasks call
+  /// virtual functions of the tool, so the profiler drains them before the tool is destroyed
+  std::unique_ptr<PostProcessingPool> m_postProcessing;
 };
 
 }  // namespace gtpin_prof
@@ -0,0 +1,107 @@
+//==============================================================
+// Copyright (C) Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+// =============================================================
+
+/**
+ * @file post_processing.cpp
+ * @brief Implements the PostProcessingPool class, which runs the accumulation of profile data on
+ * worker threads.
+ */
+
+#include "post_processing.hpp"
+
+using namespace gtpin_prof;
+
+/// Number of pending tasks per worker thread, bounds the memory held by profile array snapshots
+constexpr size_t POST_PROCESSING_TASKS_PER_THREAD = 4;
+
+PostProcessingPool::PostProcessingPool(size_t threadsNum)
+    : m_maxPending(threadsNum * POST_PROCESSING_TASKS_PER_THREAD) {
+  PTI_ASSERT(threadsNum > 0);
+  for (size_t i = 0; i < threadsNum; i++) {
+    m_threads.emplace_back(&PostProcessingPool::Worker, this);
+  }
+}
+
+PostProcessingPool::~PostProcessingPool() {
+  {
+    std::unique_lock<std::mutex> lock(m_lock);
+    m_stop = true;
+  }
+  m_taskReady.notify_all();
+  for (auto& thread : m_threads) {
+    thread.join();
+  }
+  PTI_ASSERT(m_queue.empty() && m_pending == 0);
+}
+
+std::unique_ptr<ProfileRecordBuffer> PostProcessingPool::AcquireBuffer(size_t recordSize,
+                                                                       size_t recordNum,
+                                                                       size_t bucketNum) {
+  std::unique_ptr<ProfileRecordBuffer> buffer;
+  {
+    std::unique_lock<std::mutex> lock(m_lock);
+    if (!m_freeBuffers.empty()) {
+      buffer = std::move(m_freeBuffers.back());
+      m_freeBuffers.pop_back();
+    }
+  }
+  if (buffer == nullptr) {
+    return std::make_unique<ProfileRecordBuffer>(recordSize, recordNum, bucketNum);
+  }
+  buffer->Reset(recordSize, recordNum, bucketNum);
+  return buffer;
+}
+
+void PostProcessingPool::ReleaseBuffer(std::unique_ptr<ProfileRecordBuffer> buffer) {
+  PTI_ASSERT(buffer != nullptr);
+  std::unique_lock<std::mutex> lock(m_lock);
+  ReleaseBufferLocked(std::move(buffer));
+}
+
+void PostProcessingPool::ReleaseBufferLocked(std::unique_ptr<ProfileRecordBuffer> buffer) {
+  /// Keep enough buffers to serve all pending tasks, release the rest
+  if (m_freeBuffers.size() < m_maxPending) {
+    m_freeBuffers.push_back(std::move(buffer));
+  }
+}
+
+void PostProcessingPool::Submit(std::unique_ptr<ProfileRecordBuffer> buffer, Task task) {
+  PTI_ASSERT(buffer != nullptr);
+  {
+    std::unique_lock<std::mutex> lock(m_lock);
+    PTI_ASSERT(!m_stop);
+    m_taskDone.wait(lock, [this] { return m_pending < m_maxPending; });
+    m_queue.emplace_back(std::move(buffer), std::move(task));
+    m_pending++;
+  }
+  m_taskReady.notify_one();
+}
+
+void PostProcessingPool::Drain() {
+  std::unique_lock<std::mutex> lock(m_lock);
+  m_taskDone.wait(lock, [this] { return m_pending == 0; });
+}
+
+void PostProcessingPool::Worker() {
+  std::unique_lock<std::mutex> lock(m_lock);
+  while (true) {
+    m_taskReady.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+    if (m_queue.empty()) {
+      break;  // stop requested and nothing left to process
+    }
+
+    auto item = std::move(m_queue.front());
+    m_queue.pop_front();
+
+    lock.unlock();
+    item.second(*item.first);
+    lock.lock();
+
+    ReleaseBufferLocked(std::move(item.first));
+    m_pending--;
+    m_taskDone.notify_all();
+  }
+}
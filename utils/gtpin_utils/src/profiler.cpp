@@ -65,6 +65,9 @@ PROF_STATUS GTPinProfiler::Stop() {
     PTI_ASSERT(result && "Failed to unregister tool");
   }
   m_gtpinToolHandle = nullptr;
+
+  /// Kernels may complete between the writer run and unregistration
+  m_gtpinTool->WaitPostProcessing();
   m_gtpinTool = nullptr;
 
   return PROF_STATUS::SUCCESS;
@@ -30,12 +30,12 @@ const KernelRun InvocationData::GetRunNum() const { return m_runNum; }
 const KernelRun InvocationData::GetGlobalRunNum() const { return m_globalRunNum; }
 const DispatchId InvocationData::GetDispatchId() const { return m_dispatchId; }
 size_t InvocationData::GetCollectedTilesNum() const { return m_tileResultData.size(); }
-const std::vector<ResultDataSPtr> InvocationData::GetResults(size_t tileId) const {
+const std::vector<ResultDataSPtr>& InvocationData::GetResults(size_t tileId) const {
   PTI_ASSERT(tileId < m_tileResultData.size());
   return m_tileResultData[tileId];
 }
-const ResultDataSPtr InvocationData::GetResultData(size_t tileId, size_t idx) const {
-  auto res = GetResults(tileId);
+const ResultDataSPtr& InvocationData::GetResultData(size_t tileId, size_t idx) const {
+  const auto& res = GetResults(tileId);
   PTI_ASSERT(idx < res.size());
   return res[idx];
 }
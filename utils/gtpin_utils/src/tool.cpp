@@ -19,18 +19,28 @@
 #include <algorithm>
 
 #include "capsule.hpp"
+#include "knob_parser.h"
 
 using namespace gtpin_prof;
 
+static gtpin::Knob<int> knobPostProcThreads(
+    "post-proc-threads", 0,
+    "Number of threads accumulating profile data asynchronously, 0 to accumulate on kernel "
+    "completion");
+
 GTPinTool::GTPinTool(const ToolFactorySPtr factory)
     : m_factory(factory),
       m_control(factory->GetControl()),
       m_applicationData(factory->MakeApplicationData()),
       m_globalRun(0) {
   PTI_ASSERT(m_control != nullptr);
+  if (knobPostProcThreads > 0) {
+    m_postProcessing = std::make_unique<PostProcessingPool>(knobPostProcThreads);
+  }
 }
 
 PROF_STATUS GTPinTool::RunWriter(const WriterBaseSPtr writer) const {
+  WaitPostProcessing();
   writer->Write(m_applicationData);
   return PROF_STATUS::SUCCESS;
 }
@@ -48,7 +58,14 @@ std::vector<const char*> GTPinTool::GetGTPinKnobs() const {
 
 const KernelRun GTPinTool::GetGlobalRun() const { return m_globalRun; }
 
-const ApplicationDataSPtr GTPinTool::GetProfilingData() const { return m_applicationData; }
+const ApplicationDataSPtr GTPinTool::GetProfilingData() const {
+  WaitPostProcessing();
+  return m_applicationData;
+}
+
+void GTPinTool::WaitPostProcessing() const {
+  if (m_postProcessing != nullptr) m_postProcessing->Drain();
+}
 
 void GTPinTool::OnKernelBuild(gtpin::IGtKernelInstrument& instrumentor) {
   PROF_STATUS status;
@@ -122,16 +139,25 @@ void GTPinTool::OnKernelComplete(gtpin::IGtKernelDispatch& dispatcher) {
 
   PTI_ASSERT(dispatcher.IsCompleted() == true);
 
+  /// The invocation is marked as collected once its data is processed
   status = this->ReadProfileData(kernelData, dispatcher, m_factory);
   PTI_ASSERT(PROF_STATUS::SUCCESS == status && "Fail to read data");
-
-  SetInvocationCollected(kernelData, dispatcher);
 }
 
 PROF_STATUS GTPinTool::PostProcData(KernelDataSPtr kernel, InvocationDataSPtr invocationResult) {
   return PROF_STATUS::SUCCESS;
 }
 
+PROF_STATUS GTPinTool::AccumulateBatch(KernelDataSPtr kernelData, ResultDataSPtr profilingResult,
+                                       SiteOfInstrumentSPtr siteOfInstrument,
+                                       const RawRecordBatch& records) {
+  for (size_t idx = 0; idx < records.Size(); idx++) {
+    PROF_STATUS status = Accumulate(kernelData, profilingResult, siteOfInstrument, records[idx]);
+    if (status != PROF_STATUS::SUCCESS) return status;
+  }
+  return PROF_STATUS::SUCCESS;
+}
+
 PROF_STATUS GTPinTool::AllocateResources(KernelDataSPtr kernelData,
                                          const gtpin::IGtKernelInstrument& instrumentor) {
   PTI_ASSERT(kernelData->IsRecordSizeSet() &&
@@ -193,44 +219,67 @@ PROF_STATUS GTPinTool::InitBuffer(KernelDataSPtr kernelData, gtpin::IGtKernelDis
 PROF_STATUS GTPinTool::ReadProfileData(KernelDataSPtr kernelData,
                                        gtpin::IGtKernelDispatch& dispatcher,
                                        const ToolFactorySPtr factory) {
-  PROF_STATUS status;
-
   const gtpin::IGtProfileBuffer* buffer = dispatcher.GetProfileBuffer();
   PTI_ASSERT((buffer != nullptr) && "Profile kernel was not found");
 
   auto invocation = kernelData->m_invocations[dispatcher.DispatchId()];
   PTI_ASSERT(invocation != nullptr && "Invocation data was not initialized");
 
-  char* recordChar = new char[kernelData->GetRecordSize()];
-  RawRecord* record = reinterpret_cast<RawRecord*>(recordChar);
+  /// Copy the whole profile array, all records of a thread bucket at once
+  auto& profileArray = kernelData->m_profileArray;
+  size_t recordSize = kernelData->GetRecordSize();
+  size_t recordNum = kernelData->GetSiteOfInstrumentNum() * kernelData->GetCollectedTilesNum();
+  std::unique_ptr<ProfileRecordBuffer> records =
+      (m_postProcessing != nullptr)
+          ? m_postProcessing->AcquireBuffer(recordSize, recordNum, profileArray.NumThreadBuckets())
+          : std::make_unique<ProfileRecordBuffer>(recordSize, recordNum,
+                                                  profileArray.NumThreadBuckets());
+  for (uint32_t threadBucket = 0; threadBucket < records->GetBucketsNum(); ++threadBucket) {
+    if (!profileArray.Read(*buffer, records->GetBucket(threadBucket), 0, records->GetRecordNum(),
+                           threadBucket)) {
+      if (m_postProcessing != nullptr) {
+        m_postProcessing->ReleaseBuffer(std::move(records));
+      }
+      return PROF_STATUS::ERROR;
+    }
+  }
+
+  if (m_postProcessing == nullptr) {
+    return ProcessProfileData(kernelData, invocation, *records);
+  }
+
+  /// The profile buffer may be reused by the next dispatch, the copy is processed asynchronously
+  m_postProcessing->Submit(std::move(records),
+                           [this, kernelData, invocation](ProfileRecordBuffer& snapshot) {
+                             PROF_STATUS status =
+                                 ProcessProfileData(kernelData, invocation, snapshot);
+                             PTI_ASSERT(PROF_STATUS::SUCCESS == status && "Fail to process data");
+                           });
+  return PROF_STATUS::SUCCESS;
+}
+
+PROF_STATUS GTPinTool::ProcessProfileData(KernelDataSPtr kernelData, InvocationDataSPtr invocation,
+                                          ProfileRecordBuffer& records) {
+  PROF_STATUS status;
 
   size_t tileNum = kernelData->GetCollectedTilesNum();
   for (size_t i = 0; i < kernelData->GetSiteOfInstrumentNum(); i++) {
-    for (uint32_t threadBucket = 0; threadBucket < kernelData->m_profileArray.NumThreadBuckets();
-         ++threadBucket) {
-      for (size_t tileId = 0; tileId < tileNum; tileId++) {
-        if (!kernelData->m_profileArray.Read(*buffer, record, i * tileNum + tileId, 1,
-                                             threadBucket)) {
-          delete[] recordChar;
-          return PROF_STATUS::ERROR;
-        } else {
-          PTI_ASSERT((record != nullptr) && "Record is corrupted");
-          auto site = kernelData->GetSiteOfInstrument(i);
-          for (const auto& resultData : GetResultDataForSiteOfInstrument(invocation, site)) {
-            if (resultData->GetTileId() != tileId) continue;
-            status = Accumulate(kernelData, resultData, site, record);
-            PTI_ASSERT((PROF_STATUS::SUCCESS == status) && "Fail to accumulate result data");
-          }
-        }
+    auto site = kernelData->GetSiteOfInstrument(i);
+    for (size_t tileId = 0; tileId < tileNum; tileId++) {
+      RawRecordBatch batch = records.GetBatch(i * tileNum + tileId);
+      /// Result data of the site are mapped by index, no need to look them up
+      for (const auto& idx : site->m_results) {
+        status = AccumulateBatch(kernelData, invocation->GetResultData(tileId, idx), site, batch);
+        PTI_ASSERT((PROF_STATUS::SUCCESS == status) && "Fail to accumulate result data");
       }
     }
   }
 
-  delete[] recordChar;
-
   status = this->PostProcData(kernelData, invocation);
   PTI_ASSERT((PROF_STATUS::SUCCESS == status) && "Fail to post process data");
 
+  invocation->m_collected = true;
+
   return PROF_STATUS::SUCCESS;
 }
 
@@ -299,10 +348,6 @@ gtpin::GtProfileArray& GTPinTool::GetProfileArray(KernelDataSPtr kernelData) {
 void GTPinTool::MapResultData(SiteOfInstrumentSPtr siteOfInstrument, size_t resultDataIdx) {
   siteOfInstrument->m_results.push_back(resultDataIdx);
 }
-void GTPinTool::SetInvocationCollected(KernelDataSPtr kernelData,
-                                       gtpin::IGtKernelDispatch& dispatcher) {
-  kernelData->m_invocations[dispatcher.DispatchId()]->m_collected = true;
-}
 
 std::vector<ResultDataSPtr> GTPinTool::GetResultDataForSiteOfInstrument(
     InvocationDataSPtr invocation, SiteOfInstrumentSPtr siteOfInstrument) {
@@ -0,0 +1,203 @@
+//==============================================================
+// Copyright (C) Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+// =============================================================
+
+// Tests of the bulk processing of profile arrays on synthetic records, no GTPin is required.
+// The buffer is filled bucket by bucket like the profile array is read, and the batch sums are
+// checked against accumulating the records one by one.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "record_batch.hpp"
+
+using gtpin_prof::ProfileRecordBuffer;
+using gtpin_prof::RawRecord;
+using gtpin_prof::RawRecordBatch;
+
+namespace {
+
+constexpr size_t kCounters = 5;
+
+// Packed so that the record size is not a multiple of the counter size and the counters of
+// most records are unaligned
+#pragma pack(push, 1)
+struct TestRecord : RawRecord {
+  uint32_t flags;
+  uint64_t count;
+  uint64_t counters[kCounters];
+  uint8_t tail;
+};
+#pragma pack(pop)
+
+struct Accumulated {
+  uint64_t count = 0;
+  uint64_t counters[kCounters] = {};
+};
+
+uint64_t Value(size_t bucket, size_t record, size_t field) {
+  return (bucket + 1) * 1000003 + record * 101 + field * 7 + (bucket % 3 == 0 ? 1ULL << 40 : 0);
+}
+
+// Writes the records of every bucket the way the profile array is read: one bucket at a time
+void Fill(ProfileRecordBuffer& buffer) {
+  for (size_t bucket = 0; bucket < buffer.GetBucketsNum(); bucket++) {
+    uint8_t* dst = buffer.GetBucket(bucket);
+    for (size_t record = 0; record < buffer.GetRecordNum(); record++) {
+      TestRecord rec;
+      std::memset(&rec, 0, sizeof(rec));
+      rec.flags = 0xffffffff;
+      rec.count = Value(bucket, record, 0);
+      for (size_t i = 0; i < kCounters; i++) {
+        rec.counters[i] = Value(bucket, record, i + 1);
+      }
+      rec.tail = 0xff;
+      std::memcpy(dst + record * sizeof(TestRecord), &rec, sizeof(rec));
+    }
+  }
+}
+
+// Per-record path: every record of the batch accumulated on its own, as Accumulate does
+Accumulated AccumulatePerRecord(const RawRecordBatch& batch) {
+  Accumulated result;
+  for (size_t idx = 0; idx < batch.Size(); idx++) {
+    TestRecord rec;
+    std::memcpy(&rec, batch[idx], sizeof(rec));
+    result.count += rec.count;
+    for (size_t i = 0; i < kCounters; i++) {
+      result.counters[i] += rec.counters[i];
+    }
+  }
+  return result;
+}
+
+Accumulated AccumulateBulk(const RawRecordBatch& batch) {
+  Accumulated result;
+  result.count = batch.Sum(offsetof(TestRecord, count));
+  batch.SumArray(offsetof(TestRecord, counters), kCounters, result.counters);
+  return result;
+}
+
+Accumulated Expected(size_t buckets, size_t record) {
+  Accumulated result;
+  for (size_t bucket = 0; bucket < buckets; bucket++) {
+    result.count += Value(bucket, record, 0);
+    for (size_t i = 0; i < kCounters; i++) {
+      result.counters[i] += Value(bucket, record, i + 1);
+    }
+  }
+  return result;
+}
+
+bool Equal(const Accumulated& lhs, const Accumulated& rhs) {
+  if (lhs.count != rhs.count) return false;
+  for (size_t i = 0; i < kCounters; i++) {
+    if (lhs.counters[i] != rhs.counters[i]) return false;
+  }
+  return true;
+}
+
+bool CheckBuffer(ProfileRecordBuffer& buffer, const char* name) {
+  Fill(buffer);
+  for (size_t record = 0; record < buffer.GetRecordNum(); record++) {
+    RawRecordBatch batch = buffer.GetBatch(record);
+    if (batch.Size() != buffer.GetBucketsNum()) {
+      std::cerr << "[ERROR] " << name << ": batch of record " << record << " has " << batch.Size()
+                << " records" << std::endl;
+      return false;
+    }
+    Accumulated expected = Expected(buffer.GetBucketsNum(), record);
+    if (!Equal(AccumulatePerRecord(batch), expected)) {
+      std::cerr << "[ERROR] " << name << ": per-record accumulation of record " << record
+                << " is wrong" << std::endl;
+      return false;
+    }
+    if (!Equal(AccumulateBulk(batch), expected)) {
+      std::cerr << "[ERROR] " << name << ": bulk accumulation of record " << record
+                << " differs from per-record one" << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+static bool TestBulkMatchesPerRecord() {
+  bool passed = true;
+  ProfileRecordBuffer single(sizeof(TestRecord), 1, 1);
+  passed = CheckBuffer(single, "single record") && passed;
+  ProfileRecordBuffer many(sizeof(TestRecord), 13, 64);
+  passed = CheckBuffer(many, "many buckets") && passed;
+  return passed;
+}
+
+// Sums are added to what the result already holds, like accumulation into result data
+static bool TestSumArrayAddsToDestination() {
+  ProfileRecordBuffer buffer(sizeof(TestRecord), 2, 4);
+  Fill(buffer);
+  RawRecordBatch batch = buffer.GetBatch(1);
+  Accumulated result;
+  for (size_t i = 0; i < kCounters; i++) {
+    result.counters[i] = i;
+  }
+  batch.SumArray(offsetof(TestRecord, counters), kCounters, result.counters);
+  batch.SumArray(offsetof(TestRecord, counters), 0, nullptr);
+  Accumulated expected = Expected(4, 1);
+  for (size_t i = 0; i < kCounters; i++) {
+    if (result.counters[i] != expected.counters[i] + i) {
+      std::cerr << "[ERROR] SumArray does not add to the destination" << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool TestEmptyBatch() {
+  ProfileRecordBuffer buffer(sizeof(TestRecord), 3, 0);
+  RawRecordBatch batch = buffer.GetBatch(2);
+  uint64_t counters[kCounters] = {};
+  batch.SumArray(offsetof(TestRecord, counters), kCounters, counters);
+  for (size_t i = 0; i < kCounters; i++) {
+    if (counters[i] != 0) {
+      std::cerr << "[ERROR] Empty batch changes the destination" << std::endl;
+      return false;
+    }
+  }
+  if (batch.Size() != 0 || batch.Sum(offsetof(TestRecord, count)) != 0) {
+    std::cerr << "[ERROR] Empty batch is not empty" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// Buffers taken from the post-processing pool are reshaped for the next kernel
+static bool TestReset() {
+  ProfileRecordBuffer buffer(sizeof(TestRecord), 32, 16);
+  Fill(buffer);
+  buffer.Reset(sizeof(TestRecord), 5, 7);
+  if (buffer.GetRecordNum() != 5 || buffer.GetBucketsNum() != 7) {
+    std::cerr << "[ERROR] Reset does not reshape the buffer" << std::endl;
+    return false;
+  }
+  bool passed = CheckBuffer(buffer, "reset to smaller");
+  buffer.Reset(sizeof(TestRecord), 40, 9);
+  passed = CheckBuffer(buffer, "reset to larger") && passed;
+  return passed;
+}
+
+int main() {
+  bool passed = true;
+  passed = TestBulkMatchesPerRecord() && passed;
+  passed = TestSumArrayAddsToDestination() && passed;
+  passed = TestEmptyBatch() && passed;
+  passed = TestReset() && passed;
+  std::cout << (passed ? "[PASSED]" : "[FAILED]") << " record_batch_test" << std::endl;
+  return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
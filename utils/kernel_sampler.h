@@ -0,0 +1,181 @@
+//==============================================================
+// Copyright (C) Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+// =============================================================
+
+#ifndef PTI_UTILS_KERNEL_SAMPLER_H_
+#define PTI_UTILS_KERNEL_SAMPLER_H_
+
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace utils {
+
+enum class KernelSamplingMode : uint32_t {
+  kNone = 0,       // every launch is traced
+  kEveryNth = 1,   // launches 1, N + 1, 2N + 1, ... of each kernel are traced
+  kReservoir = 2,  // first N launches of each kernel are traced, launch n > N with probability N/n
+};
+
+struct KernelLaunchCount {
+  uint64_t launched = 0;  // exact number of launches
+  uint64_t traced = 0;    // number of launches selected for tracing
+};
+
+// Estimate of a total (e.g. kernel time) from the values of the traced launches, each standing for
+// weight launches (Horvitz-Thompson estimator). The variance is the one of independent selection
+// with probability 1/weight, a conservative bound for every-Nth sampling.
+struct SampledTotal {
+  double weight = 0.0;    // estimated number of launches
+  double total = 0.0;     // estimated total
+  double variance = 0.0;  // variance of the estimated total
+
+  void Add(double value, double sample_weight) {
+    weight += sample_weight;
+    total += sample_weight * value;
+    variance += sample_weight * (sample_weight - 1.0) * value * value;
+  }
+
+  void Merge(const SampledTotal& other) {
+    weight += other.weight;
+    total += other.total;
+    variance += other.variance;
+  }
+
+  // Half-width of the 95% confidence interval of the total
+  double GetErrorBound() const { return 1.96 * std::sqrt(variance); }
+};
+
+// Decides which kernel launches are instrumented when the launch rate is too high to trace all of
+// them. Launches are counted per key (kernel name or identifier), so launch counts stay exact even
+// though only the sampled launches are timed. Decisions are deterministic for a given sequence of
+// launches, which keeps the sampler testable without a device.
+template <typename Key, typename Hash = std::hash<Key>>
+class KernelSampler {
+ public:
+  KernelSampler() = default;
+  KernelSampler(KernelSamplingMode mode, uint32_t rate) { SetPolicy(mode, rate); }
+
+  KernelSampler(const KernelSampler&) = delete;
+  KernelSampler& operator=(const KernelSampler&) = delete;
+
+  // Sets the policy and restarts counting. A rate less than 2 disables sampling.
+  void SetPolicy(KernelSamplingMode mode, uint32_t rate) {
+    if (rate < 2) {
+      mode = KernelSamplingMode::kNone;
+    }
+    for (auto& shard : shards_) {
+      std::lock_guard<std::mutex> lock(shard.lock_);
+      shard.kernels_.clear();
+    }
+    rate_.store(rate, std::memory_order_relaxed);
+    mode_.store(mode, std::memory_order_release);
+  }
+
+  KernelSamplingMode GetMode() const { return mode_.load(std::memory_order_acquire); }
+  uint32_t GetRate() const { return rate_.load(std::memory_order_relaxed); }
+  bool IsEnabled() const { return GetMode() != KernelSamplingMode::kNone; }
+
+  // Counts a launch of the kernel. Returns the number of launches the traced one stands for
+  // (inverse of the probability to be traced), or 0 if the launch should not be instrumented.
+  double Sample(const Key& key) {
+    KernelSamplingMode mode = GetMode();
+    if (mode == KernelSamplingMode::kNone) {
+      return 1.0;
+    }
+    uint64_t rate = GetRate();
+
+    Shard& shard = shards_[Hash{}(key) % kShardCount];
+    std::lock_guard<std::mutex> lock(shard.lock_);
+    auto it = shard.kernels_.find(key);
+    if (it == shard.kernels_.end()) {
+      it = shard.kernels_.emplace(key, KernelState{{}, Hash{}(key) ^ kSeed}).first;
+    }
+    KernelState& state = it->second;
+    uint64_t n = ++state.count_.launched;
+
+    double weight = 0.0;
+    if (mode == KernelSamplingMode::kEveryNth) {
+      if ((n - 1) % rate == 0) {
+        weight = static_cast<double>(rate);
+      }
+    } else if (n <= rate) {
+      weight = 1.0;
+    } else if (NextRandom(state.random_) % n < rate) {
+      weight = static_cast<double>(n) / static_cast<double>(rate);
+    }
+
+    if (weight > 0.0) {
+      ++state.count_.traced;
+    }
+    return weight;
+  }
+
+  KernelLaunchCount GetCount(const Key& key) const {
+    const Shard& shard = shards_[Hash{}(key) % kShardCount];
+    std::lock_guard<std::mutex> lock(shard.lock_);
+    auto it = shard.kernels_.find(key);
+    return (it == shard.kernels_.end()) ? KernelLaunchCount{} : it->second.count_;
+  }
+
+  std::vector<std::pair<Key, KernelLaunchCount>> GetCounts() const {
+    std::vector<std::pair<Key, KernelLaunchCount>> counts;
+    for (const auto& shard : shards_) {
+      std::lock_guard<std::mutex> lock(shard.lock_);
+      for (const auto& it : shard.kernels_) {
+        counts.emplace_back(it.first, it.second.count_);
+      }
+    }
+    return counts;
+  }
+
+  KernelLaunchCount GetTotalCount() const {
+    KernelLaunchCount total;
+    for (const auto& shard : shards_) {
+      std::lock_guard<std::mutex> lock(shard.lock_);
+      for (const auto& it : shard.kernels_) {
+        total.launched += it.second.count_.launched;
+        total.traced += it.second.count_.traced;
+      }
+    }
+    return total;
+  }
+
+ private:
+  static constexpr size_t kShardCount = 16;
+  static constexpr uint64_t kSeed = 0x9e3779b97f4a7c15ULL;
+
+  struct KernelState {
+    KernelLaunchCount count_;
+    uint64_t random_;  // state of the random number generator of the kernel
+  };
+
+  struct alignas(64) Shard {
+    mutable std::mutex lock_;
+    std::unordered_map<Key, KernelState, Hash> kernels_;
+  };
+
+  // splitmix64
+  static uint64_t NextRandom(uint64_t& state) {
+    uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+  }
+
+  std::atomic<KernelSamplingMode> mode_{KernelSamplingMode::kNone};
+  std::atomic<uint32_t> rate_{0};
+  std::array<Shard, kShardCount> shards_;
+};
+
+}  // namespace utils
+
+#endif  // PTI_UTILS_KERNEL_SAMPLER_H_
@@ -0,0 +1,280 @@
+//==============================================================
+// Copyright (C) Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+// =============================================================
+
+// Tests of event-driven completion of OpenCL commands. A stub runtime stands in for the OpenCL
+// ICD: it completes commands on its own threads and calls the callbacks registered for their
+// events, like clSetEventCallback does. No GPU is required.
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "completion_queue.h"
+
+struct StubCommand {
+  uint64_t id = 0;
+  uint64_t duration = 0;
+  std::shared_ptr<utils::CompletionQueue<StubCommand>> completion_queue;
+  StubCommand* next_completed = nullptr;
+};
+
+typedef void (*StubEventCallback)(int status, void* user_data);
+
+// Completes submitted commands from runtime threads, in no particular order
+class StubRuntime {
+ public:
+  explicit StubRuntime(int threads) {
+    for (int i = 0; i < threads; ++i) {
+      threads_.emplace_back([this]() { Run(); });
+    }
+  }
+
+  ~StubRuntime() {
+    stop_ = true;
+    for (auto& t : threads_) {
+      t.join();
+    }
+  }
+
+  void SetEventCallback(StubEventCallback callback, void* user_data) {
+    const std::lock_guard<std::mutex> lock(lock_);
+    pending_.push_back({callback, user_data});
+  }
+
+ private:
+  struct Pending {
+    StubEventCallback callback;
+    void* user_data;
+  };
+
+  void Run() {
+    while (true) {
+      Pending pending = {nullptr, nullptr};
+      {
+        const std::lock_guard<std::mutex> lock(lock_);
+        if (!pending_.empty()) {
+          // completes the most recent submissions first to shuffle the order
+          pending = pending_.back();
+          pending_.pop_back();
+        }
+      }
+      if (pending.callback != nullptr) {
+        pending.callback(0, pending.user_data);
+      } else if (stop_) {
+        break;
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  std::atomic<bool> stop_{false};
+  std::mutex lock_;
+  std::vector<Pending> pending_;
+  std::vector<std::thread> threads_;
+};
+
+// Mirrors how the OpenCL collectors use the queue
+class StubCollector {
+ public:
+  explicit StubCollector(StubRuntime* runtime) : runtime_(runtime) {}
+
+  void Submit(uint64_t id) {
+    StubCommand* command = new StubCommand;
+    command->id = id;
+    command->duration = id % 100 + 1;
+    command->completion_queue = completion_queue_;
+    completion_queue_->AddInFlight();
+    runtime_->SetEventCallback(OnEventComplete, command);
+  }
+
+  static void OnEventComplete(int /* status */, void* user_data) {
+    StubCommand* command = reinterpret_cast<StubCommand*>(user_data);
+    std::shared_ptr<utils::CompletionQueue<StubCommand>> queue = command->completion_queue;
+    queue->Push(command);
+  }
+
+  void Finalize() {
+    completion_queue_->WaitForInFlight(std::chrono::milliseconds(10000));
+    drainer_.Stop();
+  }
+
+  uint64_t GetProcessed() const { return processed_; }
+  uint64_t GetTotalDuration() const { return total_duration_; }
+  bool IsValid() const { return valid_; }
+  uint64_t GetInFlightCount() const { return completion_queue_->GetInFlightCount(); }
+
+ private:
+  void OnCommandComplete(StubCommand* command) {
+    if (handler_running_.exchange(true)) {
+      valid_ = false;   // handler calls must not overlap
+    }
+    ++processed_;
+    total_duration_ += command->duration;
+    delete command;
+    handler_running_ = false;
+  }
+
+  StubRuntime* runtime_;
+  uint64_t processed_ = 0;
+  uint64_t total_duration_ = 0;
+  std::atomic<bool> handler_running_{false};
+  std::atomic<bool> valid_{true};
+  std::shared_ptr<utils::CompletionQueue<StubCommand>> completion_queue_ =
+    std::make_shared<utils::CompletionQueue<StubCommand>>();
+  utils::CompletionDrainer<StubCommand> drainer_{
+    completion_queue_, [this](StubCommand* command) { OnCommandComplete(command); }};
+};
+
+static uint64_t GetExpectedDuration(uint64_t commands) {
+  uint64_t total = 0;
+  for (uint64_t id = 0; id < commands; ++id) {
+    total += id % 100 + 1;
+  }
+  return total;
+}
+
+static bool TestAllCommandsProcessed() {
+  constexpr int kSubmitters = 4;
+  constexpr uint64_t kCommands = 50000;
+  StubRuntime runtime(3);
+  StubCollector collector(&runtime);
+  std::vector<std::thread> submitters;
+  for (int t = 0; t < kSubmitters; ++t) {
+    submitters.emplace_back([&collector, t]() {
+      for (uint64_t id = t; id < kCommands; id += kSubmitters) {
+        collector.Submit(id);
+      }
+    });
+  }
+  for (auto& t : submitters) {
+    t.join();
+  }
+  collector.Finalize();
+
+  bool passed = true;
+  if (collector.GetProcessed() != kCommands || collector.GetInFlightCount() != 0) {
+    std::cerr << "[ERROR] " << collector.GetProcessed() << " commands processed out of " << kCommands << std::endl;
+    passed = false;
+  }
+  if (collector.GetTotalDuration() != GetExpectedDuration(kCommands)) {
+    std::cerr << "[ERROR] Unexpected total duration " << collector.GetTotalDuration() << std::endl;
+    passed = false;
+  }
+  if (!collector.IsValid()) {
+    std::cerr << "[ERROR] Completed commands are processed concurrently" << std::endl;
+    passed = false;
+  }
+  return passed;
+}
+
+static bool TestCompletionOrder() {
+  utils::CompletionQueue<StubCommand> queue;
+  std::vector<StubCommand> commands(5);
+  for (uint64_t i = 0; i < commands.size(); ++i) {
+    commands[i].id = i;
+    queue.AddInFlight();
+    queue.Push(&commands[i]);
+  }
+  uint64_t expected = 0;
+  for (StubCommand* command = queue.PopAll(); command != nullptr; command = command->next_completed) {
+    if (command->id != expected++) {
+      std::cerr << "[ERROR] Completed commands are not in completion order" << std::endl;
+      return false;
+    }
+  }
+  return expected == commands.size() && queue.IsEmpty() && queue.GetInFlightCount() == 0;
+}
+
+static bool TestInFlightTimeout() {
+  utils::CompletionQueue<StubCommand> queue;
+  queue.AddInFlight();
+  if (queue.WaitForInFlight(std::chrono::milliseconds(10))) {
+    std::cerr << "[ERROR] Waiting for a command that never completes does not time out" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// Commands completing after the collector is gone must not touch it
+static bool TestCompletionAfterCollectorDestroyed() {
+  std::vector<StubCommand*> late;
+  std::weak_ptr<utils::CompletionQueue<StubCommand>> weak_queue;
+  {
+    auto queue = std::make_shared<utils::CompletionQueue<StubCommand>>();
+    weak_queue = queue;
+    utils::CompletionDrainer<StubCommand> drainer(queue, [](StubCommand* command) { delete command; });
+    for (int i = 0; i < 3; ++i) {
+      StubCommand* command = new StubCommand;
+      command->completion_queue = queue;
+      queue->AddInFlight();
+      late.push_back(command);
+    }
+  }
+  if (weak_queue.expired()) {
+    std::cerr << "[ERROR] Queue is destroyed while commands are in flight" << std::endl;
+    return false;
+  }
+  for (StubCommand* command : late) {
+    StubCollector::OnEventComplete(0, command);
+  }
+  // nobody drains the queue anymore, commands are leaked as they are at process exit
+  auto queue = weak_queue.lock();
+  if (queue == nullptr) {
+    std::cerr << "[ERROR] Queue is destroyed while commands are not drained" << std::endl;
+    return false;
+  }
+  for (StubCommand* command = queue->PopAll(); command != nullptr;) {
+    StubCommand* next = command->next_completed;
+    command->completion_queue.reset();
+    delete command;
+    command = next;
+  }
+  return queue->GetInFlightCount() == 0;
+}
+
+// The drainer sleeps until a command completes and still stops while idle
+static bool TestIdleDrainerWakesUp() {
+  auto queue = std::make_shared<utils::CompletionQueue<StubCommand>>();
+  std::atomic<uint64_t> drained{0};
+  utils::CompletionDrainer<StubCommand> drainer(queue, [&drained](StubCommand* command) {
+    drained += command->id;
+  });
+  std::vector<StubCommand> commands(3);
+  for (uint64_t i = 0; i < commands.size(); ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    commands[i].id = i + 1;
+    queue->AddInFlight();
+    queue->Push(&commands[i]);
+  }
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (drained != 6 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  if (drained != 6) {
+    std::cerr << "[ERROR] Idle drainer does not wake up for completed commands" << std::endl;
+    return false;
+  }
+  drainer.Stop();
+  return true;
+}
+
+int main() {
+  bool passed = true;
+  passed = TestAllCommandsProcessed() && passed;
+  passed = TestCompletionOrder() && passed;
+  passed = TestInFlightTimeout() && passed;
+  passed = TestCompletionAfterCollectorDestroyed() && passed;
+  passed = TestIdleDrainerWakesUp() && passed;
+  std::cout << (passed ? "[PASSED]" : "[FAILED]") << " completion_queue_test" << std::endl;
+  return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,82 @@
+//==============================================================
+// Copyright (C) Intel Corporation
+//
+// SPDX-License-Identifier: MIT
+// =============================================================
+
+#ifndef PTI_UTILS_THREAD_TABLES_H_
+#define PTI_UTILS_THREAD_TABLES_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace utils {
+
+// Tables of type T, one per thread. T guards its content with its own lock_
+// member. A thread only takes the lock of its own table, which is contended
+// only while another thread reads the table. Tables outlive their threads, so
+// readers see the data of threads that have exited.
+template <typename T>
+class ThreadTables {
+ public:
+  ThreadTables() : id_(NextId().fetch_add(1, std::memory_order_relaxed)) {}
+
+  ThreadTables(const ThreadTables& copy) = delete;
+  ThreadTables& operator=(const ThreadTables& copy) = delete;
+
+  // Table of the calling thread, the last one used is cached per thread
+  T* Get() {
+    struct CachedTable {
+      uint64_t owner_id = 0;
+      T* table = nullptr;
+    };
+    thread_local CachedTable cached;
+    if (cached.owner_id == id_) {
+      return cached.table;
+    }
+
+    const std::lock_guard<std::mutex> lock(tables_lock_);
+    T*& table = thread_tables_[std::this_thread::get_id()];
+    if (table == nullptr) {
+      tables_.push_back(std::unique_ptr<T>(new T()));
+      table = tables_.back().get();
+    }
+    cached.owner_id = id_;
+    cached.table = table;
+    return table;
+  }
+
+  // Calls f(table) for the table of every thread, with the lock of the table
+  // held
+  template <typename F>
+  void ForEach(F f) const {
+    const std::lock_guard<std::mutex> lock(tables_lock_);
+    for (const auto& table : tables_) {
+      const std::lock_guard<std::mutex> table_lock(table->lock_);
+      f(*table);
+    }
+  }
+
+ private:
+  // Ids are never reused, so a cached table of a destroyed object is not
+  // taken for the table of a new one at the same address
+  static std::atomic<uint64_t>& NextId() {
+    static std::atomic<uint64_t> id{1};
+    return id;
+  }
+
+  const uint64_t id_;
+  mutable std::mutex tables_lock_;
+  std::vector<std::unique_ptr<T>> tables_;
+  std::unordered_map<std::thread::id, T*> thread_tables_;
+};
+
+} // namespace utils
+
+#endif // PTI_UTILS_THREAD_TABLES_H_
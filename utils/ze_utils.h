@@ -305,7 +305,7 @@ inline std::string GetKernelName(
   PTI_ASSERT(name[size - 1] == '\0');
 
   if (demangle) {
-    return utils::Demangle(name.data());
+    return std::string(utils::DemangleCached(name.data()));
   }
   return std::string(name.begin(), name.end() - 1);
 }